@@ -5,6 +5,7 @@
 #include "SgSystem.h"
 #include "FeBasicFeatures.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include "FePatternBase.h"
@@ -16,6 +17,7 @@
 #include "GoPattern3x3.h"
 #include "GoSafetySolver.h"
 #include "GoSetupUtil.h"
+#include "SgArray.h"
 #include "SgPointSet.h"
 #include "SgWrite.h"
 
@@ -843,21 +845,43 @@ void FindDistPrevMoveFeatures(const GoBoard& bd,
         SetDistances2ndLastMove(lastMove2, legalBoardMoves, features);
 }
 
-int FindClosestStoneDistance(const GoBoard& bd,
-                             SgPoint empty, SgBlackWhite color)
+/** Distance of each point to the closest stone of a color.
+    Uses the metric of Distance(), which is the chamfer distance with
+    weight 2 for orthogonal and 3 for diagonal steps. Therefore it can be
+    computed exactly with one forward and one backward pass over the board
+    instead of comparing each point with each stone. */
+void FindClosestStoneDistances(const GoBoard& bd, SgBlackWhite color,
+                               SgPointArray<int>& distance)
 {
-    int distance = 99999;
-
-    for (GoBoard::Iterator it(bd); it; ++it) // @todo: slow, loop from
-                                             // closest to furtherst instead
-        if (  bd.GetColor(*it) == color
-           && Distance(empty, *it) < distance)
+    const int INFINITE_DISTANCE = 99999;
+    for (SgPoint p = 0; p < SG_MAXPOINT; ++p)
+        distance[p] = INFINITE_DISTANCE;
+    for (GoBoard::Iterator it(bd); it; ++it)
+        if (bd.GetColor(*it) == color)
+            distance[*it] = 0;
+    const SgGrid size = bd.Size();
+    for (SgGrid row = 1; row <= size; ++row)
+        for (SgGrid col = 1; col <= size; ++col)
         {
-            distance = Distance(empty, *it);
+            const SgPoint p = Pt(col, row);
+            int d = distance[p];
+            d = std::min(d, distance[p - SG_WE] + 2);
+            d = std::min(d, distance[p - SG_NS] + 2);
+            d = std::min(d, distance[p - SG_NS - SG_WE] + 3);
+            d = std::min(d, distance[p - SG_NS + SG_WE] + 3);
+            distance[p] = d;
+        }
+    for (SgGrid row = size; row >= 1; --row)
+        for (SgGrid col = size; col >= 1; --col)
+        {
+            const SgPoint p = Pt(col, row);
+            int d = distance[p];
+            d = std::min(d, distance[p + SG_WE] + 2);
+            d = std::min(d, distance[p + SG_NS] + 2);
+            d = std::min(d, distance[p + SG_NS + SG_WE] + 3);
+            d = std::min(d, distance[p + SG_NS - SG_WE] + 3);
+            distance[p] = d;
         }
-
-    SG_ASSERT(distance < 99999);
-    return distance;
 }
 
 void FindClosestDistanceFeaturesForColor(const GoBoard& bd,
@@ -869,9 +893,11 @@ void FindClosestDistanceFeaturesForColor(const GoBoard& bd,
     if (bd.All(color).IsEmpty())
         return;
 
+    SgPointArray<int> closest;
+    FindClosestStoneDistances(bd, color, closest);
     for (GoPointList::Iterator it(legalBoardMoves); it; ++it)
     {
-        int distance = FindClosestStoneDistance(bd, *it, color);
+        int distance = closest[*it];
         SG_ASSERT(distance >= 2);
         if (distance > MAX_CLOSEST_DISTANCE)
             distance = MAX_CLOSEST_DISTANCE;
@@ -1126,16 +1152,7 @@ float FeFeatures::EvaluateActiveFeatures(const FeActiveArray& active,
                                          size_t nuActive,
                                          const FeFeatureWeights& weights)
 {
-    float value = 0.0;
-    for (FeActiveIterator it = active.begin();
-                          it < active.begin() + nuActive; ++it)
-    {
-        value += weights.m_w[*it];
-        for (FeActiveIterator it2 = it + 1;
-                              it2 < active.begin() + nuActive; ++it2)
-            value += weights.Combine(*it, *it2);
-    }
-    return value;
+    return weights.EvaluateActive(active.data(), nuActive);
 }
 
 float FeFeatures::EvaluateMoveFeatures(const FeMoveFeatures& features,
@@ -1282,6 +1299,16 @@ void WriteFeatureSetNumeric(std::ostream& stream,
 size_t FeMoveFeatures::ActiveFeatures(FeActiveArray& active) const
 {
     size_t nuActive = 0;
+#ifdef __GLIBCXX__
+    // Skip the unset bits a word at a time, only a few features are active
+    for (size_t i = m_basicFeatures._Find_first(); i < _NU_FE_FEATURES;
+         i = m_basicFeatures._Find_next(i))
+    {
+        active[nuActive] = static_cast<int>(i);
+        if (++nuActive >= MAX_ACTIVE_LENGTH)
+            return nuActive;
+    }
+#else
     for (int i = 0; i < _NU_FE_FEATURES; ++i)
         if (m_basicFeatures.test(i))
         {
@@ -1289,6 +1316,7 @@ size_t FeMoveFeatures::ActiveFeatures(FeActiveArray& active) const
             if (++nuActive >= MAX_ACTIVE_LENGTH)
                 return nuActive;
         }
+#endif
     // invalid for pass move and (1,1) points
     if (m_3x3Index != INVALID_PATTERN_INDEX)
     {
@@ -1365,10 +1393,30 @@ void FeMoveFeatures::WriteFeatures(std::ostream& stream,
 GoEvalArray<float> FeFullBoardFeatures::
 EvaluateFeatures(const FeFeatureWeights& weights) const
 {
-    GoEvalArray<float> eval(0);
+    // Collect the active features of all moves and evaluate them in one
+    // batch
+    SgArray<SgPoint, SG_MAX_MOVES> moves;
+    int nuMoves = 0;
     for (GoPointList::Iterator it(m_legalMoves); it; ++it)
-            eval[*it] = FeFeatures::EvaluateMoveFeatures(m_features[*it], weights);
-    eval[SG_PASS] = FeFeatures::EvaluateMoveFeatures(m_features[SG_PASS], weights);
+        moves[nuMoves++] = *it;
+    moves[nuMoves++] = SG_PASS;
+    int active[SG_MAX_MOVES * MAX_ACTIVE_LENGTH];
+    size_t begin[SG_MAX_MOVES + 1];
+    begin[0] = 0;
+    for (int i = 0; i < nuMoves; ++i)
+    {
+        FeActiveArray moveActive;
+        const size_t nuActive =
+            m_features[moves[i]].ActiveFeatures(moveActive);
+        std::copy(moveActive.begin(), moveActive.begin() + nuActive,
+                  active + begin[i]);
+        begin[i + 1] = begin[i] + nuActive;
+    }
+    float values[SG_MAX_MOVES];
+    weights.EvaluateBatch(active, begin, nuMoves, values);
+    GoEvalArray<float> eval(0);
+    for (int i = 0; i < nuMoves; ++i)
+        eval[moves[i]] = values[i];
     return eval;
 }
 
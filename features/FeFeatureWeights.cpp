@@ -8,6 +8,9 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
 #include "FeBasicFeatures.h"
 #include "FeData.h"
 #include "SgDebug.h"
@@ -24,30 +27,84 @@ FeFeatureWeights::FeFeatureWeights(size_t nuFeatures, size_t k)
     : m_nuFeatures(nuFeatures),
       m_k(k),
       m_minID(std::numeric_limits<size_t>::max()),
-      m_maxID(std::numeric_limits<size_t>::min())
+      m_maxID(std::numeric_limits<size_t>::min()),
+      m_kStride((k + 3) / 4 * 4)
 {
     SG_ASSERT(  nuFeatures == 0
              || nuFeatures == MAX_FEATURE_INDEX);
     m_w.resize(nuFeatures, 0);
-    m_v.resize(k); // create empty vectors
-    for (size_t i = 0; i < k; ++i)
-        m_v[i].resize(nuFeatures, 0);
+    m_v.resize(nuFeatures * m_kStride, 0);
     SG_ASSERT(IsAllocated());
 }
 
+float FeFeatureWeights::EvaluateActive(const int* active,
+                                       size_t nuActive) const
+{
+    // Collect the valid features, so that the inner loops need no checks
+    SG_ASSERT(nuActive <= MAX_ACTIVE_LENGTH);
+    int valid[MAX_ACTIVE_LENGTH];
+    size_t nuValid = 0;
+    float value = 0.0;
+    for (size_t i = 0; i < nuActive; ++i)
+        if (static_cast<size_t>(active[i]) < m_w.size())
+        {
+            valid[nuValid++] = active[i];
+            value += m_w[active[i]];
+        }
+    if (nuValid < 2)
+        return value;
+    float interaction = 0.0;
+#ifdef __SSE__
+    __m128 total = _mm_setzero_ps();
+    for (size_t k = 0; k < m_kStride; k += 4)
+    {
+        __m128 sum = _mm_setzero_ps();
+        __m128 sumSquares = _mm_setzero_ps();
+        for (size_t i = 0; i < nuValid; ++i)
+        {
+            const __m128 v = _mm_loadu_ps(V(valid[i]) + k);
+            sum = _mm_add_ps(sum, v);
+            sumSquares = _mm_add_ps(sumSquares, _mm_mul_ps(v, v));
+        }
+        total = _mm_add_ps(total,
+                           _mm_sub_ps(_mm_mul_ps(sum, sum), sumSquares));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, total);
+    interaction = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+    for (size_t k = 0; k < m_k; ++k)
+    {
+        float sum = 0.0;
+        float sumSquares = 0.0;
+        for (size_t i = 0; i < nuValid; ++i)
+        {
+            const float v = V(valid[i])[k];
+            sum += v;
+            sumSquares += v * v;
+        }
+        interaction += sum * sum - sumSquares;
+    }
+#endif
+    return value + 0.5f * interaction;
+}
+
+void FeFeatureWeights::EvaluateBatch(const int* active, const size_t* begin,
+                                     size_t nuMoves, float* values) const
+{
+    for (size_t i = 0; i < nuMoves; ++i)
+        values[i] = EvaluateActive(active + begin[i],
+                                   begin[i + 1] - begin[i]);
+}
+
 bool FeFeatureWeights::IsAllocated() const
 {
     return m_w.size() == m_nuFeatures
     && m_w.capacity() == m_nuFeatures
-    && m_v.size() == m_k
-    && m_v.capacity() == m_k
-    && ( (m_v.size() == 0)
-        ||
-        (
-         m_v[0].size() == m_nuFeatures
-         && m_v[0].capacity() == m_nuFeatures
-         )
-        );
+    && m_kStride % 4 == 0
+    && m_kStride >= m_k
+    && m_v.size() == m_nuFeatures * m_kStride
+    && m_v.capacity() == m_nuFeatures * m_kStride;
 }
 
 FeFeatureWeights FeFeatureWeights::Read(std::istream& stream)
@@ -97,7 +154,7 @@ FeFeatureWeights FeFeatureWeights::Read(std::istream& stream)
             float v;
             stream >> v;
             SG_ASSERT(! stream.fail());
-            f.m_v[j][index] = v;
+            f.V(index, j) = v;
         }
         SG_ASSERT(! stream.fail());
     }
@@ -145,7 +202,7 @@ std::ostream& operator<<(std::ostream& stream,
                    << w.m_w[i] << "\nv = \n";
             for (size_t k = 0; k < w.m_k; ++k)
                 stream << "v[" << k << "][" << i << "] = "
-                       << w.m_v[k][i] << '\n';
+                       << w.V(static_cast<int>(i))[k] << '\n';
         }
     }
     return stream;
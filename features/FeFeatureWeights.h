@@ -28,6 +28,29 @@ public:
     /** Combine v-values of features i and j */
     float Combine(int i, int j) const;
 
+    /** Evaluate a list of active features.
+        Computes the sum of the weights w plus the sum of Combine() over
+        all pairs of features, using the identity
+        sum_{i<j} <v_i,v_j> = 1/2 sum_k ((sum_i v_ik)^2 - sum_i v_ik^2),
+        which needs O(n k) instead of O(n^2 k) operations. Features with
+        IDs that have no weights are skipped. At most MAX_ACTIVE_LENGTH
+        features. */
+    float EvaluateActive(const int* active, size_t nuActive) const;
+
+    /** Evaluate the active features of several moves in one batch.
+        The features of move i are active[begin[i]] to
+        active[begin[i + 1] - 1]; the result is stored in values[i].
+        Same result as calling EvaluateActive() for each move. */
+    void EvaluateBatch(const int* active, const size_t* begin,
+                       size_t nuMoves, float* values) const;
+
+    /** The v-values of feature i.
+        Points to m_k values, followed by zeroes up to m_kStride. */
+    const float* V(int i) const;
+
+    /** The k'th v-value of feature i. */
+    float& V(size_t i, size_t k);
+
     /** Read features in the format produced by Wistuba's tool. */
     static FeFeatureWeights Read(std::istream& stream);
 
@@ -47,9 +70,17 @@ public:
     // length m_nuFeatures
     std::vector<float> m_w;
 
-    // length k of length m_nuFeatures
-    // todo other order should be more cache friendly.
-    std::vector<std::vector<float> > m_v;
+    /** Distance between the v-values of two features in m_v.
+        m_k rounded up to a multiple of 4, so that the v-values of a
+        feature can be processed in blocks of 4 floats with SIMD
+        instructions. */
+    size_t m_kStride;
+
+    /** v-values of all features, feature-major.
+        The v-values of feature i start at m_v[i * m_kStride]. The entries
+        between m_k and m_kStride are zero. Length
+        m_nuFeatures * m_kStride. */
+    std::vector<float> m_v;
 };
 
 //----------------------------------------------------------------------------
@@ -74,15 +105,27 @@ inline float FeFeatureWeights::Combine(int i, int j) const
         //SgDebug() << "skipping feature pair " << i << ", " << j << '\n';
         return 0.0;
     }
+    const float* vi = V(i);
+    const float* vj = V(j);
     float sum = 0.0;
     for (size_t k = 0; k < m_k; ++k)
-    {
-        SG_ASSERT(m_v[k].size() == m_w.size());
-        sum += m_v[k][i] * m_v[k][j];
-    }
+        sum += vi[k] * vj[k];
     return sum;
 }
 
+inline const float* FeFeatureWeights::V(int i) const
+{
+    SG_ASSERT(static_cast<size_t>(i) < m_nuFeatures);
+    return &m_v[i * m_kStride];
+}
+
+inline float& FeFeatureWeights::V(size_t i, size_t k)
+{
+    SG_ASSERT(i < m_nuFeatures);
+    SG_ASSERT(k < m_k);
+    return m_v[i * m_kStride + k];
+}
+
 //----------------------------------------------------------------------------
 
 #endif // FE_FEATURE_WEIGHTS_H
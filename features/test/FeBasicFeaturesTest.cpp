@@ -1012,6 +1012,46 @@ BOOST_AUTO_TEST_CASE(FeBasicFeaturesTest_ClosestStone)
     }
 }
 
+/** Test the distance to the closest stone on a large board, including the
+    limit at MAX_CLOSEST_DISTANCE. */
+BOOST_AUTO_TEST_CASE(FeBasicFeaturesTest_ClosestStone_19x19)
+{
+    GoSetup setup;
+    setup.AddBlack(Pt(1, 1));
+    setup.AddBlack(Pt(19, 19));
+    setup.AddWhite(Pt(10, 10));
+    setup.m_player = SG_BLACK;
+    GoBoard bd(19, setup);
+
+    const FeBasicFeatureSet closestOwn = ClosestOwnFeatures();
+    const FeBasicFeatureSet closestOpp = ClosestOppFeatures();
+
+    {
+        FeBasicFeatureSet features;
+        FeFeatures::FindBasicMoveFeaturesUI(bd, Pt(7, 3), features);
+        TestSingle(features, closestOwn, FE_DIST_CLOSEST_OWN_STONE_14);
+        TestSingle(features, closestOpp, FE_DIST_CLOSEST_OPP_STONE_17);
+    }
+    {
+        FeBasicFeatureSet features;
+        FeFeatures::FindBasicMoveFeaturesUI(bd, Pt(17, 13), features);
+        TestSingle(features, closestOwn, FE_DIST_CLOSEST_OWN_STONE_14);
+        TestSingle(features, closestOpp, FE_DIST_CLOSEST_OPP_STONE_17);
+    }
+    {
+        FeBasicFeatureSet features;
+        FeFeatures::FindBasicMoveFeaturesUI(bd, Pt(10, 1), features);
+        TestSingle(features, closestOwn, FE_DIST_CLOSEST_OWN_STONE_18);
+        TestSingle(features, closestOpp, FE_DIST_CLOSEST_OPP_STONE_18);
+    }
+    {
+        FeBasicFeatureSet features;
+        FeFeatures::FindBasicMoveFeaturesUI(bd, Pt(1, 19), features);
+        TestSingle(features, closestOwn, FE_DIST_CLOSEST_OWN_STONE_20_OR_MORE);
+        TestSingle(features, closestOpp, FE_DIST_CLOSEST_OPP_STONE_20_OR_MORE);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(FeBasicFeaturesTest_FeEvalDetail)
 {
     const double eps = 1.0e-5;
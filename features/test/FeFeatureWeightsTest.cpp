@@ -0,0 +1,101 @@
+//----------------------------------------------------------------------------
+/** @file FeFeatureWeightsTest.cpp
+ Unit tests for FeFeatureWeights. */
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+
+#include <boost/test/auto_unit_test.hpp>
+#include "FeFeatureWeights.h"
+
+#include <algorithm>
+#include <cmath>
+#include "FeBasicFeatures.h"
+#include "GoBoard.h"
+#include "SgRandom.h"
+
+using SgPointUtil::Pt;
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+/** Evaluation as sum of weights and pairwise Combine(). */
+float EvaluatePairwise(const FeActiveArray& active, size_t nuActive,
+                       const FeFeatureWeights& weights)
+{
+    float value = 0.0;
+    for (size_t i = 0; i < nuActive; ++i)
+    {
+        if (static_cast<size_t>(active[i]) < weights.m_w.size())
+            value += weights.m_w[active[i]];
+        for (size_t j = i + 1; j < nuActive; ++j)
+            value += weights.Combine(active[i], active[j]);
+    }
+    return value;
+}
+
+void CheckClose(float value, float expected)
+{
+    BOOST_CHECK_SMALL(value - expected,
+                      1e-4f * std::max(1.f, std::fabs(expected)));
+}
+
+BOOST_AUTO_TEST_CASE(FeFeatureWeightsTest_EvaluateActive)
+{
+    const FeFeatureWeights weights = FeFeatureWeights::ReadDefaultWeights();
+    BOOST_REQUIRE(weights.m_k > 0);
+    BOOST_CHECK_EQUAL(weights.m_kStride % 4, 0u);
+    SgRandom random;
+    for (int n = 0; n < 1000; ++n)
+    {
+        FeActiveArray active;
+        const size_t nuActive = random.Int(MAX_ACTIVE_LENGTH + 1);
+        for (size_t i = 0; i < nuActive; ++i)
+            // Include some IDs without weights, which are skipped
+            active[i] = random.Int(
+                      static_cast<int>(FeFeatureWeights::MAX_FEATURE_INDEX)
+                      + 10);
+        CheckClose(weights.EvaluateActive(active.data(), nuActive),
+                   EvaluatePairwise(active, nuActive, weights));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(FeFeatureWeightsTest_EvaluateActive_NoWeights)
+{
+    const FeFeatureWeights weights(0, 0);
+    const int active[3] = { 1, 2, 3 };
+    BOOST_CHECK_EQUAL(weights.EvaluateActive(active, 3), 0.f);
+}
+
+/** FeFullBoardFeatures::EvaluateFeatures() evaluates all moves in one
+    batch. */
+BOOST_AUTO_TEST_CASE(FeFeatureWeightsTest_EvaluateBatch)
+{
+    const FeFeatureWeights weights = FeFeatureWeights::ReadDefaultWeights();
+    GoBoard bd(19);
+    bd.Play(Pt(4, 4), SG_BLACK);
+    bd.Play(Pt(16, 16), SG_WHITE);
+    bd.Play(Pt(4, 16), SG_BLACK);
+    bd.Play(Pt(5, 16), SG_WHITE);
+    bd.Play(Pt(5, 17), SG_BLACK);
+    FeFullBoardFeatures f(bd);
+    f.FindAllFeatures();
+    const GoEvalArray<float> eval = f.EvaluateFeatures(weights);
+    int nuMoves = 0;
+    for (GoPointList::Iterator it(f.LegalMoves()); it; ++it)
+    {
+        FeActiveArray active;
+        const size_t nuActive = f.Features()[*it].ActiveFeatures(active);
+        CheckClose(eval[*it], EvaluatePairwise(active, nuActive, weights));
+        ++nuMoves;
+    }
+    BOOST_CHECK_EQUAL(nuMoves, 19 * 19 - 5);
+    FeActiveArray active;
+    const size_t nuActive = f.Features()[SG_PASS].ActiveFeatures(active);
+    CheckClose(eval[SG_PASS], EvaluatePairwise(active, nuActive, weights));
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
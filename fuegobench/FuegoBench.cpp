@@ -0,0 +1,485 @@
+//----------------------------------------------------------------------------
+/** @file FuegoBench.cpp
+    See FuegoBench.h */
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+#include "FuegoBench.h"
+
+#include <iomanip>
+#include <limits>
+#include <boost/ref.hpp>
+#include <boost/thread/thread.hpp>
+#include "GoBoard.h"
+#include "GoUctBitBoard.h"
+#include "GoUctBoard.h"
+#include "GoUctGlobalSearch.h"
+#include "GoUctPlayer.h"
+#include "GoUctPlayoutPolicy.h"
+#include "SgDebug.h"
+#include "SgTimer.h"
+#include "SgUctTree.h"
+
+using std::numeric_limits;
+using std::string;
+using std::vector;
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+/** The player of the Fuego engine, see FuegoMainEngine. */
+typedef GoUctPlayer<GoUctGlobalSearch<GoUctPlayoutPolicy<GoUctBoard>,
+                    GoUctPlayoutPolicyFactory<GoUctBoard> >,
+                    GoUctGlobalSearchState<GoUctPlayoutPolicy<GoUctBoard> > >
+PlayerType;
+
+typedef GoUctPlayoutPolicy<GoUctBoard> Policy;
+
+/** Maximum length of a playout like in the search. */
+int MaxPlayoutLength(int boardSize)
+{
+    return 3 * boardSize * boardSize;
+}
+
+/** Play a playout with the policy until two passes in a row.
+    @param bd The board, must be initialized
+    @param policy A policy for this board
+    @param[out] moves If not null, the moves of the playout are appended
+    @return The number of moves played */
+template<class BOARD>
+int Playout(BOARD& bd, GoUctPlayoutPolicy<BOARD>& policy,
+            vector<SgPoint>* moves)
+{
+    const int maxLength = MaxPlayoutLength(bd.Size());
+    int length = 0;
+    int nuPasses = 0;
+    policy.StartPlayout();
+    while (length < maxLength)
+    {
+        SgPoint move = policy.GenerateMove();
+        if (move == SG_PASS)
+        {
+            if (++nuPasses == 2)
+                break;
+        }
+        else
+            nuPasses = 0;
+        bd.Play(move);
+        policy.OnPlay();
+        ++length;
+        if (moves != 0)
+            moves->push_back(move);
+    }
+    policy.EndPlayout();
+    return length;
+}
+
+/** Generate a game with the playout policy from the empty board. */
+void GenerateGame(int boardSize, vector<SgPoint>& moves)
+{
+    GoBoard bd(boardSize);
+    GoUctBoard uctBd(bd);
+    GoUctPlayoutPolicyParam param;
+    Policy policy(uctBd, param);
+    uctBd.Init(bd);
+    moves.clear();
+    Playout(uctBd, policy, &moves);
+}
+
+/** Function object for RunTasks() that replays a game on a GoBoard. */
+class BoardTask
+{
+public:
+    double m_rate;
+
+    BoardTask(int boardSize, double time, const vector<SgPoint>& game);
+
+    void operator()();
+
+private:
+    int m_boardSize;
+
+    double m_time;
+
+    const vector<SgPoint>& m_game;
+};
+
+BoardTask::BoardTask(int boardSize, double time, const vector<SgPoint>& game)
+    : m_rate(0),
+      m_boardSize(boardSize),
+      m_time(time),
+      m_game(game)
+{ }
+
+void BoardTask::operator()()
+{
+    GoBoard bd(m_boardSize);
+    double count = 0;
+    SgTimer timer;
+    do
+    {
+        for (vector<SgPoint>::const_iterator it = m_game.begin();
+             it != m_game.end(); ++it)
+            bd.Play(*it);
+        for (size_t i = 0; i < m_game.size(); ++i)
+            bd.Undo();
+        count += double(m_game.size());
+    }
+    while (timer.GetTime() < m_time);
+    m_rate = count / timer.GetTime();
+}
+
+/** Function object for RunTasks() that plays playouts from the empty
+    board.
+    @tparam BOARD GoUctBoard or GoUctBitBoard */
+template<class BOARD>
+class PlayoutTask
+{
+public:
+    double m_playoutRate;
+
+    double m_moveRate;
+
+    PlayoutTask(int boardSize, double time);
+
+    void operator()();
+
+private:
+    int m_boardSize;
+
+    double m_time;
+};
+
+template<class BOARD>
+PlayoutTask<BOARD>::PlayoutTask(int boardSize, double time)
+    : m_playoutRate(0),
+      m_moveRate(0),
+      m_boardSize(boardSize),
+      m_time(time)
+{ }
+
+template<class BOARD>
+void PlayoutTask<BOARD>::operator()()
+{
+    GoBoard bd(m_boardSize);
+    BOARD uctBd(bd);
+    GoUctPlayoutPolicyParam param;
+    GoUctPlayoutPolicy<BOARD> policy(uctBd, param);
+    double nuPlayouts = 0;
+    double nuMoves = 0;
+    SgTimer timer;
+    do
+    {
+        uctBd.Init(bd);
+        nuMoves += Playout(uctBd, policy, 0);
+        ++nuPlayouts;
+    }
+    while (timer.GetTime() < m_time);
+    double time = timer.GetTime();
+    m_playoutRate = nuPlayouts / time;
+    m_moveRate = nuMoves / time;
+}
+
+/** Run each task in its own thread and wait for all threads. */
+template<class TASK>
+void RunTasks(vector<TASK>& tasks)
+{
+    boost::thread_group threads;
+    for (size_t i = 0; i < tasks.size(); ++i)
+        threads.create_thread(boost::ref(tasks[i]));
+    threads.join_all();
+}
+
+template<class BOARD>
+void RunPlayoutTasks(const string& name, int boardSize,
+                     unsigned int nuThreads, double time,
+                     vector<FuegoBench::Result>& results)
+{
+    vector<PlayoutTask<BOARD> > tasks(nuThreads,
+                                      PlayoutTask<BOARD>(boardSize, time));
+    RunTasks(tasks);
+    double playoutRate = 0;
+    double moveRate = 0;
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        playoutRate += tasks[i].m_playoutRate;
+        moveRate += tasks[i].m_moveRate;
+    }
+    results.push_back(FuegoBench::Result(name, boardSize, nuThreads,
+                                         "playouts_per_sec", playoutRate,
+                                         "1/s"));
+    results.push_back(FuegoBench::Result(name, boardSize, nuThreads,
+                                         "moves_per_sec", moveRate, "1/s"));
+}
+
+/** Descend from the root to a leaf selecting the child with the highest
+    bound.
+    @param search
+    @param tree
+    @param[out] nodes If not null, the root and the selected nodes are
+    appended
+    @return The number of nodes selected. */
+size_t Descend(const SgUctSearch& search, const SgUctTree& tree,
+               vector<const SgUctNode*>* nodes = 0)
+{
+    size_t nuNodes = 0;
+    const SgUctNode* node = &tree.Root();
+    if (nodes != 0)
+        nodes->push_back(node);
+    while (node->HasChildren())
+    {
+        const SgUctNode* bestChild = 0;
+        SgUctValue bestBound = -numeric_limits<SgUctValue>::max();
+        for (SgUctChildIterator it(tree, *node); it; ++it)
+        {
+            const SgUctNode& child = *it;
+            SgUctValue bound = search.GetBound(search.Rave(), *node, child);
+            if (bestChild == 0 || bound > bestBound)
+            {
+                bestChild = &child;
+                bestBound = bound;
+            }
+        }
+        node = bestChild;
+        ++nuNodes;
+        if (nodes != 0)
+            nodes->push_back(node);
+    }
+    return nuNodes;
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
+
+FuegoBench::Result::Result(const string& benchmark, int boardSize,
+                           unsigned int threads, const string& metric,
+                           double value, const string& unit)
+    : m_benchmark(benchmark),
+      m_boardSize(boardSize),
+      m_threads(threads),
+      m_metric(metric),
+      m_value(value),
+      m_unit(unit)
+{ }
+
+void FuegoBench::BoardBenchmark(int boardSize, unsigned int nuThreads,
+                                double time, vector<Result>& results)
+{
+    vector<SgPoint> game;
+    GenerateGame(boardSize, game);
+    vector<BoardTask> tasks(nuThreads, BoardTask(boardSize, time, game));
+    RunTasks(tasks);
+    double rate = 0;
+    for (size_t i = 0; i < tasks.size(); ++i)
+        rate += tasks[i].m_rate;
+    results.push_back(Result("board", boardSize, nuThreads,
+                             "play_undo_per_sec", rate, "1/s"));
+}
+
+void FuegoBench::KnowledgeBenchmark(int boardSize, double time,
+                                    vector<Result>& results)
+{
+    vector<SgPoint> game;
+    GenerateGame(boardSize, game);
+    GoBoard bd(boardSize);
+    PlayerType player(bd);
+    SgUctSearch& search = player.GlobalSearch();
+    search.SetNumberThreads(1);
+    vector<SgUctMoveInfo> moves;
+    SgUctProvenType provenType;
+    double count = 0;
+    double totalTime = 0;
+    // Positions at the start, in the middle and near the end of the game
+    const int NU_POSITIONS = 3;
+    for (int i = 0; i < NU_POSITIONS; ++i)
+    {
+        size_t end = game.size() * i / NU_POSITIONS;
+        for (size_t j = bd.MoveNumber(); j < end; ++j)
+            bd.Play(game[j]);
+        player.UpdateSubscriber();
+        search.StartSearch();
+        SgUctThreadState& state = search.ThreadState(0);
+        state.GameStart();
+        SgTimer timer;
+        do
+        {
+            state.GenerateAllMoves(0, moves, provenType);
+            ++count;
+        }
+        while (timer.GetTime() < time / NU_POSITIONS);
+        totalTime += timer.GetTime();
+        search.EndSearch();
+    }
+    results.push_back(Result("knowledge", boardSize, 1,
+                             "knowledge_us_per_node",
+                             1e6 * totalTime / count, "us"));
+}
+
+void FuegoBench::BitBoardPlayoutBenchmark(int boardSize,
+                                          unsigned int nuThreads, double time,
+                                          vector<Result>& results)
+{
+    RunPlayoutTasks<GoUctBitBoard>("playout_bitboard", boardSize, nuThreads,
+                                   time, results);
+}
+
+void FuegoBench::PlayoutBenchmark(int boardSize, unsigned int nuThreads,
+                                  double time, vector<Result>& results)
+{
+    RunPlayoutTasks<GoUctBoard>("playout", boardSize, nuThreads, time,
+                                results);
+    results.push_back(Result("playout", boardSize, nuThreads, "board_hash",
+                             GOUCT_BOARD_HASH, "bool"));
+}
+
+void FuegoBench::RaveBenchmark(int boardSize, SgUctValue games, double time,
+                               vector<Result>& results)
+{
+    GoBoard bd(boardSize);
+    PlayerType player(bd);
+    SgUctSearch& search = player.GlobalSearch();
+    search.SetNumberThreads(1);
+    vector<SgMove> sequence;
+    search.Search(games, numeric_limits<double>::max(), sequence);
+    // Game along the path of highest bounds, continued with the moves of a
+    // playout game (the moves need not be legal for the RAVE update)
+    SgUctThreadState& state = search.ThreadState(0);
+    SgUctGameInfo& info = state.m_gameInfo;
+    info.Clear(search.NumberPlayouts(), search.MaxGameLength());
+    vector<const SgUctNode*> nodes;
+    Descend(search, search.Tree(), &nodes);
+    for (size_t i = 1; i < nodes.size(); ++i)
+        info.AddInTreeMove(nodes[i]->Move());
+    info.m_nodes = nodes;
+    vector<SgPoint> game;
+    GenerateGame(boardSize, game);
+    for (size_t i = 0; i < search.NumberPlayouts(); ++i)
+    {
+        info.StartPlayout(i);
+        for (size_t j = info.m_nuMovesInTree; j < game.size(); ++j)
+            info.m_sequence[i].PushBack(game[j]);
+        info.m_eval[i] = 1;
+    }
+    double nuChildren = 0;
+    for (size_t i = 0; i < nodes.size(); ++i)
+        nuChildren += nodes[i]->NuChildren();
+    double count = 0;
+    SgTimer timer;
+    do
+    {
+        search.UpdateRaveValues(state);
+        ++count;
+    }
+    while (timer.GetTime() < time);
+    results.push_back(Result("rave", boardSize, 1, "rave_nodes",
+                             double(nodes.size()), "nodes"));
+    results.push_back(Result("rave", boardSize, 1, "rave_us_per_game",
+                             1e6 * timer.GetTime() / count, "us"));
+    if (nuChildren > 0)
+        results.push_back(Result("rave", boardSize, 1, "rave_ns_per_child",
+                                 1e9 * timer.GetTime() / (count * nuChildren),
+                                 "ns"));
+}
+
+void FuegoBench::ScalingBenchmark(int boardSize,
+                                  const vector<unsigned int>& threads,
+                                  SgUctValue games, vector<Result>& results)
+{
+    double baseGamesPerSecond = 0;
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        const unsigned int nuThreads = threads[i];
+        SgDebug() << "fuegobench: scaling " << boardSize << " threads "
+                  << nuThreads << '\n';
+        GoBoard bd(boardSize);
+        PlayerType player(bd);
+        SgUctSearch& search = player.GlobalSearch();
+        search.SetNumberThreads(nuThreads);
+        search.SetLockFree(true);
+        vector<SgMove> sequence;
+        search.Search(games * nuThreads, numeric_limits<double>::max(),
+                      sequence);
+        const double gamesPerSecond = search.Statistics().m_gamesPerSecond;
+        if (i == 0)
+            baseGamesPerSecond = gamesPerSecond;
+        results.push_back(Result("scaling", boardSize, nuThreads,
+                                 "games_per_sec", gamesPerSecond, "1/s"));
+        results.push_back(Result("scaling", boardSize, nuThreads,
+                                 "games_per_sec_per_thread",
+                                 gamesPerSecond / nuThreads, "1/s"));
+        if (baseGamesPerSecond > 0)
+            results.push_back(Result("scaling", boardSize, nuThreads,
+                                     "speedup",
+                                     gamesPerSecond / baseGamesPerSecond,
+                                     ""));
+    }
+}
+
+void FuegoBench::SearchBenchmark(int boardSize, unsigned int nuThreads,
+                                 SgUctValue games, vector<Result>& results)
+{
+    GoBoard bd(boardSize);
+    PlayerType player(bd);
+    SgUctSearch& search = player.GlobalSearch();
+    search.SetNumberThreads(nuThreads);
+    vector<SgMove> sequence;
+    search.Search(games, numeric_limits<double>::max(), sequence);
+    const SgUctSearchStat& stat = search.Statistics();
+    const SgUctTree& tree = search.Tree();
+    results.push_back(Result("search", boardSize, nuThreads, "games_per_sec",
+                             stat.m_gamesPerSecond, "1/s"));
+    results.push_back(Result("search", boardSize, nuThreads, "moves_in_tree",
+                             double(stat.m_movesInTree.Mean()), "moves"));
+    results.push_back(Result("search", boardSize, nuThreads, "tree_nodes",
+                             double(tree.NuNodes()), "nodes"));
+    results.push_back(Result("search", boardSize, nuThreads, "node_bytes",
+                             double(sizeof(SgUctNode)), "bytes"));
+    // Measure at least this time for the tree descent
+    const double DESCENT_TIME = 0.2;
+    double nuNodes = 0;
+    SgTimer timer;
+    do
+        nuNodes += double(Descend(search, tree));
+    while (timer.GetTime() < DESCENT_TIME && nuNodes > 0);
+    if (nuNodes > 0)
+        results.push_back(Result("search", boardSize, nuThreads,
+                                 "descent_ns_per_node",
+                                 1e9 * timer.GetTime() / nuNodes, "ns"));
+}
+
+void FuegoBench::WriteCsv(std::ostream& out, const vector<Result>& results)
+{
+    out << "benchmark,size,threads,metric,value,unit\n";
+    for (vector<Result>::const_iterator it = results.begin();
+         it != results.end(); ++it)
+        out << it->m_benchmark << ',' << it->m_boardSize << ','
+            << it->m_threads << ',' << it->m_metric << ','
+            << std::setprecision(6) << it->m_value << ',' << it->m_unit
+            << '\n';
+}
+
+void FuegoBench::WriteJson(std::ostream& out, const string& version,
+                           const vector<Result>& results)
+{
+    out << "{\n"
+        << "  \"version\": \"" << version << "\",\n"
+        << "  \"results\": [\n";
+    for (vector<Result>::const_iterator it = results.begin();
+         it != results.end(); ++it)
+    {
+        if (it != results.begin())
+            out << ",\n";
+        out << "    {\"benchmark\": \"" << it->m_benchmark << "\", "
+            << "\"size\": " << it->m_boardSize << ", "
+            << "\"threads\": " << it->m_threads << ", "
+            << "\"metric\": \"" << it->m_metric << "\", "
+            << "\"value\": " << std::setprecision(6) << it->m_value << ", "
+            << "\"unit\": \"" << it->m_unit << "\"}";
+    }
+    out << "\n  ]\n"
+        << "}\n";
+}
+
+//----------------------------------------------------------------------------
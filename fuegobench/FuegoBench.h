@@ -0,0 +1,109 @@
+//----------------------------------------------------------------------------
+/** @file FuegoBench.h
+    Performance benchmarks of the Fuego engine. */
+//----------------------------------------------------------------------------
+
+#ifndef FUEGO_BENCH_H
+#define FUEGO_BENCH_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "SgUctValue.h"
+
+//----------------------------------------------------------------------------
+
+/** Performance benchmarks of the board, playout and search classes.
+    Each benchmark adds one or more FuegoBenchResult to a list, which can
+    be written in a machine-readable format for comparing builds. The
+    benchmarks that use threads run independent copies of the measured
+    objects in each thread (except SearchBenchmark(), which uses the threads
+    of the search) and report the sum of the rates of all threads. */
+namespace FuegoBench
+{
+
+/** Result of a benchmark measurement. */
+struct Result
+{
+    /** Name of the benchmark. */
+    std::string m_benchmark;
+
+    int m_boardSize;
+
+    unsigned int m_threads;
+
+    /** Name of the measured value. */
+    std::string m_metric;
+
+    double m_value;
+
+    std::string m_unit;
+
+    Result(const std::string& benchmark, int boardSize, unsigned int threads,
+           const std::string& metric, double value, const std::string& unit);
+};
+
+/** Like PlayoutBenchmark(), but with GoUctBitBoard instead of GoUctBoard.
+    Adds the same metrics under the benchmark name @c playout_bitboard. */
+void BitBoardPlayoutBenchmark(int boardSize, unsigned int nuThreads,
+                              double time, std::vector<Result>& results);
+
+/** Rate of GoBoard::Play() and GoBoard::Undo().
+    Replays a game generated by the playout policy and takes it back.
+    Adds the metric @c play_undo_per_sec (number of Play/Undo pairs). */
+void BoardBenchmark(int boardSize, unsigned int nuThreads, double time,
+                    std::vector<Result>& results);
+
+/** Knowledge computation at a node of the search tree.
+    Measures SgUctThreadState::GenerateAllMoves() as called when a node
+    is expanded (including the prior knowledge of GoUctGlobalSearchState) in
+    positions of a game generated by the playout policy.
+    Adds the metric @c knowledge_us_per_node. */
+void KnowledgeBenchmark(int boardSize, double time,
+                        std::vector<Result>& results);
+
+/** Playouts with GoUctBoard and GoUctPlayoutPolicy from the empty board.
+    Adds the metrics @c playouts_per_sec and @c moves_per_sec. Also adds
+    the metric @c board_hash, which is 1 if GoUctBoard was compiled with
+    GOUCT_BOARD_HASH, to compare the playout speed of builds with and
+    without the incremental hash code. */
+void PlayoutBenchmark(int boardSize, unsigned int nuThreads, double time,
+                      std::vector<Result>& results);
+
+/** Update of the RAVE values after a game (SgUctSearch::UpdateRaveValues()).
+    Runs a search with the default player of Fuego from the empty board
+    and measures the update for a game that follows the path of the
+    highest bounds in the tree and continues with the moves of a game
+    generated by the playout policy. Adds the metrics @c rave_nodes (the
+    number of in-tree nodes of the game), @c rave_us_per_game and
+    @c rave_ns_per_child (time per child of the in-tree nodes). */
+void RaveBenchmark(int boardSize, SgUctValue games, double time,
+                   std::vector<Result>& results);
+
+/** Throughput of the lock-free search for an increasing number of threads.
+    Runs a search with the default player of Fuego from the empty board for
+    each number of threads in @c threads, with @c games games per thread.
+    Adds the metrics @c games_per_sec, @c games_per_sec_per_thread and
+    @c speedup (relative to the first number of threads). The speedup is
+    only meaningful if the machine has enough cores for the threads. */
+void ScalingBenchmark(int boardSize, const std::vector<unsigned int>& threads,
+                      SgUctValue games, std::vector<Result>& results);
+
+/** Search with the default player of Fuego from the empty board.
+    Adds the metrics @c games_per_sec, @c moves_in_tree and @c tree_nodes.
+    After the search, measures the cost of descending the tree with
+    SgUctSearch::GetBound() (metric @c descent_ns_per_node) and adds the
+    size of a tree node (metric @c node_bytes). */
+void SearchBenchmark(int boardSize, unsigned int nuThreads, SgUctValue games,
+                     std::vector<Result>& results);
+
+void WriteCsv(std::ostream& out, const std::vector<Result>& results);
+
+void WriteJson(std::ostream& out, const std::string& version,
+               const std::vector<Result>& results);
+
+} // namespace FuegoBench
+
+//----------------------------------------------------------------------------
+
+#endif // FUEGO_BENCH_H
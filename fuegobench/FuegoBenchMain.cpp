@@ -0,0 +1,280 @@
+//----------------------------------------------------------------------------
+/** @file FuegoBenchMain.cpp
+    Main function for FuegoBench. */
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "FuegoBench.h"
+#include "GoInit.h"
+#include "SgDebug.h"
+#include "SgException.h"
+#include "SgInit.h"
+#include "SgPoint.h"
+#include "SgRandom.h"
+#include "SgTime.h"
+
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/cmdline.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <boost/program_options/parsers.hpp>
+
+using std::string;
+using std::vector;
+namespace po = boost::program_options;
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+/** @name Settings from command line options */
+// @{
+
+/** Comma-separated list of benchmarks */
+string g_benchmarks;
+
+/** Comma-separated list of board sizes */
+string g_sizes;
+
+/** Maximum number of threads */
+unsigned int g_threads;
+
+/** Time per measurement of the board, playout, knowledge and rave
+    benchmarks */
+double g_time;
+
+/** Number of games of the search and rave benchmarks */
+int g_games;
+
+string g_format;
+
+string g_output;
+
+bool g_quiet;
+
+int g_srand;
+
+// @} // @name
+
+/** Split a comma-separated list. */
+vector<string> SplitList(const string& s)
+{
+    vector<string> result;
+    std::istringstream in(s);
+    string item;
+    while (getline(in, item, ','))
+        if (! item.empty())
+            result.push_back(item);
+    return result;
+}
+
+vector<int> ParseSizes(const string& s)
+{
+    vector<int> result;
+    vector<string> items = SplitList(s);
+    for (vector<string>::const_iterator it = items.begin(); it != items.end();
+         ++it)
+    {
+        std::istringstream in(*it);
+        int size;
+        in >> size;
+        if (! in || size < SG_MIN_SIZE || size > SG_MAX_SIZE)
+            throw SgException("invalid board size: " + *it);
+        result.push_back(size);
+    }
+    return result;
+}
+
+/** Thread numbers 1, 2, 4, ... up to and including maxThreads. */
+vector<unsigned int> ThreadCounts(unsigned int maxThreads)
+{
+    vector<unsigned int> result;
+    for (unsigned int n = 1; n < maxThreads; n *= 2)
+        result.push_back(n);
+    result.push_back(maxThreads);
+    return result;
+}
+
+void RunBenchmarks(vector<FuegoBench::Result>& results)
+{
+    const vector<string> benchmarks = SplitList(g_benchmarks);
+    const vector<int> sizes = ParseSizes(g_sizes);
+    const vector<unsigned int> threads = ThreadCounts(g_threads);
+    for (vector<string>::const_iterator it = benchmarks.begin();
+         it != benchmarks.end(); ++it)
+    {
+        const string& name = *it;
+        if (name != "board" && name != "knowledge" && name != "playout"
+            && name != "playout_bitboard" && name != "rave"
+            && name != "scaling" && name != "search")
+            throw SgException("unknown benchmark: " + name);
+        for (size_t i = 0; i < sizes.size(); ++i)
+        {
+            if (name == "knowledge")
+            {
+                SgDebug() << "fuegobench: " << name << ' ' << sizes[i]
+                          << '\n';
+                FuegoBench::KnowledgeBenchmark(sizes[i], g_time, results);
+                continue;
+            }
+            if (name == "rave")
+            {
+                SgDebug() << "fuegobench: " << name << ' ' << sizes[i]
+                          << '\n';
+                FuegoBench::RaveBenchmark(sizes[i], SgUctValue(g_games),
+                                          g_time, results);
+                continue;
+            }
+            if (name == "scaling")
+            {
+                FuegoBench::ScalingBenchmark(sizes[i], threads,
+                                             SgUctValue(g_games), results);
+                continue;
+            }
+            for (size_t j = 0; j < threads.size(); ++j)
+            {
+                SgDebug() << "fuegobench: " << name << ' ' << sizes[i]
+                          << " threads " << threads[j] << '\n';
+                if (name == "board")
+                    FuegoBench::BoardBenchmark(sizes[i], threads[j], g_time,
+                                               results);
+                else if (name == "playout")
+                    FuegoBench::PlayoutBenchmark(sizes[i], threads[j],
+                                                 g_time, results);
+                else if (name == "playout_bitboard")
+                    FuegoBench::BitBoardPlayoutBenchmark(sizes[i], threads[j],
+                                                         g_time, results);
+                else
+                    FuegoBench::SearchBenchmark(sizes[i], threads[j],
+                                                SgUctValue(g_games), results);
+            }
+        }
+    }
+}
+
+void WriteResults(std::ostream& out,
+                  const vector<FuegoBench::Result>& results)
+{
+    if (g_format == "csv")
+        FuegoBench::WriteCsv(out, results);
+    else
+    {
+#ifdef VERSION
+        const string version = VERSION;
+#else
+        const string version = "(" __DATE__ ")";
+#endif
+        FuegoBench::WriteJson(out, version, results);
+    }
+}
+
+void Help(po::options_description& desc)
+{
+    std::cout << "Usage: fuegobench [options]\n" << desc << '\n';
+    exit(1);
+}
+
+void ParseOptions(int argc, char** argv)
+{
+    po::options_description desc("Options");
+    desc.add_options()
+        ("benchmarks",
+         po::value<string>(&g_benchmarks)->default_value(
+                  "board,playout,playout_bitboard,knowledge,rave,search"),
+         "comma-separated list of benchmarks "
+         "(board|playout|playout_bitboard|knowledge|rave|scaling|search)")
+        ("format",
+         po::value<string>(&g_format)->default_value("json"),
+         "output format (json|csv)")
+        ("games",
+         po::value<int>(&g_games)->default_value(10000),
+         "number of games of the search and rave benchmarks "
+         "(per thread in the scaling benchmark)")
+        ("help", "displays this help and exit")
+        ("output",
+         po::value<string>(&g_output)->default_value(""),
+         "write results to file instead of standard output")
+        ("quiet", "don't print progress and debug messages")
+        ("sizes",
+         po::value<string>(&g_sizes)->default_value("9,13,19"),
+         "comma-separated list of board sizes")
+        ("srand",
+         po::value<int>(&g_srand)->default_value(1),
+         "set random seed (-1:none, 0:time(0))")
+        ("threads",
+         po::value<unsigned int>(&g_threads)->default_value(1),
+         "maximum number of threads (runs 1, 2, 4, ... up to this number)")
+        ("time",
+         po::value<double>(&g_time)->default_value(1),
+         "time in seconds per measurement of board, playout, knowledge "
+         "and rave");
+    po::variables_map vm;
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+    }
+    catch (...)
+    {
+        Help(desc);
+    }
+    if (vm.count("help"))
+        Help(desc);
+    if (vm.count("quiet"))
+        g_quiet = true;
+    if (g_threads < 1)
+        throw SgException("number of threads must be at least 1");
+    if (g_format != "json" && g_format != "csv")
+        throw SgException("invalid format: " + g_format);
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        ParseOptions(argc, argv);
+    }
+    catch (const SgException& e)
+    {
+        SgDebug() << e.what() << "\n";
+        return 1;
+    }
+    if (g_quiet)
+        SgDebugToNull();
+    SgRandom::SetSeed(g_srand);
+    try
+    {
+        SgInit();
+        GoInit();
+        // The benchmarks with threads measure rates in real time
+        SgTime::SetDefaultMode(SG_TIME_REAL);
+        vector<FuegoBench::Result> results;
+        RunBenchmarks(results);
+        if (g_output.empty())
+            WriteResults(std::cout, results);
+        else
+        {
+            std::ofstream out(g_output.c_str());
+            if (! out)
+                throw SgException("cannot write " + g_output);
+            WriteResults(out, results);
+        }
+        GoFini();
+        SgFini();
+    }
+    catch (const std::exception& e)
+    {
+        SgDebug() << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------
@@ -22,6 +22,7 @@
 #include "SgException.h"
 #include "SgInit.h"
 #include "SgPlatform.h"
+#include "SgSharedMemorySynchronizer.h"
 
 using boost::filesystem::path;
 using std::ostream;
@@ -86,6 +87,13 @@ struct CommandLineOptions {
     const char* m_programPath;
     
     int m_srand;
+
+    /** Name of shared memory for synchronizing with other processes */
+    string m_syncName;
+
+    int m_syncProcesses;
+
+    int m_syncRank;
     
     vector<string> m_inputFiles;
 };
@@ -109,7 +117,16 @@ void ParseOptions(int argc, char** argv, struct CommandLineOptions& options)
          "set random seed (-1:none, 0:time(0))")
         ("size", 
          po::value<int>(&options.m_fixedBoardSize)->default_value(0),
-         "initial (and fixed) board size");
+         "initial (and fixed) board size")
+        ("sync-name",
+         po::value<std::string>(&options.m_syncName)->default_value(""),
+         "search together with other processes using this shared memory name")
+        ("sync-processes",
+         po::value<int>(&options.m_syncProcesses)->default_value(1),
+         "number of processes for sync-name")
+        ("sync-rank",
+         po::value<int>(&options.m_syncRank)->default_value(0),
+         "rank of this process for sync-name (0 is root process)");
     po::options_description hiddenOptions;
     hiddenOptions.add_options()
         ("input-file", po::value<vector<string> >(&options.m_inputFiles),
@@ -188,6 +205,11 @@ int main(int argc, char** argv)
                                options.m_programPath,
                                ! options.m_allowHandicap);
         GoGtpAssertionHandler assertionHandler(engine);
+        if (options.m_syncName != "")
+            engine.SetMpiSynchronizer(
+                SgSharedMemorySynchronizer::Create(options.m_syncName,
+                                                   options.m_syncRank,
+                                                   options.m_syncProcesses));
         if (options.m_maxGames >= 0)
             engine.SetMaxClearBoard(options.m_maxGames);
         if (options.m_useBook)
@@ -68,4 +68,13 @@ void FuegoMainEngine::CmdVersion(GtpCommand& cmd)
     cmd << FuegoMainUtil::Version();
 }
 
+void FuegoMainEngine::SetMpiSynchronizer(
+                                        const SgMpiSynchronizerHandle& handle)
+{
+    GoGtpEngine::SetMpiSynchronizer(handle);
+    PlayerType* player = dynamic_cast<PlayerType*>(m_player);
+    if (player != 0)
+        player->SetMpiSynchronizer(handle);
+}
+
 //----------------------------------------------------------------------------
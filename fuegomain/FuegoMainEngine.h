@@ -28,6 +28,9 @@ public:
     void CmdName(GtpCommand& cmd);
     void CmdVersion(GtpCommand& cmd);
 
+    /** Set the synchronizer of the engine and of the player. */
+    void SetMpiSynchronizer(const SgMpiSynchronizerHandle& handle);
+
 private:
     GoUctCommands m_uctCommands;
 
@@ -21,15 +21,14 @@ bool LoadBookFile(GoBook& book, const boost::filesystem::path& file)
 {
     std::string nativeFile = SgStringUtil::GetNativeFileName(file);
     SgDebug() << "Loading opening book from '" << nativeFile << "'... ";
-    std::ifstream in(nativeFile.c_str());
-    if (! in)
+    if (! std::ifstream(nativeFile.c_str()))
     {
         SgDebug() << "not found\n";
         return false;
     }
     try
     {
-        book.Read(in);
+        book.Read(nativeFile);
     }
     catch (const SgException& e)
     {
@@ -40,6 +39,45 @@ bool LoadBookFile(GoBook& book, const boost::filesystem::path& file)
     return true;
 }
 
+/** Check if a compiled book is older than the book it was created from.
+    The compiled book is not updated automatically, when the text book is
+    edited. */
+bool IsOutdated(const boost::filesystem::path& compiledFile,
+                const boost::filesystem::path& textFile)
+{
+    if (! boost::filesystem::exists(textFile))
+        return false;
+    try
+    {
+        return boost::filesystem::last_write_time(compiledFile)
+            < boost::filesystem::last_write_time(textFile);
+    }
+    catch (const boost::filesystem::filesystem_error&)
+    {
+        return false;
+    }
+}
+
+/** Load the compiled book "book.bin", if it exists in the directory and is
+    not older than the book "book.dat" in text format, or "book.dat". */
+bool LoadBookFromDir(GoBook& book, const boost::filesystem::path& dir)
+{
+    const boost::filesystem::path compiledFile = dir / "book.bin";
+    const boost::filesystem::path textFile = dir / "book.dat";
+    if (boost::filesystem::exists(compiledFile))
+    {
+        if (IsOutdated(compiledFile, textFile))
+            SgWarning() << "Ignoring opening book '"
+                        << SgStringUtil::GetNativeFileName(compiledFile)
+                        << "', which is older than '"
+                        << SgStringUtil::GetNativeFileName(textFile)
+                        << "'\n";
+        else if (LoadBookFile(book, compiledFile))
+            return true;
+    }
+    return LoadBookFile(book, textFile);
+}
+
 } // namespace
 
 //----------------------------------------------------------------------------
@@ -47,16 +85,15 @@ bool LoadBookFile(GoBook& book, const boost::filesystem::path& file)
 void FuegoMainUtil::LoadBook(GoBook& book,
                              const boost::filesystem::path& programDir)
 {
-    const std::string fileName = "book.dat";
     using boost::filesystem::path;
     #ifdef ABS_TOP_SRCDIR
-        if (LoadBookFile(book, path(ABS_TOP_SRCDIR) / "book" / fileName))
+        if (LoadBookFromDir(book, path(ABS_TOP_SRCDIR) / "book"))
             return;
     #endif
-    if (LoadBookFile(book, programDir / fileName))
+    if (LoadBookFromDir(book, programDir))
         return;
     #if defined(DATADIR) && defined(PACKAGE)
-        if (LoadBookFile(book, path(DATADIR) / PACKAGE / fileName))
+        if (LoadBookFromDir(book, path(DATADIR) / PACKAGE))
             return;
     #endif
     throw SgException("Could not find opening book.");
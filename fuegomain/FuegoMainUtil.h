@@ -16,7 +16,11 @@ namespace FuegoMainUtil
 {
 
     /** Try to load opening book from a set of known paths.
-        The file name is "book.dat". The paths tried are (in this order):
+        The file name is "book.bin" for a compiled book (see
+        GoCompiledBook), which is preferred if it exists and is not older
+        than "book.dat", or "book.dat" for the text format. An outdated
+        "book.bin" is ignored with a warning.
+        The paths tried are (in this order):
         - the directory of the executable
         - ABS_TOP_SRCDIR/book
         - DATADIR/PACKAGE
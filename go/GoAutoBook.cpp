@@ -6,6 +6,9 @@
 #include "SgSystem.h"
 #include "GoAutoBook.h"
 
+#include <algorithm>
+#include <boost/filesystem/operations.hpp>
+
 //----------------------------------------------------------------------------
 
 GoAutoBookState::GoAutoBookState(const GoBoard& brd)
@@ -74,71 +77,284 @@ GoAutoBookParam::GoAutoBookParam()
 
 //----------------------------------------------------------------------------
 
-GoAutoBook::GoAutoBook(const std::string& filename,
-                       const GoAutoBookParam& param)
-    : m_param(param), 
-      m_filename(filename)
+namespace {
+
+const uint64_t EMPTY = static_cast<uint64_t>(-1);
+
+const std::size_t MIN_INDEX_SIZE = 1024;
+
+/** Parse a line of the log.
+    @return false, if the line is not a valid entry */
+bool ParseLine(const std::string& line, SgHashCode& hash, SgBookNode& node)
+{
+    const std::string::size_type tab = line.find('\t');
+    if (line.size() < 19 || tab == std::string::npos)
+        return false;
+    hash.FromString(line.substr(0, tab));
+    node = SgBookNode(line.substr(tab + 1));
+    return true;
+}
+
+std::string FormatLine(const SgHashCode& hash, const SgBookNode& node)
+{
+    return hash.ToString() + '\t' + node.ToString() + '\n';
+}
+
+} // namespace
+
+GoAutoBookStore::GoAutoBookStore(const std::string& filename)
+    : m_filename(filename),
+      m_nuIndexed(0),
+      m_nuRecords(0),
+      m_fileSize(0)
+{
+    {
+        std::ifstream is(filename.c_str());
+        if (! is)
+        {
+            std::ofstream of(filename.c_str());
+            if (! of)
+                throw SgException("Invalid file name!");
+        }
+    }
+    ReadLog();
+}
+
+GoAutoBookStore::~GoAutoBookStore()
+{ }
+
+void GoAutoBookStore::Compact()
 {
-    std::ifstream is(filename.c_str());
-    if (! is)
+    Flush();
+    const std::string tmpFilename = m_filename + ".tmp";
     {
-        std::ofstream of(filename.c_str());
-        if (! of)
-            throw SgException("Invalid file name!");
-        of.close();
+        std::ofstream out(tmpFilename.c_str(), std::ios::binary);
+        Write(out);
+        out.close();
+        if (! out)
+            throw SgException("GoAutoBookStore: error writing "
+                              + tmpFilename);
     }
-    else
+    m_in.close();
+    // Replacing the file by renaming is atomic, the old log stays valid
+    // if the program is interrupted before
+    boost::filesystem::rename(tmpFilename, m_filename);
+    ReadLog();
+}
+
+std::size_t GoAutoBookStore::Find(const SgHashCode& hash) const
+{
+    const std::size_t mask = m_index.size() - 1;
+    for (std::size_t i = hash.Hash(static_cast<int>(m_index.size())); ;
+         i = (i + 1) & mask)
+    {
+        const Slot& slot = m_index[i];
+        if (slot.m_offset == EMPTY || slot.m_hash == hash)
+            return i;
+    }
+}
+
+void GoAutoBookStore::Flush()
+{
+    if (m_pending.empty())
+        return;
     {
-        while (is)
+        std::ofstream out(m_filename.c_str(),
+                          std::ios::binary | std::ios::app);
+        for (std::map<SgHashCode, SgBookNode>::const_iterator it =
+                 m_pending.begin(); it != m_pending.end(); ++it)
         {
-            std::string line;
-            std::getline(is, line);
-            if (line.size() < 19)
-                continue;
-            std::string str;
-            std::istringstream iss(line);
-            iss >> str;
+            const std::string line = FormatLine(it->first, it->second);
+            out << line;
+            Index(it->first, m_fileSize);
+            m_fileSize += line.size();
+            ++m_nuRecords;
+        }
+        out.close();
+        if (! out)
+            throw SgException("GoAutoBookStore: error writing "
+                              + m_filename);
+    }
+    m_pending.clear();
+    if (m_nuRecords > 2 * Size())
+        Compact();
+}
+
+bool GoAutoBookStore::Get(const SgHashCode& hash, SgBookNode& node) const
+{
+    std::map<SgHashCode, SgBookNode>::const_iterator it =
+        m_pending.find(hash);
+    if (it != m_pending.end())
+    {
+        node = it->second;
+        return true;
+    }
+    const Slot& slot = m_index[Find(hash)];
+    if (slot.m_offset == EMPTY)
+        return false;
+    ReadNode(slot.m_offset, node);
+    return true;
+}
+
+void GoAutoBookStore::GetKeys(std::vector<SgHashCode>& keys) const
+{
+    keys.clear();
+    for (std::vector<Slot>::const_iterator it = m_index.begin();
+         it != m_index.end(); ++it)
+        if (it->m_offset != EMPTY)
+            keys.push_back(it->m_hash);
+    for (std::map<SgHashCode, SgBookNode>::const_iterator it =
+             m_pending.begin(); it != m_pending.end(); ++it)
+        if (m_index[Find(it->first)].m_offset == EMPTY)
+            keys.push_back(it->first);
+}
+
+void GoAutoBookStore::Index(const SgHashCode& hash, uint64_t offset)
+{
+    // Keep the table at most half full
+    if (2 * (m_nuIndexed + 1) > m_index.size())
+    {
+        std::vector<Slot> old;
+        old.swap(m_index);
+        Slot empty;
+        empty.m_offset = EMPTY;
+        m_index.assign(2 * old.size(), empty);
+        m_nuIndexed = 0;
+        for (std::vector<Slot>::const_iterator it = old.begin();
+             it != old.end(); ++it)
+            if (it->m_offset != EMPTY)
+                Index(it->m_hash, it->m_offset);
+    }
+    Slot& slot = m_index[Find(hash)];
+    if (slot.m_offset == EMPTY)
+    {
+        slot.m_hash = hash;
+        ++m_nuIndexed;
+    }
+    slot.m_offset = offset;
+}
+
+void GoAutoBookStore::Put(const SgHashCode& hash, const SgBookNode& node)
+{
+    m_pending[hash] = node;
+}
+
+void GoAutoBookStore::ReadLog()
+{
+    Slot empty;
+    empty.m_offset = EMPTY;
+    m_index.assign(MIN_INDEX_SIZE, empty);
+    m_nuIndexed = 0;
+    m_nuRecords = 0;
+    m_fileSize = 0;
+    {
+        std::ifstream in(m_filename.c_str(), std::ios::binary);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            if (in.eof())
+            {
+                // Last line without newline: incomplete write
+                SgWarning() << "GoAutoBookStore: removing incomplete line "
+                            << "at end of " << m_filename << '\n';
+                break;
+            }
             SgHashCode hash;
-            hash.FromString(str);
-            SgBookNode node(line.substr(19));
-            m_data[hash] = node;
+            SgBookNode node;
+            if (ParseLine(line, hash, node))
+            {
+                Index(hash, m_fileSize);
+                ++m_nuRecords;
+            }
+            m_fileSize += line.size() + 1;
         }
-        SgDebug() << "GoAutoBook: Parsed " << m_data.size() << " lines.\n";
     }
+    if (boost::filesystem::file_size(m_filename) != m_fileSize)
+        boost::filesystem::resize_file(m_filename, m_fileSize);
+    m_in.close();
+    m_in.clear();
+    m_in.open(m_filename.c_str(), std::ios::binary);
+    SgDebug() << "GoAutoBookStore: Indexed " << Size() << " nodes in "
+              << m_nuRecords << " lines.\n";
 }
 
+void GoAutoBookStore::ReadNode(uint64_t offset, SgBookNode& node) const
+{
+    std::string line;
+    bool isRead;
+    {
+        boost::mutex::scoped_lock lock(m_inMutex);
+        m_in.clear();
+        m_in.seekg(static_cast<std::streamoff>(offset));
+        isRead = ! std::getline(m_in, line).fail();
+    }
+    SgHashCode hash;
+    if (! isRead || ! ParseLine(line, hash, node))
+        throw SgException("GoAutoBookStore: error reading " + m_filename);
+}
+
+std::size_t GoAutoBookStore::Size() const
+{
+    std::size_t size = m_nuIndexed;
+    for (std::map<SgHashCode, SgBookNode>::const_iterator it =
+             m_pending.begin(); it != m_pending.end(); ++it)
+        if (m_index[Find(it->first)].m_offset == EMPTY)
+            ++size;
+    return size;
+}
+
+void GoAutoBookStore::Write(std::ostream& out) const
+{
+    std::vector<SgHashCode> keys;
+    GetKeys(keys);
+    std::sort(keys.begin(), keys.end());
+    for (std::vector<SgHashCode>::const_iterator it = keys.begin();
+         it != keys.end(); ++it)
+    {
+        SgBookNode node;
+        Get(*it, node);
+        out << FormatLine(*it, node);
+    }
+}
+
+//----------------------------------------------------------------------------
+
+GoAutoBook::GoAutoBook(const std::string& filename,
+                       const GoAutoBookParam& param)
+    : m_data(filename),
+      m_param(param), 
+      m_filename(filename)
+{ }
+
 GoAutoBook::~GoAutoBook()
 { }
 
 bool GoAutoBook::Get(const GoAutoBookState& state, SgBookNode& node) const
 {
-    Map::const_iterator it = m_data.find(state.GetHashCode());
-    if (it != m_data.end())
-    {
-        node = it->second;
-        return true;
-    }
-    return false;
+    return m_data.Get(state.GetHashCode(), node);
 }
 
 void GoAutoBook::Put(const GoAutoBookState& state, const SgBookNode& node)
 {
-    m_data[state.GetHashCode()] = node;
+    m_data.Put(state.GetHashCode(), node);
 }
 
 void GoAutoBook::Flush()
 {
-    Save(m_filename);
+    m_data.Flush();
 }
 
 void GoAutoBook::Save(const std::string& filename) const
 {
+    // Compare the files, not only the names, the file could also be given
+    // with a different relative path or by a link. equivalent() fails if
+    // the file does not exist yet, which is not an error here.
+    boost::system::error_code ec;
+    if (filename == m_filename
+        || boost::filesystem::equivalent(filename, m_filename, ec))
+        throw SgException("GoAutoBook::Save: cannot overwrite file of book");
     std::ofstream out(filename.c_str());
-    for (Map::const_iterator it = m_data.begin(); it != m_data.end(); ++it)
-    {
-        out << it->first.ToString() << '\t' 
-            << it->second.ToString() << '\n';
-    }
+    m_data.Write(out);
     out.close();
 }
 
@@ -150,14 +366,17 @@ void GoAutoBook::Merge(const GoAutoBook& other)
     std::size_t leafsInCommon = 0;
     std::size_t internalInCommon = 0;
     std::size_t leafToInternal = 0;
-    for (Map::const_iterator it = other.m_data.begin();
-         it != other.m_data.end(); ++it)
+    std::vector<SgHashCode> keys;
+    other.m_data.GetKeys(keys);
+    for (std::vector<SgHashCode>::const_iterator it = keys.begin();
+         it != keys.end(); ++it)
     {
-        Map::iterator mine = m_data.find(it->first);
-        SgBookNode newNode(it->second);
-        if (mine == m_data.end())
+        SgBookNode newNode;
+        other.m_data.Get(*it, newNode);
+        SgBookNode oldNode;
+        if (! m_data.Get(*it, oldNode))
         {
-            m_data[it->first] = it->second;
+            m_data.Put(*it, newNode);
             if (newNode.IsLeaf())
                 newLeafs++;
             else
@@ -165,12 +384,11 @@ void GoAutoBook::Merge(const GoAutoBook& other)
         }
         else
         {
-            SgBookNode oldNode(mine->second);
             if (newNode.IsLeaf() && oldNode.IsLeaf())
             {
                 newNode.m_heurValue = 0.5f * (newNode.m_heurValue 
                                              + oldNode.m_heurValue);
-                m_data[it->first] = newNode;
+                m_data.Put(*it, newNode);
                 leafsInCommon++;
             }
             else if (! newNode.IsLeaf())
@@ -183,7 +401,7 @@ void GoAutoBook::Merge(const GoAutoBook& other)
                 // accurate after the merge.  I don't think it matters
                 // that much.
                 newNode.m_count = std::max(newNode.m_count, oldNode.m_count);
-                m_data[it->first] = newNode;
+                m_data.Put(*it, newNode);
                 if (! oldNode.IsLeaf())
                     internalInCommon++;
                 else 
@@ -257,16 +475,16 @@ void GoAutoBook::ImportHashValuePairs(std::istream& in)
         if (! in) 
             break;
         in >> value;
-        if (m_data.count(hash) == 0)
+        SgBookNode node;
+        if (! m_data.Get(hash, node))
         {
             std::ostringstream os;
             os << "Unknown hash: " << hash << '\n';
             throw SgException(os.str());
         }
-        SgBookNode node(m_data[hash]);
         node.m_heurValue = value;
         node.m_value = value;
-        m_data[hash] = node;
+        m_data.Put(hash, node);
         count++;
     }
     SgDebug() << "GoAutoBook::ImportHashValue: imported " 
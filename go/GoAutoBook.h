@@ -10,6 +10,9 @@
 #include <fstream>
 #include <set>
 #include <map>
+#include <stdint.h>
+#include <vector>
+#include <boost/thread/mutex.hpp>
 #include "SgBookBuilder.h"
 #include "SgThreadedWorker.h"
 #include "GoBoard.h"
@@ -83,8 +86,116 @@ struct GoAutoBookParam
 
 //----------------------------------------------------------------------------
 
+/** Disk-backed store of book nodes keyed by hash code.
+    The file is an append-only log in the text format of the book: one
+    line per node with the hash code and SgBookNode::ToString(), separated
+    by a tab. A later line for the same hash code replaces the earlier
+    ones, so a book written by an older version is a valid log.
+
+    Only a compact index from hash code to the file offset of the latest
+    line is kept in memory (an open-addressing hash table); Get() reads the
+    node from the file. Put() buffers nodes until Flush(), which appends
+    them to the log. If the program is interrupted while appending, the
+    incomplete last line is removed when the file is opened again, so book
+    building can be restarted with all nodes of completed flushes. If the
+    log contains more than twice as many lines as nodes, Flush() compacts
+    it by writing the current nodes to a temporary file and renaming it
+    to the file of the book.
+
+    The const functions, including Get(), can be called by several threads
+    at the same time, but not at the same time as the non-const functions. */
+class GoAutoBookStore
+{
+public:
+    /** Open the log file and build the index.
+        Creates the file, if it does not exist.
+        @throws SgException if the file cannot be created. */
+    GoAutoBookStore(const std::string& filename);
+
+    ~GoAutoBookStore();
+
+    bool Get(const SgHashCode& hash, SgBookNode& node) const;
+
+    void Put(const SgHashCode& hash, const SgBookNode& node);
+
+    /** Append the nodes stored since the last flush to the log.
+        @throws SgException on write error. */
+    void Flush();
+
+    /** Rewrite the log with one line per node. */
+    void Compact();
+
+    /** Hash codes of all nodes (in no particular order). */
+    void GetKeys(std::vector<SgHashCode>& keys) const;
+
+    /** Number of nodes. */
+    std::size_t Size() const;
+
+    /** Number of lines in the log file. */
+    std::size_t NuRecords() const;
+
+    /** Write all nodes sorted by hash code in the format of the log. */
+    void Write(std::ostream& out) const;
+
+private:
+    struct Slot
+    {
+        SgHashCode m_hash;
+
+        /** Offset of the line in the file, or EMPTY for unused slots. */
+        uint64_t m_offset;
+    };
+
+    std::string m_filename;
+
+    /** Hash table with linear probing; the size is a power of two. */
+    std::vector<Slot> m_index;
+
+    /** Number of used slots in m_index. */
+    std::size_t m_nuIndexed;
+
+    std::size_t m_nuRecords;
+
+    /** Size of the log file. */
+    uint64_t m_fileSize;
+
+    /** Nodes not yet written to the log. */
+    std::map<SgHashCode, SgBookNode> m_pending;
+
+    /** Stream for reading nodes from the log.
+        Protected by m_inMutex, because reading a node moves the read
+        position. */
+    mutable std::ifstream m_in;
+
+    mutable boost::mutex m_inMutex;
+
+    /** Index of the slot of a hash code or of the empty slot where it
+        would be inserted. */
+    std::size_t Find(const SgHashCode& hash) const;
+
+    void Index(const SgHashCode& hash, uint64_t offset);
+
+    void ReadLog();
+
+    void ReadNode(uint64_t offset, SgBookNode& node) const;
+
+    /** Not implemented. */
+    GoAutoBookStore(const GoAutoBookStore&);
+
+    /** Not implemented. */
+    GoAutoBookStore& operator=(const GoAutoBookStore&);
+};
+
+inline std::size_t GoAutoBookStore::NuRecords() const
+{
+    return m_nuRecords;
+}
+
+//----------------------------------------------------------------------------
+
 /** Simple text-based book format.
-    Entire book is loaded into memory. */
+    The book is stored in a GoAutoBookStore, so only an index of the
+    positions is kept in memory. */
 class GoAutoBook
 {
 public:
@@ -100,10 +211,13 @@ public:
     /** Store the node in the given state. */
     void Put(const GoAutoBookState& state, const SgBookNode& node);
 
-    /** Since there is no cache, same as Save(). */
+    /** Writes the nodes stored since the last flush to the file of the
+        book. */
     void Flush();
 
-    /** Writes book to disk. */
+    /** Writes a copy of the book with one line per node to a file.
+        @throws SgException if the file is the file of this book, also if
+        given by a different path (use Flush() for that) */
     void Save(const std::string& filename) const;
 
     /** Helper function: calls FindBestChild() on the given board.*/
@@ -154,9 +268,7 @@ public:
     static std::vector< std::vector<SgMove> > ParseWorkList(std::istream& in);
 
 private:
-    typedef std::map<SgHashCode, SgBookNode> Map;
-
-    Map m_data;
+    GoAutoBookStore m_data;
 
     const GoAutoBookParam& m_param;
 
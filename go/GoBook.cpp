@@ -85,6 +85,7 @@ void GoBook::Entry::ApplyTo(GoBoard& bd) const
 
 void GoBook::Add(const GoBoard& bd, SgPoint move)
 {
+    CheckNotCompiled();
     if (move != SG_PASS && bd.Occupied(move))
         throw SgException("point is not empty");
     if (! bd.IsLegal(move))
@@ -109,14 +110,22 @@ void GoBook::Add(const GoBoard& bd, SgPoint move)
     }
 }
 
+void GoBook::CheckNotCompiled() const
+{
+    if (IsCompiled())
+        throw SgException("compiled book cannot be modified");
+}
+
 void GoBook::Clear()
 {
     m_entries.clear();
     m_map.clear();
+    m_compiled.Close();
 }
 
 void GoBook::Delete(const GoBoard& bd, SgPoint move)
 {
+    CheckNotCompiled();
     const GoBook::MapEntry* mapEntry = LookupEntry(bd);
     if (mapEntry == 0)
         return;
@@ -201,6 +210,8 @@ void GoBook::InsertEntry(const vector<SgPoint>& sequence,
 
 int GoBook::Line(const GoBoard& bd) const
 {
+    if (IsCompiled())
+        return m_compiled.Line(bd);
     const GoBook::MapEntry* mapEntry = LookupEntry(bd);
     if (mapEntry == 0)
         return 0;
@@ -233,6 +244,8 @@ SgPoint GoBook::LookupMove(const GoBoard& bd) const
 
 vector<SgPoint> GoBook::LookupAllMoves(const GoBoard& bd) const
 {
+    if (IsCompiled())
+        return m_compiled.LookupAllMoves(bd);
     vector<SgPoint> result;
     const GoBook::MapEntry* mapEntry = LookupEntry(bd);
     if (mapEntry == 0)
@@ -299,6 +312,12 @@ void GoBook::Read(std::istream& in, const string& streamName)
 
 void GoBook::Read(const string& filename)
 {
+    if (GoCompiledBook::IsCompiledFile(filename))
+    {
+        Clear();
+        m_compiled.Open(filename);
+        return;
+    }
     std::ifstream in(filename.c_str());
     if (! in)
         throw SgException("Cannot find file " + filename);
@@ -335,6 +354,7 @@ void GoBook::ThrowError(const string& message) const
 
 void GoBook::Write(std::ostream& out) const
 {
+    CheckNotCompiled();
     for (vector<Entry>::const_iterator it = m_entries.begin();
          it != m_entries.end(); ++it)
     {
@@ -355,8 +375,21 @@ void GoBook::Write(std::ostream& out) const
     }
 }
 
+void GoBook::WriteCompiled(const string& filename) const
+{
+    CheckNotCompiled();
+    GoCompiledBook::Write(*this, filename);
+}
+
 void GoBook::WriteInfo(std::ostream& out) const
 {
+    if (IsCompiled())
+    {
+        out << SgWriteLabel("Compiled") << "yes\n"
+            << SgWriteLabel("NuTransformed") << m_compiled.NuPositions()
+            << '\n';
+        return;
+    }
     out << SgWriteLabel("NuBasic") << m_entries.size() << '\n'
         << SgWriteLabel("NuTransformed") << m_map.size() << '\n';
 }
@@ -374,6 +407,7 @@ void GoBookCommands::AddGoGuiAnalyzeCommands(GtpCommand& cmd)
     cmd <<
         "gfx/Book Add/book_add %p\n"
         "none/Book Clear/book_clear\n"
+        "none/Book Compile/book_compile %w\n"
         "gfx/Book Delete/book_delete %p\n"
         "hstring/Book Info/book_info\n"
         "none/Book Load/book_load %r\n"
@@ -406,11 +440,33 @@ void GoBookCommands::CmdClear(GtpCommand& cmd)
     m_book.Clear();
 }
 
+/** Write the current book as compiled book file.
+    The compiled book is loaded faster than the text format, because it is
+    memory-mapped instead of parsed (see GoCompiledBook). It can be loaded
+    with @c book_load like a book in text format.<br>
+    Arguments: filename */
+void GoBookCommands::CmdCompile(GtpCommand& cmd)
+{
+    if (m_engine.MpiSynchronizer()->IsRootProcess())
+    {
+        try
+        {
+            m_book.WriteCompiled(cmd.Arg());
+        }
+        catch (const SgException& e)
+        {
+            throw GtpFailure() << "compiling book failed: " << e.what();
+        }
+    }
+}
+
 /** Delete a move for the current position to the book.
     Arguments: point <br>
     Returns: Position information after the move deletion as in CmdPosition() */
 void GoBookCommands::CmdDelete(GtpCommand& cmd)
 {
+    if (m_book.IsCompiled())
+        throw GtpFailure("compiled book cannot be modified");
     vector<SgPoint> moves = m_book.LookupAllMoves(m_bd);
     if (moves.empty())
         throw GtpFailure("book contains no moves for current position");
@@ -478,6 +534,8 @@ void GoBookCommands::CmdSave(GtpCommand& cmd)
     cmd.CheckArgNone();
     if (m_fileName == "")
         throw GtpFailure("no filename associated with current book");
+    if (m_book.IsCompiled())
+        throw GtpFailure("compiled book cannot be saved");
     ofstream out(m_fileName.c_str());
     m_book.Write(out);
     if (! out)
@@ -491,6 +549,8 @@ void GoBookCommands::CmdSaveAs(GtpCommand& cmd)
 {
     if (m_engine.MpiSynchronizer()->IsRootProcess())
     {
+        if (m_book.IsCompiled())
+            throw GtpFailure("compiled book cannot be saved");
         m_fileName = cmd.Arg();
         ofstream out(m_fileName.c_str());
         m_book.Write(out);
@@ -535,6 +595,7 @@ void GoBookCommands::Register(GtpEngine& e)
 {
     e.Register("book_add", &GoBookCommands::CmdAdd, this);
     e.Register("book_clear", &GoBookCommands::CmdClear, this);
+    e.Register("book_compile", &GoBookCommands::CmdCompile, this);
     e.Register("book_delete", &GoBookCommands::CmdDelete, this);
     e.Register("book_info", &GoBookCommands::CmdInfo, this);
     e.Register("book_load", &GoBookCommands::CmdLoad, this);
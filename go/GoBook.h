@@ -10,6 +10,7 @@
 #include <map>
 #include <string>
 #include <vector>
+#include "GoCompiledBook.h"
 #include "GtpEngine.h"
 #include "SgHash.h"
 #include "SgPoint.h"
@@ -32,7 +33,12 @@ class GoBoard;
     mirroring. If there are duplicates, because of sequences with move
     transpositions or rotating/mirroring, reading will throw an exception
     containing an error message with line number information of the
-    duplicates. */
+    duplicates.
+
+    A book can also be read from a file created with WriteCompiled(), which
+    is memory-mapped instead of parsed (see GoCompiledBook). Such a book
+    supports only the lookup functions; it cannot be modified or written in
+    text format. */
 
 class GoGtpEngine;
 
@@ -61,6 +67,7 @@ public:
         to current position cannot be determined) */
     void Add(const GoBoard& bd, SgPoint move);
 
+    /** Remove all entries and close the compiled book, if one is open. */
     void Clear();
 
     /** Deletes a book move in the current position.
@@ -68,6 +75,7 @@ public:
     void Delete(const GoBoard& bd, SgPoint move);
 
     /** Get an entry.
+        Not available for a compiled book.
         @param index The index of the entry
         @see NuEntries() */
     const Entry& GetEntry(std::size_t index) const;
@@ -84,6 +92,9 @@ public:
 
     std::vector<SgPoint> LookupAllMoves(const GoBoard& bd) const;
 
+    /** Return whether the book was read from a compiled book file. */
+    bool IsCompiled() const;
+
     std::size_t NuEntries() const;
 
     /** Read book from stream.
@@ -91,11 +102,21 @@ public:
         @param streamName Name used for error messages (e.g. file name) */
     void Read(std::istream& in, const std::string& streamName = "");
 
-    /** Read book from file. */
+    /** Read book from file.
+        If the file is a compiled book created by WriteCompiled(), the file
+        is memory-mapped instead of parsed. */
     void Read(const std::string& filename);
 
+    /** Write book in text format.
+        @throws SgException if the book is a compiled book */
     void Write(std::ostream& out) const;
 
+    /** Write book as compiled book file.
+        @see GoCompiledBook::Write()
+        @throws SgException if the book is a compiled book or on write
+        error */
+    void WriteCompiled(const std::string& filename) const;
+
     void WriteInfo(std::ostream& out) const;
 
 private:
@@ -128,6 +149,11 @@ private:
     /** Mapping hash key to entries. */
     Map m_map;
 
+    /** Lookup table, if the book was read from a compiled book file. */
+    GoCompiledBook m_compiled;
+
+    void CheckNotCompiled() const;
+
     void InsertEntry(const std::vector<SgPoint>& sequence,
                      const std::vector<SgPoint>& moves, int size,
                      GoBoard& tempBoard, int line);
@@ -147,6 +173,11 @@ inline const GoBook::Entry& GoBook::GetEntry(std::size_t index) const
     return m_entries[index];
 }
 
+inline bool GoBook::IsCompiled() const
+{
+    return m_compiled.IsOpen();
+}
+
 inline std::size_t GoBook::NuEntries() const
 {
     return m_entries.size();
@@ -167,6 +198,7 @@ public:
     /** @page gobookcommands GoBookCommands
         - @link CmdAdd() @c book_add @endlink
         - @link CmdClear() @c book_clear @endlink
+        - @link CmdCompile() @c book_compile @endlink
         - @link CmdDelete() @c book_delete @endlink
         - @link CmdInfo() @c book_info @endlink
         - @link CmdLoad() @c book_load @endlink
@@ -179,6 +211,7 @@ public:
     // The callback functions are documented in the cpp file
     void CmdAdd(GtpCommand& cmd);
     void CmdClear(GtpCommand& cmd);
+    void CmdCompile(GtpCommand& cmd);
     void CmdDelete(GtpCommand& cmd);
     void CmdInfo(GtpCommand& cmd);
     void CmdLoad(GtpCommand& cmd);
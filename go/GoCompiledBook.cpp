@@ -0,0 +1,374 @@
+//----------------------------------------------------------------------------
+/** @file GoCompiledBook.cpp
+    See GoCompiledBook.h */
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+#include "GoCompiledBook.h"
+
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "GoBoard.h"
+#include "GoBoardUtil.h"
+#include "GoBook.h"
+#include "SgDebug.h"
+#include "SgException.h"
+
+using std::string;
+using std::vector;
+using boost::interprocess::file_mapping;
+using boost::interprocess::interprocess_exception;
+using boost::interprocess::mapped_region;
+using boost::interprocess::read_only;
+
+//----------------------------------------------------------------------------
+
+struct GoCompiledBook::Header
+{
+    char m_magic[8];
+
+    /** BYTE_ORDER_MARK as written by the machine that created the file. */
+    uint32_t m_byteOrder;
+
+    uint32_t m_version;
+
+    /** Size of the hash table. A power of two. */
+    uint32_t m_nuSlots;
+
+    uint32_t m_nuPositions;
+
+    uint32_t m_nuMoves;
+
+    uint32_t m_reserved;
+};
+
+/** Entry of the hash table.
+    Empty slots have m_size 0. */
+struct GoCompiledBook::Slot
+{
+    uint64_t m_key;
+
+    int32_t m_size;
+
+    int32_t m_line;
+
+    /** Index of the first move in the move array. */
+    uint32_t m_firstMove;
+
+    uint32_t m_nuMoves;
+};
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+const char MAGIC[8] = { 'F', 'U', 'E', 'G', 'O', 'B', 'K', '\n' };
+
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+const uint32_t FORMAT_VERSION = 1;
+
+/** Finalizer of MurmurHash3 (a bijective mix function). */
+uint64_t Mix(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+/** Encode a point as column and row, independent of SG_MAX_SIZE. */
+uint16_t EncodeMove(SgPoint p)
+{
+    if (p == SG_PASS)
+        return 0;
+    return static_cast<uint16_t>(SgPointUtil::Col(p)
+                                 | (SgPointUtil::Row(p) << 8));
+}
+
+/** Check that a move in the file is a pass or a point on the board. */
+bool IsValidMove(uint16_t move, int size)
+{
+    if (move == 0)
+        return true;
+    const int col = move & 0xff;
+    const int row = move >> 8;
+    return col >= 1 && col <= size && row >= 1 && row <= size;
+}
+
+SgPoint DecodeMove(uint16_t move)
+{
+    if (move == 0)
+        return SG_PASS;
+    return SgPointUtil::Pt(move & 0xff, move >> 8);
+}
+
+/** Position with moves, as collected by GoCompiledBook::Write(). */
+struct Position
+{
+    uint64_t m_key;
+
+    int m_size;
+
+    int m_line;
+
+    vector<SgPoint> m_moves;
+};
+
+} // namespace
+
+//----------------------------------------------------------------------------
+
+GoCompiledBook::GoCompiledBook()
+    : m_header(0),
+      m_slots(0),
+      m_moves(0)
+{ }
+
+GoCompiledBook::~GoCompiledBook()
+{ }
+
+void GoCompiledBook::Close()
+{
+    m_region.reset(0);
+    m_header = 0;
+    m_slots = 0;
+    m_moves = 0;
+}
+
+bool GoCompiledBook::IsCompiledFile(const string& fileName)
+{
+    std::ifstream in(fileName.c_str(), std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    if (! in.read(magic, sizeof(magic)))
+        return false;
+    return std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+uint64_t GoCompiledBook::Key(const GoBoard& bd)
+{
+    uint64_t key = Mix(bd.Size() * 4 + bd.ToPlay());
+    for (GoBoard::Iterator it(bd); it; ++it)
+        if (bd.Occupied(*it))
+        {
+            // Row and column are at least 1, so these values are distinct
+            // from the value for size and color to play
+            const uint64_t stone =
+                (static_cast<uint64_t>(EncodeMove(*it)) << 2)
+                | bd.GetColor(*it);
+            key ^= Mix(stone);
+        }
+    return key;
+}
+
+int GoCompiledBook::Line(const GoBoard& bd) const
+{
+    const Slot* slot = LookupSlot(bd);
+    if (slot == 0)
+        return 0;
+    return slot->m_line;
+}
+
+vector<SgPoint> GoCompiledBook::LookupAllMoves(const GoBoard& bd) const
+{
+    vector<SgPoint> result;
+    const Slot* slot = LookupSlot(bd);
+    if (slot == 0)
+        return result;
+    const uint16_t* moves = m_moves + slot->m_firstMove;
+    for (uint32_t i = 0; i < slot->m_nuMoves; ++i)
+    {
+        SgPoint p = DecodeMove(moves[i]);
+        if (! bd.IsLegal(p))
+        {
+            // Should not happen with 64-bit keys, but not impossible
+            SgWarning() << "illegal book move (key collision?)\n";
+            result.clear();
+            break;
+        }
+        result.push_back(p);
+    }
+    return result;
+}
+
+const GoCompiledBook::Slot* GoCompiledBook::LookupSlot(const GoBoard& bd)
+    const
+{
+    if (! IsOpen())
+        return 0;
+    const uint64_t key = Key(bd);
+    const uint32_t mask = m_header->m_nuSlots - 1;
+    // The table is at most half full, so there is always an empty slot
+    for (uint32_t i = static_cast<uint32_t>(key) & mask; ; i = (i + 1) & mask)
+    {
+        const Slot& slot = m_slots[i];
+        if (slot.m_size == 0)
+            return 0;
+        if (slot.m_key == key && slot.m_size == bd.Size())
+            return &slot;
+    }
+}
+
+size_t GoCompiledBook::NuPositions() const
+{
+    return IsOpen() ? m_header->m_nuPositions : 0;
+}
+
+void GoCompiledBook::Open(const string& fileName)
+{
+    Close();
+    try
+    {
+        file_mapping file(fileName.c_str(), read_only);
+        m_region.reset(new mapped_region(file, read_only));
+    }
+    catch (const interprocess_exception& e)
+    {
+        m_region.reset(0);
+        throw SgException("cannot map " + fileName + ": " + e.what());
+    }
+    const char* data = static_cast<const char*>(m_region->get_address());
+    const size_t size = m_region->get_size();
+    const Header* header = reinterpret_cast<const Header*>(data);
+    if (size < sizeof(Header)
+        || std::memcmp(header->m_magic, MAGIC, sizeof(MAGIC)) != 0)
+    {
+        m_region.reset(0);
+        throw SgException(fileName + " is not a compiled book");
+    }
+    if (header->m_byteOrder != BYTE_ORDER_MARK
+        || header->m_version != FORMAT_VERSION
+        || header->m_nuSlots == 0
+        || (header->m_nuSlots & (header->m_nuSlots - 1)) != 0
+        || header->m_nuPositions >= header->m_nuSlots
+        || size != sizeof(Header) + header->m_nuSlots * sizeof(Slot)
+                   + header->m_nuMoves * sizeof(uint16_t))
+    {
+        m_region.reset(0);
+        throw SgException(fileName + ": unsupported or corrupt compiled book");
+    }
+    const Slot* slots = reinterpret_cast<const Slot*>(data + sizeof(Header));
+    const uint16_t* moves = reinterpret_cast<const uint16_t*>(
+                               data + sizeof(Header)
+                               + header->m_nuSlots * sizeof(Slot));
+    // Check all slots, because LookupAllMoves() would read outside the file
+    // with an invalid move range and LookupSlot() would not terminate
+    // without an empty slot
+    uint32_t nuUsedSlots = 0;
+    bool isValid = true;
+    for (uint32_t i = 0; i < header->m_nuSlots && isValid; ++i)
+    {
+        const Slot& slot = slots[i];
+        if (slot.m_size == 0)
+            continue;
+        ++nuUsedSlots;
+        if (slot.m_size < SG_MIN_SIZE || slot.m_size > SG_MAX_SIZE
+            || slot.m_nuMoves > header->m_nuMoves
+            || slot.m_firstMove > header->m_nuMoves - slot.m_nuMoves)
+        {
+            isValid = false;
+            break;
+        }
+        for (uint32_t j = 0; j < slot.m_nuMoves; ++j)
+            if (! IsValidMove(moves[slot.m_firstMove + j], slot.m_size))
+            {
+                isValid = false;
+                break;
+            }
+    }
+    if (! isValid || nuUsedSlots != header->m_nuPositions)
+    {
+        m_region.reset(0);
+        throw SgException(fileName + ": corrupt compiled book");
+    }
+    m_header = header;
+    m_slots = slots;
+    m_moves = moves;
+}
+
+void GoCompiledBook::Write(const GoBook& book, const string& fileName)
+{
+    // Collect all positions in the same order as GoBook::InsertEntry(), so
+    // that the moves of symmetric positions are the same as in GoBook
+    vector<Position> positions;
+    std::set<uint64_t> keys;
+    GoBoard tempBoard;
+    uint32_t nuMoves = 0;
+    for (size_t id = 0; id < book.NuEntries(); ++id)
+    {
+        const GoBook::Entry& entry = book.GetEntry(id);
+        if (entry.m_moves.empty())
+            continue;
+        const int size = entry.m_size;
+        if (tempBoard.Size() != size)
+            tempBoard.Init(size);
+        for (int rot = 0; rot < 8; ++rot)
+        {
+            GoBoardUtil::UndoAll(tempBoard);
+            for (vector<SgPoint>::const_iterator it = entry.m_sequence.begin();
+                 it != entry.m_sequence.end(); ++it)
+                tempBoard.Play(SgPointUtil::Rotate(rot, *it, size));
+            const uint64_t key = Key(tempBoard);
+            if (! keys.insert(key).second)
+                continue;
+            Position position;
+            position.m_key = key;
+            position.m_size = size;
+            position.m_line = entry.m_line;
+            for (vector<SgPoint>::const_iterator it = entry.m_moves.begin();
+                 it != entry.m_moves.end(); ++it)
+                position.m_moves.push_back(
+                                     SgPointUtil::Rotate(rot, *it, size));
+            nuMoves += static_cast<uint32_t>(position.m_moves.size());
+            positions.push_back(position);
+        }
+    }
+    uint32_t nuSlots = 1;
+    while (nuSlots < 2 * positions.size() + 1)
+        nuSlots *= 2;
+    Slot emptySlot;
+    std::memset(&emptySlot, 0, sizeof(emptySlot));
+    vector<Slot> slots(nuSlots, emptySlot);
+    vector<uint16_t> moves;
+    moves.reserve(nuMoves);
+    for (vector<Position>::const_iterator it = positions.begin();
+         it != positions.end(); ++it)
+    {
+        uint32_t i = static_cast<uint32_t>(it->m_key) & (nuSlots - 1);
+        while (slots[i].m_size != 0)
+            i = (i + 1) & (nuSlots - 1);
+        Slot& slot = slots[i];
+        slot.m_key = it->m_key;
+        slot.m_size = it->m_size;
+        slot.m_line = it->m_line;
+        slot.m_firstMove = static_cast<uint32_t>(moves.size());
+        slot.m_nuMoves = static_cast<uint32_t>(it->m_moves.size());
+        for (vector<SgPoint>::const_iterator it2 = it->m_moves.begin();
+             it2 != it->m_moves.end(); ++it2)
+            moves.push_back(EncodeMove(*it2));
+    }
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.m_magic, MAGIC, sizeof(MAGIC));
+    header.m_byteOrder = BYTE_ORDER_MARK;
+    header.m_version = FORMAT_VERSION;
+    header.m_nuSlots = nuSlots;
+    header.m_nuPositions = static_cast<uint32_t>(positions.size());
+    header.m_nuMoves = nuMoves;
+    std::ofstream out(fileName.c_str(), std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(&slots[0]),
+              nuSlots * sizeof(Slot));
+    if (! moves.empty())
+        out.write(reinterpret_cast<const char*>(&moves[0]),
+                  moves.size() * sizeof(uint16_t));
+    if (! out)
+        throw SgException("error writing to file " + fileName);
+}
+
+//----------------------------------------------------------------------------
@@ -0,0 +1,116 @@
+//----------------------------------------------------------------------------
+/** @file GoCompiledBook.h
+    Precompiled opening book in a memory-mapped binary file. */
+//----------------------------------------------------------------------------
+
+#ifndef GO_COMPILED_BOOK_H
+#define GO_COMPILED_BOOK_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <boost/scoped_ptr.hpp>
+#include "SgPoint.h"
+
+class GoBoard;
+class GoBook;
+
+namespace boost {
+namespace interprocess {
+    class mapped_region;
+}
+}
+
+//----------------------------------------------------------------------------
+
+/** Read-only opening book in a binary file that is used without parsing.
+    The file is created from a GoBook with Write(). It contains a hash table
+    with all positions of the book, including the rotated and mirrored
+    positions, and the moves for each position already transformed. Open()
+    maps the file into memory, so loading the book costs only the time for
+    mapping the file, and the pages are shared between processes that use
+    the same book.
+
+    The positions are identified by a 64-bit key computed from the board
+    size, the stones and the color to play with a fixed function (see Key()),
+    not with the Zobrist hash codes of GoBoard, which are not guaranteed to
+    be the same in different programs or builds. Points are stored as
+    column and row, so the file does not depend on SG_MAX_SIZE. The file
+    uses the byte order of the machine that wrote it; Open() rejects files
+    written with a different byte order. */
+class GoCompiledBook
+{
+public:
+    GoCompiledBook();
+
+    ~GoCompiledBook();
+
+    void Close();
+
+    bool IsOpen() const;
+
+    /** Line number of the current position in the text file that the
+        compiled book was created from.
+        @return Line number or 0, if the position is not in the book. */
+    int Line(const GoBoard& bd) const;
+
+    /** Moves for the current position.
+        Same result as GoBook::LookupAllMoves() of the book that the file
+        was created from. */
+    std::vector<SgPoint> LookupAllMoves(const GoBoard& bd) const;
+
+    /** Number of positions including the transformed positions. */
+    std::size_t NuPositions() const;
+
+    /** Map a compiled book file into memory.
+        Checks the header and all slots of the hash table, including the
+        move ranges and the moves, so that lookups in a corrupt file cannot
+        read outside the file or loop forever.
+        @throws SgException if the file cannot be mapped or is not a valid
+        compiled book. */
+    void Open(const std::string& fileName);
+
+    /** Check if a file starts with the identifier of a compiled book. */
+    static bool IsCompiledFile(const std::string& fileName);
+
+    /** Key of the current position. */
+    static uint64_t Key(const GoBoard& bd);
+
+    /** Write a book as compiled book file.
+        Entries without moves are skipped like in GoBook::Write(). If
+        positions of different entries are equal (possible for positions
+        that GoBook distinguishes by the history of captures), the first
+        entry is used.
+        @throws SgException on write error. */
+    static void Write(const GoBook& book, const std::string& fileName);
+
+private:
+    struct Header;
+
+    struct Slot;
+
+    boost::scoped_ptr<boost::interprocess::mapped_region> m_region;
+
+    const Header* m_header;
+
+    const Slot* m_slots;
+
+    const uint16_t* m_moves;
+
+    const Slot* LookupSlot(const GoBoard& bd) const;
+
+    /** Not implemented. */
+    GoCompiledBook(const GoCompiledBook&);
+
+    /** Not implemented. */
+    GoCompiledBook& operator=(const GoCompiledBook&);
+};
+
+inline bool GoCompiledBook::IsOpen() const
+{
+    return m_header != 0;
+}
+
+//----------------------------------------------------------------------------
+
+#endif // GO_COMPILED_BOOK_H
@@ -6,6 +6,8 @@
 #include "SgSystem.h"
 #include "GoPattern12Point.h"
 
+#include <algorithm>
+
 namespace {
     /** A bit is set iff point p is either of color c or off the board. */
     inline unsigned int ColorOrBorderBit(const GoBoard& bd, SgPoint p, int c)
@@ -231,3 +233,93 @@ namespace GoPattern12Point {
     }
     
 } // namespace GoPattern12Point
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+/** Offsets of the points that the context of a point depends on. */
+const int NEIGHBORHOOD_12[13] = {
+    0,
+    - SG_NS - SG_WE, - SG_NS, - SG_NS + SG_WE,
+    - SG_WE, SG_WE,
+    SG_NS - SG_WE, SG_NS, SG_NS + SG_WE,
+    - 2 * SG_NS, - 2 * SG_WE, 2 * SG_WE, 2 * SG_NS
+};
+
+} // namespace
+
+GoPattern12PointCache::GoPattern12PointCache(const GoBoard& bd)
+    : m_bd(bd),
+      m_toPlay(SG_BLACK),
+      m_nuComputed(0)
+{
+    m_snapshot[SG_BLACK].m_isValid = false;
+    m_snapshot[SG_WHITE].m_isValid = false;
+}
+
+/** Color of a point and, for stones, the liberty class used in the
+    context. */
+inline int GoPattern12PointCache::PointState(SgPoint p) const
+{
+    const SgBoardColor c = m_bd.GetColor(p);
+    if (c == SG_EMPTY)
+        return c;
+    return c + 4 * std::min(m_bd.NumLiberties(p), 3);
+}
+
+void GoPattern12PointCache::Update()
+{
+    m_toPlay = m_bd.ToPlay();
+    const SgBlackWhite opponent = m_bd.Opponent();
+    Snapshot& snapshot = m_snapshot[m_toPlay];
+    m_nuComputed = 0;
+    if (! snapshot.m_isValid || snapshot.m_size != m_bd.Size())
+    {
+        for (GoBoard::Iterator it(m_bd); it; ++it)
+        {
+            const SgPoint p = *it;
+            snapshot.m_state[p] = PointState(p);
+            if (m_bd.IsEmpty(p))
+            {
+                snapshot.m_context[p] =
+                    GoPattern12Point::Context(m_bd, p, m_toPlay, opponent);
+                ++m_nuComputed;
+            }
+        }
+        snapshot.m_isValid = true;
+        snapshot.m_size = m_bd.Size();
+        return;
+    }
+    m_changed.Clear();
+    bool anyChanged = false;
+    for (GoBoard::Iterator it(m_bd); it; ++it)
+    {
+        const SgPoint p = *it;
+        const int state = PointState(p);
+        if (state == snapshot.m_state[p])
+            continue;
+        snapshot.m_state[p] = state;
+        anyChanged = true;
+        for (int i = 0; i < 13; ++i)
+        {
+            const SgPoint p2 = p + NEIGHBORHOOD_12[i];
+            if (SgPointUtil::InBoardRange(p2))
+                m_changed.Include(p2);
+        }
+    }
+    if (! anyChanged)
+        return;
+    for (GoBoard::Iterator it(m_bd); it; ++it)
+    {
+        const SgPoint p = *it;
+        if (m_changed.Contains(p) && m_bd.IsEmpty(p))
+        {
+            snapshot.m_context[p] =
+                GoPattern12Point::Context(m_bd, p, m_toPlay, opponent);
+            ++m_nuComputed;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
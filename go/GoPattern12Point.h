@@ -7,6 +7,9 @@
 
 #include "GoBoard.h"
 #include "GoEvalArray.h"
+#include "SgArray.h"
+#include "SgBWArray.h"
+#include "SgMarker.h"
 
 //----------------------------------------------------------------------------
 namespace GoPattern12Point {
@@ -56,4 +59,77 @@ namespace GoPattern12Point {
 
 //----------------------------------------------------------------------------
 
+/** Cache for the contexts of GoPattern12Point of all empty points.
+    Computing the contexts of all legal moves is expensive and is done
+    for every node expanded in the search, but most of them are the same as
+    in the position of the previous expansion. The cache remembers the color
+    and the liberty class (1, 2 or more liberties) of every point at the last
+    call of Update() separately for each color to play. Update() compares
+    the board with this and recomputes only the contexts of points that
+    have a changed point in their 12-point neighborhood. */
+class GoPattern12PointCache
+{
+public:
+    explicit GoPattern12PointCache(const GoBoard& bd);
+
+    /** Update the contexts to the current position of the board. */
+    void Update();
+
+    /** Context of an empty point in the position of the last Update().
+        Same as GoPattern12Point::Context() for the color to play. */
+    unsigned int Context(SgPoint p) const;
+
+    /** Number of contexts recomputed in the last Update(). */
+    int NuComputed() const;
+
+private:
+    /** Position of the last Update() for one color to play. */
+    struct Snapshot
+    {
+        bool m_isValid;
+
+        SgGrid m_size;
+
+        /** Color and liberty class of each point.
+            @see GoPattern12PointCache::PointState */
+        SgArray<int,SG_MAXPOINT> m_state;
+
+        SgArray<unsigned int,SG_MAXPOINT> m_context;
+    };
+
+    const GoBoard& m_bd;
+
+    SgBWArray<Snapshot> m_snapshot;
+
+    /** The color to play at the last Update(). */
+    SgBlackWhite m_toPlay;
+
+    int m_nuComputed;
+
+    /** Points whose context needs to be recomputed. */
+    SgMarker m_changed;
+
+    int PointState(SgPoint p) const;
+
+    /** Not implemented. */
+    GoPattern12PointCache(const GoPattern12PointCache&);
+
+    /** Not implemented. */
+    GoPattern12PointCache& operator=(const GoPattern12PointCache&);
+};
+
+inline unsigned int GoPattern12PointCache::Context(SgPoint p) const
+{
+    SG_ASSERT(m_bd.IsEmpty(p));
+    SG_ASSERT(m_snapshot[m_toPlay].m_isValid);
+    return m_snapshot[m_toPlay].m_context[p];
+}
+
+inline int GoPattern12PointCache::NuComputed() const
+{
+    return m_nuComputed;
+}
+
+//----------------------------------------------------------------------------
+
 #endif // GO_PATTERN_12_POINT_H
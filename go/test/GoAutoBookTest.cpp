@@ -0,0 +1,189 @@
+//----------------------------------------------------------------------------
+/** @file GoAutoBookTest.cpp
+    Unit tests for GoAutoBook. */
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+
+#include <cstdio>
+#include <fstream>
+#include <boost/bind.hpp>
+#include <boost/test/auto_unit_test.hpp>
+#include <boost/thread/thread.hpp>
+#include "GoAutoBook.h"
+#include "SgException.h"
+
+using SgPointUtil::Pt;
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+const char* FILENAME = "GoAutoBookTest.dat";
+
+/** Nodes are written to the file only by Flush() and found again after
+    reopening it. */
+BOOST_AUTO_TEST_CASE(GoAutoBookTest_Store)
+{
+    std::remove(FILENAME);
+    {
+        GoAutoBookStore store(FILENAME);
+        BOOST_CHECK_EQUAL(store.Size(), 0u);
+        for (unsigned int i = 0; i < 2000; ++i)
+            store.Put(SgHashCode(i), SgBookNode(float(i)));
+        SgBookNode node;
+        BOOST_REQUIRE(store.Get(SgHashCode(5), node));
+        BOOST_CHECK_EQUAL(node.m_heurValue, 5.f);
+        BOOST_CHECK_EQUAL(store.NuRecords(), 0u);
+        store.Flush();
+        BOOST_CHECK_EQUAL(store.NuRecords(), 2000u);
+        store.Put(SgHashCode(7), SgBookNode(-1.f));
+        store.Flush();
+        store.Put(SgHashCode(8), SgBookNode(-2.f));
+    }
+    GoAutoBookStore store(FILENAME);
+    BOOST_CHECK_EQUAL(store.Size(), 2000u);
+    BOOST_CHECK_EQUAL(store.NuRecords(), 2001u);
+    SgBookNode node;
+    for (unsigned int i = 0; i < 2000; ++i)
+    {
+        BOOST_REQUIRE(store.Get(SgHashCode(i), node));
+        BOOST_CHECK_EQUAL(node.m_heurValue, i == 7 ? -1.f : float(i));
+    }
+    BOOST_CHECK(! store.Get(SgHashCode(2000), node));
+    std::remove(FILENAME);
+}
+
+/** Read all nodes of GoAutoBookTest_ConcurrentGet and count the wrong ones. */
+void GetAll(const GoAutoBookStore* store, unsigned int nuNodes,
+            int* nuErrors)
+{
+    for (unsigned int i = 0; i < nuNodes; ++i)
+    {
+        SgBookNode node;
+        if (! store->Get(SgHashCode(i), node)
+            || node.m_heurValue != float(i))
+            ++(*nuErrors);
+    }
+}
+
+/** Get() can be called by several threads at the same time. */
+BOOST_AUTO_TEST_CASE(GoAutoBookTest_ConcurrentGet)
+{
+    std::remove(FILENAME);
+    const unsigned int nuNodes = 2000;
+    const int nuThreads = 4;
+    GoAutoBookStore store(FILENAME);
+    for (unsigned int i = 0; i < nuNodes; ++i)
+        store.Put(SgHashCode(i), SgBookNode(float(i)));
+    store.Flush();
+    int nuErrors[nuThreads] = { 0 };
+    boost::thread_group threads;
+    for (int i = 0; i < nuThreads; ++i)
+        threads.create_thread(boost::bind(GetAll, &store, nuNodes,
+                                          &nuErrors[i]));
+    threads.join_all();
+    for (int i = 0; i < nuThreads; ++i)
+        BOOST_CHECK_EQUAL(nuErrors[i], 0);
+    std::remove(FILENAME);
+}
+
+/** An incomplete last line, as left by an interrupted flush, is removed
+    when the file is opened. */
+BOOST_AUTO_TEST_CASE(GoAutoBookTest_IncompleteLine)
+{
+    {
+        std::ofstream out(FILENAME);
+        out << SgHashCode(1).ToString() << '\t'
+            << SgBookNode(0.25f).ToString() << '\n'
+            << SgHashCode(2).ToString() << '\t'
+            << SgBookNode(0.5f).ToString() << '\n'
+            << SgHashCode(3).ToString() << "\tVal +0.1";
+    }
+    {
+        GoAutoBookStore store(FILENAME);
+        BOOST_CHECK_EQUAL(store.Size(), 2u);
+        SgBookNode node;
+        BOOST_CHECK(! store.Get(SgHashCode(3), node));
+        store.Put(SgHashCode(3), SgBookNode(0.75f));
+        store.Flush();
+    }
+    GoAutoBookStore store(FILENAME);
+    BOOST_CHECK_EQUAL(store.Size(), 3u);
+    SgBookNode node;
+    BOOST_REQUIRE(store.Get(SgHashCode(2), node));
+    BOOST_CHECK_EQUAL(node.m_heurValue, 0.5f);
+    BOOST_REQUIRE(store.Get(SgHashCode(3), node));
+    BOOST_CHECK_EQUAL(node.m_heurValue, 0.75f);
+    std::remove(FILENAME);
+}
+
+/** Flush() compacts the log if it contains many replaced nodes. */
+BOOST_AUTO_TEST_CASE(GoAutoBookTest_Compact)
+{
+    std::remove(FILENAME);
+    GoAutoBookStore store(FILENAME);
+    for (int n = 0; n < 10; ++n)
+    {
+        for (unsigned int i = 0; i < 10; ++i)
+            store.Put(SgHashCode(i), SgBookNode(float(n)));
+        store.Flush();
+        BOOST_CHECK(store.NuRecords() <= 2 * store.Size());
+    }
+    BOOST_CHECK_EQUAL(store.Size(), 10u);
+    SgBookNode node;
+    BOOST_REQUIRE(store.Get(SgHashCode(3), node));
+    BOOST_CHECK_EQUAL(node.m_heurValue, 9.f);
+    std::remove(FILENAME);
+}
+
+BOOST_AUTO_TEST_CASE(GoAutoBookTest_LookupMove)
+{
+    std::remove(FILENAME);
+    GoBoard bd(9);
+    GoAutoBookParam param;
+    {
+        GoAutoBook book(FILENAME, param);
+        GoAutoBookState state(bd);
+        state.Synchronize();
+        SgBookNode root(0.5f);
+        root.m_count = 1;
+        book.Put(state, root);
+        state.Play(Pt(5, 5));
+        book.Put(state, SgBookNode(0.2f));
+        state.Undo();
+        state.Play(Pt(3, 3));
+        book.Put(state, SgBookNode(0.4f));
+        book.Flush();
+    }
+    GoAutoBook book(FILENAME, param);
+    // Values are from the view of the opponent, the minimum is selected
+    BOOST_CHECK_EQUAL(book.LookupMove(bd), Pt(5, 5));
+    std::remove(FILENAME);
+}
+
+/** Save() does not overwrite the log of the book, also if the file name
+    is given by a different path. */
+BOOST_AUTO_TEST_CASE(GoAutoBookTest_SaveOwnFile)
+{
+    std::remove(FILENAME);
+    GoAutoBookParam param;
+    GoAutoBook book(FILENAME, param);
+    GoBoard bd(9);
+    GoAutoBookState state(bd);
+    state.Synchronize();
+    book.Put(state, SgBookNode(0.5f));
+    book.Flush();
+    BOOST_CHECK_THROW(book.Save(FILENAME), SgException);
+    BOOST_CHECK_THROW(book.Save(std::string("./") + FILENAME), SgException);
+    const char* otherFilename = "GoAutoBookTest_Save.dat";
+    book.Save(otherFilename);
+    SgBookNode node;
+    BOOST_CHECK(book.Get(state, node));
+    std::remove(otherFilename);
+    std::remove(FILENAME);
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
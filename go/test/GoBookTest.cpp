@@ -5,13 +5,17 @@
 
 #include "SgSystem.h"
 
+#include <cstdio>
+#include <fstream>
 #include <sstream>
 #include <boost/test/auto_unit_test.hpp>
 #include "GoBoard.h"
 #include "GoBoardUtil.h"
 #include "GoBook.h"
+#include "SgException.h"
 
 using std::istringstream;
+using std::string;
 using std::vector;
 using GoBoardUtil::UndoAll;
 using SgPointUtil::Pt;
@@ -131,6 +135,97 @@ BOOST_AUTO_TEST_CASE(GoBookTest_MatchInclToPlay)
     BOOST_REQUIRE_EQUAL(moves.size(), 0u);
 }
 
+/** Test that a compiled book returns the same moves as the book it was
+    created from for all rotations of the positions. */
+BOOST_AUTO_TEST_CASE(GoBookTest_Compiled)
+{
+    istringstream in("9 | E5\n"
+                     "9 E5 | C3 G7\n"
+                     "9 C3 C7 E5 | G3 G7\n"
+                     "19 | Q16\n"
+                     "19 Q16 | D4 D16\n"
+                     "19 Q16 D4 | C16\n");
+    GoBook book;
+    book.Read(in);
+    const char* fileName = "GoBookTest_Compiled.bin";
+    book.WriteCompiled(fileName);
+    GoBook compiledBook;
+    compiledBook.Read(fileName);
+    std::remove(fileName);
+    BOOST_REQUIRE(compiledBook.IsCompiled());
+    BOOST_CHECK(! book.IsCompiled());
+    for (size_t i = 0; i < book.NuEntries(); ++i)
+    {
+        const GoBook::Entry& entry = book.GetEntry(i);
+        GoBoard bd;
+        for (int rot = 0; rot < 8; ++rot)
+        {
+            bd.Init(entry.m_size);
+            for (vector<SgPoint>::const_iterator it = entry.m_sequence.begin();
+                 it != entry.m_sequence.end(); ++it)
+                bd.Play(SgPointUtil::Rotate(rot, *it, entry.m_size));
+            vector<SgPoint> moves = compiledBook.LookupAllMoves(bd);
+            BOOST_CHECK(moves == book.LookupAllMoves(bd));
+            BOOST_CHECK_EQUAL(moves.size(), entry.m_moves.size());
+            BOOST_CHECK_EQUAL(compiledBook.Line(bd), entry.m_line);
+            bd.SetToPlay(SgOppBW(bd.ToPlay()));
+            BOOST_CHECK(compiledBook.LookupAllMoves(bd).empty());
+            BOOST_CHECK(book.LookupAllMoves(bd).empty());
+        }
+    }
+    GoBoard bd(9);
+    bd.Play(Pt(1, 1));
+    BOOST_CHECK(compiledBook.LookupAllMoves(bd).empty());
+    BOOST_CHECK_EQUAL(compiledBook.Line(bd), 0);
+    BOOST_CHECK_THROW(compiledBook.Add(bd, Pt(5, 5)), SgException);
+    compiledBook.Clear();
+    BOOST_CHECK(! compiledBook.IsCompiled());
+}
+
+/** Test that reading a compiled book rejects corrupt slots.
+    Changes the file with the offsets of the header (32 bytes) and the slots
+    (24 bytes each, with the size at offset 8 and the index of the first
+    move at offset 16). */
+BOOST_AUTO_TEST_CASE(GoBookTest_CompiledCorrupt)
+{
+    istringstream in("9 | E5\n");
+    GoBook book;
+    book.Read(in);
+    const char* fileName = "GoBookTest_CompiledCorrupt.bin";
+    book.WriteCompiled(fileName);
+    string data;
+    {
+        std::ifstream file(fileName, std::ios::binary);
+        std::ostringstream buffer;
+        buffer << file.rdbuf();
+        data = buffer.str();
+    }
+    const size_t headerSize = 32;
+    const size_t slotSize = 24;
+    const size_t nuSlots = (data.size() - headerSize) / slotSize;
+    for (int i = 0; i < 2; ++i)
+    {
+        string corrupt = data;
+        for (size_t j = 0; j < nuSlots; ++j)
+        {
+            char* slot = &corrupt[headerSize + j * slotSize];
+            if (i == 0 && slot[8] != 0)
+                // Move range outside of the move array
+                slot[16] = 100;
+            else if (i == 1 && slot[8] == 0)
+                // No empty slot
+                slot[8] = 9;
+        }
+        {
+            std::ofstream file(fileName, std::ios::binary);
+            file.write(corrupt.data(), corrupt.size());
+        }
+        GoBook compiledBook;
+        BOOST_CHECK_THROW(compiledBook.Read(fileName), SgException);
+    }
+    std::remove(fileName);
+}
+
 } // namespace
 
 //----------------------------------------------------------------------------
@@ -0,0 +1,64 @@
+//----------------------------------------------------------------------------
+/** @file GoPattern12PointTest.cpp
+    Unit tests for GoPattern12Point. */
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+
+#include <boost/test/auto_unit_test.hpp>
+#include <vector>
+#include "GoPattern12Point.h"
+#include "GoBoardUtil.h"
+#include "SgRandom.h"
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+/** Check that the cached contexts of all empty points are equal to
+    GoPattern12Point::Context(). */
+void CheckCache(const GoBoard& bd, GoPattern12PointCache& cache)
+{
+    cache.Update();
+    for (GoBoard::Iterator it(bd); it; ++it)
+        if (bd.IsEmpty(*it))
+            BOOST_REQUIRE_EQUAL(cache.Context(*it),
+                                GoPattern12Point::Context(bd, *it,
+                                                          bd.ToPlay(),
+                                                          bd.Opponent()));
+}
+
+/** Compare GoPattern12PointCache with GoPattern12Point::Context() in
+    random games with undo, as in the expansion of nodes in a search. */
+BOOST_AUTO_TEST_CASE(GoPattern12PointTest_Cache)
+{
+    SgRandom random;
+    GoBoard bd(19);
+    GoPattern12PointCache cache(bd);
+    for (int i = 0; i < 400; ++i)
+    {
+        std::vector<SgPoint> moves;
+        for (GoBoard::Iterator it(bd); it; ++it)
+            if (bd.IsLegal(*it)
+                && ! (bd.IsSuicide(*it)
+                      || GoBoardUtil::IsCompletelySurrounded(bd, *it)))
+                moves.push_back(*it);
+        if (moves.empty())
+            break;
+        // Expand a sibling, take it back and continue with another move
+        const SgPoint sibling = moves[random.Int(int(moves.size()))];
+        bd.Play(sibling);
+        CheckCache(bd, cache);
+        bd.Undo();
+        CheckCache(bd, cache);
+        bd.Play(moves[random.Int(int(moves.size()))]);
+        CheckCache(bd, cache);
+    }
+    // Nothing to recompute if the position did not change
+    cache.Update();
+    BOOST_CHECK_EQUAL(cache.NuComputed(), 0);
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
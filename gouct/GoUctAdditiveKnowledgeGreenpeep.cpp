@@ -36,38 +36,29 @@ const short unsigned int PASSPREDICTION = 2;
 
 const unsigned int PASS_CONTEXT = UINT_MAX;
 
-void ComputeContexts19(const GoBoard& bd,
-                     std::vector<SgUctMoveInfo>::const_iterator begin,
-                     std::vector<SgUctMoveInfo>::const_iterator end,
-                     unsigned int contexts[])
+void ComputeContexts19(const GoPattern12PointCache& cache,
+                       std::vector<SgUctMoveInfo>::const_iterator begin,
+                       std::vector<SgUctMoveInfo>::const_iterator end,
+                       unsigned int contexts[])
 {
-    SG_ASSERT(bd.Size() >= 15);
-    const SgBlackWhite toPlay = bd.ToPlay();
-    const SgBlackWhite opponent = bd.Opponent();
-
     for (int i = 0; begin != end; ++begin, ++i)
     {
         SgMove p = begin->m_move;
         if (p != SG_PASS)
-        {
-            unsigned int context =
-                GoPattern12Point::Context(bd, p, toPlay, opponent);
-            contexts[i] = context;
-        }
+            contexts[i] = cache.Context(p);
         else // Pass
             contexts[i] = PASS_CONTEXT;
     }
 }
 
 void ComputeContexts9(const GoBoard& bd,
-                     std::vector<SgUctMoveInfo>::const_iterator begin,
-                     std::vector<SgUctMoveInfo>::const_iterator end,
-                     unsigned int contexts[])
+                      const GoPattern12PointCache& cache,
+                      std::vector<SgUctMoveInfo>::const_iterator begin,
+                      std::vector<SgUctMoveInfo>::const_iterator end,
+                      unsigned int contexts[])
 {
     SG_ASSERT(bd.Size() < 15);
     std::bitset<SG_MAXPOINT + 1> atariBits;
-    const SgBlackWhite toPlay = bd.ToPlay();
-    const SgBlackWhite opponent = bd.Opponent();
     const bool koExists = bd.KoPoint() != SG_NULLPOINT;
     const SgMove lastMove = bd.GetLastMove();
     if (  ! SgIsSpecialMove(lastMove) // skip if Pass or Nullmove
@@ -85,8 +76,7 @@ void ComputeContexts9(const GoBoard& bd,
         SgMove p = begin->m_move;
         if (p != SG_PASS)
         {
-            unsigned int context =
-                GoPattern12Point::Context(bd, p, toPlay, opponent);
+            unsigned int context = cache.Context(p);
             if (koExists)
                 context |= GoPattern12Point::KO_BIT;
             if (! SgIsSpecialMove(p) && atariBits[p])
@@ -136,7 +126,8 @@ GoUctAdditiveKnowledgeGreenpeep::GoUctAdditiveKnowledgeGreenpeep(
                         const GoBoard& bd,
                         const GoUctAdditiveKnowledgeParamGreenpeep& param)
   : GoAdditiveKnowledge(bd),
-    m_param(param)
+    m_param(param),
+    m_contextCache(bd)
 { }
 
 void GoUctAdditiveKnowledgeGreenpeep::
@@ -144,7 +135,8 @@ ProcessPosition19(std::vector<SgUctMoveInfo>& moves)
 {
     SG_ASSERT(Board().Size() >= 15);
     const unsigned short* predictor(m_param.m_predictor19x19);
-    ComputeContexts19(Board(), moves.begin(), moves.end(), m_contexts);
+    m_contextCache.Update();
+    ComputeContexts19(m_contextCache, moves.begin(), moves.end(), m_contexts);
 
     for (std::size_t i = 0; i < moves.size(); ++i)
     {
@@ -165,7 +157,9 @@ ProcessPosition9(std::vector<SgUctMoveInfo>& moves)
 {
     SG_ASSERT(Board().Size() < 15);
     const unsigned short* predictor = m_param.m_predictor9x9;
-    ComputeContexts9(Board(), moves.begin(), moves.end(), m_contexts);
+    m_contextCache.Update();
+    ComputeContexts9(Board(), m_contextCache, moves.begin(), moves.end(),
+                     m_contexts);
 
     for (std::size_t i = 0; i < moves.size(); ++i)
     {
@@ -6,6 +6,7 @@
 #define GOUCT_ADDITIVEKNOWLEDGEGREENPEEP_H
 
 #include "GoAdditiveKnowledge.h"
+#include "GoPattern12Point.h"
 #include "GoUctPlayoutPolicy.h"
 #include <boost/static_assert.hpp>
 
@@ -52,6 +53,10 @@ private:
 
     const GoUctAdditiveKnowledgeParamGreenpeep& m_param;
 
+    /** Contexts of the empty points, updated incrementally between calls
+        of ProcessPosition(). */
+    GoPattern12PointCache m_contextCache;
+
     unsigned int m_contexts[SG_MAX_ONBOARD + 1];
 };
 
@@ -23,6 +23,23 @@ namespace {
     time. */
 const bool CONSISTENCY = false;
 
+/** Directions of the neighbors in the order used in the code of
+    GoPattern3x3::CodeOf8Neighbors(). */
+const int NB_3X3[8] = {
+    - SG_NS - SG_WE, - SG_NS, - SG_NS + SG_WE, - SG_WE,
+    SG_WE, SG_NS - SG_WE, SG_NS, SG_NS + SG_WE
+};
+
+/** Index of a direction in NB_3X3. */
+int IndexNb3x3(int dir)
+{
+    for (int i = 0; i < 8; ++i)
+        if (NB_3X3[i] == dir)
+            return i;
+    SG_ASSERT(false);
+    return -1;
+}
+
 } // namespace
 
 //----------------------------------------------------------------------------
@@ -66,7 +83,15 @@ void GoUctBoard::CheckConsistency() const
             CheckConsistencyBlock(p);
         if (c == SG_EMPTY)
             SG_ASSERT(m_block[p] == 0);
+        SG_ASSERT(m_code3x3[p] == ComputeCode3x3(p));
     }
+#if GOUCT_BOARD_HASH
+    SgHashCode hash;
+    for (SgPoint p = 0; p < SG_MAXPOINT; ++p)
+        if (! IsBorder(p) && m_color[p] != SG_EMPTY)
+            SgHashUtil::XorZobrist(hash, p + m_color[p] * SG_MAXPOINT);
+    SG_ASSERT(hash == m_hash);
+#endif
 }
 
 void GoUctBoard::CheckConsistencyBlock(SgPoint point) const
@@ -145,6 +170,19 @@ void GoUctBoard::AddStoneToBlock(SgPoint p, Block* block)
     m_block[p] = block;
 }
 
+/** Compute the code of Pattern3x3Code() from the neighbors of a point. */
+int GoUctBoard::ComputeCode3x3(SgPoint p) const
+{
+    int code = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        const SgPoint nb = p + NB_3X3[i];
+        // Weights of border points are zero
+        code += m_color[nb] * m_code3x3Weight[nb][7 - i];
+    }
+    return code;
+}
+
 void GoUctBoard::CreateSingleStoneBlock(SgPoint p, SgBlackWhite c)
 {
     // Stone already placed
@@ -236,6 +274,15 @@ void GoUctBoard::UpdateBlocksAfterAddStone(SgPoint p, SgBlackWhite c,
     }
 }
 
+/** Update the 3x3 pattern codes of the neighbors of a point after its
+    color changed by @c delta. */
+inline void GoUctBoard::UpdateCode3x3(SgPoint p, int delta)
+{
+    const SgArray<int,8>& weight = m_code3x3Weight[p];
+    for (int i = 0; i < 8; ++i)
+        m_code3x3[p + NB_3X3[i]] += delta * weight[i];
+}
+
 void GoUctBoard::Init(const GoBoard& bd)
 {
     if (bd.Size() != m_size)
@@ -246,6 +293,9 @@ void GoUctBoard::Init(const GoBoard& bd)
     m_lastMove = bd.GetLastMove();
     m_secondLastMove = bd.Get2ndLastMove();
     m_toPlay = bd.ToPlay();
+#if GOUCT_BOARD_HASH
+    m_hash.Clear();
+#endif
     for (GoBoard::Iterator it(bd); it; ++it)
     {
         const SgPoint p = *it;
@@ -269,10 +319,50 @@ void GoUctBoard::Init(const GoBoard& bd)
             for (GoBoard::LibertyIterator it2(bd, p); it2; ++it2)
                 block.m_liberties.PushBack(*it2);
         }
+#if GOUCT_BOARD_HASH
+        if (c != SG_EMPTY)
+            XorHashStone(p, c);
+#endif
     }
+    for (Iterator it(*this); it; ++it)
+        m_code3x3[*it] = ComputeCode3x3(*it);
     CheckConsistency();
 }
 
+/** Initialize m_code3x3Weight for the current board size.
+    Uses the same order of the neighbors as GoPattern3x3::CodeOf8Neighbors()
+    and GoPattern3x3::CodeOfEdgeNeighbors(). */
+void GoUctBoard::InitCode3x3Weights()
+{
+    for (SgPoint p = 0; p < SG_MAXPOINT; ++p)
+        m_code3x3Weight[p].Fill(0);
+    for (Iterator it(*this); it; ++it)
+    {
+        const SgPoint p = *it;
+        if (Line(p) > 1)
+        {
+            int weight = 1;
+            for (int i = 7; i >= 0; --i)
+            {
+                m_code3x3Weight[p + NB_3X3[i]][7 - i] = weight;
+                weight *= 3;
+            }
+        }
+        else if (Pos(p) > 1)
+        {
+            const int up = Up(p);
+            const int other = GoPatternBase::OtherDir(up);
+            const int dir[5] = { other, up + other, up, up - other, -other };
+            int weight = 1;
+            for (int i = 4; i >= 0; --i)
+            {
+                m_code3x3Weight[p + dir[i]][IndexNb3x3(-dir[i])] = weight;
+                weight *= 3;
+            }
+        }
+    }
+}
+
 void GoUctBoard::InitSize(const GoBoard& bd)
 {
     m_size = bd.Size();
@@ -291,6 +381,8 @@ void GoUctBoard::InitSize(const GoBoard& bd)
             m_isBorder[p] = false;
     }
     m_const.ChangeSize(m_size);
+    m_code3x3.Fill(0);
+    InitCode3x3Weights();
 }
 
 void GoUctBoard::NeighborBlocks(SgPoint p, SgBlackWhite c,
@@ -320,6 +412,10 @@ void GoUctBoard::AddStone(SgPoint p, SgBlackWhite c)
     SG_ASSERT(IsEmpty(p));
     SG_ASSERT_BW(c);
     m_color[p] = c;
+    UpdateCode3x3(p, c - SG_EMPTY);
+#if GOUCT_BOARD_HASH
+    XorHashStone(p, c);
+#endif
     --m_nuNeighborsEmpty[p - SG_NS];
     --m_nuNeighborsEmpty[p - SG_WE];
     --m_nuNeighborsEmpty[p + SG_WE];
@@ -398,6 +494,10 @@ void GoUctBoard::KillBlock(const Block* block)
         SgPoint p = *it;
         AddLibToAdjBlocks(p, opp);
         m_color[p] = SG_EMPTY;
+        UpdateCode3x3(p, SG_EMPTY - c);
+#if GOUCT_BOARD_HASH
+        XorHashStone(p, c);
+#endif
         ++m_nuNeighborsEmpty[p - SG_NS];
         ++m_nuNeighborsEmpty[p - SG_WE];
         ++m_nuNeighborsEmpty[p + SG_WE];
@@ -12,6 +12,7 @@
 #include <boost/static_assert.hpp>
 #include "GoBoard.h"
 #include "GoBoardUtil.h"
+#include "GoPattern3x3.h"
 #include "GoPlayerMove.h"
 #include "SgArray.h"
 #include "SgArrayList.h"
@@ -19,6 +20,7 @@
 #include "SgBoardColor.h"
 #include "SgMarker.h"
 #include "SgBWArray.h"
+#include "SgHash.h"
 #include "SgNbIterator.h"
 #include "SgPoint.h"
 #include "SgPointArray.h"
@@ -26,6 +28,17 @@
 
 //----------------------------------------------------------------------------
 
+/** @def GOUCT_BOARD_HASH
+    Maintain a hash code of the position in GoUctBoard.
+    Enabled with the configure option @c --enable-uct-board-hash. If
+    disabled, the board has no hash code functions and playouts pay nothing
+    for updating it. */
+#ifndef GOUCT_BOARD_HASH
+#define GOUCT_BOARD_HASH 0
+#endif
+
+//----------------------------------------------------------------------------
+
 class GoUctBoard;
 typedef GoNb4Iterator<GoUctBoard> GoUctNbIterator;
 
@@ -198,6 +211,15 @@ public:
     /** Return NumStones(p) == 1. */
     bool IsSingleStone(SgPoint p) const;
 
+    /** Code of the 3x3 pattern around a point.
+        Same as GoPattern3x3::CodeOf8Neighbors() if <code>Line(p) > 1</code>
+        and GoPattern3x3::CodeOfEdgeNeighbors() if <code>Line(p) == 1</code>
+        and <code>Pos(p) > 1</code>, but updated incrementally when stones
+        are added or captured, so that looking up a pattern is a single array
+        access. GoPattern3x3 has specializations of these functions for
+        GoUctBoard that return this code. */
+    int Pattern3x3Code(SgPoint p) const;
+
     /** Return whether the two stones are located in the same block.
         Return false if one of the stones is an empty or border point. */
     bool AreInSameBlock(SgPoint stone1, SgPoint stone2) const;
@@ -271,6 +293,22 @@ public:
         state. */
     void CheckConsistency() const;
 
+#if GOUCT_BOARD_HASH
+    /** Hash code of the stones on the board.
+        Updated incrementally in Play(). Uses the same Zobrist keys for the
+        stones as GoBoard::GetHashCode(), but in contrast to GoBoard, it
+        depends only on the stones and not on the history of captures.
+        Only available if GOUCT_BOARD_HASH is enabled. */
+    const SgHashCode& GetHashCode() const;
+
+    /** Hash code including the color to play and the ko point.
+        Positions with the same stones but a different color to play or ko
+        point have different legal moves, so this is the key to use for
+        looking up positions during the search.
+        Only available if GOUCT_BOARD_HASH is enabled. */
+    SgHashCode GetHashCodeInclToPlay() const;
+#endif
+
 private:
     /** Data related to a block of stones on the board. */
     struct Block
@@ -353,6 +391,22 @@ private:
 
     SgArray<bool,SG_MAXPOINT> m_isBorder;
 
+    /** See Pattern3x3Code() */
+    SgArray<int,SG_MAXPOINT> m_code3x3;
+
+    /** Weights of a stone in the 3x3 pattern codes of its neighbors.
+        <code>m_code3x3Weight[p][i]</code> is the weight of the color at p in
+        the code of the i'th neighbor of p in the order of
+        GoPattern3x3::CodeOf8Neighbors() (or zero if the neighbor has no
+        code). Depends only on the board size. */
+    SgArray<SgArray<int,8>,SG_MAXPOINT> m_code3x3Weight;
+
+#if GOUCT_BOARD_HASH
+    /** Hash code of the stones.
+        @see GetHashCode() */
+    SgHashCode m_hash;
+#endif
+
     /** Not implemented. */
     GoUctBoard(const GoUctBoard&);
 
@@ -365,6 +419,8 @@ private:
 
     void CreateSingleStoneBlock(SgPoint p, SgBlackWhite c);
 
+    void InitCode3x3Weights();
+
     void InitSize(const GoBoard& bd);
 
     bool IsAdjacentTo(SgPoint p, const Block* block) const;
@@ -377,8 +433,12 @@ private:
     void UpdateBlocksAfterAddStone(SgPoint p, SgBlackWhite c,
                                    const SgArrayList<Block*,4>& adjBlocks);
 
+    void UpdateCode3x3(SgPoint p, int delta);
+
     void CheckConsistencyBlock(SgPoint p) const;
 
+    int ComputeCode3x3(SgPoint p) const;
+
     bool FullBoardRepetition() const;
 
     void AddStone(SgPoint p, SgBlackWhite c);
@@ -387,6 +447,10 @@ private:
 
     bool HasLiberties(SgPoint p) const;
 
+#if GOUCT_BOARD_HASH
+    void XorHashStone(SgPoint p, SgBlackWhite c);
+#endif
+
 public:
     friend class LibertyIterator;
     friend class StoneIterator;
@@ -621,6 +685,23 @@ inline SgBoardColor GoUctBoard::GetColor(SgPoint p) const
     return m_color[p];
 }
 
+#if GOUCT_BOARD_HASH
+inline const SgHashCode& GoUctBoard::GetHashCode() const
+{
+    return m_hash;
+}
+
+inline SgHashCode GoUctBoard::GetHashCodeInclToPlay() const
+{
+    SgHashCode hash = m_hash;
+    // Same Zobrist index for the color to play as in GoBoard
+    SgHashUtil::XorZobrist(hash, m_toPlay + 1);
+    if (m_koPoint != SG_NULLPOINT)
+        SgHashUtil::XorInteger(hash, m_koPoint);
+    return hash;
+}
+#endif
+
 inline SgPoint GoUctBoard::GetLastMove() const
 {
     return m_lastMove;
@@ -887,6 +968,12 @@ inline SgBlackWhite GoUctBoard::Opponent() const
     return SgOppBW(m_toPlay);
 }
 
+inline int GoUctBoard::Pattern3x3Code(SgPoint p) const
+{
+    SG_ASSERT(IsValidPoint(p));
+    return m_code3x3[p];
+}
+
 inline SgGrid GoUctBoard::Pos(SgPoint p) const
 {
     return m_const.Pos(p);
@@ -924,6 +1011,38 @@ inline int GoUctBoard::Up(SgPoint p) const
     return m_const.Up(p);
 }
 
+#if GOUCT_BOARD_HASH
+inline void GoUctBoard::XorHashStone(SgPoint p, SgBlackWhite c)
+{
+    BOOST_STATIC_ASSERT(SG_BLACK == 0);
+    BOOST_STATIC_ASSERT(SG_WHITE == 1);
+    // Same Zobrist index for stones as in GoBoard
+    SgHashUtil::XorZobrist(m_hash, p + c * SG_MAXPOINT);
+}
+#endif
+
+//----------------------------------------------------------------------------
+
+namespace GoPattern3x3
+{
+
+template<>
+inline int CodeOf8Neighbors<GoUctBoard>(const GoUctBoard& bd, SgPoint p)
+{
+    SG_ASSERT(bd.Line(p) > 1);
+    return bd.Pattern3x3Code(p);
+}
+
+template<>
+inline int CodeOfEdgeNeighbors<GoUctBoard>(const GoUctBoard& bd, SgPoint p)
+{
+    SG_ASSERT(bd.Line(p) == 1);
+    SG_ASSERT(bd.Pos(p) > 1);
+    return bd.Pattern3x3Code(p);
+}
+
+} // namespace GoPattern3x3
+
 //----------------------------------------------------------------------------
 
 #endif // GOUCT_BOARD_H
@@ -49,6 +49,7 @@ bool IsBlockedInDeterministicMode(const string& name)
 {
 	return name == "ignore_clock"
     	|| name == "reuse_subtree"
+        || name == "tree_dir"
         || name == "number_threads"
         || name == "max_nodes"
         ;
@@ -330,11 +331,13 @@ void GoUctCommands::AddGoGuiAnalyzeCommands(GtpCommand& cmd)
         "plist/Uct Root Filter/uct_root_filter\n"
         "none/Uct SaveGames/uct_savegames %w\n"
         "none/Uct SaveTree/uct_savetree %w\n"
+        "string/Uct SaveTree Binary/uct_savetree_binary %s\n"
         "gfx/Uct Sequence/uct_sequence\n"
         "hstring/Uct Stat Player/uct_stat_player\n"
         "none/Uct Stat Player Clear/uct_stat_player_clear\n"
         "hstring/Uct Stat Policy/uct_stat_policy\n"
         "none/Uct Stat Policy Clear/uct_stat_policy_clear\n"
+        "hstring/Uct Stat Profile/uct_stat_profile\n"
         "hstring/Uct Stat Search/uct_stat_search\n"
         "dboard/Uct Stat Territory/uct_stat_territory\n";
 }
@@ -685,6 +688,8 @@ void GoUctCommands::CmdParamGlobalSearch(GtpCommand& cmd)
     @arg @c ignore_clock See GoUctPlayer::IgnoreClock
     @arg @c ponder See GoUctPlayer::EnablePonder
     @arg @c reuse_subtree See GoUctPlayer::ReuseSubtree
+    @arg @c tree_dir See GoUctPlayer::TreeDirectory (the empty string, if
+    the value is omitted)
     @arg @c use_root_filter See GoUctPlayer::UseRootFilter
     @arg @c max_games See GoUctPlayer::MaxGames
     @arg @c max_ponder_time See GoUctPlayer::MaxPonderTime
@@ -711,7 +716,8 @@ void GoUctCommands::CmdParamPlayer(GtpCommand& cmd)
             << "[string] resign_min_games " << p.ResignMinGames() << '\n'
             << "[string] resign_threshold " << p.ResignThreshold() << '\n'
             << "[list/playout_policy/uct/one_ply] search_mode "
-            << SearchModeToString(p.SearchMode()) << '\n';
+            << SearchModeToString(p.SearchMode()) << '\n'
+            << "[string] tree_dir " << p.TreeDirectory() << '\n';
     }
     else if (cmd.NuArg() >= 1 && cmd.NuArg() <= 2)
     {
@@ -746,6 +752,8 @@ void GoUctCommands::CmdParamPlayer(GtpCommand& cmd)
             p.SetResignThreshold(cmd.ArgMinMax<SgUctValue>(1, 0, 1));
         else if (name == "search_mode")
             p.SetSearchMode(SearchModeArg(cmd, 1));
+        else if (name == "tree_dir")
+            p.SetTreeDirectory(cmd.NuArg() == 2 ? cmd.Arg(1) : "");
         else
             throw GtpFailure() << "unknown parameter: " << name;
 
@@ -912,24 +920,30 @@ void GoUctCommands::CmdParamTreeFilter(GtpCommand& cmd)
     This command is compatible with the GoGui analyze command type "param".
 
     Parameters:
+    @arg @c atomic_tree See SgUctSearch::AtomicTree
     @arg @c check_float_precision See SgUctSearch::CheckFloatPrecision
+    @arg @c incremental_prune See SgUctSearch::IncrementalPrune
     @arg @c keep_games See GoUctSearch::KeepGames
     @arg @c lock_free See SgUctSearch::LockFree
     @arg @c log_games See SgUctSearch::LogGames
+    @arg @c numa See SgUctSearch::Numa
     @arg @c prune_full_tree See SgUctSearch::PruneFullTree
     @arg @c rave See SgUctSearch::Rave
+    @arg @c transpositions See SgUctSearch::Transpositions
     @arg @c weight_rave_updates SgUctSearch::WeightRaveUpdates
     @arg @c bias_term_constant See SgUctSearch::BiasTermConstant
     @arg @c bias_term_frequency See SgUctSearch::BiasTermFrequency
     @arg @c expand_threshold See SgUctSearch::ExpandThreshold
     @arg @c first_play_urgency See SgUctSearch::FirstPlayUrgency
     @arg @c knowledge_threshold See SgUctSearch::KnowledgeThreshold
+    @arg @c knowledge_workers See SgUctSearch::KnowledgeWorkers
     @arg @c live_gfx @c none|counts|sequence See GoUctSearch::LiveGfx
     @arg @c live_gfx_interval See GoUctSearch::LiveGfxInterval
     @arg @c max_nodes See SgUctSearch::MaxNodes
     @arg @c move_select @c value|count|bound|rave See SgUctSearch::MoveSelect
     @arg @c number_threads See SgUctSearch::NumberThreads
     @arg @c number_playouts See SgUctSearch::NumberPlayouts
+    @arg @c numa_interleave_nodes See SgUctSearch::NumaInterleaveNodes
     @arg @c prune_min_count See SgUctSearch::PruneMinCount
     @arg @c rave_weight_final See SgUctSearch::RaveWeightFinal
     @arg @c rave_weight_initial See SgUctSearch::RaveWeightInitial */
@@ -941,13 +955,17 @@ void GoUctCommands::CmdParamSearch(GtpCommand& cmd)
     {
         // Boolean parameters first for better layout of GoGui parameter
         // dialog, alphabetically otherwise
-        cmd << "[bool] check_float_precision " << s.CheckFloatPrecision()
+        cmd << "[bool] atomic_tree " << s.AtomicTree() << '\n'
+            << "[bool] check_float_precision " << s.CheckFloatPrecision()
             << '\n'
+            << "[bool] incremental_prune " << s.IncrementalPrune() << '\n'
             << "[bool] keep_games " << s.KeepGames() << '\n'
             << "[bool] lock_free " << s.LockFree() << '\n'
             << "[bool] log_games " << s.LogGames() << '\n'
+            << "[bool] numa " << s.Numa() << '\n'
             << "[bool] prune_full_tree " << s.PruneFullTree() << '\n'
             << "[bool] rave " << s.Rave() << '\n'
+            << "[bool] transpositions " << s.Transpositions() << '\n'
             << "[bool] update_multiple_playouts_as_single " 
             << s.UpdateMultiplePlayoutsAsSingle() << '\n'
             << "[bool] virtual_loss " << s.VirtualLoss() << '\n'
@@ -962,6 +980,7 @@ void GoUctCommands::CmdParamSearch(GtpCommand& cmd)
             << "[string] first_play_urgency " << s.FirstPlayUrgency() << '\n'
             << "[string] knowledge_threshold "
             << KnowledgeThresholdToString(s.KnowledgeThreshold()) << '\n'
+            << "[string] knowledge_workers " << s.KnowledgeWorkers() << '\n'
             << "[string] max_knowledge_threads " 
             << s.MaxKnowledgeThreads() << '\n'
             << "[list/none/counts/sequence] live_gfx "
@@ -972,6 +991,8 @@ void GoUctCommands::CmdParamSearch(GtpCommand& cmd)
             << SgGtpUtil::MoveSelectToString(s.MoveSelect()) << '\n'
             << "[string] number_threads " << s.NumberThreads() << '\n'
             << "[string] number_playouts " << s.NumberPlayouts() << '\n'
+            << "[string] numa_interleave_nodes " << s.NumaInterleaveNodes()
+            << '\n'
             << "[string] prune_min_count " << s.PruneMinCount() << '\n'
             << "[string] randomize_rave_frequency " 
             << s.RandomizeRaveFrequency() << '\n'
@@ -991,6 +1012,8 @@ void GoUctCommands::CmdParamSearch(GtpCommand& cmd)
 
         if (name == "additive_predictor_decay")
             s.AdditiveKnowledge().SetPredictorDecay(cmd.Arg<float>(1));
+        else if (name == "atomic_tree")
+            s.SetAtomicTree(cmd.Arg<bool>(1));
         else if (name == "bias_term_constant")
             s.SetBiasTermConstant(cmd.Arg<float>(1));
         else if (name == "bias_term_frequency")
@@ -1003,10 +1026,14 @@ void GoUctCommands::CmdParamSearch(GtpCommand& cmd)
             s.SetExpandThreshold(cmd.ArgMin<SgUctValue>(1, 0));
         else if (name == "first_play_urgency")
             s.SetFirstPlayUrgency(cmd.Arg<SgUctValue>(1));
+        else if (name == "incremental_prune")
+            s.SetIncrementalPrune(cmd.Arg<bool>(1));
         else if (name == "keep_games")
             s.SetKeepGames(cmd.Arg<bool>(1));
         else if (name == "knowledge_threshold")
             s.SetKnowledgeThreshold(KnowledgeThresholdFromString(cmd.Arg(1)));
+        else if (name == "knowledge_workers")
+            s.SetKnowledgeWorkers(cmd.Arg<unsigned int>(1));
         else if (name == "live_gfx")
             s.SetLiveGfx(LiveGfxArg(cmd, 1));
         else if (name == "live_gfx_interval")
@@ -1021,6 +1048,10 @@ void GoUctCommands::CmdParamSearch(GtpCommand& cmd)
             s.SetMaxNodes(cmd.ArgMin<size_t>(1, 1));
         else if (name == "move_select")
             s.SetMoveSelect(SgGtpUtil::MoveSelectArg(cmd, 1));
+        else if (name == "numa")
+            s.SetNuma(cmd.Arg<bool>(1));
+        else if (name == "numa_interleave_nodes")
+            s.SetNumaInterleaveNodes(cmd.Arg<size_t>(1));
         else if (name == "number_threads")
              s.SetNumberThreads(cmd.ArgMin<unsigned int>(1, 1));
         else if (name == "number_playouts")
@@ -1037,6 +1068,8 @@ void GoUctCommands::CmdParamSearch(GtpCommand& cmd)
             s.SetRaveWeightFinal(cmd.Arg<float>(1));
         else if (name == "rave_weight_initial")
             s.SetRaveWeightInitial(cmd.Arg<float>(1));
+        else if (name == "transpositions")
+            s.SetTranspositions(cmd.Arg<bool>(1));
         else if (name == "update_multiple_playouts_as_single")
             s.SetUpdateMultiplePlayoutsAsSingle(cmd.Arg<bool>(1));
         else if (name == "virtual_loss")
@@ -1240,6 +1273,23 @@ void GoUctCommands::CmdSaveTree(GtpCommand& cmd)
     }
 }
 
+/** Save the UCT tree of the last search in a binary file.
+    Arguments: directory <br>
+    Returns: The name of the file
+    @see GoUctSearch::SaveTreeBinary() */
+void GoUctCommands::CmdSaveTreeBinary(GtpCommand& cmd)
+{
+    cmd.CheckNuArg(1);
+    try
+    {
+        cmd << Search().SaveTreeBinary(cmd.Arg(0));
+    }
+    catch (const SgException& e)
+    {
+        throw GtpFailure(e.what());
+    }
+}
+
 /** Save all random games.
     Arguments: filename
     @see GoUctSearch::SaveGames() */
@@ -1332,6 +1382,19 @@ void GoUctCommands::CmdStatPolicyClear(GtpCommand& cmd)
     Policy(0).ClearStatistics();
 }
 
+/** Write the time spent in the phases of the games of the last search.
+    Arguments: none <br>
+    Only measured if Fuego was compiled with SG_UCT_PROFILE (configure
+    option @c --enable-uct-profile). The profiles of the threads are added.
+    @see SgUctPhaseProfile::Write() */
+void GoUctCommands::CmdStatProfile(GtpCommand& cmd)
+{
+    cmd.CheckArgNone();
+    if (! SG_UCT_PROFILE)
+        SgWarning() << "profiling not enabled at compile time\n";
+    Search().Statistics().m_profile.Write(cmd);
+}
+
 /** Write statistics of search and tree.
     Arguments: none
     @see SgUctSearch::WriteStatistics() */
@@ -1680,12 +1743,14 @@ void GoUctCommands::Register(GtpEngine& e)
     Register(e, "uct_root_filter", &GoUctCommands::CmdRootFilter);
     Register(e, "uct_savegames", &GoUctCommands::CmdSaveGames);
     Register(e, "uct_savetree", &GoUctCommands::CmdSaveTree);
+    Register(e, "uct_savetree_binary", &GoUctCommands::CmdSaveTreeBinary);
     Register(e, "uct_sequence", &GoUctCommands::CmdSequence);
     Register(e, "uct_score", &GoUctCommands::CmdScore);
     Register(e, "uct_stat_player", &GoUctCommands::CmdStatPlayer);
     Register(e, "uct_stat_player_clear", &GoUctCommands::CmdStatPlayerClear);
     Register(e, "uct_stat_policy", &GoUctCommands::CmdStatPolicy);
     Register(e, "uct_stat_policy_clear", &GoUctCommands::CmdStatPolicyClear);
+    Register(e, "uct_stat_profile", &GoUctCommands::CmdStatProfile);
     Register(e, "uct_stat_search", &GoUctCommands::CmdStatSearch);
     Register(e, "uct_stat_territory", &GoUctCommands::CmdStatTerritory);
     Register(e, "uct_value", &GoUctCommands::CmdValue);
@@ -81,12 +81,14 @@ public:
         - @link CmdRootFilter() @c uct_root_filter @endlink
         - @link CmdSaveGames() @c uct_savegames @endlink
         - @link CmdSaveTree() @c uct_savetree @endlink
+        - @link CmdSaveTreeBinary() @c uct_savetree_binary @endlink
         - @link CmdSequence() @c uct_sequence @endlink
         - @link CmdScore() @c uct_score @endlink
         - @link CmdStatPlayer() @c uct_stat_player @endlink
         - @link CmdStatPlayerClear() @c uct_stat_player_clear @endlink
         - @link CmdStatPolicy() @c uct_stat_policy @endlink
         - @link CmdStatPolicyClear() @c uct_stat_policy_clear @endlink
+        - @link CmdStatProfile() @c uct_stat_profile @endlink
         - @link CmdStatSearch() @c uct_stat_search @endlink
         - @link CmdStatTerritory() @c uct_stat_territory @endlink
         - @link CmdValue() @c uct_value @endlink
@@ -125,12 +127,14 @@ public:
     void CmdRootFilter(GtpCommand& cmd);
     void CmdSaveGames(GtpCommand& cmd);
     void CmdSaveTree(GtpCommand& cmd);
+    void CmdSaveTreeBinary(GtpCommand& cmd);
     void CmdScore(GtpCommand& cmd);
     void CmdSequence(GtpCommand& cmd);
     void CmdStatPlayer(GtpCommand& cmd);
     void CmdStatPlayerClear(GtpCommand& cmd);
     void CmdStatPolicy(GtpCommand& cmd);
     void CmdStatPolicyClear(GtpCommand& cmd);
+    void CmdStatProfile(GtpCommand& cmd);
     void CmdStatSearch(GtpCommand& cmd);
     void CmdStatTerritory(GtpCommand& cmd);
     void CmdValue(GtpCommand& cmd);
@@ -6,10 +6,13 @@
 #ifndef GOUCT_PLAYER_H
 #define GOUCT_PLAYER_H
 
+#include <boost/filesystem/operations.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <string>
 #include <vector>
 #include "GoBoard.h"
 #include "GoBoardRestorer.h"
+#include "GoCompiledBook.h"
 #include "GoPlayer.h"
 #include "GoTimeControl.h"
 #include "GoUctDefaultMoveFilter.h"
@@ -62,8 +65,13 @@ public:
     {
         std::size_t m_nuGenMove;
 
+        /** Fraction of the nodes of the old tree retained by reusing the
+            subtree (see ReuseSubtree()). */
         SgStatisticsExt<float,std::size_t> m_reuse;
 
+        /** Time for extracting the subtree to reuse. */
+        SgStatisticsExt<double,std::size_t> m_reuseTime;
+
         SgStatisticsExt<double,std::size_t> m_gamesPerSecond;
 
         Statistics();
@@ -212,6 +220,18 @@ public:
     /** See ReuseSubtree() */
     void SetReuseSubtree(bool enable);
 
+    /** Directory with precomputed search trees.
+        If not empty, a search first looks for a binary tree file for the
+        current position in this directory (see
+        GoUctSearch::TreeFileName()) and uses the tree in the file as the
+        initial tree instead of reusing the subtree of the last search.
+        Tree files can be written with GoUctSearch::SaveTreeBinary().
+        Default is empty. */
+    const std::string& TreeDirectory() const;
+
+    /** See TreeDirectory() */
+    void SetTreeDirectory(const std::string& directory);
+
     /** Threshold for position value to resign.
         Default is 0.01. */
     SgUctValue ResignThreshold() const;
@@ -280,6 +300,9 @@ public:
     /** See ReuseSubtree() */
     bool m_reuseSubtree;
 
+    /** See TreeDirectory() */
+    std::string m_treeDirectory;
+
     /** See EarlyPass() */
     bool m_earlyPass;
 
@@ -324,6 +347,8 @@ public:
     void FindInitTree(SgUctTree& initTree, SgBlackWhite toPlay,
                       double maxTime);
 
+    bool LoadInitTree(SgUctTree& initTree, SgBlackWhite toPlay);
+
     void SetDefaultParameters(int boardSize);
 
     bool VerifyNeutralMove(SgUctValue maxGames, double maxTime, SgPoint move);
@@ -408,6 +433,12 @@ inline bool GoUctPlayer<SEARCH, THREAD>::ReuseSubtree() const
     return m_reuseSubtree;
 }
 
+template <class SEARCH, class THREAD>
+inline const std::string& GoUctPlayer<SEARCH, THREAD>::TreeDirectory() const
+{
+    return m_treeDirectory;
+}
+
 template <class SEARCH, class THREAD>
 inline GoUctMoveFilter& GoUctPlayer<SEARCH, THREAD>::RootFilter()
 {
@@ -520,6 +551,7 @@ void GoUctPlayer<SEARCH, THREAD>::Statistics::Clear()
     m_nuGenMove = 0;
     m_gamesPerSecond.Clear();
     m_reuse.Clear();
+    m_reuseTime.Clear();
 }
 
 template <class SEARCH, class THREAD>
@@ -543,6 +575,9 @@ void GoUctPlayer<SEARCH, THREAD>::Statistics::Write(std::ostream& out) const
     out << '\n'
         << SgWriteLabel("Reuse");
     m_reuse.Write(out);
+    out << '\n'
+        << SgWriteLabel("ReuseTime");
+    m_reuseTime.Write(out);
     out << '\n';
 }
 
@@ -801,7 +836,14 @@ SgPoint GoUctPlayer<SEARCH, THREAD>::DoSearch(SgBlackWhite toPlay,
     SgUctTree* initTree = 0;
     SgTimer timer;
     double timeInitTree = 0;
-    if (m_reuseSubtree)
+    if (! m_treeDirectory.empty())
+    {
+        SgUctTree& tree = m_search.GetTempTree();
+        if (LoadInitTree(tree, toPlay))
+            initTree = &tree;
+        timeInitTree = timer.GetTime();
+    }
+    if (initTree == 0 && m_reuseSubtree)
     {
         initTree = &m_search.GetTempTree();
         timeInitTree = -timer.GetTime();
@@ -851,7 +893,7 @@ SgPoint GoUctPlayer<SEARCH, THREAD>::DoSearch(SgBlackWhite toPlay,
         out << SgWriteLabel("Value") << std::fixed << std::setprecision(2) 
             << value << '\n' << SgWriteLabel("Sequence") 
             << SgWritePointList(sequence, "", false);
-        if (m_reuseSubtree)
+        if (m_reuseSubtree || ! m_treeDirectory.empty())
             out << SgWriteLabel("TimeInitTree") << std::fixed 
                 << std::setprecision(2) << timeInitTree << '\n';
         if (m_useRootFilter)
@@ -906,8 +948,11 @@ void GoUctPlayer<SEARCH, THREAD>::FindInitTree(SgUctTree& initTree,
         SgDebug() << "GoUctPlayer: No tree to reuse found\n";
         return;
     }
+    SgTimer timer;
     SgUctTreeUtil::ExtractSubtree(m_search.Tree(), initTree, sequence, true,
                                   maxTime, m_search.PruneMinCount());
+    const double reuseTime = timer.GetTime();
+    m_statistics.m_reuseTime.Add(reuseTime);
     const size_t initTreeNodes = initTree.NuNodes();
     const size_t oldTreeNodes = m_search.Tree().NuNodes();
     if (oldTreeNodes > 1 && initTreeNodes >= 1)
@@ -915,7 +960,8 @@ void GoUctPlayer<SEARCH, THREAD>::FindInitTree(SgUctTree& initTree,
         const float reuse = float(initTreeNodes) / float(oldTreeNodes);
         const int reusePercent = static_cast<int>(100 * reuse);
         SgDebug() << "GoUctPlayer: Reusing " << initTreeNodes
-                  << " nodes (" << reusePercent << "%)\n";
+                  << " nodes (" << reusePercent << "%) time: "
+                  << reuseTime << "\n";
 
         //SgDebug() << SgWritePointList(sequence, "Sequence", false);
         m_statistics.m_reuse.Add(reuse);
@@ -941,6 +987,50 @@ void GoUctPlayer<SEARCH, THREAD>::FindInitTree(SgUctTree& initTree,
     }
 }
 
+/** Load the initial tree for the search from the tree directory.
+    @return @c true if a tree file for the current position was found and
+    loaded
+    @see TreeDirectory() */
+template <class SEARCH, class THREAD>
+bool GoUctPlayer<SEARCH, THREAD>::LoadInitTree(SgUctTree& initTree,
+                                               SgBlackWhite toPlay)
+{
+    Board().SetToPlay(toPlay);
+    const std::string fileName =
+        GoUctSearch::TreeFileName(m_treeDirectory, Board());
+    if (! boost::filesystem::exists(fileName))
+        return false;
+    SgTimer timer;
+    try
+    {
+        if (! initTree.Load(fileName, GoCompiledBook::Key(Board())))
+        {
+            SgWarning() << "GoUctPlayer: " << fileName
+                        << " is for a different position\n";
+            return false;
+        }
+    }
+    catch (const SgException& e)
+    {
+        SgWarning() << "GoUctPlayer: " << e.what() << '\n';
+        return false;
+    }
+    // The key does not contain the ko point and the move history
+    if (initTree.Root().HasChildren())
+        for (SgUctChildIterator it(initTree, initTree.Root()); it; ++it)
+            if (! Board().IsLegal((*it).Move()))
+            {
+                SgWarning() << "GoUctPlayer: illegal move in root child of "
+                            << fileName << '\n';
+                initTree.Clear();
+                return false;
+            }
+    SgDebug() << "GoUctPlayer: Loaded " << initTree.NuNodes()
+              << " nodes from " << fileName << " time: " << timer.GetTime()
+              << '\n';
+    return true;
+}
+
 template <class SEARCH, class THREAD>
 SgPoint GoUctPlayer<SEARCH, THREAD>::GenMove(const SgTimeRecord& time,
                                              SgBlackWhite toPlay)
@@ -1090,6 +1180,13 @@ void GoUctPlayer<SEARCH, THREAD>::SetReuseSubtree(bool enable)
     m_reuseSubtree = enable;
 }
 
+template <class SEARCH, class THREAD>
+void GoUctPlayer<SEARCH, THREAD>::SetTreeDirectory(
+                                               const std::string& directory)
+{
+    m_treeDirectory = directory;
+}
+
 template <class SEARCH, class THREAD>
 SgDefaultTimeControl& GoUctPlayer<SEARCH, THREAD>::TimeControl()
 {
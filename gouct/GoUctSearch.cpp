@@ -6,8 +6,11 @@
 #include "GoUctSearch.h"
 
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include "GoBoardUtil.h"
+#include "GoCompiledBook.h"
 #include "GoNodeUtil.h"
 #include "GoUctUtil.h"
 #include "SgDebug.h"
@@ -50,10 +53,10 @@ void AppendGame(SgNode* node, SgUctValue gameNumber, unsigned int threadId,
                 << "Game " << gameNumber << '\n';
         node = AppendChild(node, comment.str());
     }
-    size_t nuMovesInTree = info.m_inTreeSequence.size();
+    size_t nuMovesInTree = info.m_nuMovesInTree;
     for (size_t i = 0; i < nuMovesInTree; ++i)
     {
-        node = AppendChild(node, toPlay, info.m_inTreeSequence[i]);
+        node = AppendChild(node, toPlay, info.m_sequence[0][i]);
         toPlay = SgOppBW(toPlay);
     }
     SgNode* lastInTreeNode = node;
@@ -67,7 +70,7 @@ void AppendGame(SgNode* node, SgUctValue gameNumber, unsigned int threadId,
                 << "Eval " << info.m_eval[i] << '\n'
                 << "Aborted " << info.m_aborted[i] << '\n';
         node = AppendChild(node, comment.str());
-        for (size_t j = nuMovesInTree; j < info.m_sequence[i].size(); ++j)
+        for (size_t j = nuMovesInTree; j < info.m_sequence[i].Size(); ++j)
         {
             node = AppendChild(node, toPlay, info.m_sequence[i][j]);
             toPlay = SgOppBW(toPlay);
@@ -138,6 +141,19 @@ void GoUctState::GameStart()
     m_gameLength = 0;
 }
 
+SgHashCode GoUctState::PositionHash() const
+{
+    SG_ASSERT(! m_isInPlayout);
+    SgHashCode hash = m_bd.GetHashCodeInclToPlay();
+    // The ko point and a previous pass change the legal moves (and ending
+    // the game) in positions with the same stones
+    if (m_bd.KoPoint() != SG_NULLPOINT)
+        SgHashUtil::XorInteger(hash, m_bd.KoPoint());
+    if (m_bd.GetLastMove() == SG_PASS)
+        SgHashUtil::XorInteger(hash, SG_MAXPOINT);
+    return hash;
+}
+
 void GoUctState::StartPlayout()
 {
     m_uctBd.Init(m_bd);
@@ -206,12 +222,14 @@ void GoUctSearch::OnSearchIteration(SgUctValue gameNumber,
 {
     SgUctSearch::OnSearchIteration(gameNumber, threadId, info);
 
+    // gameNumber counts only the games of this thread, the interval is
+    // measured in the games of all threads
     if (m_liveGfx != GOUCT_LIVEGFX_NONE && threadId == 0
-        && NeedLiveGfx(gameNumber))
+        && NeedLiveGfx(GamesPlayed()))
     {
         DisplayGfx();
     }
-    if (! LockFree() && m_root != 0)
+    if (! LockFree() && ! AtomicTree() && m_root != 0)
         AppendGame(m_root, gameNumber, threadId, m_toPlay, info);
 }
 
@@ -249,10 +267,10 @@ void GoUctSearch::OnStartSearch()
     if (m_keepGames)
     {
         m_root = GoNodeUtil::CreateRoot(m_bd);
-        if (LockFree())
+        if (LockFree() || AtomicTree())
             SgWarning() <<
                 "GoUctSearch: keep games will be ignored"
-                " in lock free search\n";
+                " in lock free or atomic search\n";
     }
     m_toPlay = m_bd.ToPlay(); // Not needed if SetToPlay() was called
     for (SgBWIterator it; it; ++it)
@@ -285,11 +303,34 @@ void GoUctSearch::SaveTree(std::ostream& out, int maxDepth) const
                         maxDepth);
 }
 
+std::string GoUctSearch::SaveTreeBinary(const std::string& directory) const
+{
+    // Position of the last search
+    GoSetup setup;
+    setup.m_stones = m_stones;
+    setup.m_player = m_toPlay;
+    GoBoard bd(m_bd.Size(), setup);
+    const std::string fileName = TreeFileName(directory, bd);
+    Tree().Save(fileName, GoCompiledBook::Key(bd));
+    return fileName;
+}
+
 SgBlackWhite GoUctSearch::ToPlay() const
 {
     return m_toPlay;
 }
 
+std::string GoUctSearch::TreeFileName(const std::string& directory,
+                                      const GoBoard& bd)
+{
+    std::ostringstream fileName;
+    if (! directory.empty())
+        fileName << directory << '/';
+    fileName << std::hex << std::setw(16) << std::setfill('0')
+             << GoCompiledBook::Key(bd) << ".uct";
+    return fileName.str();
+}
+
 //----------------------------------------------------------------------------
 
 SgPoint GoUctSearchUtil::TrompTaylorPassCheck(SgPoint move,
@@ -58,6 +58,10 @@ public:
 
     void StartPlayouts();
 
+    /** Hash code of the in-tree board including the color to play, the ko
+        point and whether the last move was a pass. */
+    SgHashCode PositionHash() const;
+
     // @} // @name
 
     /** Board used during in-tree phase. */
@@ -195,6 +199,24 @@ public:
     /** See GoUctUtil::SaveTree() */
     void SaveTree(std::ostream& out, int maxDepth = -1) const;
 
+    /** Write the tree of the last search to a binary file.
+        The file can be loaded as initial tree of a search (see
+        GoUctPlayer::TreeDirectory()). See SgUctTree::Save() for the format.
+        @param directory The directory of the file. The file name is
+        TreeFileName() for the position of the last search.
+        @return The name of the written file
+        @throws SgException on write error. */
+    std::string SaveTreeBinary(const std::string& directory) const;
+
+    /** Name of the binary tree file for a position.
+        The name consists of the position key GoCompiledBook::Key() in
+        hexadecimal and the extension @c .uct. The key is also used as the
+        key of the tree in the file (see SgUctTree::Save()).
+        @param directory The directory; the empty string for the current
+        directory. */
+    static std::string TreeFileName(const std::string& directory,
+                                    const GoBoard& bd);
+
     /** Set initial color to play. */
     void SetToPlay(SgBlackWhite toPlay);
 
@@ -228,6 +250,7 @@ public:
     void SetLiveGfx(GoUctLiveGfx mode);
 
     /** Interval for outputting of live graphics commands for GoGui.
+        Counts the games of all threads, the output is done by thread 0.
         Default is every 5000 games.
         @see LiveGfx() */
     SgUctValue LiveGfxInterval() const;
@@ -0,0 +1,144 @@
+//----------------------------------------------------------------------------
+/** @file GoUctBitBoardTest.cpp
+    Unit tests for GoUctBitBoard. */
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+
+#include <boost/test/auto_unit_test.hpp>
+#include <vector>
+#include "GoUctBitBoard.h"
+#include "GoUctBoard.h"
+#include "GoUctPlayoutPolicy.h"
+#include "SgRandom.h"
+
+using SgPointUtil::Pt;
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+/** Check that the blocks of a point are the same on both boards. */
+void CheckSameBlock(const GoUctBoard& bd, const GoUctBitBoard& bitBd,
+                    SgPoint p)
+{
+    BOOST_REQUIRE_EQUAL(bd.Anchor(p), bitBd.Anchor(p));
+    BOOST_REQUIRE_EQUAL(bd.NumStones(p), bitBd.NumStones(p));
+    BOOST_REQUIRE_EQUAL(bd.NumLiberties(p), bitBd.NumLiberties(p));
+    BOOST_REQUIRE_EQUAL(bd.InAtari(p), bitBd.InAtari(p));
+    if (bd.NumLiberties(p) == 1)
+        BOOST_REQUIRE_EQUAL(bd.TheLiberty(p), bitBd.TheLiberty(p));
+    SgPointSet liberties;
+    for (GoUctBoard::LibertyIterator it(bd, p); it; ++it)
+        liberties.Include(*it);
+    SgPointSet bitLiberties;
+    SgPoint last = SG_NULLPOINT;
+    for (GoUctBitBoard::LibertyIterator it(bitBd, p); it; ++it)
+    {
+        // Liberties are iterated in increasing order
+        BOOST_REQUIRE(*it > last);
+        last = *it;
+        BOOST_REQUIRE(bitBd.IsLibertyOfBlock(*it, bitBd.Anchor(p)));
+        bitLiberties.Include(*it);
+    }
+    BOOST_REQUIRE(liberties == bitLiberties);
+}
+
+/** Check that both boards have the same position. */
+void CheckSamePosition(const GoUctBoard& bd, const GoUctBitBoard& bitBd)
+{
+    BOOST_REQUIRE_EQUAL(bd.ToPlay(), bitBd.ToPlay());
+    BOOST_REQUIRE_EQUAL(bd.NumPrisoners(SG_BLACK),
+                        bitBd.NumPrisoners(SG_BLACK));
+    BOOST_REQUIRE_EQUAL(bd.NumPrisoners(SG_WHITE),
+                        bitBd.NumPrisoners(SG_WHITE));
+    for (GoUctBoard::Iterator it(bd); it; ++it)
+    {
+        const SgPoint p = *it;
+        BOOST_REQUIRE_EQUAL(bd.GetColor(p), bitBd.GetColor(p));
+        if (bd.Occupied(p))
+            CheckSameBlock(bd, bitBd, p);
+    }
+}
+
+/** Play random legal moves on both boards and compare them after each
+    move. */
+BOOST_AUTO_TEST_CASE(GoUctBitBoardTest_SameAsGoUctBoard)
+{
+    SgRandom random;
+    GoBoard board(19);
+    GoUctBoard bd(board);
+    GoUctBitBoard bitBd(board);
+    for (int game = 0; game < 5; ++game)
+    {
+        bd.Init(board);
+        bitBd.Init(board);
+        for (int i = 0; i < 600; ++i)
+        {
+            // Legal moves that don't fill an own single-point eye
+            std::vector<SgPoint> moves;
+            for (GoUctBoard::Iterator it(bd); it; ++it)
+                if (bd.IsEmpty(*it) && bd.IsLegal(*it)
+                    && (bd.NumEmptyNeighbors(*it) > 0
+                        || bd.NumNeighbors(*it, bd.Opponent()) > 0))
+                {
+                    BOOST_REQUIRE(bitBd.IsLegal(*it));
+                    moves.push_back(*it);
+                }
+            SgPoint move = SG_PASS;
+            if (! moves.empty())
+                move = moves[random.Int(int(moves.size()))];
+            bd.Play(move);
+            bitBd.Play(move);
+            CheckSamePosition(bd, bitBd);
+        }
+    }
+}
+
+/** Copied from GoUctBoardTest_IsLibertyOfBlock */
+BOOST_AUTO_TEST_CASE(GoUctBitBoardTest_IsLibertyOfBlock)
+{
+    GoSetup setup;
+    setup.AddWhite(Pt(1, 2));
+    setup.AddWhite(Pt(2, 1));
+    setup.AddBlack(Pt(2, 2));
+    GoBoard board(9, setup);
+    GoUctBitBoard bd(board);
+    BOOST_CHECK(bd.IsLibertyOfBlock(Pt(1, 1), bd.Anchor(Pt(1, 2))));
+    BOOST_CHECK(bd.IsLibertyOfBlock(Pt(1, 1), bd.Anchor(Pt(2, 1))));
+    BOOST_CHECK(! bd.IsLibertyOfBlock(Pt(1, 1), bd.Anchor(Pt(2, 2))));
+    BOOST_CHECK(bd.IsLibertyOfBlock(Pt(3, 2), bd.Anchor(Pt(2, 2))));
+    BOOST_CHECK(bd.IsLibertyOfBlock(Pt(2, 3), bd.Anchor(Pt(2, 2))));
+    BOOST_CHECK(! bd.IsLibertyOfBlock(Pt(2, 3), bd.Anchor(Pt(1, 2))));
+}
+
+/** Playouts with GoUctPlayoutPolicy on GoUctBitBoard until two passes. */
+BOOST_AUTO_TEST_CASE(GoUctBitBoardTest_PlayoutPolicy)
+{
+    GoBoard board(9);
+    GoUctBitBoard bd(board);
+    GoUctPlayoutPolicyParam param;
+    GoUctPlayoutPolicy<GoUctBitBoard> policy(bd, param);
+    for (int game = 0; game < 10; ++game)
+    {
+        bd.Init(board);
+        policy.StartPlayout();
+        int nuPasses = 0;
+        int length = 0;
+        while (nuPasses < 2 && length < 3 * 81)
+        {
+            SgPoint move = policy.GenerateMove();
+            BOOST_REQUIRE(move == SG_PASS || bd.IsLegal(move));
+            nuPasses = (move == SG_PASS ? nuPasses + 1 : 0);
+            bd.Play(move);
+            policy.OnPlay();
+            ++length;
+        }
+        policy.EndPlayout();
+        BOOST_CHECK_EQUAL(nuPasses, 2);
+    }
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
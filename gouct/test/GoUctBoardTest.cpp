@@ -6,7 +6,9 @@
 #include "SgSystem.h"
 
 #include <boost/test/auto_unit_test.hpp>
+#include <vector>
 #include "GoUctBoard.h"
+#include "SgRandom.h"
 
 using SgPointUtil::Pt;
 
@@ -50,6 +52,120 @@ BOOST_AUTO_TEST_CASE(GoUctBoardTest_IsLibertyOfBlock)
     BOOST_CHECK(! bd.IsLibertyOfBlock(Pt(2, 3), bd.Anchor(Pt(1, 2))));
 }
 
+/** Compare the incrementally updated 3x3 pattern codes with the codes
+    computed from GoBoard during random games including captures. */
+BOOST_AUTO_TEST_CASE(GoUctBoardTest_Pattern3x3Code)
+{
+    SgRandom random;
+    for (int size = 7; size <= 19; size += 6)
+    {
+        GoBoard board(size);
+        GoUctBoard bd(board);
+        for (int i = 0; i < 3 * size * size; ++i)
+        {
+            std::vector<SgPoint> moves;
+            for (GoUctBoard::Iterator it(bd); it; ++it)
+                if (bd.IsEmpty(*it) && bd.IsLegal(*it)
+                    && (bd.NumEmptyNeighbors(*it) > 0
+                        || bd.NumNeighbors(*it, bd.Opponent()) > 0))
+                    moves.push_back(*it);
+            SgPoint move = SG_PASS;
+            if (! moves.empty())
+                move = moves[random.Int(int(moves.size()))];
+            bd.Play(move);
+            board.Play(move);
+            for (GoUctBoard::Iterator it(bd); it; ++it)
+            {
+                const SgPoint p = *it;
+                if (bd.Line(p) > 1)
+                    BOOST_REQUIRE_EQUAL(
+                                 GoPattern3x3::CodeOf8Neighbors(bd, p),
+                                 GoPattern3x3::CodeOf8Neighbors(board, p));
+                else if (bd.Pos(p) > 1)
+                    BOOST_REQUIRE_EQUAL(
+                                 GoPattern3x3::CodeOfEdgeNeighbors(bd, p),
+                                 GoPattern3x3::CodeOfEdgeNeighbors(board, p));
+            }
+        }
+    }
+}
+
+#if GOUCT_BOARD_HASH
+
+/** Compare the incrementally updated hash code with the one computed by
+    GoUctBoard::Init() during random games including captures. */
+BOOST_AUTO_TEST_CASE(GoUctBoardTest_HashCode)
+{
+    SgRandom random;
+    GoBoard board(9);
+    GoUctBoard bd(board);
+    for (int game = 0; game < 10; ++game)
+    {
+        board.Init(9);
+        bd.Init(board);
+        for (int i = 0; i < 200; ++i)
+        {
+            std::vector<SgPoint> moves;
+            for (GoUctBoard::Iterator it(bd); it; ++it)
+                if (bd.IsEmpty(*it) && bd.IsLegal(*it)
+                    && (bd.NumEmptyNeighbors(*it) > 0
+                        || bd.NumNeighbors(*it, bd.Opponent()) > 0))
+                    moves.push_back(*it);
+            SgPoint move = SG_PASS;
+            if (! moves.empty())
+                move = moves[random.Int(int(moves.size()))];
+            bd.Play(move);
+            board.Play(move);
+            GoUctBoard initBd(board);
+            BOOST_REQUIRE(bd.GetHashCode() == initBd.GetHashCode());
+            BOOST_REQUIRE(bd.GetHashCodeInclToPlay()
+                          == initBd.GetHashCodeInclToPlay());
+        }
+    }
+}
+
+/** Test that the hash code depends on the position, the color to play and
+    the ko point, but not on the move order. */
+BOOST_AUTO_TEST_CASE(GoUctBoardTest_HashCodeInclToPlay)
+{
+    GoBoard board(9);
+    GoUctBoard bd1(board);
+    GoUctBoard bd2(board);
+    BOOST_CHECK(bd1.GetHashCode().IsZero());
+    bd1.Play(Pt(1, 1));
+    bd1.Play(Pt(2, 2));
+    bd1.Play(Pt(3, 3));
+    bd2.Play(Pt(3, 3));
+    bd2.Play(Pt(2, 2));
+    BOOST_CHECK(bd1.GetHashCode() != bd2.GetHashCode());
+    bd2.Play(Pt(1, 1));
+    BOOST_CHECK(bd1.GetHashCode() == bd2.GetHashCode());
+    BOOST_CHECK(bd1.GetHashCodeInclToPlay() == bd2.GetHashCodeInclToPlay());
+    bd2.Play(SG_PASS);
+    BOOST_CHECK(bd1.GetHashCode() == bd2.GetHashCode());
+    BOOST_CHECK(bd1.GetHashCodeInclToPlay() != bd2.GetHashCodeInclToPlay());
+    // Black captures a white stone at 2,1 and creates a ko
+    GoSetup setup;
+    setup.AddBlack(Pt(1, 1));
+    setup.AddBlack(Pt(2, 2));
+    setup.AddWhite(Pt(2, 1));
+    setup.AddWhite(Pt(4, 1));
+    setup.AddWhite(Pt(3, 2));
+    board.Init(9, setup);
+    bd1.Init(board);
+    bd1.Play(Pt(3, 1));
+    BOOST_CHECK_EQUAL(bd1.NuCapturedStones(), 1);
+    setup.m_stones[SG_WHITE].Exclude(Pt(2, 1));
+    setup.AddBlack(Pt(3, 1));
+    setup.m_player = SG_WHITE;
+    board.Init(9, setup);
+    bd2.Init(board);
+    BOOST_CHECK(bd1.GetHashCode() == bd2.GetHashCode());
+    BOOST_CHECK(bd1.GetHashCodeInclToPlay() != bd2.GetHashCodeInclToPlay());
+}
+
+#endif // GOUCT_BOARD_HASH
+
 } // namespace
 
 //----------------------------------------------------------------------------
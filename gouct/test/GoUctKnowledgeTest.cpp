@@ -18,6 +18,12 @@ using SgPointUtil::Pt;
 
 namespace {
 
+/** Tolerance in percent for comparing values.
+    Depends on the precision of SgUctValue, which is float with
+    SG_UCT_COMPACT_NODE or --enable-uct-value-type=float. */
+const double VALUE_TOLERANCE =
+    sizeof(SgUctValue) < sizeof(double) ? 0.001 : 0.00001;
+
 class GoUctKnowledgeTester : public GoUctKnowledge
 {
 public:
@@ -49,10 +55,9 @@ void CheckValue(const SgUctMoveInfo& moveInfo, SgPoint p,
 {
     BOOST_CHECK_EQUAL(moveInfo.m_move, p);
     BOOST_CHECK_CLOSE(moveInfo.m_value, SgUctSearch::InverseEstimate(value),
-                      0.00001);
+                      VALUE_TOLERANCE);
     BOOST_CHECK_EQUAL(moveInfo.m_count, count);
-    BOOST_CHECK_CLOSE(moveInfo.m_raveValue, value,
-                      0.00001);
+    BOOST_CHECK_CLOSE(moveInfo.m_raveValue, value, VALUE_TOLERANCE);
     BOOST_CHECK_EQUAL(moveInfo.m_raveCount, count);
 }
 
@@ -6,7 +6,12 @@
 #include "SgDfpnSearch.h"
 #include "SgSearchTracer.h"
 
+#include <algorithm>
 #include <cmath>
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #include "SgDebug.h"
 #include "SgWrite.h"
 
@@ -19,12 +24,142 @@ namespace {
 */
 const bool USE_WIDENING = true;
 
+/** Bounds above this value are not increased by virtual proof and
+    disproof numbers.
+    Keeps the sums of bounds in UpdateBounds() far from INFTY. */
+const DfpnBoundType MAX_VIRTUAL_BOUND = 1000000;
+
 inline SgEmptyBlackWhite Winner(bool isWinning, SgEmptyBlackWhite toPlay)
 {
 	return isWinning ? toPlay : SgOppBW(toPlay);
 }
 
+/** Bound of a state searched by nuSearching other threads. */
+DfpnBoundType VirtualBound(DfpnBoundType bound, int nuSearching)
+{
+    if (bound >= MAX_VIRTUAL_BOUND)
+        return bound;
+    return std::min(bound * DfpnBoundType(nuSearching + 1),
+                    MAX_VIRTUAL_BOUND);
+}
+
 } // namespace
+
+//----------------------------------------------------------------------------
+
+/** Data shared by the threads of a parallel dfpn search.
+    The hash table is protected by NU_LOCKS locks. Each lock protects a
+    range of consecutive table entries of at least the block size of the
+    table, so the entries probed for a hash code are protected by at most
+    two locks, which are always acquired in ascending order. The statistics
+    counters of the hash table are still updated without synchronization
+    and are only approximate in a parallel search. */
+class DfpnSharedData
+{
+public:
+    /** Set by a thread when the root is solved or the search is aborted.
+        The other threads then return from MID() as fast as possible. */
+    boost::atomic<bool> m_stop;
+
+    explicit DfpnSharedData(DfpnHashTable& hashTable);
+
+    bool Lookup(SgHashCode hash, DfpnData& data) const;
+
+    /** Store an entry unless it would replace a solved entry with an
+        unsolved one.
+        Another thread can have solved the state, while this thread
+        searched it with older information. */
+    void Store(SgHashCode hash, const DfpnData& data);
+
+    /** Register a thread that starts searching a state. */
+    void Enter(SgHashCode hash);
+
+    /** Unregister a thread that has finished searching a state. */
+    void Leave(SgHashCode hash);
+
+    /** Number of threads searching a state.
+        States are mapped to NU_COUNTERS counters, so the number can
+        include threads in other states. */
+    int NuSearching(SgHashCode hash) const;
+
+private:
+    static const int NU_LOCKS = 4096;
+
+    static const int NU_COUNTERS = 1 << 16;
+
+    /** Size of the table entry block, see SgHashTable */
+    static const int BLOCK_SIZE = 4;
+
+    DfpnHashTable& m_hashTable;
+
+    int m_entriesPerLock;
+
+    mutable boost::mutex m_lock[NU_LOCKS];
+
+    boost::atomic<int> m_nuSearching[NU_COUNTERS];
+
+    /** Not implemented. */
+    DfpnSharedData(const DfpnSharedData&);
+
+    /** Not implemented. */
+    DfpnSharedData& operator=(const DfpnSharedData&);
+};
+
+DfpnSharedData::DfpnSharedData(DfpnHashTable& hashTable)
+    : m_stop(false),
+      m_hashTable(hashTable),
+      m_entriesPerLock(hashTable.MaxHash() / NU_LOCKS + BLOCK_SIZE)
+{
+    for (int i = 0; i < NU_COUNTERS; ++i)
+        m_nuSearching[i] = 0;
+}
+
+void DfpnSharedData::Enter(SgHashCode hash)
+{
+    m_nuSearching[hash.Hash(NU_COUNTERS)].fetch_add(1,
+                                                   boost::memory_order_relaxed);
+}
+
+void DfpnSharedData::Leave(SgHashCode hash)
+{
+    m_nuSearching[hash.Hash(NU_COUNTERS)].fetch_sub(1,
+                                                   boost::memory_order_relaxed);
+}
+
+bool DfpnSharedData::Lookup(SgHashCode hash, DfpnData& data) const
+{
+    const int h = hash.Hash(m_hashTable.MaxHash());
+    const int first = h / m_entriesPerLock;
+    const int last = (h + BLOCK_SIZE - 1) / m_entriesPerLock;
+    boost::mutex::scoped_lock lock1(m_lock[first]);
+    boost::mutex::scoped_lock lock2(m_lock[last], boost::defer_lock);
+    if (last != first)
+        lock2.lock();
+    return m_hashTable.Lookup(hash, &data);
+}
+
+int DfpnSharedData::NuSearching(SgHashCode hash) const
+{
+    return m_nuSearching[hash.Hash(NU_COUNTERS)].load(
+                                                   boost::memory_order_relaxed);
+}
+
+void DfpnSharedData::Store(SgHashCode hash, const DfpnData& data)
+{
+    const int h = hash.Hash(m_hashTable.MaxHash());
+    const int first = h / m_entriesPerLock;
+    const int last = (h + BLOCK_SIZE - 1) / m_entriesPerLock;
+    boost::mutex::scoped_lock lock1(m_lock[first]);
+    boost::mutex::scoped_lock lock2(m_lock[last], boost::defer_lock);
+    if (last != first)
+        lock2.lock();
+    DfpnData oldData;
+    if (! data.m_bounds.IsSolved() && m_hashTable.Lookup(hash, &oldData)
+        && oldData.m_bounds.IsSolved())
+        return;
+    m_hashTable.Store(hash, data);
+}
+
 //----------------------------------------------------------------------------
 
 void DfpnBounds::CheckConsistency() const
@@ -53,14 +188,30 @@ DfpnSolver::DfpnSolver()
       m_timelimit(0.0),
       m_wideningBase(1),
       m_wideningFactor(0.25f),
-      m_epsilon(0.0f)
+      m_epsilon(0.0f),
+      m_numberThreads(1),
+      m_shared(0)
 { }
 
 DfpnSolver::~DfpnSolver()
 { }
 
+void DfpnSolver::AddVirtualBounds(SgHashCode hash, DfpnBounds& bounds) const
+{
+    if (m_shared == 0 || bounds.IsSolved())
+        return;
+    const int nuSearching = m_shared->NuSearching(hash);
+    if (nuSearching > 0)
+    {
+        bounds.phi = VirtualBound(bounds.phi, nuSearching);
+        bounds.delta = VirtualBound(bounds.delta, nuSearching);
+    }
+}
+
 bool DfpnSolver::CheckAbort()
 {
+    if (m_shared != 0 && m_shared->m_stop.load(boost::memory_order_relaxed))
+        return true;
     if (! m_aborted)
     {
         if (SgUserAbort()) 
@@ -94,6 +245,11 @@ bool DfpnSolver::CheckAbort()
     return m_aborted;
 }
 
+DfpnSolver* DfpnSolver::CreateHelper() const
+{
+    return 0;
+}
+
 void DfpnSolver::GetPVFromHash(PointSequence& pv)
 {
     // to do: SgAssertRestore r(state of search in subclass);
@@ -115,7 +271,9 @@ void DfpnSolver::GetPVFromHash(PointSequence& pv)
 void DfpnSolver::LookupChildDataNonConst(SgMove move, DfpnData& data)
 {
     PlayMove(move);
-    if (! TTRead(data))
+    if (TTRead(data))
+        AddVirtualBounds(Hash(), data.m_bounds);
+    else
     {
         data.m_bounds.phi = 1;
         data.m_bounds.delta = 1;
@@ -220,7 +378,15 @@ size_t DfpnSolver::MID(const DfpnBounds& maxBounds, DfpnHistory& history)
         // Recurse on best child
         PlayMove(bestMove);
         history.Push(bestMove, currentHash);
-        localWork += MID(childMaxBounds, history);
+        if (m_shared != 0)
+        {
+            const SgHashCode childHash = Hash();
+            m_shared->Enter(childHash);
+            localWork += MID(childMaxBounds, history);
+            m_shared->Leave(childHash);
+        }
+        else
+            localWork += MID(childMaxBounds, history);
         history.Pop();
         UndoMove();
 
@@ -321,12 +487,87 @@ size_t DfpnSolver::ComputeMaxChildIndex(const std::vector<DfpnData>&
 }
 
 
+void DfpnSolver::InitStatistics()
+{
+    m_aborted = false;
+    m_numTerminal = 0;
+    m_numMIDcalls = 0;
+    m_generateMoves = 0;
+    m_totalWastedWork = 0;
+    m_prunedSiblingStats.Clear();
+    m_moveOrderingPercent.Clear();
+    m_moveOrderingIndex.Clear();
+    m_deltaIncrease.Clear();
+    m_checkTimerAbortCalls = 0;
+    m_threadMIDcalls.clear();
+}
+
+void DfpnSolver::ParallelSearch(const DfpnBounds& maxBounds)
+{
+    boost::scoped_ptr<DfpnSharedData> shared(
+                                         new DfpnSharedData(*m_hashTable));
+    std::vector<DfpnSolver*> helpers;
+    for (int i = 1; i < m_numberThreads; ++i)
+    {
+        DfpnSolver* helper = CreateHelper();
+        if (helper == 0)
+        {
+            SgWarning() << "DfpnSolver: parallel search not supported\n";
+            break;
+        }
+        helper->InitStatistics();
+        helper->m_hashTable = m_hashTable;
+        helper->m_timelimit = m_timelimit;
+        helper->m_wideningBase = m_wideningBase;
+        helper->m_wideningFactor = m_wideningFactor;
+        helper->m_epsilon = m_epsilon;
+        helper->m_shared = shared.get();
+        helper->m_timer.Start();
+        helpers.push_back(helper);
+    }
+    m_shared = shared.get();
+    boost::thread_group threads;
+    for (std::size_t i = 0; i < helpers.size(); ++i)
+        threads.create_thread(boost::bind(&DfpnSolver::SearchThread,
+                                          helpers[i], maxBounds));
+    SearchThread(maxBounds);
+    threads.join_all();
+    m_shared = 0;
+    m_threadMIDcalls.push_back(m_numMIDcalls);
+    for (std::size_t i = 0; i < helpers.size(); ++i)
+    {
+        const DfpnSolver& helper = *helpers[i];
+        m_threadMIDcalls.push_back(helper.m_numMIDcalls);
+        m_numMIDcalls += helper.m_numMIDcalls;
+        m_generateMoves += helper.m_generateMoves;
+        m_numTerminal += helper.m_numTerminal;
+        m_totalWastedWork += helper.m_totalWastedWork;
+        m_aborted = m_aborted || helper.m_aborted;
+        delete helpers[i];
+    }
+}
+
 void DfpnSolver::PrintStatistics(SgEmptyBlackWhite winner,
                                  const PointSequence& pv) const
 {
     std::ostringstream os;
     os << '\n'
-       << SgWriteLabel("MID calls") << m_numMIDcalls << '\n'
+       << SgWriteLabel("MID calls") << m_numMIDcalls << '\n';
+    if (m_threadMIDcalls.size() > 1)
+    {
+        // Share of the busiest thread, 1 / threads for a perfect balance
+        const std::size_t maxCalls = *std::max_element(
+                                                    m_threadMIDcalls.begin(),
+                                                    m_threadMIDcalls.end());
+        os << SgWriteLabel("Threads") << m_threadMIDcalls.size() << '\n'
+           << SgWriteLabel("MID calls/thread");
+        for (std::size_t i = 0; i < m_threadMIDcalls.size(); ++i)
+            os << (i > 0 ? " " : "") << m_threadMIDcalls[i];
+        os << '\n'
+           << SgWriteLabel("Max thread share")
+           << double(maxCalls) / double(m_numMIDcalls) << '\n';
+    }
+    os
        << SgWriteLabel("Generate moves") << m_generateMoves << '\n'
        << SgWriteLabel("Terminal") << m_numTerminal << '\n'
        << SgWriteLabel("Work") << m_numMIDcalls + m_numTerminal << '\n'
@@ -356,6 +597,21 @@ void DfpnSolver::PrintStatistics(SgEmptyBlackWhite winner,
     SgDebug() << os.str();
 }
 
+void DfpnSolver::SearchThread(const DfpnBounds& maxBounds)
+{
+    DfpnHistory history;
+    while (! CheckAbort())
+    {
+        // Another thread can have solved the root or increased its bounds
+        // beyond maxBounds
+        DfpnData data;
+        if (TTRead(data) && ! maxBounds.GreaterThan(data.m_bounds))
+            break;
+        MID(maxBounds, history);
+    }
+    m_shared->m_stop = true;
+}
+
 void DfpnSolver::SelectChild(std::size_t& bestIndex, DfpnBoundType& delta2,
                              const std::vector<DfpnData>& childrenData,
                              size_t maxChildIndex) const
@@ -397,17 +653,8 @@ SgEmptyBlackWhite DfpnSolver::StartSearch(DfpnHashTable& hashTable,
                                           PointSequence& pv,
                                           const DfpnBounds& maxBounds)
 {
-    m_aborted = false;
+    InitStatistics();
     m_hashTable = &hashTable;
-    m_numTerminal = 0;
-    m_numMIDcalls = 0;
-    m_generateMoves = 0;
-    m_totalWastedWork = 0;
-    m_prunedSiblingStats.Clear();
-    m_moveOrderingPercent.Clear();
-    m_moveOrderingIndex.Clear();
-    m_deltaIncrease.Clear();
-    m_checkTimerAbortCalls = 0;
 
     // Skip search if already solved
     DfpnData data;
@@ -423,8 +670,13 @@ SgEmptyBlackWhite DfpnSolver::StartSearch(DfpnHashTable& hashTable,
     }
 
     m_timer.Start();
-    DfpnHistory history;
-    MID(maxBounds, history);
+    if (m_numberThreads > 1)
+        ParallelSearch(maxBounds);
+    else
+    {
+        DfpnHistory history;
+        MID(maxBounds, history);
+    }
     m_timer.Stop();
 
     GetPVFromHash(pv);
@@ -441,6 +693,29 @@ SgEmptyBlackWhite DfpnSolver::StartSearch(DfpnHashTable& hashTable,
     return winner;
 }
 
+bool DfpnSolver::TTRead(SgHashCode hash, DfpnData& data) const
+{
+    if (m_shared != 0)
+        return m_shared->Lookup(hash, data);
+    return m_hashTable->Lookup(hash, &data);
+}
+
+bool DfpnSolver::TTRead(DfpnData& data) const
+{
+    return TTRead(Hash(), data);
+}
+
+void DfpnSolver::TTWrite(const DfpnData& data)
+{
+    #ifndef NDEBUG
+        data.m_bounds.CheckConsistency();
+    #endif
+    if (m_shared != 0)
+        m_shared->Store(Hash(), data);
+    else
+        m_hashTable->Store(Hash(), data);
+}
+
 void DfpnSolver::UpdateBounds(DfpnBounds& bounds, 
                               const std::vector<DfpnData>& childData,
                               size_t maxChildIndex) const
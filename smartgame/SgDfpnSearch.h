@@ -350,7 +350,23 @@ typedef SgHashTable<DfpnData, 4> DfpnHashTable;
 
 //----------------------------------------------------------------------------
 
+class DfpnSharedData;
+
+//----------------------------------------------------------------------------
+
 /** Solver using DFPN search. 
+
+    If NumberThreads() is greater than one and the subclass implements
+    CreateHelper(), StartSearch() runs a parallel df-pn search similar to
+    SPDFPN. Each thread uses its own solver with its own game state and
+    repeatedly calls MID() from the root until the root is solved. The
+    threads share the hash table, which is accessed under locks that each
+    protect a range of table entries. The threads avoid searching the same
+    subtree with virtual proof and disproof numbers: while threads search a
+    state, the bounds of this state as seen by the other threads are
+    increased according to the number of threads in it. A solved entry in
+    the table is never replaced by an unsolved one, so the winner is the
+    same as in a sequential search, but the principal variation can differ.
     @ingroup dfpn
 */
 class DfpnSolver 
@@ -413,6 +429,17 @@ public:
     
     size_t NumTerminalNodes() const;
 
+    /** Number of MID calls of each thread in the last search.
+        NumMIDcalls() is the sum of these numbers. */
+    const std::vector<size_t>& NumMIDcallsPerThread() const;
+
+    /** Create a solver for an additional thread of a parallel search.
+        The solver must be in the same state as this solver and must not
+        share the game state with it. The caller takes ownership. The
+        default implementation returns 0, which means that parallel
+        search is not supported. */
+    virtual DfpnSolver* CreateHelper() const;
+
     /** Write move. Override for game-specific output */
     virtual void WriteMove(std::ostream& stream, SgMove move) const;
 
@@ -453,9 +480,24 @@ public:
     
     /** See Epsilon() */
     void SetEpsilon(float epsilon);
+
+    /** Number of threads used by StartSearch().
+        Values greater than one require an implementation of
+        CreateHelper(). */
+    int NumberThreads() const;
+
+    /** See NumberThreads() */
+    void SetNumberThreads(int numberThreads);
     
     // @}
 
+protected:
+    /** Increase the bounds of a child by the virtual proof and disproof
+        numbers of a parallel search.
+        @param hash The hash code of the child
+        @param[in,out] bounds The bounds of the child from the hash table */
+    void AddVirtualBounds(SgHashCode hash, DfpnBounds& bounds) const;
+
 private:
 
     DfpnHashTable* m_hashTable;
@@ -474,6 +516,16 @@ private:
     /** See Epsilon() */
     float m_epsilon;
 
+    /** See NumberThreads() */
+    int m_numberThreads;
+
+    /** Data shared by the threads of a parallel search.
+        Null if no parallel search is running. */
+    DfpnSharedData* m_shared;
+
+    /** See NumMIDcallsPerThread() */
+    std::vector<size_t> m_threadMIDcalls;
+
     /** Number of calls to CheckAbort() before we check the timer.
         This is to avoid expensive calls to SgTime::Get(). Try to scale
         this so that it is checked twice a second. */
@@ -497,8 +549,16 @@ private:
 
     size_t m_totalWastedWork;
 
+    void InitStatistics();
+
     size_t MID(const DfpnBounds& n, DfpnHistory& history);
 
+    /** Run MID() in several threads until the root is solved. */
+    void ParallelSearch(const DfpnBounds& maxBounds);
+
+    /** Function of a thread in ParallelSearch() */
+    void SearchThread(const DfpnBounds& maxBounds);
+
     void SelectChild(std::size_t& bestIndex, DfpnBoundType& delta2, 
                      const std::vector<DfpnData>& childrenDfpnBounds,
                      size_t maxChildIndex) const;
@@ -522,7 +582,8 @@ private:
         The default method executes the move, so is not efficient.
         It is also not threadsafe if multiple threads search the same game.
         Override if a search has a more efficient/safe method to lookup
-        a child's hash code, e.g. direct computation */
+        a child's hash code, e.g. direct computation. An override should
+        call AddVirtualBounds() to support parallel search. */
     virtual void LookupChildData(SgMove move, DfpnData& data) const;
 
     /** Lookup data for child with index childIndex. */
@@ -562,6 +623,22 @@ inline size_t DfpnSolver::NumTerminalNodes() const
     return m_numTerminal;
 }
 
+inline const std::vector<size_t>& DfpnSolver::NumMIDcallsPerThread() const
+{
+    return m_threadMIDcalls;
+}
+
+inline int DfpnSolver::NumberThreads() const
+{
+    return m_numberThreads;
+}
+
+inline void DfpnSolver::SetNumberThreads(int numberThreads)
+{
+    SG_ASSERT(numberThreads >= 1);
+    m_numberThreads = numberThreads;
+}
+
 inline float DfpnSolver::Score(SgMove move) const
 {
 	SG_UNUSED(move);
@@ -593,25 +670,6 @@ inline double DfpnSolver::Timelimit() const
     return m_timelimit;
 }
 
-inline bool DfpnSolver::TTRead(SgHashCode hash, DfpnData& data) const
-{
-    return m_hashTable->Lookup(hash, &data);
-}
-
-
-inline bool DfpnSolver::TTRead(DfpnData& data) const
-{
-    return TTRead(Hash(), data);
-}
-
-inline void DfpnSolver::TTWrite(const DfpnData& data)
-{
-    #ifndef NDEBUG
-        data.m_bounds.CheckConsistency();
-    #endif
-    m_hashTable->Store(Hash(), data);
-}
-
 inline int DfpnSolver::WideningBase() const
 {
     return m_wideningBase;
@@ -0,0 +1,107 @@
+//----------------------------------------------------------------------------
+/** @file SgNuma.cpp
+    See SgNuma.h */
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+#include "SgNuma.h"
+
+#if defined(HAVE_LIBNUMA) && defined(HAVE_NUMA_H)
+#define SG_NUMA 1
+#include <numa.h>
+#include <unistd.h>
+#else
+#define SG_NUMA 0
+#endif
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+#if SG_NUMA
+
+/** Extend a memory range to page boundaries, as required by the memory
+    policy functions of libnuma. */
+void AlignToPages(void*& start, std::size_t& size)
+{
+    const std::size_t pageSize = static_cast<std::size_t>(getpagesize());
+    char* begin = static_cast<char*>(start);
+    char* end = begin + size;
+    std::size_t offset = reinterpret_cast<std::size_t>(begin) % pageSize;
+    begin -= offset;
+    std::size_t endOffset = reinterpret_cast<std::size_t>(end) % pageSize;
+    if (endOffset != 0)
+        end += pageSize - endOffset;
+    start = begin;
+    size = end - begin;
+}
+
+#endif // SG_NUMA
+
+} // namespace
+
+//----------------------------------------------------------------------------
+
+bool SgNuma::IsAvailable()
+{
+#if SG_NUMA
+    return numa_available() != -1;
+#else
+    return false;
+#endif
+}
+
+void SgNuma::Interleave(void* start, std::size_t size)
+{
+#if SG_NUMA
+    if (! IsAvailable() || size == 0)
+        return;
+    AlignToPages(start, size);
+    numa_interleave_memory(start, size, numa_all_nodes_ptr);
+#else
+    SG_UNUSED(start);
+    SG_UNUSED(size);
+#endif
+}
+
+int SgNuma::NuNodes()
+{
+#if SG_NUMA
+    if (IsAvailable())
+        return numa_max_node() + 1;
+#endif
+    return 1;
+}
+
+void SgNuma::PlaceOnNode(void* start, std::size_t size, int node)
+{
+#if SG_NUMA
+    if (! IsAvailable() || size == 0)
+        return;
+    AlignToPages(start, size);
+    numa_tonode_memory(start, size, node);
+#else
+    SG_UNUSED(start);
+    SG_UNUSED(size);
+    SG_UNUSED(node);
+#endif
+}
+
+void SgNuma::RunOnNode(int node)
+{
+#if SG_NUMA
+    if (! IsAvailable())
+        return;
+    numa_run_on_node(node);
+    numa_set_preferred(node);
+#else
+    SG_UNUSED(node);
+#endif
+}
+
+int SgNuma::ThreadNode(unsigned int threadId)
+{
+    return static_cast<int>(threadId % NuNodes());
+}
+
+//----------------------------------------------------------------------------
@@ -0,0 +1,48 @@
+//----------------------------------------------------------------------------
+/** @file SgNuma.h
+    Thread binding and memory placement on NUMA systems. */
+//----------------------------------------------------------------------------
+
+#ifndef SG_NUMA_H
+#define SG_NUMA_H
+
+#include <cstddef>
+
+//----------------------------------------------------------------------------
+
+/** Thread binding and memory placement on NUMA systems.
+    Uses libnuma, if Fuego was configured with it (it is used automatically
+    if the library and its header are found). Otherwise, the system is
+    treated as a single NUMA node and the functions have no effect. */
+namespace SgNuma
+{
+    /** Check if NUMA support is compiled in and supported by the system. */
+    bool IsAvailable();
+
+    /** Number of NUMA nodes.
+        Returns 1 if IsAvailable() is false. */
+    int NuNodes();
+
+    /** The NUMA node for a thread.
+        Threads are assigned to the NUMA nodes round-robin by their index. */
+    int ThreadNode(unsigned int threadId);
+
+    /** Restrict the calling thread to the CPUs of a NUMA node and prefer
+        memory of this node for its allocations. */
+    void RunOnNode(int node);
+
+    /** Place memory on a NUMA node.
+        Sets the memory policy of the pages that contain the given memory
+        range. Only pages that are touched after the call are affected, so
+        this should be called directly after allocating the memory. */
+    void PlaceOnNode(void* start, std::size_t size, int node);
+
+    /** Interleave memory over all NUMA nodes.
+        Like PlaceOnNode(), but the pages are distributed round-robin over
+        the nodes. */
+    void Interleave(void* start, std::size_t size);
+}
+
+//----------------------------------------------------------------------------
+
+#endif // SG_NUMA_H
@@ -11,11 +11,18 @@
 #include <limits>
 #include <sstream>
 #include <math.h>
+#include <stdint.h>
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
 #include "SgDebug.h"
 #include "SgHashTable.h"
 #include "SgMath.h"
 #include "SgNode.h"
 #include "SgProbCut.h"
+#include "SgRestorer.h"
 #include "SgSearchControl.h"
 #include "SgSearchValue.h"
 #include "SgTime.h"
@@ -118,10 +125,221 @@ void PrintPV(const SgSearch& search, int depth, int value,
     SgDebug() << '\n';
 }
 
+/** Vary the move order in the helper threads of a parallel search.
+    Keeps the first move, which is usually the best one, and rotates the
+    other moves by the index of the thread. */
+void VaryMoveOrder(SgVector<SgMove>& moves, int threadIndex)
+{
+    const int nuRest = moves.Length() - 1;
+    if (nuRest < 2 || threadIndex % nuRest == 0)
+        return;
+    SgMove* first = &moves[1];
+    std::rotate(first, first + threadIndex % nuRest, first + nuRest);
+}
+
 } // namespace
 
 //----------------------------------------------------------------------------
 
+/** Data shared by the threads of a parallel search.
+    Contains the lockless hash table and owns the helper searches and their
+    threads. The table has the same layout as SgSearchHashTable. The data
+    of an entry is packed into a 64-bit word, which is stored together with
+    the exclusive or of the data and the hash code. A lookup only accepts
+    an entry if the data and the check word match the hash code, so it
+    ignores entries that were written concurrently by another thread. */
+class SgSearchSharedData
+{
+public:
+    /** Set by the main thread when the search is finished.
+        The helpers then abort their search. */
+    boost::atomic<bool> m_stop;
+
+    std::vector<SgSearch*> m_helpers;
+
+    boost::thread_group m_threads;
+
+    explicit SgSearchSharedData(int maxHash);
+
+    /** Stops the helpers, if not already done, and deletes them. */
+    ~SgSearchSharedData();
+
+    bool Lookup(const SgHashCode& code, SgSearchHashData& data) const;
+
+    void Store(const SgHashCode& code, const SgSearchHashData& data);
+
+    /** Store all entries of a hash table. */
+    void Read(const SgSearchHashTable& hashTable);
+
+    /** Stop the helpers and wait for their threads to finish. */
+    void StopHelpers();
+
+    /** Replace the content of a hash table by the content of this table. */
+    void Write(SgSearchHashTable& hashTable) const;
+
+private:
+    static const int BLOCK_SIZE = 4;
+
+    /** Packed data with this bit set are valid. */
+    static const uint64_t VALID = uint64_t(1) << 63;
+
+    struct Entry
+    {
+        /** Hash code for Write().
+            Not used in Lookup(), so it does not matter that it is not
+            written atomically. */
+        SgHashCode m_hash;
+
+        boost::atomic<uint64_t> m_data;
+
+        /** Exclusive or of m_data and the key of the hash code. */
+        boost::atomic<uint64_t> m_check;
+    };
+
+    int m_maxHash;
+
+    boost::scoped_array<Entry> m_entry;
+
+    static uint64_t Key(const SgHashCode& code);
+
+    static uint64_t Pack(const SgSearchHashData& data);
+
+    static SgSearchHashData Unpack(uint64_t data);
+
+    /** Not implemented. */
+    SgSearchSharedData(const SgSearchSharedData&);
+
+    /** Not implemented. */
+    SgSearchSharedData& operator=(const SgSearchSharedData&);
+};
+
+SgSearchSharedData::SgSearchSharedData(int maxHash)
+    : m_stop(false),
+      m_maxHash(maxHash),
+      m_entry(new Entry[maxHash + BLOCK_SIZE - 1])
+{
+    for (int i = 0; i < m_maxHash + BLOCK_SIZE - 1; ++i)
+    {
+        m_entry[i].m_data.store(0, boost::memory_order_relaxed);
+        m_entry[i].m_check.store(0, boost::memory_order_relaxed);
+    }
+}
+
+SgSearchSharedData::~SgSearchSharedData()
+{
+    StopHelpers();
+    for (std::size_t i = 0; i < m_helpers.size(); ++i)
+        delete m_helpers[i];
+}
+
+uint64_t SgSearchSharedData::Key(const SgHashCode& code)
+{
+    return code.Code1() | (static_cast<uint64_t>(code.Code2()) << 32);
+}
+
+bool SgSearchSharedData::Lookup(const SgHashCode& code,
+                                SgSearchHashData& data) const
+{
+    const uint64_t key = Key(code);
+    const int h = code.Hash(m_maxHash);
+    for (int i = h; i < h + BLOCK_SIZE; ++i)
+    {
+        const Entry& entry = m_entry[i];
+        const uint64_t d = entry.m_data.load(boost::memory_order_relaxed);
+        if ((d & VALID) == 0)
+            return false;
+        if ((entry.m_check.load(boost::memory_order_relaxed) ^ d) == key)
+        {
+            data = Unpack(d);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t SgSearchSharedData::Pack(const SgSearchHashData& data)
+{
+    return static_cast<uint32_t>(data.BestMove())
+        | (static_cast<uint64_t>(static_cast<uint16_t>(data.Value())) << 32)
+        | (static_cast<uint64_t>(data.Depth() & 0xfff) << 48)
+        | (data.IsOnlyUpperBound() ? uint64_t(1) << 60 : 0)
+        | (data.IsOnlyLowerBound() ? uint64_t(1) << 61 : 0)
+        | (data.IsExactValue() ? uint64_t(1) << 62 : 0)
+        | VALID;
+}
+
+void SgSearchSharedData::Read(const SgSearchHashTable& hashTable)
+{
+    for (SgSearchHashTable::Iterator it(hashTable); it; ++it)
+        Store(it->m_hash, it->m_data);
+}
+
+void SgSearchSharedData::StopHelpers()
+{
+    m_stop = true;
+    m_threads.join_all();
+}
+
+void SgSearchSharedData::Store(const SgHashCode& code,
+                               const SgSearchHashData& data)
+{
+    const uint64_t key = Key(code);
+    const int h = code.Hash(m_maxHash);
+    int best = -1;
+    SgSearchHashData bestData;
+    for (int i = h; i < h + BLOCK_SIZE; ++i)
+    {
+        const Entry& entry = m_entry[i];
+        const uint64_t d = entry.m_data.load(boost::memory_order_relaxed);
+        if (  (d & VALID) == 0
+           || (entry.m_check.load(boost::memory_order_relaxed) ^ d) == key
+           )
+        {
+            best = i;
+            break;
+        }
+        const SgSearchHashData entryData = Unpack(d);
+        if (best == -1 || bestData.IsBetterThan(entryData))
+        {
+            best = i;
+            bestData = entryData;
+        }
+    }
+    SG_ASSERTRANGE(best, h, h + BLOCK_SIZE - 1);
+    Entry& entry = m_entry[best];
+    const uint64_t d = Pack(data);
+    entry.m_hash = code;
+    entry.m_data.store(d, boost::memory_order_relaxed);
+    entry.m_check.store(d ^ key, boost::memory_order_relaxed);
+}
+
+SgSearchHashData SgSearchSharedData::Unpack(uint64_t data)
+{
+    return SgSearchHashData(static_cast<int>((data >> 48) & 0xfff),
+                            static_cast<int16_t>((data >> 32) & 0xffff),
+                            static_cast<int32_t>(data & 0xffffffff),
+                            (data & (uint64_t(1) << 60)) != 0,
+                            (data & (uint64_t(1) << 61)) != 0,
+                            (data & (uint64_t(1) << 62)) != 0);
+}
+
+void SgSearchSharedData::Write(SgSearchHashTable& hashTable) const
+{
+    hashTable.Clear();
+    for (int i = 0; i < m_maxHash + BLOCK_SIZE - 1; ++i)
+    {
+        const Entry& entry = m_entry[i];
+        const uint64_t d = entry.m_data.load(boost::memory_order_relaxed);
+        if (  (d & VALID) != 0
+           && (entry.m_check.load(boost::memory_order_relaxed) ^ d)
+              == Key(entry.m_hash)
+           )
+            hashTable.Store(entry.m_hash, Unpack(d));
+    }
+}
+
+//----------------------------------------------------------------------------
+
 const int SgSearch::SG_INFINITY = numeric_limits<int>::max();
 
 SgSearch::SgSearch(SgSearchHashTable* hash)
@@ -140,7 +358,10 @@ SgSearch::SgSearch(SgSearchHashTable* hash)
       m_timerLevel(0),
       m_control(0),
       m_probcut(0),
-      m_abortFrequency(1)
+      m_abortFrequency(1),
+      m_numberThreads(1),
+      m_threadIndex(0),
+      m_shared(0)
 {
     InitSearch();
 }
@@ -175,7 +396,12 @@ void SgSearch::InitSearch(int startDepth)
 bool SgSearch::LookupHash(SgSearchHashData& data) const
 {
     SG_ASSERT(! data.IsValid());
-    if (m_hash == 0 || ! m_hash->Lookup(GetHashCode(), &data))
+    if (m_shared != 0)
+    {
+        if (! m_shared->Lookup(GetHashCode(), data))
+            return false;
+    }
+    else if (m_hash == 0 || ! m_hash->Lookup(GetHashCode(), &data))
         return false;
     if (DEBUG_SEARCH)
     {
@@ -212,7 +438,16 @@ void SgSearch::StoreHash(int depth, int value, SgMove move,
                   << ": ";
         WriteSgSearchHashData(SgDebug(), *this, data);
     }
-    m_hash->Store(GetHashCode(), data);
+    StoreHashData(GetHashCode(), data);
+}
+
+void SgSearch::StoreHashData(const SgHashCode& code,
+                             const SgSearchHashData& data)
+{
+    if (m_shared != 0)
+        m_shared->Store(code, data);
+    else
+        m_hash->Store(code, data);
 }
 
 bool SgSearch::TraceIsOn() const
@@ -222,6 +457,11 @@ bool SgSearch::TraceIsOn() const
 
 bool SgSearch::AbortSearch()
 {
+    if (  ! m_aborted
+       && m_threadIndex > 0
+       && m_shared->m_stop.load(boost::memory_order_relaxed)
+       )
+        m_aborted = true;
     if (! m_aborted)
     {
         // Checking abort is potentially expensive, involves system call.
@@ -323,6 +563,11 @@ void SgSearch::CallTakeBack()
     --m_currentDepth;
 }
 
+SgSearch* SgSearch::CreateHelper() const
+{
+    return 0;
+}
+
 void SgSearch::CreateTracer()
 {
     m_tracer = new SgSearchTracer(0);
@@ -345,7 +590,7 @@ void SgSearch::AddSequenceToHash(const SgVector<SgMove>& sequence, int depth)
             // Move is the only relevant data for seeding the hash table.
             SgSearchHashData data(0, 0, move);
             SG_ASSERT(move != SG_NULLMOVE);
-            m_hash->Store(GetHashCode(), data);
+            StoreHashData(GetHashCode(), data);
             if (DEBUG_SEARCH)
                 SgDebug() << "SgSearch::AddSequenceToHash: "
                           << MoveString(move) << '\n';
@@ -410,6 +655,12 @@ int SgSearch::DepthFirstSearch(int depthLimit, int boundLo, int boundHi,
     return value;
 }
 
+void SgSearch::HelperSearch(int depthMin, int depthMax, int boundLo,
+                            int boundHi, SgVector<SgMove> sequence)
+{
+    IteratedSearch(depthMin, depthMax, boundLo, boundHi, &sequence, false);
+}
+
 int SgSearch::IteratedSearch(int depthMin, int depthMax, int boundLo,
                              int boundHi, SgVector<SgMove>* sequence,
                              bool clearHash, SgNode* traceNode)
@@ -423,11 +674,44 @@ int SgSearch::IteratedSearch(int depthMin, int depthMax, int boundLo,
         m_tracer->InitTracing("IteratedSearch");
     }
     StartTime();
+    boost::scoped_ptr<SgSearchSharedData> shared;
+    SgRestorer<SgSearchSharedData*> restoreShared(&m_shared);
+    if (m_numberThreads > 1 && m_threadIndex == 0 && m_hash != 0)
+    {
+        shared.reset(new SgSearchSharedData(m_hash->MaxHash()));
+        if (! clearHash)
+            shared->Read(*m_hash);
+        m_shared = shared.get();
+    }
     if (clearHash && m_hash)
     {
         m_hash->Clear();
         AddSequenceToHash(*sequence, 0);
     }
+    if (shared)
+        for (int i = 1; i < m_numberThreads; ++i)
+        {
+            SgSearch* helper = CreateHelper();
+            if (helper == 0)
+            {
+                SgWarning() << "SgSearch: parallel search not supported\n";
+                break;
+            }
+            shared->m_helpers.push_back(helper);
+            helper->m_hash = m_hash;
+            helper->m_shared = m_shared;
+            helper->m_threadIndex = i;
+            helper->m_useScout = m_useScout;
+            helper->m_useKillers = m_useKillers;
+            helper->m_useOpponentBest = m_useOpponentBest;
+            helper->m_useNullMove = m_useNullMove;
+            helper->m_nullMoveDepth = m_nullMoveDepth;
+            helper->m_abortFrequency = m_abortFrequency;
+            shared->m_threads.create_thread(
+                boost::bind(&SgSearch::HelperSearch, helper,
+                            min(depthMin + i % 2, depthMax), depthMax,
+                            boundLo, boundHi, *sequence));
+        }
 
     int value = 0;
     m_depthLimit = depthMin;
@@ -480,6 +764,7 @@ int SgSearch::IteratedSearch(int depthMin, int depthMax, int boundLo,
                 PrintPV(*this, m_depthLimit, value, *sequence, isExactValue);
             m_prevValue = value;
             m_prevSequence = *sequence;
+            m_stat.SetDepthTime(m_depthLimit, m_timer.GetTime());
         }
 
         // Stop iteration as soon as exact result or a bounding value found.
@@ -494,6 +779,20 @@ int SgSearch::IteratedSearch(int depthMin, int depthMax, int boundLo,
             && (! CheckDepthLimitReached() || m_reachedDepthLimit)
             );
 
+    if (shared)
+    {
+        shared->StopHelpers();
+        // Add the helpers' node counts, but keep time and depth of the
+        // main thread
+        for (std::size_t i = 0; i < shared->m_helpers.size(); ++i)
+        {
+            SgSearchStatistics stat = shared->m_helpers[i]->m_stat;
+            stat.SetTimeUsed(0);
+            stat.SetDepthReached(0);
+            m_stat += stat;
+        }
+        shared->Write(*m_hash);
+    }
     StopTime();
     if (m_tracer && traceNode)
         m_tracer->AppendTrace(traceNode);
@@ -793,6 +1092,8 @@ int SgSearch::SearchEngine(int depth, int alpha, int beta,
         if (! foundCutoff && ! m_aborted)
         {
             CallGenerate(&moves, depth);
+            if (m_threadIndex > 0)
+                VaryMoveOrder(moves, m_threadIndex);
             // Iterate through all the moves to find the best move and
             // correct value for this position.
             for (SgVectorIterator<SgMove> it(moves); it && ! foundCutoff; ++it)
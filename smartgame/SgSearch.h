@@ -22,6 +22,7 @@ template <class DATA, int BLOCK_SIZE> class SgHashTable;
 class SgNode;
 class SgProbCut;
 class SgSearchControl;
+class SgSearchSharedData;
 
 //----------------------------------------------------------------------------
 
@@ -231,6 +232,20 @@ typedef SgStack<SgMove, SgSearchLimit::MAX_DEPTH> SgSearchStack;
     to the position where that value is really reached is returned,
     otherwise the empty list is returned.
 
+    IteratedSearch() can run a parallel search in the style of Lazy SMP, if
+    NumberThreads() is greater than one, a hash table is used, and the
+    subclass implements CreateHelper(). Helper searches run the same
+    iterated search in additional threads, with different move orders and
+    every other helper starting one depth higher. All threads use a
+    lockless hash table, in which an entry is stored together with the
+    exclusive or of its data and its hash code, so that entries that were
+    overwritten concurrently are detected and ignored (Hyatt and Mann). The
+    result and the statistics of the search are the ones of the main thread
+    with the node counts of the helpers added. The hash table passed to the
+    constructor is copied into the lockless table before the search, if
+    the search does not clear it, and receives its content after the
+    search.
+
     @todo Why does AmaSearch::Evaluate need the hash table, shouldn't that be
     done in SgSearch?
     @todo Remove m_depth, pass as argument to Evaluate instead
@@ -266,6 +281,21 @@ public:
         current depth, this function has to return false. */
     virtual bool CheckDepthLimitReached() const = 0;
 
+    /** Create a search for a helper thread of a parallel search.
+        The search must be in the same state as this search and must not
+        share the game state with it. The caller takes ownership. The
+        default implementation returns 0, which means that parallel search
+        is not supported. */
+    virtual SgSearch* CreateHelper() const;
+
+    /** Number of threads used by IteratedSearch().
+        Values greater than one require a hash table and an implementation
+        of CreateHelper(). */
+    int NumberThreads() const;
+
+    /** See NumberThreads() */
+    void SetNumberThreads(int numberThreads);
+
     const SgSearchHashTable* HashTable() const;
 
     void SetHashTable(SgSearchHashTable* hashtable);
@@ -518,10 +548,25 @@ private:
 
     int m_abortFrequency;
 
+    /** See NumberThreads() */
+    int m_numberThreads;
+
+    /** Index of the thread in a parallel search.
+        0 for the main thread and in a sequential search. */
+    int m_threadIndex;
+
+    /** Data shared by the threads of a parallel search.
+        Null if no parallel search is running. */
+    SgSearchSharedData* m_shared;
+
     /** Depth-first search (see implementation) */
     int DFS(int startDepth, int depthLimit, int boundLo, int boundHi,
             SgVector<SgMove>* sequence, bool* isExactValue);
 
+    /** Run IteratedSearch() as helper in a parallel search. */
+    void HelperSearch(int depthMin, int depthMax, int boundLo, int boundHi,
+                      SgVector<SgMove> sequence);
+
     /** Try to find current position in m_hash */
     bool LookupHash(SgSearchHashData& data) const;
 
@@ -531,6 +576,10 @@ private:
     void StoreHash(int depth, int value, SgMove move, bool isUpperBound,
                    bool isLowerBound, bool isExact);
 
+    /** Store data in m_hash or the shared hash table of a parallel
+        search. */
+    void StoreHashData(const SgHashCode& code, const SgSearchHashData& data);
+
     /** Seed the hash table with the given sequence. */
     void AddSequenceToHash(const SgVector<SgMove>& sequence, int depth);
 
@@ -579,6 +628,11 @@ inline int SgSearch::CurrentDepth() const
     return m_currentDepth;
 }
 
+inline int SgSearch::NumberThreads() const
+{
+    return m_numberThreads;
+}
+
 inline int SgSearch::DepthFirstSearch(int depthLimit,
                                       SgVector<SgMove>* sequence,
                                       bool clearHash, SgNode* traceNode)
@@ -646,6 +700,12 @@ inline void SgSearch::SetNullMove(bool flag)
     m_useNullMove = flag;
 }
 
+inline void SgSearch::SetNumberThreads(int numberThreads)
+{
+    SG_ASSERT(numberThreads >= 1);
+    m_numberThreads = numberThreads;
+}
+
 inline void SgSearch::SetNullMoveDepth(int depth)
 {
     m_nullMoveDepth = depth;
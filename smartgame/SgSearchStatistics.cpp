@@ -23,7 +23,8 @@ SgSearchStatistics::SgSearchStatistics(const SgSearchStatistics& stat)
       m_numMoves(stat.m_numMoves),
       m_numPass(stat.m_numPass),
       m_depthReached(stat.m_depthReached),
-      m_timeUsed(stat.m_timeUsed)
+      m_timeUsed(stat.m_timeUsed),
+      m_depthTime(stat.m_depthTime)
 { }
 
 SgSearchStatistics::~SgSearchStatistics()
@@ -40,6 +41,7 @@ SgSearchStatistics::operator=(const SgSearchStatistics& rhs)
         m_numPass = rhs.m_numPass;
         m_timeUsed = rhs.m_timeUsed;
         m_depthReached = rhs.m_depthReached;
+        m_depthTime = rhs.m_depthTime;
     }
     return *this;
 }
@@ -55,6 +57,7 @@ SgSearchStatistics::operator+=(const SgSearchStatistics& rhs)
     if (m_depthReached < rhs.m_depthReached)
     {
         m_depthReached = rhs.m_depthReached;
+        m_depthTime = rhs.m_depthTime;
     }
     return *this;
 }
@@ -67,6 +70,7 @@ void SgSearchStatistics::Clear()
     m_numPass = 0;
     m_timeUsed = 0;
     m_depthReached = 0;
+    m_depthTime.clear();
 }
 
 SgSearchStatistics* SgSearchStatistics::Duplicate() const
@@ -74,6 +78,14 @@ SgSearchStatistics* SgSearchStatistics::Duplicate() const
     return new SgSearchStatistics(*this);
 }
 
+void SgSearchStatistics::SetDepthTime(int depth, double time)
+{
+    SG_ASSERT(depth >= 0);
+    if (depth >= static_cast<int>(m_depthTime.size()))
+        m_depthTime.resize(depth + 1, -1);
+    m_depthTime[depth] = time;
+}
+
 double SgSearchStatistics::NumNodesPerSecond() const
 {
     double used = TimeUsed();
@@ -99,6 +111,16 @@ ostream& operator<<(ostream& stream, const SgSearchStatistics &s)
            << " DepthReached: " << s.DepthReached() << ", " 
            << s.NumNodesPerSecond() << " Nodes/s, "
            << s.NumEvalsPerSecond() << " Evals/s\n";
+    bool isFirst = true;
+    for (int depth = 0; depth <= s.DepthReached(); ++depth)
+        if (s.DepthTime(depth) >= 0)
+        {
+            stream << (isFirst ? "DepthTimes:" : "") << ' ' << depth << ':'
+                   << s.DepthTime(depth);
+            isFirst = false;
+        }
+    if (! isFirst)
+        stream << '\n';
     return stream;
 }
 
@@ -7,6 +7,7 @@
 #define SG_SEARCHSTATISTICS_H
 
 #include <iosfwd>
+#include <vector>
 
 //----------------------------------------------------------------------------
 
@@ -22,6 +23,9 @@ public:
 
     SgSearchStatistics& operator=(const SgSearchStatistics& rhs);
 
+    /** Add the counts of another search.
+        If the other search reached a greater depth, the depth reached and
+        the depth times are replaced by those of the other search. */
     SgSearchStatistics& operator+=(const SgSearchStatistics& rhs);
 
     /** Set the number of nodes and leafs searched to zero. */
@@ -29,6 +33,11 @@ public:
 
     int DepthReached() const;
 
+    /** Time when the iteration with a given depth was completed.
+        @return The time since the start of the search or -1, if no
+        iteration with this depth was completed. */
+    double DepthTime(int depth) const;
+
     virtual SgSearchStatistics* Duplicate() const;
 
     void IncNumEvals();
@@ -53,6 +62,12 @@ public:
 
     void SetDepthReached(int depthReached);
 
+    /** Record the time when the iteration with a given depth was
+        completed.
+        Used by SgSearch::IteratedSearch() to compare the time to reach a
+        given depth with different numbers of threads. */
+    void SetDepthTime(int depth, double time);
+
     /** Set the time used to the given value.
         Only needed because doesn't keep track of real time used, and some
         searches might want to report the real time rather than the thread
@@ -73,6 +88,9 @@ private:
     int m_depthReached;
 
     double m_timeUsed;
+
+    /** See DepthTime() */
+    std::vector<double> m_depthTime;
 };
 
 std::ostream& operator<<(std::ostream& stream,
@@ -83,6 +101,13 @@ inline int SgSearchStatistics::DepthReached() const
     return m_depthReached;
 }
 
+inline double SgSearchStatistics::DepthTime(int depth) const
+{
+    if (depth < 0 || depth >= static_cast<int>(m_depthTime.size()))
+        return -1;
+    return m_depthTime[depth];
+}
+
 inline void SgSearchStatistics::IncNumEvals()
 {
     ++m_numEvals;
@@ -0,0 +1,430 @@
+//----------------------------------------------------------------------------
+/** @file SgSharedMemorySynchronizer.cpp
+    See SgSharedMemorySynchronizer.h */
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+#include "SgSharedMemorySynchronizer.h"
+
+#include <errno.h>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <signal.h>
+#include <unistd.h>
+#endif
+#include <boost/atomic.hpp>
+#include <boost/format.hpp>
+#include <boost/interprocess/sync/interprocess_condition.hpp>
+#include <boost/interprocess/sync/interprocess_mutex.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/thread/thread.hpp>
+#include "SgException.h"
+#include "SgTimer.h"
+#include "SgUctSearch.h"
+#include "SgWrite.h"
+
+using namespace std;
+using boost::format;
+using boost::interprocess::interprocess_condition;
+using boost::interprocess::interprocess_mutex;
+using boost::interprocess::create_only;
+using boost::interprocess::managed_shared_memory;
+using boost::interprocess::open_only;
+using boost::interprocess::shared_memory_object;
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+typedef boost::interprocess::scoped_lock<interprocess_mutex> SharedLock;
+
+/** Maximum time in seconds that a non-root process waits for the root
+    process to create the shared memory segment. */
+const double ATTACH_TIMEOUT = 60;
+
+int CurrentProcessId()
+{
+#ifdef WIN32
+    return static_cast<int>(GetCurrentProcessId());
+#else
+    return static_cast<int>(getpid());
+#endif
+}
+
+/** Check if a process is still running.
+    On Windows, the check is not implemented and always returns @c true. */
+bool IsProcessRunning(int processId)
+{
+#ifdef WIN32
+    SG_UNUSED(processId);
+    return true;
+#else
+    return kill(static_cast<pid_t>(processId), 0) == 0 || errno == EPERM;
+#endif
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
+
+/** Data that a process publishes at a barrier. */
+struct SgSharedMemorySynchronizer::Slot
+{
+    double m_value;
+
+    double m_count;
+
+    bool m_flag;
+
+    int m_nuMoves;
+
+    SgMove m_moves[MAX_ROOT_MOVES];
+
+    double m_moveCounts[MAX_ROOT_MOVES];
+
+    double m_moveMeans[MAX_ROOT_MOVES];
+};
+
+/** Data in the shared memory segment.
+    Must only contain data that can be shared between processes (no
+    pointers). The slots are indexed by the parity of the barrier generation,
+    such that a process that has passed a barrier cannot overwrite the data
+    of the previous barrier before all processes have left it. */
+struct SgSharedMemorySynchronizer::SharedData
+{
+    interprocess_mutex m_mutex;
+
+    interprocess_condition m_condition;
+
+    const int m_nuProcesses;
+
+    /** Process ID of the root process that created the segment.
+        Used by the other processes to detect a segment that was left by a
+        root process that terminated abnormally. */
+    const int m_rootProcessId;
+
+    /** Number of processes waiting at the current barrier. */
+    int m_nuWaiting;
+
+    /** Number of completed barriers. */
+    unsigned int m_generation;
+
+    /** Number of the search that the root process has ended.
+        Written by the root process, polled without lock by the others.
+        An atomic in shared memory works across processes only if it is
+        lock-free (see the static assertion below). */
+    boost::atomic<int> m_abortSearch;
+
+    Slot m_slots[2][MAX_PROCESSES];
+
+    SharedData(int nuProcesses, int rootProcessId);
+};
+
+SgSharedMemorySynchronizer::SharedData::SharedData(int nuProcesses,
+                                                   int rootProcessId)
+    : m_nuProcesses(nuProcesses),
+      m_rootProcessId(rootProcessId),
+      m_nuWaiting(0),
+      m_generation(0),
+      m_abortSearch(-1)
+{ }
+
+BOOST_STATIC_ASSERT(BOOST_ATOMIC_INT_LOCK_FREE == 2);
+
+//----------------------------------------------------------------------------
+
+const int SgSharedMemorySynchronizer::MAX_PROCESSES;
+
+const int SgSharedMemorySynchronizer::MAX_ROOT_MOVES;
+
+SgSharedMemorySynchronizer::SgSharedMemorySynchronizer(const string& name,
+                                                       int rank,
+                                                       int nuProcesses)
+    : m_name(name),
+      m_rank(rank),
+      m_nuProcesses(nuProcesses),
+      m_isPondering(false),
+      m_searchNumber(0),
+      m_generation(0),
+      m_lastRootMoveCount(0),
+      m_data(0)
+{
+    if (nuProcesses < 1 || nuProcesses > MAX_PROCESSES)
+        throw SgException(format("SgSharedMemorySynchronizer: number of "
+                                 "processes must be in [1..%1%]")
+                          % MAX_PROCESSES);
+    if (rank < 0 || rank >= nuProcesses)
+        throw SgException(format("SgSharedMemorySynchronizer: invalid rank "
+                                 "%1%") % rank);
+    if (IsRootProcess())
+        Create();
+    else
+        Attach();
+    if (m_data->m_nuProcesses != nuProcesses)
+        throw SgException(format("SgSharedMemorySynchronizer: shared memory "
+                                 "'%1%' was created for %2% processes")
+                          % name % m_data->m_nuProcesses);
+    SharedLock lock(m_data->m_mutex);
+    m_generation = m_data->m_generation;
+}
+
+void SgSharedMemorySynchronizer::Attach()
+{
+    SgTimer timer;
+    while (true)
+    {
+        try
+        {
+            managed_shared_memory segment(open_only, m_name.c_str());
+            SharedData* data =
+                segment.find<SharedData>("SharedData").first;
+            if (data != 0 && IsProcessRunning(data->m_rootProcessId))
+            {
+                m_segment.swap(segment);
+                m_data = data;
+                return;
+            }
+            // Segment is not initialized yet or is left from a previous run
+        }
+        catch (const boost::interprocess::interprocess_exception&)
+        {
+            // Segment does not exist yet
+        }
+        if (timer.GetTime() > ATTACH_TIMEOUT)
+            throw SgException(format("SgSharedMemorySynchronizer: root "
+                                     "process did not create shared memory "
+                                     "'%1%'") % m_name);
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+}
+
+void SgSharedMemorySynchronizer::Create()
+{
+    // Extra space for the segment management data and the name index
+    const size_t size = sizeof(SharedData) + 65536;
+    // A segment with the same name can be left by processes that terminated
+    // abnormally, its barrier state would block or corrupt this run
+    shared_memory_object::remove(m_name.c_str());
+    try
+    {
+        managed_shared_memory segment(create_only, m_name.c_str(), size);
+        m_segment.swap(segment);
+        m_data = m_segment.construct<SharedData>("SharedData")
+            (m_nuProcesses, CurrentProcessId());
+    }
+    catch (const boost::interprocess::interprocess_exception& e)
+    {
+        throw SgException(format("SgSharedMemorySynchronizer: %1%")
+                          % e.what());
+    }
+}
+
+SgSharedMemorySynchronizer::~SgSharedMemorySynchronizer()
+{
+    if (IsRootProcess())
+        shared_memory_object::remove(m_name.c_str());
+}
+
+SgMpiSynchronizerHandle SgSharedMemorySynchronizer::Create(const string& name,
+                                                           int rank,
+                                                           int nuProcesses)
+{
+    return SgMpiSynchronizerHandle(
+                     new SgSharedMemorySynchronizer(name, rank, nuProcesses));
+}
+
+const SgSharedMemorySynchronizer::Slot* SgSharedMemorySynchronizer::Barrier()
+{
+    const Slot* slots = m_data->m_slots[m_generation % 2];
+    {
+        SharedLock lock(m_data->m_mutex);
+        SG_ASSERT(m_data->m_generation == m_generation);
+        if (++m_data->m_nuWaiting == m_nuProcesses)
+        {
+            m_data->m_nuWaiting = 0;
+            ++m_data->m_generation;
+            m_data->m_condition.notify_all();
+        }
+        else
+            while (m_data->m_generation == m_generation)
+                m_data->m_condition.wait(lock);
+    }
+    ++m_generation;
+    return slots;
+}
+
+double SgSharedMemorySynchronizer::Broadcast(double value)
+{
+    if (IsRootProcess())
+        LocalSlot().m_value = value;
+    return Barrier()[0].m_value;
+}
+
+bool SgSharedMemorySynchronizer::CheckAbort()
+{
+    return ! m_isPondering
+        && m_data->m_abortSearch.load(boost::memory_order_acquire)
+           == m_searchNumber;
+}
+
+bool SgSharedMemorySynchronizer::IsRootProcess() const
+{
+    return m_rank == 0;
+}
+
+SgSharedMemorySynchronizer::Slot& SgSharedMemorySynchronizer::LocalSlot()
+{
+    return m_data->m_slots[m_generation % 2][m_rank];
+}
+
+void SgSharedMemorySynchronizer::OnEndPonder()
+{
+    m_isPondering = false;
+}
+
+void SgSharedMemorySynchronizer::OnEndSearch(SgUctSearch &search)
+{
+    if (m_isPondering)
+        return;
+    if (IsRootProcess())
+        m_data->m_abortSearch.store(m_searchNumber,
+                                    boost::memory_order_release);
+    Slot& local = LocalSlot();
+    local.m_nuMoves = 0;
+    const SgUctTree& tree = search.Tree();
+    if (tree.Root().HasChildren())
+        for (SgUctChildIterator it(tree, tree.Root()); it; ++it)
+        {
+            const SgUctNode& child = *it;
+            if (child.MoveCount() == 0)
+                continue;
+            if (local.m_nuMoves == MAX_ROOT_MOVES)
+                break;
+            local.m_moves[local.m_nuMoves] = child.Move();
+            local.m_moveCounts[local.m_nuMoves] = child.MoveCount();
+            local.m_moveMeans[local.m_nuMoves] = child.Mean();
+            ++local.m_nuMoves;
+        }
+    const Slot* slots = Barrier();
+    for (int rank = 0; rank < m_nuProcesses; ++rank)
+    {
+        if (rank == m_rank)
+            continue;
+        const Slot& slot = slots[rank];
+        for (int i = 0; i < slot.m_nuMoves; ++i)
+            search.AddRootMoveResults(slot.m_moves[i],
+                                      SgUctValue(slot.m_moveMeans[i]),
+                                      SgUctValue(slot.m_moveCounts[i]));
+    }
+}
+
+void SgSharedMemorySynchronizer::OnSearchIteration(SgUctSearch &search,
+                                                   SgUctValue gameNumber,
+                                                   int threadId,
+                                                   const SgUctGameInfo& info)
+{
+    SG_UNUSED(search);
+    SG_UNUSED(gameNumber);
+    SG_UNUSED(threadId);
+    SG_UNUSED(info);
+}
+
+void SgSharedMemorySynchronizer::OnStartPonder()
+{
+    m_isPondering = true;
+}
+
+void SgSharedMemorySynchronizer::OnStartSearch(SgUctSearch &search)
+{
+    SG_UNUSED(search);
+    if (! m_isPondering)
+        ++m_searchNumber;
+}
+
+void SgSharedMemorySynchronizer::OnThreadEndSearch(SgUctSearch &search,
+                                                   SgUctThreadState &state)
+{
+    SG_UNUSED(search);
+    SG_UNUSED(state);
+}
+
+void SgSharedMemorySynchronizer::OnThreadStartSearch(SgUctSearch &search,
+                                                     SgUctThreadState &state)
+{
+    SG_UNUSED(search);
+    SG_UNUSED(state);
+}
+
+void SgSharedMemorySynchronizer::SynchronizeEarlyPassPossible(bool &flag)
+{
+    if (! m_isPondering)
+        flag = (Broadcast(flag ? 1 : 0) != 0);
+}
+
+void SgSharedMemorySynchronizer::SynchronizeMove(SgMove &move)
+{
+    if (! m_isPondering)
+        move = static_cast<SgMove>(Broadcast(move));
+}
+
+void SgSharedMemorySynchronizer::SynchronizePassWins(bool &flag)
+{
+    if (! m_isPondering)
+        flag = (Broadcast(flag ? 1 : 0) != 0);
+}
+
+void SgSharedMemorySynchronizer::SynchronizeSearchStatus(SgUctValue &value,
+                                                    bool &earlyAbort,
+                                                    SgUctValue &rootMoveCount)
+{
+    if (m_isPondering)
+        return;
+    Slot& local = LocalSlot();
+    local.m_value = value;
+    local.m_count = rootMoveCount;
+    local.m_flag = earlyAbort;
+    const Slot* slots = Barrier();
+    double count = 0;
+    double weightedValue = 0;
+    for (int rank = 0; rank < m_nuProcesses; ++rank)
+    {
+        count += slots[rank].m_count;
+        weightedValue += slots[rank].m_count * slots[rank].m_value;
+    }
+    if (count > 0)
+        value = SgUctValue(weightedValue / count);
+    rootMoveCount = SgUctValue(count);
+    earlyAbort = slots[0].m_flag;
+    m_lastRootMoveCount = rootMoveCount;
+}
+
+void SgSharedMemorySynchronizer::SynchronizeUserAbort(bool &flag)
+{
+    if (! m_isPondering)
+        flag = (Broadcast(flag ? 1 : 0) != 0);
+}
+
+void SgSharedMemorySynchronizer::SynchronizeValue(SgUctValue &value)
+{
+    if (! m_isPondering)
+        value = SgUctValue(Broadcast(value));
+}
+
+string SgSharedMemorySynchronizer::ToNodeFilename(const string &filename)
+    const
+{
+    if (IsRootProcess())
+        return filename;
+    return str(format("%1%.%2%") % filename % m_rank);
+}
+
+void SgSharedMemorySynchronizer::WriteStatistics(ostream& out) const
+{
+    out << SgWriteLabel("SyncProcesses") << m_nuProcesses << '\n'
+        << SgWriteLabel("SyncRank") << m_rank << '\n'
+        << SgWriteLabel("SyncGames") << m_lastRootMoveCount << '\n';
+}
+
+//----------------------------------------------------------------------------
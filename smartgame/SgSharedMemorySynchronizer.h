@@ -0,0 +1,200 @@
+//----------------------------------------------------------------------------
+/** @file SgSharedMemorySynchronizer.h
+    Synchronizer for several search processes on a single host. */
+//----------------------------------------------------------------------------
+
+#ifndef SG_SHAREDMEMORYSYNCHRONIZER_H
+#define SG_SHAREDMEMORYSYNCHRONIZER_H
+
+#include <string>
+#include <boost/interprocess/managed_shared_memory.hpp>
+#include "SgMpiSynchronizer.h"
+
+//----------------------------------------------------------------------------
+
+/** Synchronizer for several Fuego processes on the same machine.
+    The processes communicate through a shared memory segment (using
+    boost::interprocess), so no MPI installation is needed. All processes
+    must receive the same sequence of GTP commands; the synchronization
+    points are the calls of the Synchronize functions and the end of each
+    search.
+
+    The search is root-parallel: each process searches its own tree. When the
+    root process (rank 0) ends a search, it signals all other processes to
+    stop (see CheckAbort()). At the end of the search, each process publishes
+    the move counts and mean values of the children of the root and adds the
+    results of all other processes to its own root children
+    (see SgUctSearch::AddRootMoveResults()), so that all processes select
+    their move from the combined statistics. The Synchronize functions
+    broadcast the values of the root process, SynchronizeSearchStatus()
+    combines the values and root move counts of all processes.
+
+    No synchronization is done while pondering.
+
+    The root process creates the shared memory segment and stores its process
+    ID in it. A segment with the same name that was left by processes that
+    terminated abnormally is removed and created again by the root process.
+    The other processes wait until the root process has created the segment
+    and ignore segments whose root process is no longer running. If a process
+    terminates abnormally during a run, the other processes block at the next
+    synchronization point.
+    @ingroup sguctgroup */
+class SgSharedMemorySynchronizer
+    : public SgMpiSynchronizer
+{
+public:
+    /** Maximum number of processes. */
+    static const int MAX_PROCESSES = 32;
+
+    /** Maximum number of root children that are combined at the end of a
+        search. Additional children are ignored. */
+    static const int MAX_ROOT_MOVES = 512;
+
+    /** Constructor.
+        The root process creates the shared memory segment, the other
+        processes attach to it and wait up to 60 seconds for the root process
+        to create it.
+        @param name Name of the shared memory segment. Must be the same for
+        all processes.
+        @param rank Index of this process in [0..nuProcesses - 1]. The process
+        with rank 0 is the root process.
+        @param nuProcesses Number of processes.
+        @throws SgException If the parameters are invalid or do not match the
+        shared memory segment of the root process, or if the segment could
+        not be created or attached to. */
+    SgSharedMemorySynchronizer(const std::string& name, int rank,
+                               int nuProcesses);
+
+    /** Destructor.
+        The root process removes the shared memory segment. */
+    virtual ~SgSharedMemorySynchronizer();
+
+    static SgMpiSynchronizerHandle Create(const std::string& name, int rank,
+                                          int nuProcesses);
+
+    int Rank() const;
+
+    int NuProcesses() const;
+
+    /** Appends the rank to the file name for all processes except the root
+        process. */
+    virtual std::string ToNodeFilename(const std::string &filename) const;
+
+    virtual bool IsRootProcess() const;
+
+    virtual void OnStartSearch(SgUctSearch &search);
+
+    /** Combines the statistics of the root children of all processes. */
+    virtual void OnEndSearch(SgUctSearch &search);
+
+    virtual void OnThreadStartSearch(SgUctSearch &search,
+                                     SgUctThreadState &state);
+
+    virtual void OnThreadEndSearch(SgUctSearch &search,
+                                   SgUctThreadState &state);
+
+    /** Does nothing.
+        The statistics are only combined at the end of a search, exchanging
+        them after each game would serialize the processes. */
+    virtual void OnSearchIteration(SgUctSearch &search,
+                                   SgUctValue gameNumber,
+                                   int threadId,
+                                   const SgUctGameInfo& info);
+
+    virtual void OnStartPonder();
+
+    virtual void OnEndPonder();
+
+    virtual void WriteStatistics(std::ostream& out) const;
+
+    virtual void SynchronizeUserAbort(bool &flag);
+
+    virtual void SynchronizePassWins(bool &flag);
+
+    virtual void SynchronizeEarlyPassPossible(bool &flag);
+
+    virtual void SynchronizeMove(SgMove &move);
+
+    virtual void SynchronizeValue(SgUctValue &value);
+
+    /** Combines the search status of all processes.
+        The value is the mean of the values of all processes weighted by
+        their root move counts, the root move count is the sum of all root
+        move counts, the early abort flag is the flag of the root process. */
+    virtual void SynchronizeSearchStatus(SgUctValue &value, bool &earlyAbort,
+                                         SgUctValue &rootMoveCount);
+
+    /** Check if the root process has ended the current search. */
+    virtual bool CheckAbort();
+
+private:
+    struct Slot;
+
+    struct SharedData;
+
+    std::string m_name;
+
+    const int m_rank;
+
+    const int m_nuProcesses;
+
+    bool m_isPondering;
+
+    /** Number of searches started by this process.
+        All processes start the same searches, so the number identifies the
+        search to abort in SharedData::m_abortSearch. */
+    int m_searchNumber;
+
+    /** Local copy of the barrier generation.
+        The shared generation cannot change before this process reached the
+        barrier, so the local copy is valid between two barriers. */
+    unsigned int m_generation;
+
+    /** Number of games combined in the last SynchronizeSearchStatus(). */
+    SgUctValue m_lastRootMoveCount;
+
+    boost::interprocess::managed_shared_memory m_segment;
+
+    SharedData* m_data;
+
+    /** Attach to the segment created by the root process.
+        Waits until the segment exists and was created by a running root
+        process. */
+    void Attach();
+
+    /** Create the segment in the root process.
+        Removes an existing segment with the same name. */
+    void Create();
+
+    /** The slot of this process for the next barrier. */
+    Slot& LocalSlot();
+
+    /** Wait until all processes reached the barrier.
+        @return The slots of all processes, which were filled before
+        reaching the barrier. They are not overwritten before this process
+        reaches the next barrier. */
+    const Slot* Barrier();
+
+    /** Broadcast a value of the root process. */
+    double Broadcast(double value);
+
+    /** Not implemented */
+    SgSharedMemorySynchronizer(const SgSharedMemorySynchronizer&);
+
+    /** Not implemented */
+    SgSharedMemorySynchronizer& operator=(const SgSharedMemorySynchronizer&);
+};
+
+inline int SgSharedMemorySynchronizer::NuProcesses() const
+{
+    return m_nuProcesses;
+}
+
+inline int SgSharedMemorySynchronizer::Rank() const
+{
+    return m_rank;
+}
+
+//----------------------------------------------------------------------------
+
+#endif // SG_SHAREDMEMORYSYNCHRONIZER_H
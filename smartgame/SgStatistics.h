@@ -240,6 +240,11 @@ public:
 
     void Add(VALUE val);
 
+    /** Add all values of another statistics.
+        Equivalent to calling Add(val) for each value added to the other
+        statistics. */
+    void Add(const SgStatistics& statistics);
+
     void Clear();
 
     bool IsDefined() const;
@@ -302,6 +307,29 @@ void SgStatistics<VALUE,COUNT>::Add(VALUE val)
     }
 }
 
+template<typename VALUE, typename COUNT>
+void SgStatistics<VALUE,COUNT>::Add(const SgStatistics& statistics)
+{
+    if (! statistics.IsDefined())
+        return;
+    if (! IsDefined())
+    {
+        *this = statistics;
+        return;
+    }
+    COUNT countOld = Count();
+    VALUE meanOld = Mean();
+    COUNT countOther = statistics.Count();
+    VALUE meanOther = statistics.Mean();
+    m_statisticsBase.Add(meanOther, countOther);
+    VALUE mean = Mean();
+    COUNT count = Count();
+    m_variance = (VALUE(countOld) * (m_variance + meanOld * meanOld)
+                  + VALUE(countOther) * (statistics.m_variance
+                                         + meanOther * meanOther))
+                 / VALUE(count) - mean * mean;
+}
+
 template<typename VALUE, typename COUNT>
 inline void SgStatistics<VALUE,COUNT>::Clear()
 {
@@ -376,6 +404,10 @@ public:
 
     void Add(VALUE val);
 
+    /** Add all values of another statistics.
+        See SgStatistics::Add(const SgStatistics&) */
+    void Add(const SgStatisticsExt& statistics);
+
     void Clear();
 
     bool IsDefined() const;
@@ -418,6 +450,16 @@ void SgStatisticsExt<VALUE,COUNT>::Add(VALUE val)
         m_min = val;
 }
 
+template<typename VALUE, typename COUNT>
+void SgStatisticsExt<VALUE,COUNT>::Add(const SgStatisticsExt& statistics)
+{
+    m_statistics.Add(statistics.m_statistics);
+    if (statistics.m_max > m_max)
+        m_max = statistics.m_max;
+    if (statistics.m_min < m_min)
+        m_min = statistics.m_min;
+}
+
 template<typename VALUE, typename COUNT>
 inline void SgStatisticsExt<VALUE,COUNT>::Clear()
 {
@@ -0,0 +1,256 @@
+//----------------------------------------------------------------------------
+/** @file SgStatisticsAtomic.h
+    Specialized version of SgStatisticsBase for concurrent use without locks.
+    Like SgStatisticsVltBase, but the member variables are atomic variables
+    and the write order dependency between mean and count is expressed with
+    explicit memory ordering constraints instead of the volatile qualifier.
+    This makes the guarantees independent of the memory model of the CPU
+    (see @ref sguctsearchlockfree). */
+//----------------------------------------------------------------------------
+
+#ifndef SG_STATISTICSATOMIC_H
+#define SG_STATISTICSATOMIC_H
+
+#include <iostream>
+#include <limits>
+#include <boost/atomic.hpp>
+#include "SgException.h"
+#include "SgWrite.h"
+
+//----------------------------------------------------------------------------
+
+/** Specialized version of SgStatisticsBase for atomic member variables.
+    A thread that sees a count greater zero (Count(), IsDefined()) is
+    guaranteed to see the mean value that was written together with or after
+    this count. Concurrent calls of Add() or Remove() are not serialized and
+    updates can still get lost; callers that need exact results must protect
+    the updates with a lock (see SgUctNode::LockUpdate()).
+    @see SgStatisticsAtomic.h SgStatisticsBase */
+template<typename VALUE, typename COUNT>
+class SgStatisticsAtomicBase
+{
+public:
+    SgStatisticsAtomicBase();
+
+    /** Create statistics initialized with values.
+        Note that value must be initialized to 0 if count is 0.
+        Equivalent to creating a statistics and calling @c count times
+        Add(val) */
+    SgStatisticsAtomicBase(VALUE val, COUNT count);
+
+    /** Copy constructor.
+        Not thread-safe with respect to concurrent writes to @c stat. */
+    SgStatisticsAtomicBase(const SgStatisticsAtomicBase& stat);
+
+    /** Assignment operator.
+        Not thread-safe with respect to concurrent writes to @c stat. */
+    SgStatisticsAtomicBase& operator=(const SgStatisticsAtomicBase& stat);
+
+    void Add(VALUE val);
+
+    void Remove(VALUE val);
+
+    /** Add a value n times */
+    void Add(VALUE val, COUNT n);
+
+    /** Remove a value n times. */
+    void Remove(VALUE val, COUNT n);
+
+    void Clear();
+
+    COUNT Count() const;
+
+    /** Initialize with values.
+        Equivalent to calling Clear() and calling @c count times
+        Add(val) */
+    void Initialize(VALUE val, COUNT count);
+
+    /** Check if the mean value is defined.
+        The mean value is defined, if the count if greater than zero. The
+        result of this function is equivalent to <tt>Count() > 0</tt>, for
+        integer count types and <tt>Count() > epsilon()</tt> for floating
+        point count types. */
+    bool IsDefined() const;
+
+    VALUE Mean() const;
+
+    /** Write in human readable format. */
+    void Write(std::ostream& out) const;
+
+    /** Save in a compact platform-independent text format.
+        The data is written in a single line, without trailing newline. */
+    void SaveAsText(std::ostream& out) const;
+
+    /** Load from text format.
+        See SaveAsText() */
+    void LoadFromText(std::istream& in);
+
+private:
+    boost::atomic<COUNT> m_count;
+
+    boost::atomic<VALUE> m_mean;
+
+    /** Publish a new mean and count.
+        Write order dependency: the mean is written before the count, the
+        count is written with release semantics. */
+    void Set(VALUE mean, COUNT count);
+};
+
+template<typename VALUE, typename COUNT>
+inline SgStatisticsAtomicBase<VALUE,COUNT>::SgStatisticsAtomicBase()
+{
+    Clear();
+}
+
+template<typename VALUE, typename COUNT>
+inline SgStatisticsAtomicBase<VALUE,COUNT>::SgStatisticsAtomicBase(VALUE val,
+                                                                 COUNT count)
+    : m_count(count),
+      m_mean(val)
+{ }
+
+template<typename VALUE, typename COUNT>
+inline SgStatisticsAtomicBase<VALUE,COUNT>::SgStatisticsAtomicBase(
+                                          const SgStatisticsAtomicBase& stat)
+    : m_count(stat.m_count.load(boost::memory_order_acquire)),
+      m_mean(stat.m_mean.load(boost::memory_order_relaxed))
+{ }
+
+template<typename VALUE, typename COUNT>
+inline SgStatisticsAtomicBase<VALUE,COUNT>&
+SgStatisticsAtomicBase<VALUE,COUNT>::operator=(
+                                          const SgStatisticsAtomicBase& stat)
+{
+    COUNT count = stat.m_count.load(boost::memory_order_acquire);
+    Set(stat.m_mean.load(boost::memory_order_relaxed), count);
+    return *this;
+}
+
+template<typename VALUE, typename COUNT>
+inline void SgStatisticsAtomicBase<VALUE,COUNT>::Set(VALUE mean, COUNT count)
+{
+    m_mean.store(mean, boost::memory_order_relaxed);
+    m_count.store(count, boost::memory_order_release);
+}
+
+template<typename VALUE, typename COUNT>
+inline void SgStatisticsAtomicBase<VALUE,COUNT>::Add(VALUE val)
+{
+    COUNT count = m_count.load(boost::memory_order_relaxed);
+    ++count;
+    SG_ASSERT(! std::numeric_limits<COUNT>::is_exact
+              || count > 0); // overflow
+    VALUE mean = m_mean.load(boost::memory_order_relaxed);
+    val -= mean;
+    mean +=  val / VALUE(count);
+    Set(mean, count);
+}
+
+template<typename VALUE, typename COUNT>
+inline void SgStatisticsAtomicBase<VALUE,COUNT>::Remove(VALUE val)
+{
+    COUNT count = m_count.load(boost::memory_order_relaxed);
+    if (count > 1)
+    {
+        --count;
+        VALUE mean = m_mean.load(boost::memory_order_relaxed);
+        mean += (mean - val) / VALUE(count);
+        Set(mean, count);
+    }
+    else
+        Clear();
+}
+
+template<typename VALUE, typename COUNT>
+inline void SgStatisticsAtomicBase<VALUE,COUNT>::Remove(VALUE val, COUNT n)
+{
+    COUNT count = m_count.load(boost::memory_order_relaxed);
+    if (count > n)
+    {
+        count -= n;
+        VALUE mean = m_mean.load(boost::memory_order_relaxed);
+        mean += VALUE(n) * (mean - val) / VALUE(count);
+        Set(mean, count);
+    }
+    else
+        Clear();
+}
+
+template<typename VALUE, typename COUNT>
+inline void SgStatisticsAtomicBase<VALUE,COUNT>::Add(VALUE val, COUNT n)
+{
+    COUNT count = m_count.load(boost::memory_order_relaxed);
+    count += n;
+    SG_ASSERT(! std::numeric_limits<COUNT>::is_exact
+              || count > 0); // overflow
+    VALUE mean = m_mean.load(boost::memory_order_relaxed);
+    val -= mean;
+    mean +=  VALUE(n) * val / VALUE(count);
+    Set(mean, count);
+}
+
+template<typename VALUE, typename COUNT>
+inline void SgStatisticsAtomicBase<VALUE,COUNT>::Clear()
+{
+    // Count first, so that no thread sees the old count with the new mean
+    m_count.store(0, boost::memory_order_relaxed);
+    m_mean.store(0, boost::memory_order_release);
+}
+
+template<typename VALUE, typename COUNT>
+inline COUNT SgStatisticsAtomicBase<VALUE,COUNT>::Count() const
+{
+    return m_count.load(boost::memory_order_acquire);
+}
+
+template<typename VALUE, typename COUNT>
+inline void SgStatisticsAtomicBase<VALUE,COUNT>::Initialize(VALUE val,
+                                                           COUNT count)
+{
+    SG_ASSERT(count > 0);
+    Set(val, count);
+}
+
+template<typename VALUE, typename COUNT>
+inline bool SgStatisticsAtomicBase<VALUE,COUNT>::IsDefined() const
+{
+    if (std::numeric_limits<COUNT>::is_exact)
+        return Count() > 0;
+    else
+        return Count() > std::numeric_limits<COUNT>::epsilon();
+}
+
+template<typename VALUE, typename COUNT>
+void SgStatisticsAtomicBase<VALUE,COUNT>::LoadFromText(std::istream& in)
+{
+    COUNT count;
+    VALUE mean;
+    in >> count >> mean;
+    Set(mean, count);
+}
+
+template<typename VALUE, typename COUNT>
+inline VALUE SgStatisticsAtomicBase<VALUE,COUNT>::Mean() const
+{
+    SG_ASSERT(IsDefined());
+    return m_mean.load(boost::memory_order_relaxed);
+}
+
+template<typename VALUE, typename COUNT>
+void SgStatisticsAtomicBase<VALUE,COUNT>::Write(std::ostream& out) const
+{
+    if (IsDefined())
+        out << Mean();
+    else
+        out << '-';
+}
+
+template<typename VALUE, typename COUNT>
+void SgStatisticsAtomicBase<VALUE,COUNT>::SaveAsText(std::ostream& out) const
+{
+    out << Count() << ' ' << m_mean.load(boost::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------
+
+#endif // SG_STATISTICSATOMIC_H
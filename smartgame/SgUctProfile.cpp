@@ -0,0 +1,137 @@
+//----------------------------------------------------------------------------
+/** @file SgUctProfile.cpp
+    See SgUctProfile.h */
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+#include "SgUctProfile.h"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <boost/io/ios_state.hpp>
+#include "SgWrite.h"
+#if WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+using boost::io::ios_all_saver;
+using std::fixed;
+using std::setprecision;
+using std::setw;
+
+//----------------------------------------------------------------------------
+
+const char* SgUctPhaseName(SgUctPhase phase)
+{
+    switch (phase)
+    {
+    case SG_UCTPHASE_SELECT:
+        return "Select";
+    case SG_UCTPHASE_EXPAND:
+        return "Expand";
+    case SG_UCTPHASE_PLAYOUT:
+        return "Playout";
+    case SG_UCTPHASE_EVALUATE:
+        return "Evaluate";
+    case SG_UCTPHASE_LOCK:
+        return "Lock";
+    case SG_UCTPHASE_UPDATE_TREE:
+        return "UpdateTree";
+    case SG_UCTPHASE_UPDATE_RAVE:
+        return "UpdateRave";
+    default:
+        SG_ASSERT(false);
+        return "?";
+    }
+}
+
+//----------------------------------------------------------------------------
+
+SgUctPhaseProfile::SgUctPhaseProfile()
+    : m_lastTime(0)
+{
+    Clear();
+}
+
+void SgUctPhaseProfile::Add(const SgUctPhaseProfile& profile)
+{
+    for (int i = 0; i < _SG_UCTPHASE_NU_PHASES; ++i)
+    {
+        m_count[i] += profile.m_count[i];
+        m_time[i] += profile.m_time[i];
+        for (int j = 0; j < NU_BINS; ++j)
+            m_bins[i][j] += profile.m_bins[i][j];
+    }
+}
+
+void SgUctPhaseProfile::Clear()
+{
+    for (int i = 0; i < _SG_UCTPHASE_NU_PHASES; ++i)
+    {
+        m_count[i] = 0;
+        m_time[i] = 0;
+        for (int j = 0; j < NU_BINS; ++j)
+            m_bins[i][j] = 0;
+    }
+}
+
+uint64_t SgUctPhaseProfile::Now()
+{
+#if WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return static_cast<uint64_t>(1e9 * double(counter.QuadPart)
+                                 / double(frequency.QuadPart));
+#else
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return uint64_t(time.tv_sec) * 1000000000u + uint64_t(time.tv_nsec);
+#endif
+}
+
+void SgUctPhaseProfile::Write(std::ostream& out) const
+{
+    ios_all_saver saver(out);
+    uint64_t totalTime = 0;
+    for (int i = 0; i < _SG_UCTPHASE_NU_PHASES; ++i)
+        totalTime += m_time[i];
+    out << std::left << setw(12) << "Phase" << std::right
+        << setw(12) << "Count" << setw(10) << "Time[s]"
+        << setw(11) << "Mean[us]" << setw(8) << "Time%" << '\n'
+        << fixed;
+    for (int i = 0; i < _SG_UCTPHASE_NU_PHASES; ++i)
+    {
+        SgUctPhase phase = static_cast<SgUctPhase>(i);
+        out << std::left << setw(12) << SgUctPhaseName(phase) << std::right
+            << setw(12) << m_count[i]
+            << setw(10) << setprecision(3) << 1e-9 * double(m_time[i])
+            << setw(11) << setprecision(2)
+            << (m_count[i] > 0 ? 1e-3 * double(m_time[i]) / double(m_count[i])
+                : 0.)
+            << setw(8) << setprecision(1)
+            << (totalTime > 0 ? 100. * double(m_time[i]) / double(totalTime)
+                : 0.)
+            << '\n';
+    }
+    for (int i = 0; i < _SG_UCTPHASE_NU_PHASES; ++i)
+    {
+        SgUctPhase phase = static_cast<SgUctPhase>(i);
+        if (m_count[i] == 0)
+            continue;
+        for (int j = 0; j < NU_BINS; ++j)
+            if (m_bins[i][j] > 0)
+            {
+                std::ostringstream label;
+                label << SgUctPhaseName(phase) << '[' << (uint64_t(1) << j)
+                      << "ns]";
+                out << SgWriteLabel(label.str()) << m_bins[i][j] << '\n';
+            }
+    }
+}
+
+//----------------------------------------------------------------------------
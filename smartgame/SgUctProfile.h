@@ -0,0 +1,223 @@
+//----------------------------------------------------------------------------
+/** @file SgUctProfile.h
+    Time spent in the phases of a game of the Monte Carlo tree search. */
+//----------------------------------------------------------------------------
+
+#ifndef SG_UCTPROFILE_H
+#define SG_UCTPROFILE_H
+
+#include <iosfwd>
+#include <stdint.h>
+
+//----------------------------------------------------------------------------
+
+/** @def SG_UCT_PROFILE
+    Measure the time of the phases of the games in SgUctSearch.
+    If disabled, the functions of SgUctPhaseProfile that take the time
+    compile to nothing. If enabled, each thread reads a monotonic clock
+    about ten times per game, which costs much less than 1% of the time
+    of a game of Go on 9x9. The profile is written by the GTP command
+    @c uct_stat_profile.
+    Enabled with the configure option @c --enable-uct-profile. */
+#ifndef SG_UCT_PROFILE
+#define SG_UCT_PROFILE 0
+#endif
+
+//----------------------------------------------------------------------------
+
+/** Phase of a game in SgUctSearch::PlayGame().
+    @ingroup sguctgroup */
+enum SgUctPhase
+{
+    /** Selection of the moves in the tree (without SG_UCTPHASE_EXPAND). */
+    SG_UCTPHASE_SELECT,
+
+    /** Move generation and knowledge at the leaf node and node expansion.
+        Includes SgUctThreadState::GenerateAllMoves() at a leaf and
+        SgUctSearch::ExpandNode(). */
+    SG_UCTPHASE_EXPAND,
+
+    /** A playout (SgUctSearch::PlayoutGame()).
+        Also includes taking back the moves of the previous playout, if
+        there are several playouts per game. */
+    SG_UCTPHASE_PLAYOUT,
+
+    /** Evaluation of the end position of a playout or a terminal node. */
+    SG_UCTPHASE_EVALUATE,
+
+    /** Taking back the moves and waiting for the global lock.
+        The time for the lock is zero in lock-free mode. */
+    SG_UCTPHASE_LOCK,
+
+    /** SgUctSearch::UpdateTree() */
+    SG_UCTPHASE_UPDATE_TREE,
+
+    /** SgUctSearch::UpdateRaveValues() */
+    SG_UCTPHASE_UPDATE_RAVE,
+
+    _SG_UCTPHASE_NU_PHASES
+};
+
+/** Name of a phase for output. */
+const char* SgUctPhaseName(SgUctPhase phase);
+
+//----------------------------------------------------------------------------
+
+/** Time of the phases of the games in a search.
+    Used for a single thread; the profiles of the threads can be merged with
+    Add(const SgUctPhaseProfile&). The timing functions Start() and Lap()
+    do nothing unless SG_UCT_PROFILE is enabled.
+    For each phase, the profile contains the number of timed intervals,
+    their total time and a histogram of the interval lengths with bins of
+    exponentially growing size (bin i contains the lengths in nanoseconds
+    in [2^i, 2^(i+1)), bin 0 also contains 0).
+    @ingroup sguctgroup */
+class SgUctPhaseProfile
+{
+public:
+    static const int NU_BINS = 40;
+
+    SgUctPhaseProfile();
+
+    /** Start the time measurement of a game. */
+    void Start();
+
+    /** Add the time since the last call of Start() or Lap() to a phase. */
+    void Lap(SgUctPhase phase);
+
+    /** Add an interval to a phase.
+        @param phase
+        @param nanoSeconds The length of the interval */
+    void Add(SgUctPhase phase, uint64_t nanoSeconds);
+
+    /** Merge the profile of another thread into this profile. */
+    void Add(const SgUctPhaseProfile& profile);
+
+    void Clear();
+
+    /** Number of intervals of a phase. */
+    uint64_t Count(SgUctPhase phase) const;
+
+    /** Number of intervals of a phase in a bin of the histogram. */
+    uint64_t Count(SgUctPhase phase, int bin) const;
+
+    /** Total time of a phase in nanoseconds. */
+    uint64_t Time(SgUctPhase phase) const;
+
+    /** Current value of the clock used for the time measurement.
+        @return The time in nanoseconds since an arbitrary start time */
+    static uint64_t Now();
+
+    /** Write a table with the count, total and mean time and the
+        percentage of the total time of each phase, followed by the
+        non-empty bins of the histograms. */
+    void Write(std::ostream& out) const;
+
+private:
+    /** Time of the last call of Start() or Lap(). */
+    uint64_t m_lastTime;
+
+    uint64_t m_count[_SG_UCTPHASE_NU_PHASES];
+
+    uint64_t m_time[_SG_UCTPHASE_NU_PHASES];
+
+    uint64_t m_bins[_SG_UCTPHASE_NU_PHASES][NU_BINS];
+
+    static int Bin(uint64_t nanoSeconds);
+};
+
+inline void SgUctPhaseProfile::Add(SgUctPhase phase, uint64_t nanoSeconds)
+{
+    ++m_count[phase];
+    m_time[phase] += nanoSeconds;
+    ++m_bins[phase][Bin(nanoSeconds)];
+}
+
+inline int SgUctPhaseProfile::Bin(uint64_t nanoSeconds)
+{
+    int bin = 0;
+    while (nanoSeconds > 1 && bin < NU_BINS - 1)
+    {
+        nanoSeconds >>= 1;
+        ++bin;
+    }
+    return bin;
+}
+
+inline uint64_t SgUctPhaseProfile::Count(SgUctPhase phase) const
+{
+    return m_count[phase];
+}
+
+inline uint64_t SgUctPhaseProfile::Count(SgUctPhase phase, int bin) const
+{
+    return m_bins[phase][bin];
+}
+
+inline void SgUctPhaseProfile::Lap(SgUctPhase phase)
+{
+#if SG_UCT_PROFILE
+    const uint64_t now = Now();
+    Add(phase, now - m_lastTime);
+    m_lastTime = now;
+#else
+    SG_UNUSED(phase);
+#endif
+}
+
+inline void SgUctPhaseProfile::Start()
+{
+#if SG_UCT_PROFILE
+    m_lastTime = Now();
+#endif
+}
+
+inline uint64_t SgUctPhaseProfile::Time(SgUctPhase phase) const
+{
+    return m_time[phase];
+}
+
+//----------------------------------------------------------------------------
+
+/** Time a block of code as a phase.
+    Adds the time since the last lap to an outer phase on construction and
+    the time of the block to an inner phase on destruction, also if the
+    block is left with @c break or @c return.
+    @ingroup sguctgroup */
+class SgUctPhaseScope
+{
+public:
+    SgUctPhaseScope(SgUctPhaseProfile& profile, SgUctPhase outerPhase,
+                    SgUctPhase innerPhase);
+
+    ~SgUctPhaseScope();
+
+private:
+    SgUctPhaseProfile& m_profile;
+
+    SgUctPhase m_innerPhase;
+
+    /** Not implemented. */
+    SgUctPhaseScope(const SgUctPhaseScope&);
+
+    /** Not implemented. */
+    SgUctPhaseScope& operator=(const SgUctPhaseScope&);
+};
+
+inline SgUctPhaseScope::SgUctPhaseScope(SgUctPhaseProfile& profile,
+                                        SgUctPhase outerPhase,
+                                        SgUctPhase innerPhase)
+    : m_profile(profile),
+      m_innerPhase(innerPhase)
+{
+    m_profile.Lap(outerPhase);
+}
+
+inline SgUctPhaseScope::~SgUctPhaseScope()
+{
+    m_profile.Lap(m_innerPhase);
+}
+
+//----------------------------------------------------------------------------
+
+#endif // SG_UCTPROFILE_H
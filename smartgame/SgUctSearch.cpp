@@ -14,6 +14,7 @@
 #include "SgDebug.h"
 #include "SgHashTable.h"
 #include "SgMath.h"
+#include "SgNuma.h"
 #include "SgPlatform.h"
 #include "SgWrite.h"
 
@@ -81,6 +82,15 @@ size_t GetMaxNodesDefault()
     return nodesPerTree;
 }
 
+/** First child of a node.
+    @return The first child or 0, if the children were detached by another
+    thread (see SgUctSearch::IncrementalPrune()). */
+const SgUctNode* FirstChild(const SgUctTree& tree, const SgUctNode& node)
+{
+    SgUctChildIterator it(tree, node);
+    return it ? &*it : 0;
+}
+
 void Notify(mutex& aMutex, condition& aCondition)
 {
     mutex::scoped_lock lock(aMutex);
@@ -91,35 +101,106 @@ void Notify(mutex& aMutex, condition& aCondition)
 
 //----------------------------------------------------------------------------
 
-void SgUctGameInfo::Clear(std::size_t numberPlayouts)
+SgUctGameSequence::SgUctGameSequence()
+    : m_size(0),
+      m_capacity(0),
+      m_move(0),
+      m_skipRaveUpdate(0)
+{
+    Reserve(MIN_CAPACITY);
+}
+
+SgUctGameSequence::~SgUctGameSequence()
+{ }
+
+void SgUctGameSequence::CopyPrefix(const SgUctGameSequence& sequence,
+                                   std::size_t length)
+{
+    SG_ASSERT(length <= sequence.m_size);
+    Reserve(length);
+    std::copy(sequence.m_move, sequence.m_move + length, m_move);
+    std::copy(sequence.m_skipRaveUpdate, sequence.m_skipRaveUpdate + length,
+              m_skipRaveUpdate);
+    m_size = length;
+}
+
+void SgUctGameSequence::Reserve(std::size_t capacity)
+{
+    if (capacity <= m_capacity)
+        return;
+    // Round up, so that the flags also start at a cache line
+    capacity = (capacity + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE
+               * CACHE_LINE_SIZE;
+    const size_t moveBytes = capacity * sizeof(SgMove);
+    boost::scoped_array<char> memory(
+                          new char[moveBytes + capacity + CACHE_LINE_SIZE]);
+    char* start = memory.get();
+    start += (CACHE_LINE_SIZE - reinterpret_cast<size_t>(start)
+              % CACHE_LINE_SIZE) % CACHE_LINE_SIZE;
+    SgMove* move = reinterpret_cast<SgMove*>(start);
+    unsigned char* skipRaveUpdate =
+        reinterpret_cast<unsigned char*>(start + moveBytes);
+    std::copy(m_move, m_move + m_size, move);
+    std::copy(m_skipRaveUpdate, m_skipRaveUpdate + m_size, skipRaveUpdate);
+    m_memory.swap(memory);
+    m_move = move;
+    m_skipRaveUpdate = skipRaveUpdate;
+    m_capacity = capacity;
+}
+
+//----------------------------------------------------------------------------
+
+SgUctGameInfo::SgUctGameInfo()
+    : m_nuMovesInTree(0)
+{ }
+
+void SgUctGameInfo::Clear(std::size_t numberPlayouts,
+                          std::size_t maxGameLength)
 {
+    SG_ASSERT(numberPlayouts > 0);
     m_nodes.clear();
-    m_inTreeSequence.clear();
-    if (numberPlayouts != m_sequence.size())
+    m_nuMovesInTree = 0;
+    if (numberPlayouts != m_eval.size())
     {
-        m_sequence.resize(numberPlayouts);
-        m_skipRaveUpdate.resize(numberPlayouts);
+        m_sequence.reset(new SgUctGameSequence[numberPlayouts]);
         m_eval.resize(numberPlayouts);
         m_aborted.resize(numberPlayouts);
     }
+    // The sequences contain at most maxGameLength moves (see
+    // SgUctSearch::PlayInTree() and SgUctSearch::PlayoutGame()), but
+    // maxGameLength is not a useful capacity if no limit is set
+    const size_t MAX_RESERVE = 10000;
     for (size_t i = 0; i < numberPlayouts; ++i)
     {
-        m_sequence[i].clear();
-        m_skipRaveUpdate[i].clear();
+        m_sequence[i].Reserve(std::min(maxGameLength, MAX_RESERVE));
+        m_sequence[i].Clear();
     }
 }
 
+void SgUctGameInfo::StartPlayout(std::size_t playout)
+{
+    if (playout == 0)
+        SG_ASSERT(m_sequence[0].Size() == m_nuMovesInTree);
+    else
+        m_sequence[playout].CopyPrefix(m_sequence[0], m_nuMovesInTree);
+}
+
 //----------------------------------------------------------------------------
 
 SgUctThreadState::SgUctThreadState(unsigned int threadId, int moveRange)
     : m_threadId(threadId),
       m_isSearchInitialized(false),
-      m_isTreeOutOfMem(false)
+      m_isTreeOutOfMem(false),
+      m_ownsPruneLock(false)
 {
     if (moveRange > 0)
     {
         m_firstPlay.reset(new size_t[moveRange]);
         m_firstPlayOpp.reset(new size_t[moveRange]);
+        std::fill_n(m_firstPlay.get(), moveRange,
+                    numeric_limits<size_t>::max());
+        std::fill_n(m_firstPlayOpp.get(), moveRange,
+                    numeric_limits<size_t>::max());
     }
 }
 
@@ -136,6 +217,12 @@ void SgUctThreadState::GameStart()
     // Default implementation does nothing
 }
 
+SgHashCode SgUctThreadState::PositionHash() const
+{
+    // Default implementation disables the transposition table
+    return SgHashCode();
+}
+
 void SgUctThreadState::StartPlayout()
 {
     // Default implementation does nothing
@@ -191,6 +278,8 @@ void SgUctSearch::Thread::operator()()
     if (DEBUG_THREADS)
         SgDebug() << "SgUctSearch::Thread: starting thread "
                   << m_state->m_threadId << '\n';
+    if (m_search.Numa())
+        SgNuma::RunOnNode(SgNuma::ThreadNode(m_state->m_threadId));
     mutex::scoped_lock lock(m_startPlayMutex);
     m_threadReady.wait();
     while (true)
@@ -218,6 +307,110 @@ void SgUctSearch::Thread::WaitPlayFinished()
 
 //----------------------------------------------------------------------------
 
+const std::size_t SgUctSearch::KNOWLEDGE_BATCH_SIZE;
+
+SgUctSearch::KnowledgeWorker::Function::Function(KnowledgeWorker& worker)
+    : m_worker(worker)
+{ }
+
+void SgUctSearch::KnowledgeWorker::Function::operator()()
+{
+    m_worker();
+}
+
+SgUctSearch::KnowledgeWorker::KnowledgeWorker(SgUctSearch& search,
+                                        std::auto_ptr<SgUctThreadState> state)
+    : m_state(state),
+      m_search(search),
+      m_thread(Function(*this))
+{ }
+
+/** Destructor.
+    Requires that SgUctSearch::m_quitKnowledgeWorkers was set. */
+SgUctSearch::KnowledgeWorker::~KnowledgeWorker()
+{
+    m_thread.join();
+}
+
+void SgUctSearch::KnowledgeWorker::operator()()
+{
+    if (DEBUG_THREADS)
+        SgDebug() << "SgUctSearch::KnowledgeWorker: starting thread "
+                  << m_state->m_threadId << '\n';
+    if (m_search.Numa())
+        SgNuma::RunOnNode(SgNuma::ThreadNode(m_state->m_threadId));
+    vector<KnowledgeRequest> batch;
+    while (true)
+    {
+        {
+            mutex::scoped_lock lock(m_search.m_knowledgeMutex);
+            while (m_search.m_knowledgeRequests.empty()
+                   && ! m_search.m_quitKnowledgeWorkers)
+                m_search.m_knowledgeRequestAdded.wait(lock);
+            if (m_search.m_quitKnowledgeWorkers)
+                break;
+            while (! m_search.m_knowledgeRequests.empty()
+                   && batch.size() < KNOWLEDGE_BATCH_SIZE)
+            {
+                batch.push_back(m_search.m_knowledgeRequests.front());
+                m_search.m_knowledgeRequests.pop_front();
+            }
+            ++m_search.m_nuBusyKnowledgeWorkers;
+        }
+        for (size_t i = 0; i < batch.size(); ++i)
+            Compute(batch[i]);
+        {
+            mutex::scoped_lock lock(m_search.m_knowledgeMutex);
+            const size_t epoch = m_search.m_knowledgeEpoch.load();
+            for (size_t i = 0; i < batch.size(); ++i)
+                if (batch[i].m_epoch == epoch)
+                    m_search.m_knowledgeResults.push_back(batch[i]);
+            if (! m_search.m_knowledgeResults.empty())
+                m_search.m_hasKnowledgeResults.store(true,
+                                                boost::memory_order_release);
+            if (--m_search.m_nuBusyKnowledgeWorkers == 0)
+                m_search.m_knowledgeWorkersIdle.notify_all();
+        }
+        batch.clear();
+    }
+    if (DEBUG_THREADS)
+        SgDebug() << "SgUctSearch::KnowledgeWorker: finishing thread "
+                  << m_state->m_threadId << '\n';
+}
+
+void SgUctSearch::KnowledgeWorker::Compute(KnowledgeRequest& request)
+{
+    if (request.m_epoch != m_search.m_knowledgeEpoch.load())
+        // Result would be discarded
+        return;
+    SgUctThreadState& state = *m_state;
+    state.GameStart();
+    for (size_t i = 0; i < request.m_sequence.size(); ++i)
+        state.Execute(request.m_sequence[i]);
+    request.m_moves.clear();
+    request.m_provenType = SG_NOT_PROVEN;
+    request.m_truncate = state.GenerateAllMoves(request.m_count,
+                                                request.m_moves,
+                                                request.m_provenType);
+    state.TakeBackInTree(request.m_sequence.size());
+}
+
+//----------------------------------------------------------------------------
+
+void SgUctSearchStat::Add(const SgUctSearchStat& stat)
+{
+    m_knowledge += stat.m_knowledge;
+    m_gameLength.Add(stat.m_gameLength);
+    m_movesInTree.Add(stat.m_movesInTree);
+    if (stat.m_aborted.IsDefined())
+        m_aborted.Add(stat.m_aborted.Mean(), stat.m_aborted.Count());
+    m_pruneTime.Add(stat.m_pruneTime);
+    m_prunedNodes += stat.m_prunedNodes;
+    m_transpositions += stat.m_transpositions;
+    m_sharedNodes += stat.m_sharedNodes;
+    m_profile.Add(stat.m_profile);
+}
+
 void SgUctSearchStat::Clear()
 {
     m_time = 0;
@@ -226,6 +419,11 @@ void SgUctSearchStat::Clear()
     m_gameLength.Clear();
     m_movesInTree.Clear();
     m_aborted.Clear();
+    m_pruneTime.Clear();
+    m_prunedNodes = 0;
+    m_transpositions = 0;
+    m_sharedNodes = 0;
+    m_profile.Clear();
 }
 
 void SgUctSearchStat::Write(std::ostream& out) const
@@ -242,6 +440,71 @@ void SgUctSearchStat::Write(std::ostream& out) const
         << static_cast<int>(100 * m_aborted.Mean()) << "%\n"
         << SgWriteLabel("Games/s") << fixed << setprecision(1)
         << m_gamesPerSecond << '\n';
+    if (m_pruneTime.Count() > 0)
+    {
+        out << SgWriteLabel("PruneTime") << setprecision(6);
+        m_pruneTime.Write(out);
+        out << '\n'
+            << SgWriteLabel("PrunedNodes") << m_prunedNodes << '\n';
+    }
+    if (m_transpositions > 0)
+        out << SgWriteLabel("Transpositions") << m_transpositions << '\n'
+            << SgWriteLabel("SharedNodes") << m_sharedNodes << '\n';
+}
+
+//----------------------------------------------------------------------------
+
+SgUctThreadStatistics::SgUctThreadStatistics()
+{
+    Clear();
+}
+
+void SgUctThreadStatistics::Clear()
+{
+    m_numberGames = 0;
+    m_nextCheckTime = 0;
+    m_checkTimeInterval = 0;
+    m_gamesPerSecond = 0;
+    m_stat.Clear();
+}
+
+//----------------------------------------------------------------------------
+
+SgUctSearch::TranspositionData::TranspositionData()
+    : m_node(0),
+      m_depth(0)
+{ }
+
+SgUctSearch::TranspositionData::TranspositionData(const SgUctNode* node,
+                                                  size_t depth)
+    : m_node(node),
+      m_depth(depth)
+{ }
+
+size_t SgUctSearch::TranspositionData::Depth() const
+{
+    return m_depth;
+}
+
+const SgUctNode* SgUctSearch::TranspositionData::Node() const
+{
+    return m_node;
+}
+
+bool SgUctSearch::TranspositionData::IsValid() const
+{
+    return m_node != 0;
+}
+
+void SgUctSearch::TranspositionData::Invalidate()
+{
+    m_node = 0;
+}
+
+bool SgUctSearch::TranspositionData::IsBetterThan(
+                                      const TranspositionData& data) const
+{
+    return m_node->MoveCount() > data.m_node->MoveCount();
 }
 
 //----------------------------------------------------------------------------
@@ -253,18 +516,31 @@ SgUctSearch::SgUctSearch(SgUctThreadStateFactory* threadStateFactory,
       m_rave(false),
       m_knowledgeThreshold(),
       m_maxKnowledgeThreads(1024),
+      m_knowledgeWorkers(0),
+      m_hasKnowledgeResults(false),
+      m_knowledgeEpoch(0),
+      m_nuBusyKnowledgeWorkers(0),
+      m_quitKnowledgeWorkers(false),
       m_moveSelect(SG_UCTMOVESELECT_COUNT),
       m_raveCheckSame(false),
       m_randomizeRaveFrequency(20),
       m_lockFree(GetLockFreeDefault()),
+      m_atomicTree(false),
       m_weightRaveUpdates(true),
       m_pruneFullTree(true),
       m_checkFloatPrecision(true),
       m_numberThreads(1),
+      m_numa(false),
+      m_numaInterleaveNodes(0),
       m_numberPlayouts(1),
       m_updateMultiplePlayoutsAsSingle(true),
       m_maxNodes(GetMaxNodesDefault()),
       m_pruneMinCount(16),
+      m_incrementalPrune(true),
+      m_incrementalPruneMinCount(16),
+      m_pruneEpoch(0),
+      m_detachedEpoch(0),
+      m_transpositions(false),
       m_moveRange(moveRange),
       m_maxGameLength(numeric_limits<size_t>::max()),
       m_expandThreshold(numeric_limits<SgUctValue>::is_integer ?
@@ -291,6 +567,88 @@ SgUctSearch::~SgUctSearch()
     DeleteThreads();
 }
 
+/** Add a request for a knowledge computation at the current node of a game.
+    The request contains the path of the game from the root to the node,
+    which must be the current end of state.m_gameInfo. */
+void SgUctSearch::AddKnowledgeRequest(const SgUctThreadState& state,
+                                      const SgUctNode& node)
+{
+    SG_ASSERT(state.m_gameInfo.m_nodes.back() == &node);
+    KnowledgeRequest request;
+    request.m_nodes = state.m_gameInfo.m_nodes;
+    const SgUctGameInfo& info = state.m_gameInfo;
+    request.m_sequence.resize(info.m_nuMovesInTree);
+    for (size_t i = 0; i < info.m_nuMovesInTree; ++i)
+        request.m_sequence[i] = info.m_sequence[0][i];
+    request.m_count = node.KnowledgeCount();
+    request.m_epoch = m_knowledgeEpoch.load();
+    {
+        mutex::scoped_lock lock(m_knowledgeMutex);
+        m_knowledgeRequests.push_back(request);
+    }
+    m_knowledgeRequestAdded.notify_one();
+}
+
+void SgUctSearch::AddRootMoveResults(SgMove move, SgUctValue eval,
+                                     SgUctValue count)
+{
+    const SgUctNode& root = m_tree.Root();
+    if (! root.HasChildren())
+        return;
+    for (SgUctChildIterator it(m_tree, root); it; ++it)
+        if ((*it).Move() == move)
+        {
+            m_tree.AddGameResults(*it, &root, eval, count);
+            // The values of the root are from the view of the other player
+            m_tree.AddGameResults(root, 0, InverseEval(eval), count);
+            return;
+        }
+}
+
+/** Merge the results of the knowledge workers into the tree.
+    Results of a previous epoch are discarded, because their nodes may no
+    longer be in the tree. The prune mutex is held while the results are
+    merged, such that other threads cannot detach nodes in the meantime.
+    The epoch is checked for each result, because HandleTreeFull() in this
+    thread can detach nodes while children are created. */
+void SgUctSearch::ApplyKnowledgeResults(SgUctThreadState& state)
+{
+    vector<KnowledgeRequest> results;
+    {
+        mutex::scoped_lock lock(m_knowledgeMutex);
+        results.swap(m_knowledgeResults);
+        m_hasKnowledgeResults.store(false, boost::memory_order_relaxed);
+    }
+    mutex::scoped_lock pruneLock(m_pruneMutex, boost::defer_lock);
+    if (UseIncrementalPrune())
+        pruneLock.lock();
+    state.m_ownsPruneLock = pruneLock.owns_lock();
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        KnowledgeRequest& result = results[i];
+        if (result.m_epoch != m_knowledgeEpoch.load())
+            continue;
+        const SgUctNode& node = *result.m_nodes.back();
+        if (result.m_provenType != SG_NOT_PROVEN)
+        {
+            m_tree.SetProvenType(node, result.m_provenType);
+            PropagateProvenStatus(result.m_nodes);
+            continue;
+        }
+        if (result.m_moves.empty())
+            continue;
+        state.m_moves.swap(result.m_moves);
+        if (m_atomicTree)
+            m_tree.LockExpansion(node);
+        CreateChildren(state, node, result.m_truncate);
+        if (m_atomicTree)
+            m_tree.UnlockExpansion(node);
+        if (state.m_isTreeOutOfMem)
+            break;
+    }
+    state.m_ownsPruneLock = false;
+}
+
 void SgUctSearch::ApplyRootFilter(vector<SgUctMoveInfo>& moves)
 {
     // Filter without changing the order of the unfiltered moves
@@ -344,9 +702,11 @@ bool SgUctSearch::CheckAbortSearch(SgUctThreadState& state)
         m_wasEarlyAbort = true;
         return true;
     }
-    if (GamesPlayed() >= m_nextCheckTime)
+    SgUctThreadStatistics& statistics = state.m_statistics;
+    if (statistics.m_numberGames >= statistics.m_nextCheckTime)
     {
-        m_nextCheckTime = GamesPlayed() + m_checkTimeInterval;
+        statistics.m_nextCheckTime =
+            statistics.m_numberGames + statistics.m_checkTimeInterval;
         double time = m_timer.GetTime();
 
         if (time > m_maxTime)
@@ -362,7 +722,7 @@ bool SgUctSearch::CheckAbortSearch(SgUctThreadState& state)
             return true;
         }
         if (! SgDeterministic::DeterministicMode())
-           UpdateCheckTimeInterval(time);
+           UpdateCheckTimeInterval(statistics, time);
         if (m_moveSelect == SG_UCTMOVESELECT_COUNT)
         {
             double remainingGamesDouble = m_maxGames - rootCount - 1;
@@ -373,7 +733,7 @@ bool SgUctSearch::CheckAbortSearch(SgUctThreadState& state)
                 double remainingTime = m_maxTime - time;
                 remainingGamesDouble =
                         std::min(remainingGamesDouble,
-                        remainingTime * m_statistics.m_gamesPerSecond);
+                        remainingTime * statistics.m_gamesPerSecond);
             }
             SgUctValue uctCountMax = numeric_limits<SgUctValue>::max();
             SgUctValue remainingGames;
@@ -434,7 +794,15 @@ void SgUctSearch::CreateThreads()
         shared_ptr<Thread> thread(new Thread(*this, state));
         m_threads.push_back(thread);
     }
+    for (unsigned int i = 0; i < m_knowledgeWorkers; ++i)
+    {
+        std::auto_ptr<SgUctThreadState>
+        state(m_threadStateFactory->Create(m_numberThreads + i, *this));
+        shared_ptr<KnowledgeWorker> worker(new KnowledgeWorker(*this, state));
+        m_knowledgeWorkerThreads.push_back(worker);
+    }
     m_tree.CreateAllocators(m_numberThreads);
+    m_tree.SetNumaPlacement(m_numa, m_numaInterleaveNodes);
     m_tree.SetMaxNodes(m_maxNodes);
 
     m_searchLoopFinished.reset(new barrier(m_numberThreads));
@@ -459,9 +827,33 @@ void SgUctSearch::Debug(const SgUctThreadState& state,
         SgDebug() << (format("%1%\n") % textLine);
 }
 
+/** Discard all pending knowledge requests and results.
+    Waits until no knowledge worker is computing a request, such that the
+    thread states of the workers can be used by the caller. */
+void SgUctSearch::ClearKnowledgeRequests()
+{
+    mutex::scoped_lock lock(m_knowledgeMutex);
+    m_knowledgeEpoch.fetch_add(1);
+    m_knowledgeRequests.clear();
+    m_knowledgeResults.clear();
+    m_hasKnowledgeResults.store(false);
+    while (m_nuBusyKnowledgeWorkers > 0)
+        m_knowledgeWorkersIdle.wait(lock);
+}
+
 void SgUctSearch::DeleteThreads()
 {
     m_threads.clear();
+    {
+        mutex::scoped_lock lock(m_knowledgeMutex);
+        m_quitKnowledgeWorkers = true;
+    }
+    m_knowledgeRequestAdded.notify_all();
+    m_knowledgeWorkerThreads.clear();
+    m_quitKnowledgeWorkers = false;
+    m_knowledgeRequests.clear();
+    m_knowledgeResults.clear();
+    m_hasKnowledgeResults.store(false);
 }
 
 /** Expand a node.
@@ -470,16 +862,19 @@ void SgUctSearch::DeleteThreads()
 void SgUctSearch::ExpandNode(SgUctThreadState& state, const SgUctNode& node)
 {
     unsigned int threadId = state.m_threadId;
-    if (! m_tree.HasCapacity(threadId, state.m_moves.size()))
+    SgHashCode hash;
+    if (m_transpositionTable && &node != &m_tree.Root())
     {
-        Debug(state, str(format("SgUctSearch: maximum tree size %1% reached")
-                         % m_tree.MaxNodes()));
-        state.m_isTreeOutOfMem = true;
-        m_isTreeOutOfMemory = true;
-        SgSynchronizeThreadMemory();
-        return;
+        hash = state.PositionHash();
+        if (! hash.IsZero() && ShareTransposition(state, hash, node))
+            return;
     }
+    if (! m_tree.HasCapacity(threadId, state.m_moves.size())
+        && ! HandleTreeFull(state))
+        return;
     m_tree.CreateChildren(threadId, node, state.m_moves);
+    if (! hash.IsZero())
+        StoreTransposition(hash, node, state.m_gameInfo.m_nodes.size());
 }
 
 const SgUctNode*
@@ -604,6 +999,11 @@ SgUctValue SgUctSearch::GetBound(bool useRave, bool useBiasTerm,
 SgUctTree& SgUctSearch::GetTempTree()
 {
     m_tempTree.Clear();
+    bool numaChanged =
+        (  m_tempTree.NumaPlacement() != m_numa
+        || m_tempTree.NumaInterleaveNodes() != m_numaInterleaveNodes);
+    if (numaChanged)
+        m_tempTree.SetNumaPlacement(m_numa, m_numaInterleaveNodes);
     // Use NumberThreads() (not m_tree.NuAllocators()) and MaxNodes() (not
     // m_tree.MaxNodes()), because of the delayed thread (and thereby
     // allocator) creation in SgUctSearch
@@ -612,7 +1012,7 @@ SgUctTree& SgUctSearch::GetTempTree()
         m_tempTree.CreateAllocators(NumberThreads());
         m_tempTree.SetMaxNodes(MaxNodes());
     }
-    else if (m_tempTree.MaxNodes() != MaxNodes())
+    else if (m_tempTree.MaxNodes() != MaxNodes() || numaChanged)
     {
         m_tempTree.SetMaxNodes(MaxNodes());
     }
@@ -720,8 +1120,10 @@ SgUctValue SgUctSearch::GetValueEstimateRave(const SgUctNode& child) const
             // This can happen only in lock-free multi-threading. Normally,
             // each move played in a position should also cause a RAVE value
             // to be added. But in lock-free multi-threading it can happen
-            // that the move value was already updated but the RAVE value not
-            SG_ASSERT(m_numberThreads > 1 && m_lockFree);
+            // that the move value was already updated but the RAVE value not.
+            // The same holds in atomic mode, because the move and RAVE
+            // values are not updated together.
+            SG_ASSERT(m_numberThreads > 1 && (m_lockFree || m_atomicTree));
             value = moveValue;
         }
     }
@@ -734,6 +1136,98 @@ SgUctValue SgUctSearch::GetValueEstimateRave(const SgUctNode& child) const
     return value;
 }
 
+/** Handle a full tree in ExpandNode() and CreateChildren().
+    If IncrementalPrune() is used, reclaims the subtrees detached by a
+    previous call, if all threads have started a new game since then, or
+    detaches subtrees with low counts. Otherwise, or if no subtrees can be
+    detached anymore, the search is stopped to prune the tree with a full
+    copy (see PruneFullTree()).
+    @param state The thread state with state.m_moves already computed.
+    @return @c true, if the tree has now the capacity for state.m_moves. If
+    @c false, the node should be treated as a leaf in the current game. */
+bool SgUctSearch::HandleTreeFull(SgUctThreadState& state)
+{
+    unsigned int threadId = state.m_threadId;
+    size_t nuMoves = state.m_moves.size();
+    if (UseIncrementalPrune())
+    {
+        boost::mutex::scoped_lock lock(m_pruneMutex, boost::defer_lock);
+        if (! state.m_ownsPruneLock && ! lock.try_lock())
+            // Another thread is pruning or merging knowledge results
+            return false;
+        if (m_tree.HasCapacity(threadId, nuMoves))
+            return true;
+        double startPruneTime = m_timer.GetTime();
+        if (! m_detachedBlocks.empty())
+        {
+            for (size_t i = 0; i < m_threads.size(); ++i)
+                if (m_threadPruneEpoch[i].load(boost::memory_order_acquire)
+                    <= m_detachedEpoch)
+                    // Thread can still access nodes of detached subtrees
+                    return false;
+            size_t nuReclaimed = m_tree.ReclaimSubtrees(m_detachedBlocks);
+            m_detachedBlocks.clear();
+            if (m_tree.HasCapacity(threadId, nuMoves))
+            {
+                state.m_statistics.m_stat.m_pruneTime.Add(m_timer.GetTime()
+                                                          - startPruneTime);
+                return true;
+            }
+            Debug(state, str(format("SgUctSearch: reclaimed %1% nodes "
+                                    "are not sufficient")
+                             % nuReclaimed));
+        }
+        size_t nuNodes = m_tree.NuNodes();
+        size_t nuDetached =
+            m_tree.DetachLowCount(m_incrementalPruneMinCount, m_atomicTree,
+                                  m_detachedBlocks);
+        if (nuDetached > 0)
+        {
+            m_detachedEpoch =
+                m_pruneEpoch.fetch_add(1, boost::memory_order_acq_rel);
+            // Pending knowledge requests can refer to detached nodes
+            m_knowledgeEpoch.fetch_add(1);
+            double pruneTime = m_timer.GetTime() - startPruneTime;
+            int prunedSizePercentage =
+                static_cast<int>((nuNodes - nuDetached) * 100 / nuNodes);
+            Debug(state, str(format("SgUctSearch: detached %1% nodes with "
+                                    "count < %2% (%3%%% remaining) time: %4%")
+                             % nuDetached % m_incrementalPruneMinCount
+                             % prunedSizePercentage % pruneTime));
+            if (prunedSizePercentage > 50)
+                m_incrementalPruneMinCount *= 2;
+            else
+                m_incrementalPruneMinCount = m_pruneMinCount;
+            state.m_statistics.m_stat.m_prunedNodes += nuDetached;
+            state.m_statistics.m_stat.m_pruneTime.Add(pruneTime);
+            return false;
+        }
+    }
+    Debug(state, str(format("SgUctSearch: maximum tree size %1% reached")
+                     % m_tree.MaxNodes()));
+    state.m_isTreeOutOfMem = true;
+    m_isTreeOutOfMemory = true;
+    SgSynchronizeThreadMemory();
+    return false;
+}
+
+/** Create or clear the transposition table.
+    Must be called whenever the tree is replaced, because the table contains
+    pointers to nodes of the tree. */
+void SgUctSearch::InitTranspositionTable()
+{
+    if (! m_transpositions)
+    {
+        m_transpositionTable.reset();
+        return;
+    }
+    const int size = int(std::max(m_maxNodes / 16, size_t(1024)));
+    if (m_transpositionTable && m_transpositionTable->MaxHash() == size)
+        m_transpositionTable->Clear();
+    else
+        m_transpositionTable.reset(new TranspositionTable(size));
+}
+
 std::string SgUctSearch::LastGameSummaryLine() const
 {
     return SummaryLine(LastGameInfo());
@@ -755,15 +1249,9 @@ void SgUctSearch::CreateChildren(SgUctThreadState& state,
                                  bool deleteChildTrees)
 {
     unsigned int threadId = state.m_threadId;
-    if (! m_tree.HasCapacity(threadId, state.m_moves.size()))
-    {
-        Debug(state, str(format("SgUctSearch: maximum tree size %1% reached")
-                         % m_tree.MaxNodes()));
-        state.m_isTreeOutOfMem = true;
-        m_isTreeOutOfMemory = true;
-        SgSynchronizeThreadMemory();
+    if (! m_tree.HasCapacity(threadId, state.m_moves.size())
+        && ! HandleTreeFull(state))
         return;
-    }
     m_tree.MergeChildren(threadId, node, state.m_moves, deleteChildTrees);
 }
 
@@ -781,7 +1269,19 @@ bool SgUctSearch::NeedToComputeKnowledge(const SgUctNode* current)
                 // Mark knowledge computed immediately so other
                 // threads fall through and do not waste time
                 // re-computing this knowledge.
-                m_tree.SetKnowledgeCount(*current, threshold);
+                if (m_atomicTree)
+                {
+                    // Only the thread that wins the compare-and-swap
+                    // computes the knowledge
+                    const SgUctValue knowledgeCount =
+                        current->KnowledgeCount();
+                    if (knowledgeCount >= threshold
+                        || ! m_tree.CompareAndSetKnowledgeCount(
+                                      *current, knowledgeCount, threshold))
+                        return false;
+                }
+                else
+                    m_tree.SetKnowledgeCount(*current, threshold);
                 SG_ASSERT(current->MoveCount() > 0);
                 return true;
             }
@@ -815,7 +1315,8 @@ void SgUctSearch::PrintSearchProgress(double currTime) const
         const SgUctValue rootMean = m_tree.Root().Mean();
         out << (format("%s | %.3f | %.0f | %.1f ")
                 % SgTime::Format(currTime, true)
-                % rootMean % rootMoveCount % m_statistics.m_movesInTree.Mean());
+                % rootMean % rootMoveCount
+                % Statistics().m_movesInTree.Mean());
     }
     for (int i = 0; i <= MAX_SEQ_PRINT_LENGTH && current->HasChildren(); ++i)
     {
@@ -859,12 +1360,20 @@ void SgUctSearch::OnSearchIteration(SgUctValue gameNumber,
 
 void SgUctSearch::PlayGame(SgUctThreadState& state, GlobalLock* lock)
 {
+    SgUctPhaseProfile& profile = state.m_statistics.m_stat.m_profile;
+    profile.Start();
     state.m_isTreeOutOfMem = false;
+    if (m_threadPruneEpoch)
+        // See IncrementalPrune()
+        m_threadPruneEpoch[state.m_threadId].store(
+                               m_pruneEpoch.load(boost::memory_order_acquire),
+                               boost::memory_order_release);
     state.GameStart();
     SgUctGameInfo& info = state.m_gameInfo;
-    info.Clear(m_numberPlayouts);
+    info.Clear(m_numberPlayouts, m_maxGameLength);
     bool isTerminal;
     bool abortInTree = ! PlayInTree(state, isTerminal);
+    profile.Lap(SG_UCTPHASE_SELECT);
 
     // The playout phase is always unlocked
     if (lock != 0)
@@ -879,24 +1388,25 @@ void SgUctSearch::PlayGame(SgUctThreadState& state, GlobalLock* lock)
         else if (eval < 0.4)
             m_tree.SetProvenType(terminalNode, SG_PROVEN_LOSS);
         PropagateProvenStatus(info.m_nodes);
+        profile.Lap(SG_UCTPHASE_EVALUATE);
     }
 
-    size_t nuMovesInTree = info.m_inTreeSequence.size();
+    size_t nuMovesInTree = info.m_nuMovesInTree;
 
     // Play some "fake" playouts if node is a proven node
     if (! info.m_nodes.empty() && info.m_nodes.back()->IsProven())
     {
         for (size_t i = 0; i < m_numberPlayouts; ++i)
         {
-            info.m_sequence[i] = info.m_inTreeSequence;
-            info.m_skipRaveUpdate[i].assign(nuMovesInTree, false);
+            info.StartPlayout(i);
             SgUctValue eval = info.m_nodes.back()->IsProvenWin() ? 1 : 0;
-            size_t nuMoves = info.m_sequence[i].size();
+            size_t nuMoves = info.m_sequence[i].Size();
             if (nuMoves % 2 != 0)
                 eval = InverseEval(eval);
             info.m_aborted[i] = abortInTree || state.m_isTreeOutOfMem;
             info.m_eval[i] = eval;
         }
+        profile.Lap(SG_UCTPHASE_EVALUATE);
     }
     else 
     {
@@ -904,18 +1414,18 @@ void SgUctSearch::PlayGame(SgUctThreadState& state, GlobalLock* lock)
         for (size_t i = 0; i < m_numberPlayouts; ++i)
         {
             state.StartPlayout();
-            info.m_sequence[i] = info.m_inTreeSequence;
-            // skipRaveUpdate only used in playout phase
-            info.m_skipRaveUpdate[i].assign(nuMovesInTree, false);
+            info.StartPlayout(i);
             bool abort = abortInTree || state.m_isTreeOutOfMem;
             if (! abort && ! isTerminal)
                 abort = ! PlayoutGame(state, i);
+            profile.Lap(SG_UCTPHASE_PLAYOUT);
             SgUctValue eval;
             if (abort)
                 eval = UnknownEval();
             else
                 eval = state.Evaluate();
-            size_t nuMoves = info.m_sequence[i].size();
+            profile.Lap(SG_UCTPHASE_EVALUATE);
+            size_t nuMoves = info.m_sequence[i].Size();
             if (nuMoves % 2 != 0)
                 eval = InverseEval(eval);
             info.m_aborted[i] = abort;
@@ -929,11 +1439,16 @@ void SgUctSearch::PlayGame(SgUctThreadState& state, GlobalLock* lock)
     // End of unlocked part if ! m_lockFree
     if (lock != 0)
         lock->lock();
+    profile.Lap(SG_UCTPHASE_LOCK);
 
     UpdateTree(info);
+    profile.Lap(SG_UCTPHASE_UPDATE_TREE);
     if (m_rave)
+    {
         UpdateRaveValues(state);
-    UpdateStatistics(info);
+        profile.Lap(SG_UCTPHASE_UPDATE_RAVE);
+    }
+    UpdateStatistics(state);
 }
 
 /** Backs up proven information. Last node of nodes is the newly
@@ -946,8 +1461,12 @@ void SgUctSearch::PropagateProvenStatus(const std::vector<const SgUctNode*>& nod
     while (true)
     {
         const SgUctNode& parent = *nodes[i];
+        SgUctChildIterator it(m_tree, parent);
+        if (! it)
+            // Children were detached by IncrementalPrune() in another thread
+            break;
         SgUctProvenType type = SG_PROVEN_LOSS;
-        for (SgUctChildIterator it(m_tree, parent); it; ++it)
+        for ( ; it; ++it)
         {
             const SgUctNode& child = *it;
             if (! child.IsProven())
@@ -975,8 +1494,15 @@ void SgUctSearch::PropagateProvenStatus(const std::vector<const SgUctNode*>& nod
     @return @c false, if game was aborted due to maximum length */
 bool SgUctSearch::PlayInTree(SgUctThreadState& state, bool& isTerminal)
 {
-    vector<SgMove>& sequence = state.m_gameInfo.m_inTreeSequence;
-    vector<const SgUctNode*>& nodes = state.m_gameInfo.m_nodes;
+    SgUctGameInfo& info = state.m_gameInfo;
+    vector<const SgUctNode*>& nodes = info.m_nodes;
+    SgUctPhaseProfile& profile = state.m_statistics.m_stat.m_profile;
+    if (m_hasKnowledgeResults.load(boost::memory_order_acquire))
+    {
+        ApplyKnowledgeResults(state);
+        if (state.m_isTreeOutOfMem)
+            return true;
+    }
     const SgUctNode* root = &m_tree.Root();
     const SgUctNode* current = root;
     if (m_virtualLoss && m_numberThreads > 1)
@@ -992,14 +1518,16 @@ bool SgUctSearch::PlayInTree(SgUctThreadState& state, bool& isTerminal)
     }
     while (true)
     {
-        if (m_biasTermDepth > 0 && sequence.size() == m_biasTermDepth)
+        if (m_biasTermDepth > 0 && info.m_nuMovesInTree == m_biasTermDepth)
             useBiasTerm = false;
-        if (sequence.size() == m_maxGameLength)
+        if (info.m_nuMovesInTree == m_maxGameLength)
             return false;
         if (current->IsProven())
             break;
         if (! current->HasChildren())
         {
+            SgUctPhaseScope scope(profile, SG_UCTPHASE_SELECT,
+                                  SG_UCTPHASE_EXPAND);
             state.m_moves.clear();
             SgUctProvenType provenType = SG_NOT_PROVEN;
             state.GenerateAllMoves(0, state.m_moves, provenType);
@@ -1018,9 +1546,27 @@ bool SgUctSearch::PlayInTree(SgUctThreadState& state, bool& isTerminal)
             }
             if (current->MoveCount() >= m_expandThreshold)
             {
+                if (m_atomicTree)
+                {
+                    // If another thread is expanding this node, treat it
+                    // as a leaf in this game
+                    if (! m_tree.TryLockExpansion(*current))
+                        break;
+                    if (current->HasChildren())
+                    {
+                        m_tree.UnlockExpansion(*current);
+                        continue;
+                    }
+                }
                 ExpandNode(state, *current);
+                if (m_atomicTree)
+                    m_tree.UnlockExpansion(*current);
                 if (state.m_isTreeOutOfMem)
                     return true;
+                if (! current->HasChildren())
+                    // Tree is full and is being pruned (see
+                    // IncrementalPrune()), treat node as a leaf
+                    break;
                 breakAfterSelect = true;
             }
             else
@@ -1029,37 +1575,55 @@ bool SgUctSearch::PlayInTree(SgUctThreadState& state, bool& isTerminal)
         else if (state.m_threadId < m_maxKnowledgeThreads 
                  && NeedToComputeKnowledge(current))
         {
-            m_statistics.m_knowledge++;
-            state.m_moves.clear();
-            SgUctProvenType provenType = SG_NOT_PROVEN;
-            bool truncate = state.GenerateAllMoves(current->KnowledgeCount(), 
-                                                   state.m_moves,
-                                                   provenType);
-            if (current == root)
-                ApplyRootFilter(state.m_moves);
-            CreateChildren(state, *current, truncate);
-            if (provenType != SG_NOT_PROVEN)
-            {
-                m_tree.SetProvenType(*current, provenType);
-                PropagateProvenStatus(nodes);
-                break;
-            }
-            if (state.m_moves.empty())
+            state.m_statistics.m_stat.m_knowledge++;
+            if (m_knowledgeWorkers > 0 && current != root)
+                // Continue the game with the current children, the result
+                // is merged by ApplyKnowledgeResults()
+                AddKnowledgeRequest(state, *current);
+            else
             {
-                isTerminal = true;
-                break;
+                SgUctPhaseScope scope(profile, SG_UCTPHASE_SELECT,
+                                      SG_UCTPHASE_EXPAND);
+                state.m_moves.clear();
+                SgUctProvenType provenType = SG_NOT_PROVEN;
+                bool truncate =
+                    state.GenerateAllMoves(current->KnowledgeCount(),
+                                           state.m_moves, provenType);
+                if (current == root)
+                    ApplyRootFilter(state.m_moves);
+                if (m_atomicTree)
+                    m_tree.LockExpansion(*current);
+                CreateChildren(state, *current, truncate);
+                if (m_atomicTree)
+                    m_tree.UnlockExpansion(*current);
+                if (provenType != SG_NOT_PROVEN)
+                {
+                    m_tree.SetProvenType(*current, provenType);
+                    PropagateProvenStatus(nodes);
+                    break;
+                }
+                if (state.m_moves.empty())
+                {
+                    isTerminal = true;
+                    break;
+                }
+                if (state.m_isTreeOutOfMem)
+                    return true;
+                breakAfterSelect = true;
             }
-            if (state.m_isTreeOutOfMem)
-                return true;
-            breakAfterSelect = true;
         }
-        current = &SelectChild(state.m_randomizeRaveCounter, useBiasTerm, *current);
+        const SgUctNode* child = SelectChild(state, useBiasTerm, *current);
+        if (child == 0)
+            // Children were detached by IncrementalPrune() in another
+            // thread, treat node as a leaf
+            break;
+        current = child;
         if (m_virtualLoss && m_numberThreads > 1)
             m_tree.AddVirtualLoss(*current);
         nodes.push_back(current);
         SgMove move = current->Move();
         state.Execute(move);
-        sequence.push_back(move);
+        info.AddInTreeMove(move);
         if (breakAfterSelect)
             break;
     }
@@ -1073,19 +1637,17 @@ bool SgUctSearch::PlayInTree(SgUctThreadState& state, bool& isTerminal)
 bool SgUctSearch::PlayoutGame(SgUctThreadState& state, std::size_t playout)
 {
     SgUctGameInfo& info = state.m_gameInfo;
-    vector<SgMove>& sequence = info.m_sequence[playout];
-    vector<bool>& skipRaveUpdate = info.m_skipRaveUpdate[playout];
+    SgUctGameSequence& sequence = info.m_sequence[playout];
     while (true)
     {
-        if (sequence.size() == m_maxGameLength)
+        if (sequence.Size() == m_maxGameLength)
             return false;
         bool skipRave = false;
         SgMove move = state.GeneratePlayoutMove(skipRave);
         if (move == SG_NULLMOVE)
             break;
         state.ExecutePlayout(move);
-        sequence.push_back(move);
-        skipRaveUpdate.push_back(skipRave);
+        sequence.PushBack(move, skipRave);
     }
     return true;
 }
@@ -1135,14 +1697,26 @@ SgUctValue SgUctSearch::Search(SgUctValue maxGames, double maxTime,
             m_tree.CopyPruneLowCount(tempTree, pruneMinCount, true);
             int prunedSizePercentage =
                 static_cast<int>(tempTree.NuNodes() * 100 / m_tree.NuNodes());
+            double pruneTime = m_timer.GetTime() - startPruneTime;
             SgDebug() << "SgUctSearch: pruned size: " << tempTree.NuNodes()
                       << " (" << prunedSizePercentage << "%) time: "
-                      << (m_timer.GetTime() - startPruneTime) << "\n";
+                      << pruneTime << "\n";
             if (prunedSizePercentage > 50)
                 pruneMinCount *= 2;
             else
                  pruneMinCount = m_pruneMinCount; 
+            // The copy can be larger than the tree, if Transpositions()
+            // created shared children
+            if (tempTree.NuNodes() < m_tree.NuNodes())
+                m_statistics.m_prunedNodes +=
+                    m_tree.NuNodes() - tempTree.NuNodes();
+            m_statistics.m_pruneTime.Add(pruneTime);
             m_tree.Swap(tempTree);
+            // Detached subtrees, knowledge requests and transpositions
+            // belong to the old tree
+            m_detachedBlocks.clear();
+            ClearKnowledgeRequests();
+            InitTranspositionTable();
         }
     }
     EndSearch();
@@ -1166,7 +1740,7 @@ void SgUctSearch::SearchLoop(SgUctThreadState& state, GlobalLock* lock)
         state.m_isSearchInitialized = true;
     }
 
-    if (NumberThreads() == 1 || m_lockFree)
+    if (NumberThreads() == 1 || m_lockFree || m_atomicTree)
         lock = 0;
     if (lock != 0)
         lock->lock();
@@ -1174,11 +1748,10 @@ void SgUctSearch::SearchLoop(SgUctThreadState& state, GlobalLock* lock)
     while (! state.m_isTreeOutOfMem)
     {
         PlayGame(state, lock);
-        OnSearchIteration(m_numberGames + 1, state.m_threadId,
-                          state.m_gameInfo);
+        SgUctValue numberGames = ++state.m_statistics.m_numberGames;
+        OnSearchIteration(numberGames, state.m_threadId, state.m_gameInfo);
         if (m_logGames)
             m_log << SummaryLine(state.m_gameInfo) << '\n';
-        ++m_numberGames;
         if (m_isTreeOutOfMemory)
             break;
         if (m_aborted || CheckAbortSearch(state))
@@ -1229,12 +1802,10 @@ SgPoint SgUctSearch::SearchOnePly(SgUctValue maxGames, double maxTime,
         for (size_t i = 0; i < moves.size(); ++i)
         {
             state.GameStart();
-            info.Clear(1);
+            info.Clear(1, m_maxGameLength);
             SgMove move = moves[i].m_move;
             state.Execute(move);
-            info.m_inTreeSequence.push_back(move);
-            info.m_sequence[0].push_back(move);
-            info.m_skipRaveUpdate[0].push_back(false);
+            info.AddInTreeMove(move);
             state.StartPlayouts();
             state.StartPlayout();
             bool abortGame = ! PlayoutGame(state, 0);
@@ -1244,9 +1815,9 @@ SgPoint SgUctSearch::SearchOnePly(SgUctValue maxGames, double maxTime,
             else
                 eval = state.Evaluate();
             state.EndPlayout();
-            state.TakeBackPlayout(info.m_sequence[0].size() - 1);
+            state.TakeBackPlayout(info.m_sequence[0].Size() - 1);
             state.TakeBackInTree(1);
-            statistics[i].Add(info.m_sequence[0].size() % 2 == 0 ?
+            statistics[i].Add(info.m_sequence[0].Size() % 2 == 0 ?
                               eval : InverseEval(eval));
             OnSearchIteration(games + 1, 0, info);
             games += 1;
@@ -1268,17 +1839,20 @@ SgPoint SgUctSearch::SearchOnePly(SgUctValue maxGames, double maxTime,
     return bestMove;
 }
 
-const SgUctNode& SgUctSearch::SelectChild(int& randomizeCounter, 
+/** Select the child to play in the in-tree phase.
+    @return The child or 0, if the children of the node were detached by
+    another thread (see IncrementalPrune()). */
+const SgUctNode* SgUctSearch::SelectChild(SgUctThreadState& state,
                                           bool useBiasTerm,
                                           const SgUctNode& node)
 {
     bool useRave = m_rave;
+    int& randomizeCounter = state.m_randomizeRaveCounter;
     if (m_randomizeRaveFrequency > 0 && --randomizeCounter == 0)
     {
         useRave = false;
         randomizeCounter = m_randomizeRaveFrequency;
     }
-    SG_ASSERT(node.HasChildren());
     SgUctValue posCount = node.PosCount();
     int virtualLossCount = node.VirtualLossCount();
     if (virtualLossCount > 1)
@@ -1290,7 +1864,7 @@ const SgUctNode& SgUctSearch::SelectChild(int& randomizeCounter,
 
     // If position count is zero, return first child
     if (posCount == 0)
-        return *SgUctChildIterator(m_tree, node);
+        return FirstChild(m_tree, node);
         
     const SgUctValue logPosCount = Log(posCount);
     const SgUctNode* bestChild = 0;
@@ -1320,12 +1894,12 @@ const SgUctNode& SgUctSearch::SelectChild(int& randomizeCounter,
         }
     }
     if (bestChild != 0)
-        return *bestChild;
+        return bestChild;
     // It can happen with multiple threads that all children are losing
     // in this state but this thread got in here before that information
     // was propagated up the tree. So just return the first child
     // in this case.
-    return *node.FirstChild();
+    return FirstChild(m_tree, node);
 }
 
 void SgUctSearch::SetNumberThreads(unsigned int n)
@@ -1337,6 +1911,32 @@ void SgUctSearch::SetNumberThreads(unsigned int n)
     CreateThreads();
 }
 
+void SgUctSearch::SetKnowledgeWorkers(unsigned int n)
+{
+    if (m_knowledgeWorkers == n)
+        return;
+    m_knowledgeWorkers = n;
+    if (m_threads.size() > 0) // Threads already created
+        CreateThreads();
+}
+
+void SgUctSearch::SetNuma(bool enable)
+{
+    if (m_numa == enable)
+        return;
+    m_numa = enable;
+    if (m_threads.size() > 0) // Threads already created
+        CreateThreads();
+}
+
+void SgUctSearch::SetNumaInterleaveNodes(std::size_t n)
+{
+    m_numaInterleaveNodes = n;
+    m_tree.SetNumaPlacement(m_numa, m_numaInterleaveNodes);
+    if (m_threads.size() > 0) // Threads already created
+        m_tree.SetMaxNodes(m_maxNodes);
+}
+
 void SgUctSearch::SetCheckTimeInterval(SgUctValue n)
 {
     SG_ASSERT(n >= 0);
@@ -1360,6 +1960,47 @@ void SgUctSearch::SetThreadStateFactory(SgUctThreadStateFactory* factory)
     // is not fully constructed) as an argument to the Create() function
 }
 
+/** Let a node that is expanded use the children of a node with the same
+    position.
+    Only a node at the same depth is used. A node with the same position at
+    a different depth can be on the path to the expanded node, if the
+    position was repeated, and sharing its children would create a cycle.
+    @return @c true if the node shares the children of another node. */
+bool SgUctSearch::ShareTransposition(SgUctThreadState& state,
+                                     const SgHashCode& hash,
+                                     const SgUctNode& node)
+{
+    TranspositionData data;
+    {
+        boost::mutex::scoped_lock lock(m_transpositionMutex);
+        if (! m_transpositionTable->Lookup(hash, &data))
+            return false;
+    }
+    const SgUctNode* source = data.Node();
+    if (source == &node || data.Depth() != state.m_gameInfo.m_nodes.size()
+        || ! m_tree.ShareChildren(node, *source))
+        return false;
+    SgUctSearchStat& stat = state.m_statistics.m_stat;
+    ++stat.m_transpositions;
+    stat.m_sharedNodes += node.NuChildren();
+    return true;
+}
+
+void SgUctSearch::StoreTransposition(const SgHashCode& hash,
+                                     const SgUctNode& node, size_t depth)
+{
+    boost::mutex::scoped_lock lock(m_transpositionMutex);
+    m_transpositionTable->Store(hash, TranspositionData(&node, depth));
+}
+
+SgUctSearchStat SgUctSearch::Statistics() const
+{
+    SgUctSearchStat stat = m_statistics;
+    for (size_t i = 0; i < m_threads.size(); ++i)
+        stat.Add(m_threads[i]->m_state->m_statistics.m_stat);
+    return stat;
+}
+
 void SgUctSearch::StartSearch(const vector<SgMove>& rootFilter,
                               SgUctTree* initTree)
 {
@@ -1389,13 +2030,26 @@ void SgUctSearch::StartSearch(const vector<SgMove>& rootFilter,
     m_statistics.Clear();
     m_aborted = false;
     m_wasEarlyAbort = false;
+    m_incrementalPruneMinCount = m_pruneMinCount;
+    m_detachedBlocks.clear();
+    InitTranspositionTable();
+    m_pruneEpoch.store(0);
+    m_threadPruneEpoch.reset(new boost::atomic<size_t>[m_threads.size()]);
+    for (size_t i = 0; i < m_threads.size(); ++i)
+        m_threadPruneEpoch[i].store(0);
     if (! SgDeterministic::DeterministicMode())
        m_checkTimeInterval = 1;
-    m_numberGames = 0;
     m_lastScoreDisplayTime = m_timer.GetTime();
     OnStartSearch();
     
-    m_nextCheckTime = SgUctValue(m_checkTimeInterval);
+    for (size_t i = 0; i < m_threads.size(); ++i)
+    {
+        SgUctThreadStatistics& statistics =
+            m_threads[i]->m_state->m_statistics;
+        statistics.Clear();
+        statistics.m_checkTimeInterval = m_checkTimeInterval;
+        statistics.m_nextCheckTime = m_checkTimeInterval;
+    }
     m_startRootMoveCount = m_tree.Root().MoveCount();
 
     for (unsigned int i = 0; i < m_threads.size(); ++i)
@@ -1405,10 +2059,22 @@ void SgUctSearch::StartSearch(const vector<SgMove>& rootFilter,
         state.m_randomizeBiasCounter = m_biasTermFrequency;
         state.StartSearch();
     }
+    ClearKnowledgeRequests();
+    for (size_t i = 0; i < m_knowledgeWorkerThreads.size(); ++i)
+        m_knowledgeWorkerThreads[i]->m_state->StartSearch();
 }
 
 void SgUctSearch::EndSearch()
 {
+    // Move the statistics of the threads to m_statistics, so that they
+    // are kept if the threads are recreated
+    for (size_t i = 0; i < m_threads.size(); ++i)
+    {
+        SgUctSearchStat& stat = m_threads[i]->m_state->m_statistics.m_stat;
+        m_statistics.Add(stat);
+        stat.Clear();
+    }
+    ClearKnowledgeRequests();
     OnEndSearch();
 }
 
@@ -1428,25 +2094,35 @@ std::string SgUctSearch::SummaryLine(const SgUctGameInfo& info) const
     return buffer.str();
 }
 
-void SgUctSearch::UpdateCheckTimeInterval(double time)
+bool SgUctSearch::UseIncrementalPrune() const
+{
+    return m_pruneFullTree && m_incrementalPrune && m_threadPruneEpoch
+        && ! m_transpositions
+        && (m_numberThreads == 1 || ! m_lockFree || m_atomicTree);
+}
+
+/** Update the time check interval of a thread (see CheckTimeInterval()).
+    Only changes the statistics of the thread, so that no data shared by
+    the threads is written without a lock. */
+void SgUctSearch::UpdateCheckTimeInterval(SgUctThreadStatistics& statistics,
+                                          double time)
 {
     if (time < numeric_limits<double>::epsilon())
         return;
-    // Dynamically update m_checkTimeInterval (see comment at definition of
-    // m_checkTimeInterval)
     double wantedTimeDiff = (m_maxTime > 1 ? 0.1 : 0.1 * m_maxTime);
     if (time < wantedTimeDiff / 10)
     {
         // Computing games per second might be unreliable for small times
-        m_checkTimeInterval *= 2;
+        statistics.m_checkTimeInterval *= 2;
         return;
     }
-    m_statistics.m_gamesPerSecond = GamesPlayed() / time;
+    statistics.m_gamesPerSecond = GamesPlayed() / time;
     double gamesPerSecondPerThread =
-        m_statistics.m_gamesPerSecond / double(m_numberThreads);
-    m_checkTimeInterval = SgUctValue(wantedTimeDiff * gamesPerSecondPerThread);
-    if (m_checkTimeInterval == 0)
-        m_checkTimeInterval = 1;
+        statistics.m_gamesPerSecond / double(m_numberThreads);
+    statistics.m_checkTimeInterval =
+        SgUctValue(wantedTimeDiff * gamesPerSecondPerThread);
+    if (statistics.m_checkTimeInterval == 0)
+        statistics.m_checkTimeInterval = 1;
 }
 
 /** Update the RAVE values in the tree for both players after a game was
@@ -1462,28 +2138,24 @@ void SgUctSearch::UpdateRaveValues(SgUctThreadState& state,
                                    std::size_t playout)
 {
     SgUctGameInfo& info = state.m_gameInfo;
-    const vector<SgMove>& sequence = info.m_sequence[playout];
-    if (sequence.size() == 0)
+    const SgUctGameSequence& sequence = info.m_sequence[playout];
+    if (sequence.Size() == 0)
         return;
     SG_ASSERT(m_moveRange > 0);
     size_t* firstPlay = state.m_firstPlay.get();
     size_t* firstPlayOpp = state.m_firstPlayOpp.get();
-    std::fill_n(firstPlay, m_moveRange, numeric_limits<size_t>::max());
-    std::fill_n(firstPlayOpp, m_moveRange, numeric_limits<size_t>::max());
     const vector<const SgUctNode*>& nodes = info.m_nodes;
-    const vector<bool>& skipRaveUpdate = info.m_skipRaveUpdate[playout];
     SgUctValue eval = info.m_eval[playout];
     SgUctValue invEval = InverseEval(eval);
     size_t nuNodes = nodes.size();
-    size_t i = sequence.size() - 1;
+    size_t i = sequence.Size() - 1;
     bool opp = (i % 2 != 0);
 
     // Update firstPlay, firstPlayOpp arrays using playout moves
     for ( ; i >= nuNodes; --i)
     {
-        SG_ASSERT(i < skipRaveUpdate.size());
-        SG_ASSERT(i < sequence.size());
-        if (! skipRaveUpdate[i])
+        SG_ASSERT(i < sequence.Size());
+        if (! sequence.SkipRaveUpdate(i))
         {
             SgMove mv = sequence[i];
             size_t& first = (opp ? firstPlayOpp[mv] : firstPlay[mv]);
@@ -1495,11 +2167,10 @@ void SgUctSearch::UpdateRaveValues(SgUctThreadState& state,
 
     while (true)
     {
-        SG_ASSERT(i < skipRaveUpdate.size());
-        SG_ASSERT(i < sequence.size());
+        SG_ASSERT(i < sequence.Size());
         // skipRaveUpdate currently not used in in-tree phase
-        SG_ASSERT(i >= info.m_inTreeSequence.size() || ! skipRaveUpdate[i]);
-        if (! skipRaveUpdate[i])
+        SG_ASSERT(i >= info.m_nuMovesInTree || ! sequence.SkipRaveUpdate(i));
+        if (! sequence.SkipRaveUpdate(i))
         {
             SgMove mv = sequence[i];
             size_t& first = (opp ? firstPlayOpp[mv] : firstPlay[mv]);
@@ -1517,6 +2188,14 @@ void SgUctSearch::UpdateRaveValues(SgUctThreadState& state,
         --i;
         opp = ! opp;
     }
+
+    // Reset only the entries of the moves of this game, which is cheaper
+    // than clearing the arrays for all moves
+    for (size_t j = 0; j < sequence.Size(); ++j)
+    {
+        firstPlay[sequence[j]] = numeric_limits<size_t>::max();
+        firstPlayOpp[sequence[j]] = numeric_limits<size_t>::max();
+    }
 }
 
 void SgUctSearch::UpdateRaveValues(SgUctThreadState& state,
@@ -1529,7 +2208,13 @@ void SgUctSearch::UpdateRaveValues(SgUctThreadState& state,
     const SgUctNode* node = state.m_gameInfo.m_nodes[i];
     if (! node->HasChildren())
         return;
-    size_t len = state.m_gameInfo.m_sequence[playout].size();
+    const size_t len = state.m_gameInfo.m_sequence[playout].Size();
+    const SgUctValue range = SgUctValue(len - i);
+    // Copies of the parameters, which the compiler cannot keep in registers
+    // otherwise, because the nodes are modified in the loop
+    const bool checkSame = m_raveCheckSame;
+    const bool weightUpdates = m_weightRaveUpdates;
+    const bool atomicTree = m_atomicTree;
     for (SgUctChildIterator it(m_tree, *node); it; ++it)
     {
         const SgUctNode& child = *it;
@@ -1538,26 +2223,27 @@ void SgUctSearch::UpdateRaveValues(SgUctThreadState& state,
         SG_ASSERT(first >= i);
         if (first == numeric_limits<size_t>::max())
             continue;
-        if  (m_raveCheckSame && SgUtil::InRange(firstPlayOpp[mv], i, first))
+        if (checkSame && SgUtil::InRange(firstPlayOpp[mv], i, first))
             continue;
-        SgUctValue weight;
-        if (m_weightRaveUpdates)
-            weight = 2 - SgUctValue(first - i) / SgUctValue(len - i);
+        SgUctValue weight = 1;
+        if (weightUpdates)
+            weight = 2 - SgUctValue(first - i) / range;
+        if (atomicTree)
+            m_tree.AddRaveValueLocked(child, eval, weight);
         else
-            weight = 1;
-        m_tree.AddRaveValue(child, eval, weight);
+            m_tree.AddRaveValue(child, eval, weight);
     }
 }
 
-void SgUctSearch::UpdateStatistics(const SgUctGameInfo& info)
+void SgUctSearch::UpdateStatistics(SgUctThreadState& state)
 {
-    m_statistics.m_movesInTree.Add(
-                            static_cast<float>(info.m_inTreeSequence.size()));
+    const SgUctGameInfo& info = state.m_gameInfo;
+    SgUctSearchStat& stat = state.m_statistics.m_stat;
+    stat.m_movesInTree.Add(static_cast<float>(info.m_nuMovesInTree));
     for (size_t i = 0; i < m_numberPlayouts; ++i)
     {
-        m_statistics.m_gameLength.Add(
-                               static_cast<float>(info.m_sequence[i].size()));
-        m_statistics.m_aborted.Add(info.m_aborted[i] ? 1.f : 0.f);
+        stat.m_gameLength.Add(static_cast<float>(info.m_sequence[i].Size()));
+        stat.m_aborted.Add(info.m_aborted[i] ? 1.f : 0.f);
     }
 }
 
@@ -1575,8 +2261,11 @@ void SgUctSearch::UpdateTree(const SgUctGameInfo& info)
     {
         const SgUctNode& node = *nodes[i];
         const SgUctNode* father = (i > 0 ? nodes[i - 1] : 0);
-        m_tree.AddGameResults(node, father, i % 2 == 0 ? eval : inverseEval,
-                              count);
+        const SgUctValue value = (i % 2 == 0 ? eval : inverseEval);
+        if (m_atomicTree)
+            m_tree.AddGameResultsLocked(node, father, value, count);
+        else
+            m_tree.AddGameResults(node, father, value, count);
         // Remove the virtual loss
         if (m_virtualLoss && m_numberThreads > 1)
             m_tree.RemoveVirtualLoss(node);
@@ -1585,15 +2274,18 @@ void SgUctSearch::UpdateTree(const SgUctGameInfo& info)
 
 void SgUctSearch::WriteStatistics(std::ostream& out) const
 {
+    const SgUctSearchStat stat = Statistics();
     out << SgWriteLabel("Count") << m_tree.Root().MoveCount() << '\n'
         << SgWriteLabel("GamesPlayed") << GamesPlayed() << '\n'
         << SgWriteLabel("Nodes") << m_tree.NuNodes() << '\n';
+    if (m_numa)
+        out << SgWriteLabel("NumaNodes") << SgNuma::NuNodes() << '\n';
     if (! m_knowledgeThreshold.empty())
         out << SgWriteLabel("Knowledge") 
-            << m_statistics.m_knowledge << " (" << fixed << setprecision(1) 
-            << m_statistics.m_knowledge * 100.0 / m_tree.Root().MoveCount()
+            << stat.m_knowledge << " (" << fixed << setprecision(1) 
+            << stat.m_knowledge * 100.0 / m_tree.Root().MoveCount()
             << "%)\n";
-    m_statistics.Write(out);
+    stat.Write(out);
     m_mpiSynchronizer->WriteStatistics(out);
 }
 
@@ -6,9 +6,12 @@
 #ifndef SG_UCTSEARCH_H
 #define SG_UCTSEARCH_H
 
+#include <deque>
 #include <fstream>
 #include <vector>
+#include <boost/atomic.hpp>
 #include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread/barrier.hpp>
 #include <boost/thread/condition.hpp>
@@ -18,7 +21,10 @@
 #include "SgAdditiveKnowledge.h"
 #include "SgBlackWhite.h"
 #include "SgBWArray.h"
+#include "SgHashTable.h"
+#include "SgPoint.h"
 #include "SgTimer.h"
+#include "SgUctProfile.h"
 #include "SgUctTree.h"
 #include "SgMpiSynchronizer.h"
 
@@ -62,6 +68,7 @@
 
     @see
     - @ref sguctsearchlockfree
+    - @ref sguctsearchatomic
     - @ref sguctsearchweights
     - @ref sguctsearchproven */
 
@@ -89,9 +96,10 @@ The child information of a node consists of two variables: a pointer to the
 first child in the array, and the number of children. To avoid that another
 thread sees an inconsistent state of these variables, all threads assume that
 the number of children is valid if the pointer to the first child is not null.
-Linking a parent to a new set of children requires first writing the number of
-children, then the pointer to the first child. The compiler is prevented from
-reordering the writes by declaring these variables as volatile.
+Linking a parent to a new set of children requires first writing the pointer
+to the first child, then the number of children. The compiler and the CPU are
+prevented from reordering the writes by storing these variables with release
+semantics and loading them with acquire semantics (see SgUctNode).
 
 @section sguctsearchlockfreevalues Updating Values
 
@@ -115,20 +123,61 @@ only the RAVE mean is used, and if both counts are zero, a configurable
 constant value, the first play urgency, is used. To avoid this problem, all
 threads assume that a mean value is only valid if the corresponding count is
 non-zero. Updating a value requires first writing the new mean value, then the
-new count. The compiler is prevented from reordering the writes by declaring
-the counts and mean values as volatile.
+new count. The writes are ordered by storing the count with release semantics
+(see SgStatisticsAtomicBase).
 
 @section sguctsearchlockfreeplatform Platform Requirements
 
-There are some requirements on the memory model of the platform to make the
-lock-free search algorithm work. Writes of certain basic types (size_t, int,
-float, pointers) must be atomic. Writes by one thread must be seen by other
-threads in the same order. The IA-32 and Intel-64 CPU architectures, which are
-used in most modern standard computers, guarantee these assumptions. They also
-synchronize CPU caches after writes. (See
-<a href="http://download.intel.com/design/processor/manuals/253668.pdf">
+Previous versions declared the shared variables as volatile and relied on the
+memory model of the IA-32 and Intel-64 CPU architectures, which guarantee that
+writes of basic types are atomic and seen by other threads in the same order.
+(See <a href="http://download.intel.com/design/processor/manuals/253668.pdf">
 Intel 64 and IA-32 Architectures Software Developer's Manual</a>, chapter
-7.1 Locked Atomic Operations and 7.2 Memory Ordering). */
+7.1 Locked Atomic Operations and 7.2 Memory Ordering). The node data is now
+accessed with atomic operations and explicit memory ordering, which compile
+to plain loads and stores on these architectures and add the required
+barriers on weakly ordered CPUs. The default for LockFree() is still only
+enabled on Intel architectures or if the macro ENABLE_CACHE_SYNC is defined.
+*/
+
+/** @page sguctsearchatomic Atomic mode in SgUctSearch
+
+The atomic mode (SgUctSearch::AtomicTree()) is a third concurrency mode
+between the default mode, in which the in-tree phase, the expansion of nodes
+and the update of the values are protected by a single global mutex, and the
+lock-free mode, which tolerates lost updates. Like the lock-free mode, it does
+not use the global mutex, so all phases of a game run concurrently. Unlike the
+lock-free mode, it uses small per-node locks and atomic read-modify-write
+operations to avoid the faulty updates described in @ref sguctsearchlockfree.
+
+@section sguctsearchatomicexpand Expanding Nodes
+
+Each node has an expansion lock. A thread that wants to expand a leaf node
+tries to acquire the lock without waiting. If another thread holds the lock,
+the node is treated as a leaf for the current game and the playout starts
+from it. After acquiring the lock, the thread checks again whether the node
+was expanded in the meantime. Therefore, a node is expanded only once and no
+memory is wasted on children that are overwritten by another thread. Merging
+new children after a knowledge computation (SgUctSearch::KnowledgeThreshold())
+waits for the expansion lock. The knowledge threshold of a node is claimed
+with a compare-and-swap, so that knowledge is computed only once per
+threshold.
+
+@section sguctsearchatomicupdate Updating Values
+
+The move and RAVE values of a node are updated while holding the update lock
+of the node, which is a spin lock that is held only for the few instructions
+of the incremental mean update. The position count of the father and the
+virtual loss counts are updated with atomic read-modify-write operations.
+Readers do not take any lock; they rely on the release/acquire ordering of
+mean and count as in the lock-free mode.
+
+@section sguctsearchatomicplatform Platform Requirements
+
+The atomic mode does not make any assumptions on the memory model of the CPU
+and does not require the configure option @c --enable-cache-sync. The search
+statistics (SgUctSearchStat) are still updated without locking in this mode
+and are only approximate. */
 
 /** @page sguctsearchweights Estimator weights in SgUctSearch
     The weights of the estimators (move value, RAVE value) are chosen by
@@ -205,6 +254,94 @@ Intel 64 and IA-32 Architectures Software Developer's Manual</a>, chapter
 
 //----------------------------------------------------------------------------
 
+/** Moves of a game in SgUctSearch with flags for skipping RAVE updates.
+    Buffer that is reused for all games of a thread. The moves and the
+    flags are stored in separate arrays that start at a cache line. Memory
+    is only allocated if a game is longer than the current capacity, which
+    happens only in the first games of a thread, or if the maximum game
+    length of the search is not set.
+    @ingroup sguctgroup */
+class SgUctGameSequence
+{
+public:
+    SgUctGameSequence();
+
+    ~SgUctGameSequence();
+
+    SgMove operator[](std::size_t i) const;
+
+    /** Remove all moves. */
+    void Clear();
+
+    /** Replace the moves by the first moves of another sequence. */
+    void CopyPrefix(const SgUctGameSequence& sequence, std::size_t length);
+
+    void PushBack(SgMove move, bool skipRaveUpdate = false);
+
+    /** Increase the capacity, if it is smaller than a given value. */
+    void Reserve(std::size_t capacity);
+
+    std::size_t Size() const;
+
+    /** Flag to skip the RAVE update for the move with index i. */
+    bool SkipRaveUpdate(std::size_t i) const;
+
+private:
+    static const std::size_t CACHE_LINE_SIZE = 64;
+
+    static const std::size_t MIN_CAPACITY = 256;
+
+    std::size_t m_size;
+
+    std::size_t m_capacity;
+
+    SgMove* m_move;
+
+    /** Byte flags, faster to access than std::vector<bool> */
+    unsigned char* m_skipRaveUpdate;
+
+    boost::scoped_array<char> m_memory;
+
+    /** Not implemented. */
+    SgUctGameSequence(const SgUctGameSequence&);
+
+    /** Not implemented. */
+    SgUctGameSequence& operator=(const SgUctGameSequence&);
+};
+
+inline SgMove SgUctGameSequence::operator[](std::size_t i) const
+{
+    SG_ASSERT(i < m_size);
+    return m_move[i];
+}
+
+inline void SgUctGameSequence::Clear()
+{
+    m_size = 0;
+}
+
+inline void SgUctGameSequence::PushBack(SgMove move, bool skipRaveUpdate)
+{
+    if (m_size == m_capacity)
+        Reserve(2 * m_capacity);
+    m_move[m_size] = move;
+    m_skipRaveUpdate[m_size] = skipRaveUpdate;
+    ++m_size;
+}
+
+inline std::size_t SgUctGameSequence::Size() const
+{
+    return m_size;
+}
+
+inline bool SgUctGameSequence::SkipRaveUpdate(std::size_t i) const
+{
+    SG_ASSERT(i < m_size);
+    return m_skipRaveUpdate[i] != 0;
+}
+
+//----------------------------------------------------------------------------
+
 /** Game result, sequence and nodes of one Monte Carlo game in SgUctSearch.
     @ingroup sguctgroup */
 struct SgUctGameInfo
@@ -213,13 +350,18 @@ struct SgUctGameInfo
         The result is from the view of the player at the root. */
     std::vector<SgUctValue> m_eval;
 
-    /** The sequence of the in-tree phase. */
-    std::vector<SgMove> m_inTreeSequence;
+    /** The number of moves of the in-tree phase.
+        The moves are the first moves of each sequence in m_sequence. */
+    std::size_t m_nuMovesInTree;
 
     /** The sequence of the playout(s).
-        For convenient usage, they also include the moves from
-        m_inTreeSequence, even if they are the same for each playout. */
-    std::vector<std::vector<SgMove> > m_sequence;
+        The sequences start with the moves of the in-tree phase, which are
+        added only to the sequence of the first playout and copied to the
+        sequences of the other playouts in StartPlayout(). The number of
+        sequences is the size of m_eval. The flag to skip the RAVE update
+        is currently only used in the playout phase, so it is false for all
+        moves in the in-tree phase. */
+    boost::scoped_array<SgUctGameSequence> m_sequence;
 
     /** Was the playout aborted due to maxGameLength (stored for each
         playout). */
@@ -228,16 +370,28 @@ struct SgUctGameInfo
     /** Nodes visited in the in-tree phase. */
     std::vector<const SgUctNode*> m_nodes;
 
-    /** Flag to skip RAVE update for moves of the playout(s).
-        For convenient usage, the index corresponds to the move number from
-        the root position on, even if the flag is currently only used for
-        moves in the playout phase, so the flag is false for all moves in the
-        in-tree phase. */
-    std::vector<std::vector<bool> > m_skipRaveUpdate;
+    SgUctGameInfo();
 
-    void Clear(std::size_t numberPlayouts);
+    /** Add a move of the in-tree phase. */
+    void AddInTreeMove(SgMove move);
+
+    /** Prepare for a new game.
+        Allocates memory only if the number of playouts changes or the
+        sequences are shorter than the maximum game length. */
+    void Clear(std::size_t numberPlayouts, std::size_t maxGameLength);
+
+    /** Start the sequence of a playout with the moves of the in-tree
+        phase. */
+    void StartPlayout(std::size_t playout);
 };
 
+inline void SgUctGameInfo::AddInTreeMove(SgMove move)
+{
+    SG_ASSERT(m_sequence[0].Size() == m_nuMovesInTree);
+    m_sequence[0].PushBack(move);
+    ++m_nuMovesInTree;
+}
+
 //----------------------------------------------------------------------------
 
 /** Move selection strategy after search is finished.
@@ -258,6 +412,101 @@ enum SgUctMoveSelect
     SG_UCTMOVESELECT_ESTIMATE
 };
 
+//----------------------------------------------------------------------------
+
+/** Statistics of the last search performed by SgUctSearch. */
+struct SgUctSearchStat
+{
+    double m_time;
+
+    /** Number of nodes for which the knowledge threshold was exceeded. */ 
+    SgUctValue m_knowledge;
+
+    /** Games per second.
+        Useful values only if search time is higher than resolution of
+        SgTime::Get(). */
+    double m_gamesPerSecond;
+
+    SgStatisticsExt<SgUctValue,SgUctValue> m_gameLength;
+
+    SgStatisticsExt<SgUctValue,SgUctValue> m_movesInTree;
+
+    SgUctStatistics m_aborted;
+
+    /** Time spent for pruning the tree (see SgUctSearch::PruneFullTree()).
+        For the incremental pruning, this is the time that the pruning
+        thread spent for detaching and reclaiming subtrees, the other threads
+        continue searching in the meantime. For the full copy, this is the
+        time during which the search is stopped. */
+    SgStatisticsExt<double,std::size_t> m_pruneTime;
+
+    /** Number of nodes removed from the tree by pruning. */
+    std::size_t m_prunedNodes;
+
+    /** Number of expanded nodes that share the children of a node with the
+        same position (see SgUctSearch::Transpositions()). */
+    std::size_t m_transpositions;
+
+    /** Number of nodes not created because of shared children. */
+    std::size_t m_sharedNodes;
+
+    /** Time spent in the phases of the games.
+        Only measured if SG_UCT_PROFILE is enabled. Not written by Write()
+        (see SgUctPhaseProfile::Write()). */
+    SgUctPhaseProfile m_profile;
+
+    /** Add the counts and statistics of another SgUctSearchStat.
+        Used for adding the statistics of the threads. Does not change
+        m_time and m_gamesPerSecond, which are values of the whole
+        search. */
+    void Add(const SgUctSearchStat& stat);
+
+    void Clear();
+
+    void Write(std::ostream& out) const;
+};
+
+//----------------------------------------------------------------------------
+
+/** Statistics of the games of one thread in SgUctSearch.
+    Each thread updates only the instance in its SgUctThreadState without
+    locking. SgUctSearch adds the statistics of all threads on demand (see
+    SgUctSearch::Statistics()). The padding at the beginning and the end
+    avoids that the members share a cache line with data that is written
+    by other threads.
+    @ingroup sguctgroup */
+struct SgUctThreadStatistics
+{
+    /** Not used, see class description. */
+    char m_paddingBegin[64];
+
+    /** Number of games played by the thread in the current search. */
+    SgUctValue m_numberGames;
+
+    /** Number of games of the thread after which the thread checks the
+        time next (see SgUctSearch::CheckTimeInterval()). */
+    SgUctValue m_nextCheckTime;
+
+    /** Current interval of the time checks of the thread.
+        Starts with SgUctSearch::CheckTimeInterval() and is updated by the
+        thread at each time check. */
+    SgUctValue m_checkTimeInterval;
+
+    /** Games per second of the whole search, as computed by the thread at
+        its last time check. Used for the count abort. */
+    double m_gamesPerSecond;
+
+    SgUctSearchStat m_stat;
+
+    /** Not used, see class description. */
+    char m_paddingEnd[64];
+
+    SgUctThreadStatistics();
+
+    void Clear();
+};
+
+
 //----------------------------------------------------------------------------
 
 /** Base class for the thread state.
@@ -281,13 +530,22 @@ public:
         maximum tree size was reached. */
     bool m_isTreeOutOfMem;
 
+    /** Flag indicating that the thread holds the prune mutex of the search.
+        Set while SgUctSearch::ApplyKnowledgeResults() merges results, such
+        that SgUctSearch::HandleTreeFull() does not lock it again. */
+    bool m_ownsPruneLock;
+
     SgUctGameInfo m_gameInfo;
 
+    SgUctThreadStatistics m_statistics;
+
     /** Local variable for SgUctSearch::UpdateRaveValues().
         Reused for efficiency. Stores the first time a move was played
         by the color to play at the root position (move is used as an index,
         do m_moveRange must be > 0); numeric_limits<size_t>::max(), if the
-        move was not played. */
+        move was not played. All entries are numeric_limits<size_t>::max()
+        between calls, UpdateRaveValues() resets only the entries of the
+        moves of the game. */
     boost::scoped_array<std::size_t> m_firstPlay;
 
     /** Local variable for SgUctSearch::UpdateRaveValues().
@@ -394,6 +652,12 @@ public:
         Default implementation does nothing. */
     virtual void EndPlayout();
 
+    /** Hash code of the current position in the in-tree phase.
+        Used by SgUctSearch::Transpositions(). Positions with the same hash
+        code must have the same legal moves. Default implementation returns
+        a zero hash code, which disables the transposition table. */
+    virtual SgHashCode PositionHash() const;
+
     // @} // name
 };
 
@@ -415,32 +679,6 @@ public:
 
 //----------------------------------------------------------------------------
 
-/** Statistics of the last search performed by SgUctSearch. */
-struct SgUctSearchStat
-{
-    double m_time;
-
-    /** Number of nodes for which the knowledge threshold was exceeded. */ 
-    SgUctValue m_knowledge;
-
-    /** Games per second.
-        Useful values only if search time is higher than resolution of
-        SgTime::Get(). */
-    double m_gamesPerSecond;
-
-    SgStatisticsExt<SgUctValue,SgUctValue> m_gameLength;
-
-    SgStatisticsExt<SgUctValue,SgUctValue> m_movesInTree;
-
-    SgUctStatistics m_aborted;
-
-    void Clear();
-
-    void Write(std::ostream& out) const;
-};
-
-//----------------------------------------------------------------------------
-
 /** Optional parameters to SgUctSearch::Search() to allow early aborts.
     If early abort is used, the search will be aborted after a fraction of the
     resources (max time, max nodes) are spent, if the value is a clear win
@@ -517,7 +755,9 @@ public:
     /** Hook function that will be called by Search() after each game.
         Default implementation does nothing.
         This function does not need to be thread-safe.
-        @param gameNumber The number of this iteration.
+        @param gameNumber The number of games played by the thread in the
+        current search, including this one. Each thread counts its own
+        games, so the numbers are only unique together with threadId.
         @param threadId
         @param info The game info of the thread which played this iteration.
         @warning If LockFree() is enabled, this function will be called from
@@ -620,6 +860,13 @@ public:
     SgUctValue GetBound(bool useRave, const SgUctNode& node, 
                         const SgUctNode& child) const;
 
+    /** Update the RAVE values of the children of the nodes of a game.
+        Called after each game if Rave() is enabled. The game is the
+        m_gameInfo of the thread state. Can also be called with a game
+        set up by the caller to measure the cost of the update.
+        Requires: m_moveRange > 0 */
+    void UpdateRaveValues(SgUctThreadState& state);
+
     // @} // name
 
 
@@ -649,6 +896,18 @@ public:
         used by other code while the search is not running. */
     SgUctTree& GetTempTree();
 
+    /** Add results of games played by another search to a child of the root.
+        Used by synchronizers that combine the root statistics of several
+        searches (see SgSharedMemorySynchronizer). Must not be called while
+        the search is running. The move count and value of the root are
+        updated too, so that its move count stays the sum of the move counts
+        of its children.
+        @param move The move of the child. Results for moves that are not
+        children of the root are ignored.
+        @param eval The mean value of the games
+        @param count The number of games */
+    void AddRootMoveResults(SgMove move, SgUctValue eval, SgUctValue count);
+
     // @} // name
 
 
@@ -693,6 +952,25 @@ public:
 
     void SetMaxKnowledgeThreads(unsigned int threads);
 
+    /** Number of threads that compute the knowledge at the thresholds of
+        KnowledgeThreshold() asynchronously.
+        If greater than zero, a search thread that reaches a knowledge
+        threshold adds a request to a queue and continues the game with the
+        current children of the node. The knowledge workers take the
+        requests from the queue in batches, replay the move sequence to the
+        node in their own thread state and call
+        SgUctThreadState::GenerateAllMoves(). The results are merged into the
+        tree by the search threads at the start of their next game. Results
+        are discarded if the tree was pruned in the meantime.
+        The knowledge at the root and the move generation at the expansion of
+        a node are always computed synchronously, because the search needs
+        their result immediately. Changing this value recreates the threads.
+        The default is 0 (synchronous knowledge computation). */
+    unsigned int KnowledgeWorkers() const;
+
+    /** See KnowledgeWorkers() */
+    void SetKnowledgeWorkers(unsigned int n);
+
     /** Maximum number of nodes in the tree.
         @note The search owns two trees, one of which is used as a temporary
         tree for some operations (see GetTempTree()). This functions sets
@@ -709,12 +987,37 @@ public:
     /** See SetNumberThreads() */
     void SetNumberThreads(unsigned int n);
 
+    /** Bind the search threads to NUMA nodes.
+        If enabled, each search thread runs on the CPUs of one NUMA node
+        (see SgNuma::ThreadNode()) and the node allocator of the thread in
+        both trees is placed on the memory of this node
+        (see SgUctTree::SetNumaPlacement()). Changing this value recreates
+        the threads and clears the tree.
+        Has no effect if SgNuma::IsAvailable() is false. */
+    bool Numa() const;
+
+    /** See Numa() */
+    void SetNuma(bool enable);
+
+    /** Number of nodes per allocator that are interleaved over all NUMA
+        nodes if Numa() is enabled.
+        The top of the tree is at the beginning of the allocators and is
+        accessed by all threads, so interleaving it avoids that all threads
+        access the memory of a single node. Changing this value clears the
+        tree. The default is 0. */
+    std::size_t NumaInterleaveNodes() const;
+
+    /** See NumaInterleaveNodes() */
+    void SetNumaInterleaveNodes(std::size_t n);
+
     /** Interval in number of games in which to check time abort.
         Avoids that the potentially expensive SgTime::Get() is called after
-        every game. The interval is updated dynamically according to the
-        current games/sec, such that it is called ten times per second
-        (if the total search time is at least one second, otherwise ten times
-        per total maximum search time)
+        every game. The interval is counted in the games of each thread. It
+        is the initial interval of each search; each thread updates its own
+        copy dynamically according to the current games/sec, such that
+        each thread checks ten times per second (if the total search time is
+        at least one second, otherwise ten times per total maximum search
+        time)
     */
     SgUctValue CheckTimeInterval() const;
 
@@ -728,6 +1031,16 @@ public:
     /** See LockFree() */
     void SetLockFree(bool enable);
 
+    /** Multi-threaded search with per-node atomic synchronization.
+        If enabled, the global lock is not used (independent of LockFree()),
+        nodes are expanded by only one thread and no updates of the values
+        in the tree get lost.
+        @ref sguctsearchatomic */
+    bool AtomicTree() const;
+
+    /** See AtomicTree() */
+    void SetAtomicTree(bool enable);
+
     /** See SetRandomizeRaveFrequency() */
     int RandomizeRaveFrequency() const;
 
@@ -857,6 +1170,48 @@ public:
     /** See PruneFullTree() */
     void SetPruneMinCount(SgUctValue n);
 
+    /** Prune the full tree in place while the search continues.
+        If enabled, a thread that cannot expand a node, because the tree is
+        full, detaches the subtrees of nodes with a count below the minimum
+        count (see PruneFullTree()) with SgUctTree::DetachLowCount(). The
+        other threads continue searching, the thread itself treats the node
+        as a leaf. The nodes of the detached subtrees are reused, after all
+        threads have started a new game (a thread gets pointers to nodes only
+        during a game), by adding them to the free blocks of the allocators.
+        This avoids stopping all threads and copying the tree, but the tree
+        is not compacted. If no subtrees can be detached, the search falls
+        back to the full copy.
+        Only used in modes, in which the expansion of nodes is protected by
+        a lock (NumberThreads() == 1, ! LockFree() or AtomicTree()),
+        otherwise the full copy is always used.
+        Default is true. */
+    bool IncrementalPrune() const;
+
+    /** See IncrementalPrune() */
+    void SetIncrementalPrune(bool enable);
+
+    /** Share the children of nodes with the same position.
+        If enabled, a node that is expanded looks up the hash code of its
+        position (SgUctThreadState::PositionHash()) in a transposition
+        table. If a node with the same position, reached by a different move
+        order, already has children, the node uses these children instead of
+        creating new ones (see SgUctTree::ShareChildren()). The statistics
+        of the moves are shared and fewer nodes are needed, the tree becomes
+        a graph. A node stops sharing the children, when it computes new
+        knowledge (see KnowledgeThreshold()). Only nodes at the same depth
+        share children, otherwise a position that is repeated in a game
+        (e.g. after captures or a ko) would create a cycle in the graph and
+        functions that traverse the tree would not terminate. The
+        incremental pruning is
+        not used (see IncrementalPrune()), because it could reclaim children
+        that are still used by another node. The transposition table has
+        one entry per 16 nodes of MaxNodes().
+        Default is false. */
+    bool Transpositions() const;
+
+    /** See Transpositions() */
+    void SetTranspositions(bool enable);
+
     /** Terminate the search if the counts can no longer be represented
         precisely by SgUctValue.
         Default is true. */
@@ -877,7 +1232,11 @@ public:
     /** @name Statistics */
     // @{
 
-    const SgUctSearchStat& Statistics() const;
+    /** Statistics of the current or last search.
+        Adds the statistics of all threads (see SgUctThreadStatistics).
+        While a search is running, the values of the other threads are
+        read without locking and are only approximate. */
+    SgUctSearchStat Statistics() const;
 
     void WriteStatistics(std::ostream& out) const;
 
@@ -963,6 +1322,80 @@ private:
         void PlayGames();
     };
 
+    /** Request for an asynchronous knowledge computation.
+        See KnowledgeWorkers() */
+    struct KnowledgeRequest
+    {
+        /** The nodes from the root to the node of the request. */
+        std::vector<const SgUctNode*> m_nodes;
+
+        /** The moves from the root to the node of the request. */
+        std::vector<SgMove> m_sequence;
+
+        /** Count argument for SgUctThreadState::GenerateAllMoves(). */
+        SgUctValue m_count;
+
+        /** Value of m_knowledgeEpoch when the request was created. */
+        std::size_t m_epoch;
+
+        /** @name Result of SgUctThreadState::GenerateAllMoves() */
+        // @{
+
+        std::vector<SgUctMoveInfo> m_moves;
+
+        SgUctProvenType m_provenType;
+
+        bool m_truncate;
+
+        // @} // name
+    };
+
+    friend class KnowledgeWorker;
+
+    /** Thread that computes knowledge requests.
+        See KnowledgeWorkers() */
+    class KnowledgeWorker
+    {
+    public:
+        std::auto_ptr<SgUctThreadState> m_state;
+
+        KnowledgeWorker(SgUctSearch& search,
+                        std::auto_ptr<SgUctThreadState> state);
+
+        ~KnowledgeWorker();
+
+    private:
+        /** Copyable function object that invokes KnowledgeWorker::operator().
+            See Thread::Function */
+        class Function
+        {
+        public:
+            Function(KnowledgeWorker& worker);
+
+            void operator()();
+
+        private:
+            KnowledgeWorker& m_worker;
+        };
+
+        friend class KnowledgeWorker::Function;
+
+        SgUctSearch& m_search;
+
+        /** The thread.
+            Order dependency: must be constructed as the last member, because
+            the constructor starts the thread. */
+        boost::thread m_thread;
+
+        void operator()();
+
+        void Compute(KnowledgeRequest& request);
+    };
+
+    /** Maximum number of requests that a knowledge worker takes from the
+        queue at once. */
+    static const std::size_t KNOWLEDGE_BATCH_SIZE = 16;
+
     std::auto_ptr<SgUctThreadStateFactory> m_threadStateFactory;
 
     /** See LogGames() */
@@ -976,6 +1409,35 @@ private:
     
     unsigned int m_maxKnowledgeThreads;
 
+    /** See KnowledgeWorkers() */
+    unsigned int m_knowledgeWorkers;
+
+    /** Protects the knowledge request and result queues. */
+    boost::mutex m_knowledgeMutex;
+
+    /** Signals a new request or m_quitKnowledgeWorkers to the workers. */
+    boost::condition m_knowledgeRequestAdded;
+
+    /** Signals that m_nuBusyKnowledgeWorkers became zero. */
+    boost::condition m_knowledgeWorkersIdle;
+
+    std::deque<KnowledgeRequest> m_knowledgeRequests;
+
+    /** Computed requests that are not yet merged into the tree. */
+    std::vector<KnowledgeRequest> m_knowledgeResults;
+
+    /** Allows the search threads to check for results without locking. */
+    boost::atomic<bool> m_hasKnowledgeResults;
+
+    /** Incremented each time pending knowledge requests become invalid,
+        because the search ended or nodes were removed from the tree. */
+    boost::atomic<std::size_t> m_knowledgeEpoch;
+
+    /** Number of workers that currently compute a batch of requests. */
+    unsigned int m_nuBusyKnowledgeWorkers;
+
+    bool m_quitKnowledgeWorkers;
+
     /** Flag indicating that the search was terminated because the maximum
         time or number of games was reached. */
     volatile bool m_aborted;
@@ -1003,6 +1465,9 @@ private:
     /** See LockFree() */
     bool m_lockFree;
 
+    /** See AtomicTree() */
+    bool m_atomicTree;
+
     /** See WeightRaveUpdates() */
     bool m_weightRaveUpdates;
 
@@ -1015,6 +1480,12 @@ private:
     /** See NumberThreads() */
     unsigned int m_numberThreads;
 
+    /** See Numa() */
+    bool m_numa;
+
+    /** See NumaInterleaveNodes() */
+    std::size_t m_numaInterleaveNodes;
+
     /** See NumberPlayouts() */
     std::size_t m_numberPlayouts;
     
@@ -1027,6 +1498,74 @@ private:
     /** See PruneMinCount() */
     SgUctValue m_pruneMinCount;
 
+    /** See IncrementalPrune() */
+    bool m_incrementalPrune;
+
+    /** Current minimum count for IncrementalPrune().
+        Starts with PruneMinCount() and is doubled like in the full copy. */
+    SgUctValue m_incrementalPruneMinCount;
+
+    /** Protects the incremental pruning.
+        Only one thread prunes at a time, the other threads do not wait for
+        the lock. Also held by ApplyKnowledgeResults(), such that no nodes
+        are detached while results are merged. */
+    boost::mutex m_pruneMutex;
+
+    /** Incremented each time subtrees are detached by the incremental
+        pruning. */
+    boost::atomic<std::size_t> m_pruneEpoch;
+
+    /** Value of m_pruneEpoch at the start of the current game of each
+        thread. */
+    boost::scoped_array<boost::atomic<std::size_t> > m_threadPruneEpoch;
+
+    /** Subtrees detached by the incremental pruning that are not yet
+        reclaimed. */
+    std::vector<SgUctNodeBlock> m_detachedBlocks;
+
+    /** Value of m_pruneEpoch before m_detachedBlocks were detached. */
+    std::size_t m_detachedEpoch;
+
+    /** Data of the transposition table: the node with the children for a
+        position and its depth in the tree. */
+    class TranspositionData
+    {
+    public:
+        TranspositionData();
+
+        TranspositionData(const SgUctNode* node, std::size_t depth);
+
+        const SgUctNode* Node() const;
+
+        /** Number of nodes on the path from the root to the node. */
+        std::size_t Depth() const;
+
+        bool IsValid() const;
+
+        void Invalidate();
+
+        /** Prefer nodes with higher move count when replacing entries. */
+        bool IsBetterThan(const TranspositionData& data) const;
+
+    private:
+        const SgUctNode* m_node;
+
+        std::size_t m_depth;
+    };
+
+    typedef SgHashTable<TranspositionData,4> TranspositionTable;
+
+    /** See Transpositions() */
+    bool m_transpositions;
+
+    /** Protects m_transpositionTable. */
+    boost::mutex m_transpositionMutex;
+
+    /** Transposition table, created by StartSearch() if Transpositions()
+        is enabled. Contains pointers to nodes of the current tree and is
+        cleared whenever the tree is replaced. */
+    boost::scoped_ptr<TranspositionTable> m_transpositionTable;
+
     /** See parameter moveRange in constructor */
     const int m_moveRange;
 
@@ -1039,16 +1578,11 @@ private:
     /** Number of games limit for the current search. */
     SgUctValue m_maxGames;
 
-    /** Number of games played in the current search. */
-    SgUctValue m_numberGames;
-
     SgUctValue m_startRootMoveCount;
 
     /** See CheckTimeInterval() */
     SgUctValue m_checkTimeInterval;
 
-    volatile SgUctValue m_nextCheckTime;
-
     double m_lastScoreDisplayTime;
 
     /** See BiasTermConstant() */
@@ -1099,9 +1633,13 @@ private:
     /** Mutex for protecting global variables during multi-threading.
         Currently, only the play-out phase of games is thread safe, therefore
         this lock is always locked elsewhere (in-tree phase, updating of
-        values and statistics, etc.) */
+        values and statistics, etc.), unless LockFree() or AtomicTree() is
+        enabled. */
     boost::recursive_mutex m_globalMutex;
 
+    /** Statistics of the search that are not collected by the threads.
+        Also contains the statistics of the threads after EndSearch(), see
+        Statistics() */
     SgUctSearchStat m_statistics;
 
     /** List of threads.
@@ -1109,14 +1647,25 @@ private:
         auto_ptr should not be used with standard containers) */
     std::vector<boost::shared_ptr<Thread> > m_threads;
 
+    /** List of knowledge workers.
+        See KnowledgeWorkers() */
+    std::vector<boost::shared_ptr<KnowledgeWorker> > m_knowledgeWorkerThreads;
+
 #if SG_UCTFASTLOG
     SgFastLog m_fastLog;
 #endif
 
     boost::shared_ptr<SgMpiSynchronizer> m_mpiSynchronizer;
 
+    void AddKnowledgeRequest(const SgUctThreadState& state,
+                             const SgUctNode& node);
+
+    void ApplyKnowledgeResults(SgUctThreadState& state);
+
     void ApplyRootFilter(std::vector<SgUctMoveInfo>& moves);
 
+    void ClearKnowledgeRequests();
+
     void PropagateProvenStatus(const std::vector<const SgUctNode*>& nodes);
 
     bool CheckAbortSearch(SgUctThreadState& state);
@@ -1132,6 +1681,18 @@ private:
 
     void ExpandNode(SgUctThreadState& state, const SgUctNode& node);
 
+    bool HandleTreeFull(SgUctThreadState& state);
+
+    void InitTranspositionTable();
+
+    bool ShareTransposition(SgUctThreadState& state, const SgHashCode& hash,
+                            const SgUctNode& node);
+
+    void StoreTransposition(const SgHashCode& hash, const SgUctNode& node,
+                            std::size_t depth);
+
+    bool UseIncrementalPrune() const;
+
     void CreateChildren(SgUctThreadState& state, const SgUctNode& node,
                         bool deleteChildTrees);
 
@@ -1157,16 +1718,16 @@ private:
     
     void SearchLoop(SgUctThreadState& state, GlobalLock* lock);
 
-    const SgUctNode& SelectChild(int& randomizeCounter, bool useBiasTerm, const SgUctNode& node);
+    const SgUctNode* SelectChild(SgUctThreadState& state, bool useBiasTerm,
+                                 const SgUctNode& node);
 
     std::string SummaryLine(const SgUctGameInfo& info) const;
 
-    void UpdateCheckTimeInterval(double time);
+    void UpdateCheckTimeInterval(SgUctThreadStatistics& statistics,
+                                 double time);
 
     void UpdateDynRaveBias();
 
-    void UpdateRaveValues(SgUctThreadState& state);
-
     void UpdateRaveValues(SgUctThreadState& state, std::size_t playout);
 
     void UpdateRaveValues(SgUctThreadState& state, std::size_t playout,
@@ -1174,7 +1735,7 @@ private:
                           const std::size_t firstPlay[],
                           const std::size_t firstPlayOpp[]);
 
-    void UpdateStatistics(const SgUctGameInfo& info);
+    void UpdateStatistics(SgUctThreadState& state);
 
     void UpdateTree(const SgUctGameInfo& info);
 };
@@ -1184,6 +1745,11 @@ inline SgAdditiveKnowledge& SgUctSearch::AdditiveKnowledge()
     return m_additiveKnowledge;
 }
 
+inline bool SgUctSearch::AtomicTree() const
+{
+    return m_atomicTree;
+}
+
 inline const SgAdditiveKnowledge& SgUctSearch::AdditiveKnowledge() const
 {
     return m_additiveKnowledge;
@@ -1280,6 +1846,16 @@ inline unsigned int SgUctSearch::NumberThreads() const
     return m_numberThreads;
 }
 
+inline bool SgUctSearch::Numa() const
+{
+    return m_numa;
+}
+
+inline std::size_t SgUctSearch::NumaInterleaveNodes() const
+{
+    return m_numaInterleaveNodes;
+}
+
 inline SgUctValue SgUctSearch::CheckTimeInterval() const
 {
     return m_checkTimeInterval;
@@ -1310,6 +1886,11 @@ inline SgUctValue SgUctSearch::PruneMinCount() const
     return m_pruneMinCount;
 }
 
+inline bool SgUctSearch::IncrementalPrune() const
+{
+    return m_incrementalPrune;
+}
+
 inline bool SgUctSearch::Rave() const
 {
     return m_rave;
@@ -1330,6 +1911,11 @@ inline float SgUctSearch::RaveWeightFinal() const
     return m_raveWeightFinal;
 }
 
+inline void SgUctSearch::SetAtomicTree(bool enable)
+{
+    m_atomicTree = enable;
+}
+
 inline void SgUctSearch::SetBiasTermConstant(float biasTermConstant)
 {
     m_biasTermConstant = biasTermConstant;
@@ -1400,6 +1986,11 @@ SgUctSearch::SetMaxKnowledgeThreads(unsigned int threads)
     m_maxKnowledgeThreads = threads;
 }
 
+inline unsigned int SgUctSearch::KnowledgeWorkers() const
+{
+    return m_knowledgeWorkers;
+}
+
 inline void SgUctSearch::SetNumberPlayouts(std::size_t n)
 {
     SG_ASSERT(n >= 1);
@@ -1421,6 +2012,21 @@ inline void SgUctSearch::SetPruneMinCount(SgUctValue n)
     m_pruneMinCount = n;
 }
 
+inline void SgUctSearch::SetTranspositions(bool enable)
+{
+    m_transpositions = enable;
+}
+
+inline bool SgUctSearch::Transpositions() const
+{
+    return m_transpositions;
+}
+
+inline void SgUctSearch::SetIncrementalPrune(bool enable)
+{
+    m_incrementalPrune = enable;
+}
+
 inline void SgUctSearch::SetMpiSynchronizer(const SgMpiSynchronizerHandle 
                                             &synchronizerHandle)
 {
@@ -1477,11 +2083,6 @@ inline void SgUctSearch::SetVirtualLoss(bool enable)
     m_virtualLoss = enable;
 }
 
-inline const SgUctSearchStat& SgUctSearch::Statistics() const
-{
-    return m_statistics;
-}
-
 inline bool SgUctSearch::ThreadsCreated() const
 {
     return (m_threads.size() > 0);
@@ -6,15 +6,157 @@
 #include "SgSystem.h"
 #include "SgUctTree.h"
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <boost/bind.hpp>
 #include <boost/format.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/scoped_ptr.hpp>
 #include "SgDebug.h"
+#include "SgException.h"
+#include "SgNuma.h"
+#include "SgPoint.h"
 #include "SgTimer.h"
 
 using boost::format;
+using boost::interprocess::file_mapping;
+using boost::interprocess::interprocess_exception;
+using boost::interprocess::mapped_region;
+using boost::interprocess::read_only;
+using boost::scoped_ptr;
 using boost::shared_ptr;
 
 //----------------------------------------------------------------------------
 
+namespace {
+
+const char TREE_FILE_MAGIC[8] = { 'F', 'U', 'E', 'G', 'O', 'U', 'T', '\n' };
+
+const uint32_t TREE_FILE_BYTE_ORDER_MARK = 0x01020304;
+
+const uint32_t TREE_FILE_VERSION = 1;
+
+/** Maximum depth of a tree in a file.
+    Larger than the depth of any tree created by a search, limits the
+    recursion depth of SgUctTree::LoadSubtree() for corrupt files. */
+const int TREE_FILE_MAX_DEPTH = 10000;
+
+/** Check that a move in a file is SG_NULLMOVE, SG_PASS or a point on the
+    board. */
+bool IsValidFileMove(int move)
+{
+    if (move == SG_NULLMOVE || move == SG_PASS)
+        return true;
+    if (! SgPointUtil::InBoardRange(move))
+        return false;
+    const int col = move % SG_NS;
+    return col >= 1 && col <= SG_MAX_SIZE;
+}
+
+/** Check that a value in a file is in [0..1]. Also fails for NaN. */
+bool IsValidFileValue(double value)
+{
+    return value >= 0 && value <= 1;
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
+
+struct SgUctTree::FileHeader
+{
+    char m_magic[8];
+
+    /** TREE_FILE_BYTE_ORDER_MARK as written by the machine that created the
+        file. */
+    uint32_t m_byteOrder;
+
+    uint32_t m_version;
+
+    /** SG_MAX_SIZE of the program that wrote the file.
+        The moves depend on it. */
+    uint32_t m_maxSize;
+
+    uint32_t m_reserved;
+
+    /** See SgUctTree::Save() */
+    uint64_t m_key;
+
+    /** Number of nodes including the root node. */
+    uint64_t m_nuNodes;
+};
+
+/** Values are stored as double, independent of SgUctValue. */
+struct SgUctTree::FileNode
+{
+    double m_count;
+
+    /** Value of the node, 0 if the count is 0. */
+    double m_mean;
+
+    double m_raveCount;
+
+    /** RAVE value of the node, 0 if the RAVE count is 0. */
+    double m_raveValue;
+
+    double m_posCount;
+
+    double m_knowledgeCount;
+
+    float m_predictorValue;
+
+    int32_t m_move;
+
+    int32_t m_nuChildren;
+
+    int32_t m_provenType;
+
+    /** Initialize the node from the record.
+        Sets the number of children, but not the first child.
+        @throws SgException if the record is invalid */
+    void Get(SgUctNode& node) const;
+
+    void Set(const SgUctNode& node);
+};
+
+void SgUctTree::FileNode::Get(SgUctNode& node) const
+{
+    // Negated comparisons, such that NaN values are rejected
+    if (m_nuChildren < 0 || m_nuChildren > SG_MAX_MOVES
+        || m_provenType < SG_NOT_PROVEN || m_provenType > SG_PROVEN_LOSS
+        || ! (m_count >= 0) || ! (m_raveCount >= 0) || ! (m_posCount >= 0)
+        || ! (m_knowledgeCount >= 0)
+        || ! IsValidFileValue(m_mean) || ! IsValidFileValue(m_raveValue)
+        || ! IsValidFileMove(m_move))
+        throw SgException("invalid node");
+    SgUctMoveInfo info(m_move, SgUctValue(m_mean), SgUctValue(m_count),
+                       SgUctValue(m_raveValue), SgUctValue(m_raveCount));
+    info.m_predictorValue = m_predictorValue;
+    node = SgUctNode(info);
+    node.SetPosCount(SgUctValue(m_posCount));
+    node.SetKnowledgeCount(SgUctValue(m_knowledgeCount));
+    node.SetProvenType(static_cast<SgUctProvenType>(m_provenType));
+    node.SetNuChildren(m_nuChildren);
+}
+
+void SgUctTree::FileNode::Set(const SgUctNode& node)
+{
+    m_count = double(node.MoveCount());
+    m_mean = (node.HasMean() ? double(node.Mean()) : 0);
+    m_raveCount = double(node.RaveCount());
+    m_raveValue = (node.HasRaveValue() ? double(node.RaveValue()) : 0);
+    m_posCount = double(node.PosCount());
+    m_knowledgeCount = double(node.KnowledgeCount());
+    m_predictorValue = node.PredictorValue();
+    m_move = node.HasMove() ? node.Move() : SG_NULLMOVE;
+    m_nuChildren = node.NuChildren();
+    m_provenType = node.ProvenType();
+}
+
+//----------------------------------------------------------------------------
+
 SgUctAllocator::~SgUctAllocator()
 {
     if (m_start != 0)
@@ -29,11 +171,59 @@ bool SgUctAllocator::Contains(const SgUctNode& node) const
     return (&node >= m_start && &node < m_finish);
 }
 
+void SgUctAllocator::AddFreeBlock(const SgUctNodeBlock& block)
+{
+    SG_ASSERT(block.m_size > 0);
+    std::size_t size = block.m_size;
+    boost::mutex::scoped_lock lock(m_freeBlocksMutex);
+    if (m_freeBlocks.size() <= size)
+        m_freeBlocks.resize(size + 1);
+    m_freeBlocks[size].push_back(const_cast<SgUctNode*>(block.m_first));
+    m_nuFreeNodes += size;
+}
+
+bool SgUctAllocator::HasFreeBlock(std::size_t n) const
+{
+    boost::mutex::scoped_lock lock(m_freeBlocksMutex);
+    if (m_nuFreeNodes < n)
+        return false;
+    for (std::size_t size = n; size < m_freeBlocks.size(); ++size)
+        if (! m_freeBlocks[size].empty())
+            return true;
+    return false;
+}
+
 void SgUctAllocator::Swap(SgUctAllocator& allocator)
 {
     std::swap(m_start, allocator.m_start);
     std::swap(m_finish, allocator.m_finish);
     std::swap(m_endOfStorage, allocator.m_endOfStorage);
+    boost::mutex::scoped_lock lock(m_freeBlocksMutex);
+    boost::mutex::scoped_lock lockOther(allocator.m_freeBlocksMutex);
+    m_freeBlocks.swap(allocator.m_freeBlocks);
+    std::swap(m_nuFreeNodes, allocator.m_nuFreeNodes);
+}
+
+/** Take the smallest free block with at least n nodes.
+    If the block is larger than n, the remaining nodes are kept as a smaller
+    free block.
+    @return The first node of the block or 0, if there is no such block. */
+SgUctNode* SgUctAllocator::TakeFreeBlock(std::size_t n)
+{
+    boost::mutex::scoped_lock lock(m_freeBlocksMutex);
+    for (std::size_t size = n; size < m_freeBlocks.size(); ++size)
+    {
+        std::vector<SgUctNode*>& blocks = m_freeBlocks[size];
+        if (blocks.empty())
+            continue;
+        SgUctNode* first = blocks.back();
+        blocks.pop_back();
+        if (size > n)
+            m_freeBlocks[size - n].push_back(first + n);
+        m_nuFreeNodes -= n;
+        return first;
+    }
+    return 0;
 }
 
 void SgUctAllocator::SetMaxNodes(std::size_t maxNodes)
@@ -51,6 +241,18 @@ void SgUctAllocator::SetMaxNodes(std::size_t maxNodes)
     m_endOfStorage = m_start + maxNodes;
 }
 
+void SgUctAllocator::PlaceOnNumaNode(int numaNode,
+                                     std::size_t interleaveNodes)
+{
+    SG_ASSERT(m_finish == m_start);
+    std::size_t maxNodes = m_endOfStorage - m_start;
+    interleaveNodes = std::min(interleaveNodes, maxNodes);
+    SgNuma::Interleave(m_start, interleaveNodes * sizeof(SgUctNode));
+    SgNuma::PlaceOnNode(m_start + interleaveNodes,
+                        (maxNodes - interleaveNodes) * sizeof(SgUctNode),
+                        numaNode);
+}
+
 //----------------------------------------------------------------------------
 
 std::ostream& operator<<(std::ostream& stream, const SgUctMoveInfo& info)
@@ -112,6 +314,8 @@ std::ostream& operator<<(std::ostream& stream, const SgUctProvenType& type)
 
 SgUctTree::SgUctTree()
     : m_maxNodes(0),
+      m_numaPlacement(false),
+      m_numaInterleaveNodes(0),
       m_root(SG_NULLMOVE)
 { }
 
@@ -147,9 +351,7 @@ void SgUctTree::ApplyFilter(std::size_t allocatorId,
     SgUctNode& nonConstNode = const_cast<SgUctNode&>(node);
     // Write order dependency: SgUctSearch in lock-free mode assumes that
     // m_firstChild is valid if m_nuChildren is greater zero
-    SgSynchronizeThreadMemory();
     nonConstNode.SetFirstChild(firstChild);
-    SgSynchronizeThreadMemory();
     nonConstNode.SetNuChildren(nuChildren);
 }
 
@@ -194,9 +396,7 @@ void SgUctTree::SetChildren(std::size_t allocatorId, const SgUctNode& node,
     SgUctNode& nonConstNode = const_cast<SgUctNode&>(node);
     // Write order dependency: SgUctSearch in lock-free mode assumes that
     // m_firstChild is valid if m_nuChildren is greater zero
-    SgSynchronizeThreadMemory();
     nonConstNode.SetFirstChild(firstChild);
-    SgSynchronizeThreadMemory();
     nonConstNode.SetNuChildren(nuChildren);
 }
 
@@ -226,9 +426,44 @@ bool SgUctTree::Contains(const SgUctNode& node) const
     return false;
 }
 
+/** A subtree to be copied by CopySubtreeParallel(). */
+struct SgUctTree::CopyTask
+{
+    /** The target node; already created but the content not yet copied. */
+    SgUctNode* m_targetNode;
+
+    /** The node in the source tree. */
+    const SgUctNode* m_node;
+
+    CopyTask(SgUctNode* targetNode, const SgUctNode* node);
+
+    /** Order by decreasing count of the source node. */
+    bool operator<(const CopyTask& task) const;
+};
+
+SgUctTree::CopyTask::CopyTask(SgUctNode* targetNode, const SgUctNode* node)
+    : m_targetNode(targetNode),
+      m_node(node)
+{ }
+
+bool SgUctTree::CopyTask::operator<(const CopyTask& task) const
+{
+    return m_node->MoveCount() > task.m_node->MoveCount();
+}
+
+//----------------------------------------------------------------------------
+
 void SgUctTree::CopyPruneLowCount(SgUctTree& target, SgUctValue minCount,
                                   bool warnTruncate, double maxTime) const
 {
+    if (target.NuAllocators() > 1)
+    {
+        target.Clear();
+        CopySubtreeParallel(target, m_root, minCount, warnTruncate, maxTime,
+                            /* alwaysKeepProven */ false);
+        SgSynchronizeThreadMemory();
+        return;
+    }
     size_t allocatorId = 0;
     SgTimer timer;
     bool abort = false;
@@ -254,12 +489,15 @@ void SgUctTree::CopyPruneLowCount(SgUctTree& target, SgUctValue minCount,
     by top-level caller
     @param timer
     @param maxTime See ExtractSubtree() 
-    @param alwaysKeepProven Copy proven nodes even if below minCount */
+    @param alwaysKeepProven Copy proven nodes even if below minCount
+    @param cycleAllocators If false, all nodes are created in the allocator
+    currentAllocatorId (used by CopySubtreeWorker()) */
 SgUctProvenType SgUctTree::CopySubtree(SgUctTree& target, SgUctNode& targetNode,
                                        const SgUctNode& node, SgUctValue minCount,
                                        std::size_t& currentAllocatorId,
                                        bool warnTruncate, bool& abort, SgTimer& timer,
-                                       double maxTime, bool alwaysKeepProven) const
+                                       double maxTime, bool alwaysKeepProven,
+                                       bool cycleAllocators) const
 
 {
     SG_ASSERT(Contains(node));
@@ -326,13 +564,17 @@ SgUctProvenType SgUctTree::CopySubtree(SgUctTree& target, SgUctNode& targetNode,
     for (SgUctChildIterator it(*this, node); it; ++it, ++targetChild)
     {
         const SgUctNode& child = *it;
-        ++currentAllocatorId; // Cycle to use allocators uniformly
-        if (currentAllocatorId >= target.NuAllocators())
-            currentAllocatorId = 0;
+        if (cycleAllocators)
+        {
+            ++currentAllocatorId; // Cycle to use allocators uniformly
+            if (currentAllocatorId >= target.NuAllocators())
+                currentAllocatorId = 0;
+        }
         childProvenType = CopySubtree(target, *targetChild, child, 
                                       minCount, currentAllocatorId,
                                       warnTruncate, abort, timer,
-                                      maxTime, alwaysKeepProven);
+                                      maxTime, alwaysKeepProven,
+                                      cycleAllocators);
         if (childProvenType == SG_PROVEN_LOSS)
             parentProvenType = SG_PROVEN_WIN;
         else if (  parentProvenType != SG_PROVEN_WIN
@@ -343,6 +585,119 @@ SgUctProvenType SgUctTree::CopySubtree(SgUctTree& target, SgUctNode& targetNode,
     return parentProvenType;
 }
 
+/** Copy a subtree with one thread per allocator of the target tree.
+    The upper part of the subtree is copied first by the calling thread,
+    until no remaining subtree has more than a small fraction of the count
+    of the subtree root. The remaining subtrees are copied in parallel with
+    CopySubtreeWorker() in order of decreasing count; each thread creates
+    nodes only in its own allocator of the target tree. The proven types of
+    the nodes in the upper part are updated after the threads finished.
+    Parameters like in CopySubtree().
+    REQUIRES: target is empty */
+void SgUctTree::CopySubtreeParallel(SgUctTree& target, const SgUctNode& node,
+                                    SgUctValue minCount, bool warnTruncate,
+                                    double maxTime,
+                                    bool alwaysKeepProven) const
+{
+    SgTimer timer;
+    const size_t nuThreads = target.NuAllocators();
+    const SgUctValue splitCount =
+        node.MoveCount() / SgUctValue(4 * nuThreads);
+    std::vector<CopyTask> open;
+    std::vector<CopyTask> tasks;
+    std::vector<CopyTask> split;
+    open.push_back(CopyTask(&target.m_root, &node));
+    size_t allocatorId = 0;
+    while (! open.empty())
+    {
+        CopyTask task = open.back();
+        open.pop_back();
+        const SgUctNode& source = *task.m_node;
+        int nuChildren = source.NuChildren();
+        SgUctAllocator& allocator = target.Allocator(allocatorId);
+        if (  nuChildren == 0
+           || source.MoveCount() < minCount
+           || source.MoveCount() <= splitCount
+           || ! allocator.HasCapacity(nuChildren)
+           )
+        {
+            tasks.push_back(task);
+            continue;
+        }
+        SgUctNode& targetNode = *task.m_targetNode;
+        targetNode.CopyDataFrom(source);
+        SgUctNode* firstTargetChild = allocator.Finish();
+        targetNode.SetFirstChild(firstTargetChild);
+        targetNode.SetNuChildren(nuChildren);
+        allocator.CreateN(nuChildren);
+        const SgUctNode* firstChild = source.FirstChild();
+        for (int i = 0; i < nuChildren; ++i)
+            open.push_back(CopyTask(firstTargetChild + i, firstChild + i));
+        split.push_back(task);
+        allocatorId = (allocatorId + 1) % nuThreads;
+    }
+    std::sort(tasks.begin(), tasks.end());
+    boost::atomic<size_t> nextTask(0);
+    double remainingTime = maxTime - timer.GetTime();
+    boost::thread_group threads;
+    for (size_t i = 0; i < nuThreads; ++i)
+        threads.create_thread(boost::bind(&SgUctTree::CopySubtreeWorker,
+                                          this, boost::ref(target),
+                                          boost::ref(tasks),
+                                          boost::ref(nextTask), i, minCount,
+                                          warnTruncate, remainingTime,
+                                          alwaysKeepProven));
+    threads.join_all();
+    // Children were split after their parents
+    for (std::vector<CopyTask>::reverse_iterator it = split.rbegin();
+         it != split.rend(); ++it)
+    {
+        SgUctNode& targetNode = *it->m_targetNode;
+        SgUctProvenType provenType = SG_PROVEN_LOSS;
+        for (SgUctChildIterator childIt(target, targetNode); childIt;
+             ++childIt)
+        {
+            SgUctProvenType childProvenType = (*childIt).ProvenType();
+            if (childProvenType == SG_PROVEN_LOSS)
+                provenType = SG_PROVEN_WIN;
+            else if (  provenType != SG_PROVEN_WIN
+                    && childProvenType == SG_NOT_PROVEN)
+                provenType = SG_NOT_PROVEN;
+        }
+        targetNode.SetProvenType(provenType);
+    }
+}
+
+/** Thread function used by CopySubtreeParallel().
+    Copies tasks until all tasks are taken by the threads.
+    @param target The target tree
+    @param tasks The subtrees to copy
+    @param nextTask Index of the next task not yet taken by a thread
+    @param allocatorId The allocator of the target tree used by this thread
+    @param minCount See CopySubtree()
+    @param warnTruncate See CopySubtree()
+    @param maxTime See CopySubtree()
+    @param alwaysKeepProven See CopySubtree() */
+void SgUctTree::CopySubtreeWorker(SgUctTree& target,
+                                  std::vector<CopyTask>& tasks,
+                                  boost::atomic<std::size_t>& nextTask,
+                                  std::size_t allocatorId,
+                                  SgUctValue minCount, bool warnTruncate,
+                                  double maxTime, bool alwaysKeepProven) const
+{
+    SgTimer timer;
+    bool abort = false;
+    while (true)
+    {
+        size_t i = nextTask.fetch_add(1);
+        if (i >= tasks.size())
+            break;
+        CopySubtree(target, *tasks[i].m_targetNode, *tasks[i].m_node,
+                    minCount, allocatorId, warnTruncate, abort, timer,
+                    maxTime, alwaysKeepProven, /* cycleAllocators */ false);
+    }
+}
+
 void SgUctTree::CreateAllocators(std::size_t nuThreads)
 {
     Clear();
@@ -354,6 +709,67 @@ void SgUctTree::CreateAllocators(std::size_t nuThreads)
     }
 }
 
+std::size_t SgUctTree::DetachLowCount(SgUctValue minCount,
+                                      bool lockExpansion,
+                                      std::vector<SgUctNodeBlock>& detached)
+{
+    size_t nuDetached = 0;
+    DetachLowCount(m_root, minCount, lockExpansion, detached, nuDetached);
+    SgSynchronizeThreadMemory();
+    return nuDetached;
+}
+
+/** Recursive function used by SgUctTree::DetachLowCount.
+    The root node is never detached, the children of node are detached if
+    their count is below minCount.
+    Other threads can replace the children of a node with
+    MergeChildren() in the meantime. The new children take over the
+    children of the old children, so the children of an old child must not
+    be detached after they were copied. MergeChildren() holds the
+    expansion locks of the old children until the new children are visible,
+    and a child is only detached if it is still a child of node after its
+    lock was acquired. */
+void SgUctTree::DetachLowCount(const SgUctNode& node, SgUctValue minCount,
+                               bool lockExpansion,
+                               std::vector<SgUctNodeBlock>& detached,
+                               std::size_t& nuDetached)
+{
+    const SgUctNode* firstChild;
+    const int nuChildren = node.GetChildren(firstChild);
+    for (int i = 0; i < nuChildren; ++i)
+    {
+        const SgUctNode& child = firstChild[i];
+        if (! child.HasChildren())
+            continue;
+        if (child.MoveCount() >= minCount)
+        {
+            DetachLowCount(child, minCount, lockExpansion, detached,
+                           nuDetached);
+            continue;
+        }
+        SgUctNode& nonConstChild = const_cast<SgUctNode&>(child);
+        if (lockExpansion && ! nonConstChild.TryLockExpansion())
+            continue;
+        const SgUctNode* currentFirstChild;
+        node.GetChildren(currentFirstChild);
+        const SgUctNode* grandChild;
+        const int nuGrandChildren = child.GetChildren(grandChild);
+        if (currentFirstChild == firstChild && nuGrandChildren > 0)
+        {
+            detached.push_back(SgUctNodeBlock(grandChild, nuGrandChildren));
+            nuDetached += nuGrandChildren;
+            for (int j = 0; j < nuGrandChildren; ++j)
+                nuDetached += NuSubtreeNodes(grandChild[j]);
+            // Like in CopySubtree, the proven type of a pruned node is not
+            // kept, because it is no longer supported by its children
+            nonConstChild.SetNuChildren(0);
+            nonConstChild.SetProvenType(SG_NOT_PROVEN);
+        }
+        if (lockExpansion)
+            nonConstChild.UnlockExpansion();
+    }
+}
+
 void SgUctTree::DumpDebugInfo(std::ostream& out) const
 {
     out << "Root " << &m_root << '\n';
@@ -372,6 +788,13 @@ void SgUctTree::ExtractSubtree(SgUctTree& target, const SgUctNode& node,
     SG_ASSERT(&target != this);
     SG_ASSERT(target.MaxNodes() == MaxNodes());
     target.Clear();
+    if (target.NuAllocators() > 1)
+    {
+        CopySubtreeParallel(target, node, minCount, warnTruncate, maxTime,
+                            /* alwaysKeepProven */ true);
+        SgSynchronizeThreadMemory();
+        return;
+    }
     size_t allocatorId = 0;
     SgTimer timer;
     bool abort = false;
@@ -380,6 +803,100 @@ void SgUctTree::ExtractSubtree(SgUctTree& target, const SgUctNode& node,
     SgSynchronizeThreadMemory();
 }
 
+bool SgUctTree::Load(const std::string& fileName, uint64_t key)
+{
+    SG_ASSERT(NuAllocators() > 0);
+    scoped_ptr<mapped_region> region;
+    try
+    {
+        file_mapping file(fileName.c_str(), read_only);
+        region.reset(new mapped_region(file, read_only));
+    }
+    catch (const interprocess_exception& e)
+    {
+        throw SgException("cannot map " + fileName + ": " + e.what());
+    }
+    const char* data = static_cast<const char*>(region->get_address());
+    const size_t size = region->get_size();
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(data);
+    if (size < sizeof(FileHeader)
+        || std::memcmp(header->m_magic, TREE_FILE_MAGIC,
+                       sizeof(TREE_FILE_MAGIC)) != 0)
+        throw SgException(fileName + " is not a UCT tree file");
+    if (header->m_byteOrder != TREE_FILE_BYTE_ORDER_MARK
+        || header->m_version != TREE_FILE_VERSION
+        || header->m_maxSize != SG_MAX_SIZE
+        || header->m_nuNodes == 0
+        || header->m_nuNodes > (size - sizeof(FileHeader)) / sizeof(FileNode)
+        || size != sizeof(FileHeader) + header->m_nuNodes * sizeof(FileNode))
+        throw SgException(fileName + ": unsupported or corrupt UCT tree file");
+    if (header->m_key != key)
+        return false;
+    Clear();
+    const FileNode* next =
+        reinterpret_cast<const FileNode*>(data + sizeof(FileHeader));
+    const FileNode* end = next + header->m_nuNodes;
+    size_t allocatorId = 0;
+    try
+    {
+        (next++)->Get(m_root);
+        if (m_root.HasMove())
+            throw SgException("root node has a move");
+        LoadSubtree(m_root, next, end, allocatorId, 0);
+        if (next != end)
+            throw SgException("nodes after end of tree");
+    }
+    catch (const SgException& e)
+    {
+        Clear();
+        throw SgException(fileName + ": " + e.what());
+    }
+    SgSynchronizeThreadMemory();
+    return true;
+}
+
+/** Recursive function used by Load().
+    @param node The node, already initialized from its record, including the
+    number of children
+    @param[in,out] next The record of the first child of the node
+    @param end The end of the records
+    @param currentAllocatorId The allocator to try first for the children.
+    Cycles through the allocators like in CopySubtree().
+    @param depth The depth of the node */
+void SgUctTree::LoadSubtree(SgUctNode& node, const FileNode*& next,
+                            const FileNode* end,
+                            std::size_t& currentAllocatorId, int depth)
+{
+    const int nuChildren = node.NuChildren();
+    if (nuChildren == 0)
+        return;
+    if (end - next < nuChildren)
+        throw SgException("unexpected end of tree");
+    if (depth >= TREE_FILE_MAX_DEPTH)
+        throw SgException("tree too deep");
+    size_t allocatorId = currentAllocatorId;
+    while (! Allocator(allocatorId).HasCapacity(nuChildren))
+    {
+        allocatorId = (allocatorId + 1) % NuAllocators();
+        if (allocatorId == currentAllocatorId)
+            throw SgException("tree does not fit into maximum number of "
+                              "nodes");
+    }
+    currentAllocatorId = (allocatorId + 1) % NuAllocators();
+    SgUctAllocator& allocator = Allocator(allocatorId);
+    SgUctNode* firstChild = allocator.Finish();
+    allocator.CreateN(nuChildren);
+    for (int i = 0; i < nuChildren; ++i)
+    {
+        (next++)->Get(firstChild[i]);
+        if (! firstChild[i].HasMove())
+            throw SgException("child node has no move");
+    }
+    node.SetFirstChild(firstChild);
+    for (int i = 0; i < nuChildren; ++i)
+        LoadSubtree(firstChild[i], next, end, currentAllocatorId, depth + 1);
+}
+
 void SgUctTree::MergeChildren(std::size_t allocatorId, const SgUctNode& node,
                               const std::vector<SgUctMoveInfo>& moves,
                               bool deleteChildTrees)
@@ -395,7 +912,6 @@ void SgUctTree::MergeChildren(std::size_t allocatorId, const SgUctNode& node,
     {
         // Write order dependency
         nonConstNode.SetNuChildren(0);
-        SgSynchronizeThreadMemory();
         nonConstNode.SetFirstChild(0);
         return;
     }
@@ -403,16 +919,26 @@ void SgUctTree::MergeChildren(std::size_t allocatorId, const SgUctNode& node,
     SgUctAllocator& allocator = Allocator(allocatorId);
     SG_ASSERT(allocator.HasCapacity(nuNewChildren));
 
-    const SgUctNode* newFirstChild = allocator.Finish();
-    SgUctValue parentCount = allocator.Create(moves);
+    SgUctValue parentCount;
+    const SgUctNode* newFirstChild = allocator.Create(moves, parentCount);
+
+    const SgUctNode* oldFirstChild;
+    const int nuOldChildren = node.GetChildren(oldFirstChild);
+    // The new children take over the children of the old children. Lock the
+    // old children until the new children are visible, such that
+    // DetachLowCount() in another thread cannot detach the children of an
+    // old child after they were copied (see DetachLowCount()).
+    if (! deleteChildTrees)
+        for (int j = 0; j < nuOldChildren; ++j)
+            const_cast<SgUctNode&>(oldFirstChild[j]).LockExpansion();
     
     // Update new children with data in old children
     for (std::size_t i = 0; i < moves.size(); ++i) 
     {
         SgUctNode* newChild = const_cast<SgUctNode*>(&newFirstChild[i]);
-        for (SgUctChildIterator it(*this, node); it; ++it)
+        for (int j = 0; j < nuOldChildren; ++j)
         {
-            const SgUctNode& oldChild = *it;
+            const SgUctNode& oldChild = oldFirstChild[j];
             if (oldChild.Move() == moves[i].m_move)
             {
                 newChild->MergeResults(oldChild);
@@ -421,10 +947,12 @@ void SgUctTree::MergeChildren(std::size_t allocatorId, const SgUctNode& node,
                 {
                     newChild->SetPosCount(oldChild.PosCount());
                     parentCount += oldChild.MoveCount();
-                    if (oldChild.HasChildren())
+                    const SgUctNode* firstChild;
+                    int nuChildren = oldChild.GetChildren(firstChild);
+                    if (nuChildren > 0)
                     {
-                        newChild->SetFirstChild(oldChild.FirstChild());
-                        newChild->SetNuChildren(oldChild.NuChildren());
+                        newChild->SetFirstChild(firstChild);
+                        newChild->SetNuChildren(nuChildren);
                     }
                 }
                 break;
@@ -436,30 +964,105 @@ void SgUctTree::MergeChildren(std::size_t allocatorId, const SgUctNode& node,
     // Write order dependency: We do not want an SgUctChildIterator to
     // run past the end of a node's children, which can happen if one
     // is created between the two statements below. We modify node in
-    // such a way so as to avoid that.
-    SgSynchronizeThreadMemory();
+    // such a way so as to avoid that (see also the read order in the
+    // constructor of SgUctChildIterator).
     if (nonConstNode.NuChildren() < nuNewChildren)
     {
         nonConstNode.SetFirstChild(newFirstChild);
-        SgSynchronizeThreadMemory();
         nonConstNode.SetNuChildren(nuNewChildren);
     }
     else
     {
         nonConstNode.SetNuChildren(nuNewChildren);
-        SgSynchronizeThreadMemory();
         nonConstNode.SetFirstChild(newFirstChild);
     }
+    if (! deleteChildTrees)
+        for (int j = 0; j < nuOldChildren; ++j)
+            const_cast<SgUctNode&>(oldFirstChild[j]).UnlockExpansion();
 }
 
 std::size_t SgUctTree::NuNodes() const
 {
     size_t nuNodes = 1; // Count root node
     for (size_t i = 0; i < NuAllocators(); ++i)
-        nuNodes += Allocator(i).NuNodes();
+        nuNodes += Allocator(i).NuNodes() - Allocator(i).NuFreeNodes();
     return nuNodes;
 }
 
+/** Number of nodes below a node. */
+std::size_t SgUctTree::NuSubtreeNodes(const SgUctNode& node) const
+{
+    size_t nuNodes = 0;
+    for (SgUctChildIterator it(*this, node); it; ++it)
+        nuNodes += 1 + NuSubtreeNodes(*it);
+    return nuNodes;
+}
+
+std::size_t SgUctTree::ReclaimSubtrees(
+                                const std::vector<SgUctNodeBlock>& detached)
+{
+    SG_ASSERT(NuAllocators() > 0);
+    size_t nuReclaimed = 0;
+    size_t allocatorId = 0;
+    std::vector<SgUctNodeBlock> blocks(detached);
+    while (! blocks.empty())
+    {
+        SgUctNodeBlock block = blocks.back();
+        blocks.pop_back();
+        for (int i = 0; i < block.m_size; ++i)
+        {
+            const SgUctNode& node = block.m_first[i];
+            if (node.HasChildren())
+                blocks.push_back(SgUctNodeBlock(node.FirstChild(),
+                                                node.NuChildren()));
+        }
+        Allocator(allocatorId).AddFreeBlock(block);
+        allocatorId = (allocatorId + 1) % NuAllocators();
+        nuReclaimed += block.m_size;
+    }
+    return nuReclaimed;
+}
+
+void SgUctTree::Save(const std::string& fileName, uint64_t key) const
+{
+    std::ofstream out(fileName.c_str(), std::ios::binary);
+    if (! out)
+        throw SgException("cannot open " + fileName);
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.m_magic, TREE_FILE_MAGIC, sizeof(TREE_FILE_MAGIC));
+    header.m_byteOrder = TREE_FILE_BYTE_ORDER_MARK;
+    header.m_version = TREE_FILE_VERSION;
+    header.m_maxSize = SG_MAX_SIZE;
+    header.m_key = key;
+    header.m_nuNodes = 1 + NuSubtreeNodes(m_root);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    FileNode record;
+    record.Set(m_root);
+    out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    SaveSubtree(out, m_root);
+    out.close();
+    if (! out)
+        throw SgException("error writing " + fileName);
+}
+
+/** Recursive function used by Save().
+    Writes the records of the children of a node, then the subtrees of the
+    children. */
+void SgUctTree::SaveSubtree(std::ostream& out, const SgUctNode& node) const
+{
+    if (! node.HasChildren())
+        return;
+    FileNode record;
+    for (SgUctChildIterator it(*this, node); it; ++it)
+    {
+        record.Set(*it);
+        out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    for (SgUctChildIterator it(*this, node); it; ++it)
+        SaveSubtree(out, *it);
+}
+
 void SgUctTree::SetMaxNodes(std::size_t maxNodes)
 {
     Clear();
@@ -473,7 +1076,18 @@ void SgUctTree::SetMaxNodes(std::size_t maxNodes)
     m_maxNodes = maxNodes;
     size_t maxNodesPerAlloc = maxNodes / nuAllocators;
     for (size_t i = 0; i < NuAllocators(); ++i)
+    {
         Allocator(i).SetMaxNodes(maxNodesPerAlloc);
+        if (m_numaPlacement)
+            Allocator(i).PlaceOnNumaNode(SgNuma::ThreadNode(i),
+                                         m_numaInterleaveNodes);
+    }
+}
+
+void SgUctTree::SetNumaPlacement(bool enable, std::size_t interleaveNodes)
+{
+    m_numaPlacement = enable;
+    m_numaInterleaveNodes = interleaveNodes;
 }
 
 void SgUctTree::Swap(SgUctTree& tree)
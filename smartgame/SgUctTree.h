@@ -9,7 +9,12 @@
 #include <iostream>
 #include <limits>
 #include <stack>
+#include <stdint.h>
+#include <string>
+#include <boost/atomic.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #include "SgMove.h"
 #include "SgStatistics.h"
 #include "SgStatisticsVlt.h"
@@ -113,12 +118,19 @@ std::ostream& operator<<(std::ostream& stream, const SgUctProvenType& type);
 //----------------------------------------------------------------------------
 
 /** Node used in SgUctTree.
-    All data members are declared as volatile to avoid that the compiler
-    re-orders writes, which can break assumptions made by SgUctSearch in
-    lock-free mode (see @ref sguctsearchlockfree). For example, the search
-    relies on the fact that m_firstChild is valid, if m_nuChildren is greater
-    zero or that the mean value of the move and RAVE value statistics is valid
-    if the corresponding count is greater zero.
+    The data members that are accessed concurrently are atomic variables
+    to avoid that the compiler or the CPU re-orders writes, which can break
+    assumptions made by SgUctSearch in lock-free mode (see
+    @ref sguctsearchlockfree). For example, the search relies on the fact
+    that m_firstChild is valid, if m_nuChildren is greater zero or that the
+    mean value of the move and RAVE value statistics is valid if the
+    corresponding count is greater zero. These dependencies are expressed
+    with release/acquire memory ordering, which is free on IA-32/Intel-64
+    and makes them hold on weakly ordered CPUs as well.
+    The size of the node determines the maximum size of the tree for a given
+    amount of memory. The members are ordered to avoid padding; the compact
+    layout (see SgUctValue.h) reduces the size from 80 to 48 bytes on 64-bit
+    systems.
     @ingroup sguctgroup */
 class SgUctNode
 {
@@ -126,6 +138,14 @@ public:
     /** Initializes node with given move, value and count. */
     SgUctNode(const SgUctMoveInfo& info);
 
+    /** Copy constructor.
+        Not thread-safe; only used if the node is not shared. */
+    SgUctNode(const SgUctNode& node);
+
+    /** Assignment operator.
+        Not thread-safe; only used if the node is not shared. */
+    SgUctNode& operator=(const SgUctNode& node);
+
     /** Add game result.
         @param eval The game result (e.g. score or 0/1 for win loss) */
     void AddGameResult(SgUctValue eval);
@@ -159,6 +179,19 @@ public:
         manages nodes. Use SgUctChildIterator to access children nodes. */
     const SgUctNode* FirstChild() const;
 
+    /** Get the first child and the number of children.
+        Reads both values consistently, also if another thread replaces the
+        children (SgUctTree::MergeChildren()) or detaches them
+        (SgUctTree::DetachLowCount()) at the same time. Calling
+        HasChildren() and then FirstChild() and NuChildren() is not safe in
+        this case.
+        @note This information is an implementation detail of how SgUctTree
+        manages nodes. Use SgUctChildIterator to access children nodes.
+        @param[out] firstChild The first child, undefined if the node has no
+        children
+        @return The number of children */
+    int GetChildren(const SgUctNode*& firstChild) const;
+
     /** Does the node have at least one child? */
     bool HasChildren() const;
 
@@ -261,30 +294,97 @@ public:
 
     void SetProvenType(SgUctProvenType type);
 
+    /** Set the knowledge count, if it still has the expected value.
+        @return @c true if the knowledge count was changed. */
+    bool CompareAndSetKnowledgeCount(SgUctValue expected, SgUctValue count);
+
+    /** Increment the position count with an atomic read-modify-write.
+        Unlike IncPosCount(), concurrent increments are never lost. */
+    void AtomicIncPosCount(SgUctValue count);
+
+    /** @name Per-node locks
+        Used by the atomic mode of SgUctSearch (see @ref sguctsearchatomic).
+        Both locks are spin locks, they must only be held for a short
+        time. */
+    // @{
+
+    /** Try to acquire the exclusive right to change the children.
+        @return @c false, if another thread holds the expansion lock. */
+    bool TryLockExpansion();
+
+    /** Acquire the exclusive right to change the children.
+        Waits until the lock is available. */
+    void LockExpansion();
+
+    void UnlockExpansion();
+
+    /** Acquire the lock that serializes updates of the move and RAVE
+        statistics. */
+    void LockUpdate();
+
+    void UnlockUpdate();
+
+    // @} // @name
+
 private:
-    SgUctStatisticsVolatile m_statistics;
+    /** @name Storage types of the narrow members
+        With SG_UCT_COMPACT_NODE, the move, the number of children, the
+        virtual loss count and the proven type are stored in the smallest
+        types that hold the values that occur in practice.
+        @see SgUctValue.h */
+    // @{
 
-    const SgUctNode* volatile m_firstChild;
+#if SG_UCT_COMPACT_NODE
+    typedef short MoveStorage;
 
-    volatile int m_nuChildren;
+    typedef short NuChildrenStorage;
 
-    volatile SgMove m_move;
+    typedef short VirtualLossStorage;
 
-    /* Value of additive predictor */
-    volatile float m_predictorValue;
+    typedef unsigned char ProvenTypeStorage;
+#else
+    typedef SgMove MoveStorage;
+
+    typedef int NuChildrenStorage;
+
+    typedef int VirtualLossStorage;
+
+    typedef SgUctProvenType ProvenTypeStorage;
+#endif
+
+    // @} // @name
+
+    // The members are ordered by decreasing size to avoid padding
+
+    boost::atomic<const SgUctNode*> m_firstChild;
+
+    SgUctStatisticsAtomic m_statistics;
 
     /** RAVE statistics.
         Uses double for count to allow adding fractional values if RAVE
         updates are weighted. */
-    SgUctStatisticsVolatile m_raveValue;
+    SgUctStatisticsAtomic m_raveValue;
+
+    boost::atomic<SgUctValue> m_posCount;
+
+    boost::atomic<SgUctValue> m_knowledgeCount;
+
+    /* Value of additive predictor */
+    float m_predictorValue;
+
+    boost::atomic<NuChildrenStorage> m_nuChildren;
+
+    MoveStorage m_move;
 
-    volatile SgUctValue m_posCount;
+    boost::atomic<VirtualLossStorage> m_virtualLossCount;
 
-    volatile SgUctValue m_knowledgeCount;
+    boost::atomic<ProvenTypeStorage> m_provenType;
 
-    volatile SgUctProvenType m_provenType;
+    /** See TryLockExpansion() */
+    boost::atomic<bool> m_expansionLock;
 
-    volatile int m_virtualLossCount;
+    /** See LockUpdate() */
+    boost::atomic<bool> m_updateLock;
 };
 
 //----------------------------------------------------------------------------
@@ -294,16 +394,47 @@ std::ostream& operator<<(std::ostream& stream, const SgUctNode& node);
 //----------------------------------------------------------------------------
 inline SgUctNode::SgUctNode(const SgUctMoveInfo& info)
     : m_statistics(info.m_value, info.m_count),
-      m_nuChildren(0),
-      m_move(info.m_move),
-      m_predictorValue(info.m_predictorValue),
       m_raveValue(info.m_raveValue, info.m_raveCount),
       m_posCount(0),
       m_knowledgeCount(0),
-      m_provenType(SG_NOT_PROVEN),
-      m_virtualLossCount(0)
+      m_predictorValue(info.m_predictorValue),
+      m_nuChildren(0),
+      m_move(MoveStorage(info.m_move)),
+      m_virtualLossCount(0),
+      m_provenType(ProvenTypeStorage(SG_NOT_PROVEN)),
+      m_expansionLock(false),
+      m_updateLock(false)
 {
     // m_firstChild is not initialized, only defined if m_nuChildren > 0
+    SG_ASSERT(m_move == info.m_move); // Move fits into MoveStorage
+}
+
+inline SgUctNode::SgUctNode(const SgUctNode& node)
+    : m_firstChild(node.m_firstChild.load(boost::memory_order_relaxed)),
+      m_statistics(node.m_statistics),
+      m_raveValue(node.m_raveValue),
+      m_posCount(node.PosCount()),
+      m_knowledgeCount(node.KnowledgeCount()),
+      m_predictorValue(node.m_predictorValue),
+      m_nuChildren(node.m_nuChildren.load(boost::memory_order_relaxed)),
+      m_move(node.m_move),
+      m_virtualLossCount(node.m_virtualLossCount.load(
+                                                boost::memory_order_relaxed)),
+      m_provenType(node.m_provenType.load(boost::memory_order_relaxed)),
+      m_expansionLock(false),
+      m_updateLock(false)
+{ }
+
+inline SgUctNode& SgUctNode::operator=(const SgUctNode& node)
+{
+    CopyDataFrom(node);
+    m_firstChild.store(node.m_firstChild.load(boost::memory_order_relaxed),
+                       boost::memory_order_relaxed);
+    m_nuChildren.store(node.m_nuChildren.load(boost::memory_order_relaxed),
+                       boost::memory_order_relaxed);
+    m_expansionLock.store(false, boost::memory_order_relaxed);
+    m_updateLock.store(false, boost::memory_order_relaxed);
+    return *this;
 }
 
 inline void SgUctNode::AddGameResult(SgUctValue eval)
@@ -355,16 +486,36 @@ inline void SgUctNode::CopyDataFrom(const SgUctNode& node)
     m_move = node.m_move;
     m_predictorValue = node.m_predictorValue;
     m_raveValue = node.m_raveValue;
-    m_posCount = node.m_posCount;
-    m_knowledgeCount = node.m_knowledgeCount;
-    m_provenType = node.m_provenType;
-    m_virtualLossCount = node.m_virtualLossCount;
+    m_posCount.store(node.PosCount(), boost::memory_order_relaxed);
+    m_knowledgeCount.store(node.KnowledgeCount(),
+                           boost::memory_order_relaxed);
+    m_provenType.store(node.m_provenType.load(boost::memory_order_relaxed),
+                       boost::memory_order_relaxed);
+    m_virtualLossCount.store(node.m_virtualLossCount.load(
+                                                boost::memory_order_relaxed),
+                             boost::memory_order_relaxed);
 }
 
 inline const SgUctNode* SgUctNode::FirstChild() const
 {
     SG_ASSERT(HasChildren()); // Otherwise m_firstChild is undefined
-    return m_firstChild;
+    return m_firstChild.load(boost::memory_order_acquire);
+}
+
+inline int SgUctNode::GetChildren(const SgUctNode*& firstChild) const
+{
+    // Read-order dependency: re-read the first child to make sure that the
+    // number of children belongs to the array that starts at firstChild.
+    // m_firstChild is not reset when the children are detached, so it can
+    // be read without checking HasChildren().
+    int nuChildren;
+    do
+    {
+        firstChild = m_firstChild.load(boost::memory_order_acquire);
+        nuChildren = NuChildren();
+    }
+    while (firstChild != m_firstChild.load(boost::memory_order_acquire));
+    return nuChildren;
 }
 
 inline bool SgUctNode::HasChildren() const
@@ -379,12 +530,8 @@ inline bool SgUctNode::HasChildren() const
     // created and thereby receive a null pointer, but the test for
     // children can be called after allocation completes and therefore
     // succeeds.  The end result is a null pointer exception.  The
-    // memory synchronization below is necessary on architectures that
-    // do not guarantee read order consistency.
-
-    bool retval = (m_nuChildren > 0);
-    SgSynchronizeThreadMemory();
-    return retval;
+    // acquire load pairs with the release store in SetNuChildren().
+    return NuChildren() > 0;
 }
 
 inline bool SgUctNode::HasMean() const
@@ -399,12 +546,12 @@ inline bool SgUctNode::HasRaveValue() const
 
 inline int SgUctNode::VirtualLossCount() const
 {
-    return m_virtualLossCount;
+    return m_virtualLossCount.load(boost::memory_order_relaxed);
 }
 
 inline void SgUctNode::AddVirtualLoss()
 {
-    m_virtualLossCount++;
+    m_virtualLossCount.fetch_add(1, boost::memory_order_relaxed);
 }
 
 inline void SgUctNode::RemoveVirtualLoss()
@@ -412,35 +559,37 @@ inline void SgUctNode::RemoveVirtualLoss()
     // May become negative with lock-free multithreading.  Negative
     // values are allowed so that errors introduced by multithreading
     // will tend to average out.
-    m_virtualLossCount--;
+    m_virtualLossCount.fetch_sub(1, boost::memory_order_relaxed);
 }
 
 inline void SgUctNode::IncPosCount()
 {
-    ++m_posCount;
+    IncPosCount(1);
 }
 
 inline void SgUctNode::IncPosCount(SgUctValue count)
 {
-    m_posCount += count;
+    m_posCount.store(PosCount() + count, boost::memory_order_relaxed);
+}
+
+inline void SgUctNode::AtomicIncPosCount(SgUctValue count)
+{
+    SgUctValue posCount = PosCount();
+    while (! m_posCount.compare_exchange_weak(posCount, posCount + count,
+                                              boost::memory_order_relaxed))
+        ;
 }
 
 inline void SgUctNode::DecPosCount()
 {
-    SgUctValue posCount = m_posCount;
-    if (posCount > 0)
-    {
-        m_posCount = posCount - 1;
-    }
+    DecPosCount(1);
 }
 
 inline void SgUctNode::DecPosCount(SgUctValue count)
 {
-    SgUctValue posCount = m_posCount;
+    SgUctValue posCount = PosCount();
     if (posCount >= count)
-    {
-        m_posCount = posCount - count;
-    }
+        m_posCount.store(posCount - count, boost::memory_order_relaxed);
 }
 
 inline bool SgUctNode::HasMove() const
@@ -476,12 +625,12 @@ inline SgUctValue SgUctNode::MoveCount() const
 
 inline int SgUctNode::NuChildren() const
 {
-    return m_nuChildren;
+    return m_nuChildren.load(boost::memory_order_acquire);
 }
 
 inline SgUctValue SgUctNode::PosCount() const
 {
-    return m_posCount;
+    return m_posCount.load(boost::memory_order_relaxed);
 }
 
 inline float SgUctNode::PredictorValue() const
@@ -501,60 +650,123 @@ inline SgUctValue SgUctNode::RaveValue() const
 
 inline void SgUctNode::SetFirstChild(const SgUctNode* child)
 {
-    m_firstChild = child;
+    // Release: the children must be fully initialized before another
+    // thread can see them
+    m_firstChild.store(child, boost::memory_order_release);
 }
 
 inline void SgUctNode::SetNuChildren(int nuChildren)
 {
     SG_ASSERT(nuChildren >= 0);
-    m_nuChildren = nuChildren;
+    SG_ASSERT(nuChildren <= std::numeric_limits<NuChildrenStorage>::max());
+    m_nuChildren.store(NuChildrenStorage(nuChildren),
+                       boost::memory_order_release);
 }
 
 inline void SgUctNode::SetPosCount(SgUctValue value)
 {
-    m_posCount = value;
+    m_posCount.store(value, boost::memory_order_relaxed);
 }
 
 inline SgUctValue SgUctNode::KnowledgeCount() const
 {
-    return m_knowledgeCount;
+    return m_knowledgeCount.load(boost::memory_order_relaxed);
 }
 
 inline void SgUctNode::SetKnowledgeCount(SgUctValue count)
 {
-    m_knowledgeCount = count;
+    m_knowledgeCount.store(count, boost::memory_order_relaxed);
+}
+
+inline bool SgUctNode::CompareAndSetKnowledgeCount(SgUctValue expected,
+                                                   SgUctValue count)
+{
+    return m_knowledgeCount.compare_exchange_strong(expected, count,
+                                                boost::memory_order_relaxed);
 }
 
 inline bool SgUctNode::IsProven() const
 {
-    return m_provenType != SG_NOT_PROVEN;
+    return ProvenType() != SG_NOT_PROVEN;
 }
 
 inline bool SgUctNode::IsProvenWin() const
 {
-    return m_provenType == SG_PROVEN_WIN;
+    return ProvenType() == SG_PROVEN_WIN;
 }
 
 inline bool SgUctNode::IsProvenLoss() const
 {
-    return m_provenType == SG_PROVEN_LOSS;
+    return ProvenType() == SG_PROVEN_LOSS;
 }
 
 inline SgUctProvenType SgUctNode::ProvenType() const
 {
-    return m_provenType;
+    return SgUctProvenType(m_provenType.load(boost::memory_order_relaxed));
 }
 
 inline void SgUctNode::SetProvenType(SgUctProvenType type)
 {
-    m_provenType = type;
+    m_provenType.store(ProvenTypeStorage(type), boost::memory_order_relaxed);
+}
+
+inline bool SgUctNode::TryLockExpansion()
+{
+    return ! m_expansionLock.exchange(true, boost::memory_order_acquire);
 }
 
+inline void SgUctNode::LockExpansion()
+{
+    while (! TryLockExpansion())
+        while (m_expansionLock.load(boost::memory_order_relaxed))
+            boost::this_thread::yield();
+}
+
+inline void SgUctNode::UnlockExpansion()
+{
+    m_expansionLock.store(false, boost::memory_order_release);
+}
+
+inline void SgUctNode::LockUpdate()
+{
+    while (m_updateLock.exchange(true, boost::memory_order_acquire))
+        while (m_updateLock.load(boost::memory_order_relaxed))
+            ;
+}
+
+inline void SgUctNode::UnlockUpdate()
+{
+    m_updateLock.store(false, boost::memory_order_release);
+}
+
+//----------------------------------------------------------------------------
+
+/** A block of sibling nodes.
+    Used for reclaiming the memory of pruned subtrees (see
+    SgUctTree::DetachLowCount()). */
+struct SgUctNodeBlock
+{
+    const SgUctNode* m_first;
+
+    int m_size;
+
+    SgUctNodeBlock(const SgUctNode* first, int size);
+};
+
+inline SgUctNodeBlock::SgUctNodeBlock(const SgUctNode* first, int size)
+    : m_first(first),
+      m_size(size)
+{ }
+
 //----------------------------------------------------------------------------
 
 /** Allocater for nodes used in the implementation of SgUctTree.
     Each thread has its own node allocator to allow lock-free usage of
     SgUctTree.
+    New nodes are created at the end of the storage. If the storage is full,
+    Create() reuses blocks of nodes that were added with AddFreeBlock(). The
+    free blocks are protected by a mutex, because they are added by the
+    thread that prunes the tree, not by the thread owning the allocator.
     @ingroup sguctgroup */
 class SgUctAllocator
 {
@@ -565,15 +777,39 @@ public:
 
     void Clear();
 
-    /** Does the allocator have the capacity for n more nodes? */
+    /** Does the allocator have the capacity for n more nodes?
+        Checks the free blocks, if there is not enough space at the end of
+        the storage. */
     bool HasCapacity(std::size_t n) const;
 
+    /** Number of nodes created at the end of the storage.
+        Includes nodes that were later added to the free blocks. */
     std::size_t NuNodes() const;
 
+    /** Number of nodes in free blocks.
+        The nodes can be located in the storage of other allocators of the
+        same tree. */
+    std::size_t NuFreeNodes() const;
+
+    /** Add a block of nodes that is no longer used by the tree.
+        The nodes will be reused by Create(), if there is no space left at
+        the end of the storage. The block can be located in the storage of a
+        different allocator of the same tree.
+        REQUIRES: No thread accesses the nodes anymore. */
+    void AddFreeBlock(const SgUctNodeBlock& block);
+
     std::size_t MaxNodes() const;
 
     void SetMaxNodes(std::size_t maxNodes);
 
+    /** Place the storage on a NUMA node.
+        Must be called directly after SetMaxNodes(), before the memory is
+        touched (see SgNuma::PlaceOnNode()).
+        @param numaNode The node for the storage.
+        @param interleaveNodes The number of nodes at the beginning of the
+        storage that are interleaved over all NUMA nodes instead. */
+    void PlaceOnNumaNode(int numaNode, std::size_t interleaveNodes);
+
     /** Check if allocator contains node.
         This function uses pointer comparisons. Since the result of
         comparisons for pointers to elements in different containers
@@ -589,18 +825,24 @@ public:
     const SgUctNode* Finish() const;
 
     /** Create a new node at the end of the storage.
+        Does not use free blocks.
         REQUIRES: HasCapacity(1)
         @param move The constructor argument.
         @return A pointer to new newly created node. */
     SgUctNode* CreateOne(SgMove move);
 
-    /** Create a number of new nodes with a given list of moves at the end of
-        the storage. Returns the sum of counts of moves.
+    /** Create a number of new nodes with a given list of moves.
+        The nodes are created at the end of the storage or in a free block,
+        if the storage is full.
         REQUIRES: HasCapacity(moves.size())
-        @param moves The list of moves. */
-    SgUctValue Create(const std::vector<SgUctMoveInfo>& moves);
+        @param moves The list of moves.
+        @param[out] count The sum of counts of moves.
+        @return The first new node. */
+    SgUctNode* Create(const std::vector<SgUctMoveInfo>& moves,
+                      SgUctValue& count);
 
     /** Create a number of new nodes at the end of the storage.
+        Does not use free blocks.
         REQUIRES: HasCapacity(n)
         @param n The number of nodes to create. */
     void CreateN(std::size_t n);
@@ -614,6 +856,19 @@ private:
 
     SgUctNode* m_endOfStorage;
 
+    /** Free blocks indexed by the number of nodes in the block. */
+    std::vector<std::vector<SgUctNode*> > m_freeBlocks;
+
+    /** See NuFreeNodes() */
+    std::size_t m_nuFreeNodes;
+
+    /** Protects m_freeBlocks and m_nuFreeNodes. */
+    mutable boost::mutex m_freeBlocksMutex;
+
+    bool HasFreeBlock(std::size_t n) const;
+
+    SgUctNode* TakeFreeBlock(std::size_t n);
+
     /** Not implemented.
         Cannot be copied because array contains pointers to elements.
         Use Swap() instead. */
@@ -621,6 +876,7 @@ private:
 };
 
 inline SgUctAllocator::SgUctAllocator()
+    : m_nuFreeNodes(0)
 {
     m_start = 0;
 }
@@ -633,32 +889,46 @@ inline void SgUctAllocator::Clear()
             it->~SgUctNode();
         m_finish = m_start;
     }
+    boost::mutex::scoped_lock lock(m_freeBlocksMutex);
+    m_freeBlocks.clear();
+    m_nuFreeNodes = 0;
 }
 
 inline SgUctNode* SgUctAllocator::CreateOne(SgMove move)
 {
-    SG_ASSERT(HasCapacity(1));
+    SG_ASSERT(m_finish + 1 <= m_endOfStorage);
     new(m_finish) SgUctNode(move);
     return (m_finish++);
 }
 
-inline SgUctValue SgUctAllocator::Create(
-                                         const std::vector<SgUctMoveInfo>& moves)
+inline SgUctNode* SgUctAllocator::Create(
+                                         const std::vector<SgUctMoveInfo>& moves,
+                                         SgUctValue& count)
 {
     SG_ASSERT(HasCapacity(moves.size()));
-    SgUctValue count = 0;
+    SgUctNode* first;
+    if (m_finish + moves.size() <= m_endOfStorage)
+    {
+        first = m_finish;
+        m_finish += moves.size();
+    }
+    else
+        first = TakeFreeBlock(moves.size());
+    SG_ASSERT(first != 0);
+    count = 0;
+    SgUctNode* node = first;
     for (std::vector<SgUctMoveInfo>::const_iterator it = moves.begin();
-         it != moves.end(); ++it, ++m_finish)
+         it != moves.end(); ++it, ++node)
     {
-        new(m_finish) SgUctNode(*it);
+        new(node) SgUctNode(*it);
         count += it->m_count;
     }
-    return count;
+    return first;
 }
 
 inline void SgUctAllocator::CreateN(std::size_t n)
 {
-    SG_ASSERT(HasCapacity(n));
+    SG_ASSERT(m_finish + n <= m_endOfStorage);
     SgUctNode* newFinish = m_finish + n;
     for ( ; m_finish != newFinish; ++m_finish)
         new(m_finish) SgUctNode(SG_NULLMOVE);
@@ -676,7 +946,7 @@ inline const SgUctNode* SgUctAllocator::Finish() const
 
 inline bool SgUctAllocator::HasCapacity(std::size_t n) const
 {
-    return (m_finish + n <= m_endOfStorage);
+    return (m_finish + n <= m_endOfStorage || HasFreeBlock(n));
 }
 
 inline std::size_t SgUctAllocator::MaxNodes() const
@@ -684,6 +954,12 @@ inline std::size_t SgUctAllocator::MaxNodes() const
     return m_endOfStorage - m_start;
 }
 
+inline std::size_t SgUctAllocator::NuFreeNodes() const
+{
+    boost::mutex::scoped_lock lock(m_freeBlocksMutex);
+    return m_nuFreeNodes;
+}
+
 inline std::size_t SgUctAllocator::NuNodes() const
 {
     return m_finish - m_start;
@@ -727,6 +1003,13 @@ public:
     void AddGameResults(const SgUctNode& node, const SgUctNode* father,
                         SgUctValue eval, SgUctValue count);
 
+    /** Like AddGameResults(), but safe for concurrent use.
+        The update of the node statistics is protected by the update lock of
+        the node and the position count of the father is incremented
+        atomically, so that no updates get lost. */
+    void AddGameResultsLocked(const SgUctNode& node, const SgUctNode* father,
+                              SgUctValue eval, SgUctValue count);
+
     /** Removes a game result.
         @param node The node.
         @param father The father (if not root) to update the position count.
@@ -748,6 +1031,19 @@ public:
 
     void SetKnowledgeCount(const SgUctNode& node, SgUctValue count);
 
+    /** See SgUctNode::CompareAndSetKnowledgeCount() */
+    bool CompareAndSetKnowledgeCount(const SgUctNode& node,
+                                     SgUctValue expected, SgUctValue count);
+
+    /** See SgUctNode::TryLockExpansion() */
+    bool TryLockExpansion(const SgUctNode& node);
+
+    /** See SgUctNode::LockExpansion() */
+    void LockExpansion(const SgUctNode& node);
+
+    /** See SgUctNode::UnlockExpansion() */
+    void UnlockExpansion(const SgUctNode& node);
+
     void Clear();
 
     /** Return the current maximum number of nodes.
@@ -765,6 +1061,22 @@ public:
         @param maxNodes Maximum number of nodes */
     void SetMaxNodes(std::size_t maxNodes);
 
+    /** Place the storage of the allocators on NUMA nodes.
+        If enabled, the storage of allocator i is placed on the NUMA node of
+        search thread i (see SgNuma::ThreadNode()), except for the first
+        interleaveNodes nodes of each allocator, which are interleaved over
+        all NUMA nodes. The nodes near the root are created first, so they
+        are at the beginning of the allocators and are accessed by all
+        threads. Takes effect at the next call of SetMaxNodes().
+        Has no effect if SgNuma::IsAvailable() is false. */
+    void SetNumaPlacement(bool enable, std::size_t interleaveNodes);
+
+    /** See SetNumaPlacement() */
+    bool NumaPlacement() const;
+
+    /** See SetNumaPlacement() */
+    std::size_t NumaInterleaveNodes() const;
+
     /** Swap content with another tree.
         The other tree must have the same number of allocators and
         the same maximum number of nodes. */
@@ -787,6 +1099,8 @@ public:
         The tree will be truncated if one of the allocators overflows (can
         happen due to reassigning nodes to different allocators), the given
         max time is exceeded or on SgUserAbort().
+        If the target tree has more than one allocator, the subtree is copied
+        with one thread per allocator (see CopySubtreeParallel()).
         @param[out] target The resulting subtree. Must have the same maximum
         number of nodes. Will be cleared before using.
         @param node The start node of the subtree.
@@ -803,6 +1117,7 @@ public:
         The tree will be truncated if one of the allocators overflows (can
         happen due to reassigning nodes to different allocators), the given
         max time is exceeded or on SgUserAbort().
+        Uses multiple threads like ExtractSubtree().
         @param[out] target The resulting tree. Must have the same maximum
         number of nodes. Will be cleared before using.
         @param minCount The minimum count (SgUctNode::MoveCount())
@@ -813,12 +1128,73 @@ public:
                    bool warnTruncate,
                    double maxTime = std::numeric_limits<double>::max()) const;
 
+    /** Prune nodes with low counts in place.
+        Removes the children of all non-root nodes with a count below
+        minCount by setting their number of children to zero. The nodes of
+        the removed subtrees are not freed, because other threads can still
+        access them. The caller has to pass the detached blocks to
+        ReclaimSubtrees() after all threads stopped using them.
+        This function can be used while other threads search the tree, if
+        the threads protect the expansion of nodes with
+        SgUctNode::TryLockExpansion(). The other threads must read the
+        children with SgUctChildIterator or SgUctNode::GetChildren() and
+        handle nodes whose children disappear after HasChildren() returned
+        @c true.
+        @param minCount The minimum count (SgUctNode::MoveCount())
+        @param lockExpansion Acquire the expansion lock of a node before
+        removing its children and skip nodes that are locked.
+        @param[out] detached The child blocks of the pruned nodes are
+        appended to this list.
+        @return The number of nodes in the removed subtrees. */
+    std::size_t DetachLowCount(SgUctValue minCount, bool lockExpansion,
+                               std::vector<SgUctNodeBlock>& detached);
+
+    /** Add the nodes of subtrees removed by DetachLowCount() to the free
+        blocks of the allocators.
+        The blocks are distributed evenly over the allocators.
+        REQUIRES: No thread accesses the nodes in the subtrees anymore.
+        @return The number of reclaimed nodes. */
+    std::size_t ReclaimSubtrees(const std::vector<SgUctNodeBlock>& detached);
+
+    /** Write the tree to a binary file.
+        The file contains a header and the data of the nodes (counts,
+        values, RAVE values, knowledge count, predictor value and proven
+        type) in a fixed-size record per node. Each block of children
+        follows the record of its parent, before the blocks of the
+        children's children (the same order as CopyPruneLowCount()). The
+        file uses the byte order of the machine and stores moves as SgMove,
+        so it can only be read by a program with the same byte order and
+        SG_MAX_SIZE.
+        @param fileName
+        @param key An identifier of the position at the root node, chosen
+        by the caller. Load() only accepts the file for the same key.
+        @throws SgException on write error. */
+    void Save(const std::string& fileName, uint64_t key) const;
+
+    /** Replace the tree by a tree from a file written by Save().
+        Maps the file into memory and creates the nodes directly from the
+        records in the file, using the allocators like CopyPruneLowCount().
+        The tree must be initialized with CreateAllocators() and
+        SetMaxNodes().
+        The records are checked: moves must be points on the board or
+        SG_PASS, values must be in [0..1] and the depth of the tree is
+        limited.
+        @param fileName
+        @param key See Save()
+        @return @c false, if the file was written for a different key. The
+        tree is not changed in this case.
+        @throws SgException if the file cannot be mapped, is not a valid tree
+        file or if the tree does not fit into the allocators. The tree is
+        cleared in this case. */
+    bool Load(const std::string& fileName, uint64_t key);
+
     const SgUctNode& Root() const;
 
     std::size_t NuAllocators() const;
 
     /** Total number of nodes.
-        Includes the sum of nodes in all allocators plus the root node. */
+        Includes the sum of nodes in all allocators plus the root node.
+        Nodes in the free blocks of the allocators are not counted. */
     std::size_t NuNodes() const;
 
     /** Number of nodes in one of the allocators. */
@@ -831,6 +1207,11 @@ public:
         @see SgUctSearch::Rave(). */
     void AddRaveValue(const SgUctNode& node, SgUctValue value, SgUctValue weight);
 
+    /** Like AddRaveValue(), but protected by the update lock of the node.
+        @see AddGameResultsLocked() */
+    void AddRaveValueLocked(const SgUctNode& node, SgUctValue value,
+                            SgUctValue weight);
+
     /** Remove a game result from the RAVE value of a node.
         @param node The node with the move
         @param value
@@ -863,6 +1244,21 @@ public:
     void SetChildren(std::size_t allocatorId, const SgUctNode& node,
                      const std::vector<SgMove>& moves);
 
+    /** Let a node use the children of another node.
+        Used for positions reached by different move orders (see
+        SgUctSearch::Transpositions()). The children are not copied, both
+        nodes point to the same children afterwards, so the statistics of
+        the children are shared. The position count of the node is set to
+        the sum of the move counts of the children (like the prior counts in
+        CreateChildren()) and the knowledge count is taken from the other
+        node. Functions that copy the tree create separate copies of shared
+        children. This function can be used in lock-free mode, the
+        children of the source are read with SgUctNode::GetChildren().
+        @return @c false, if the source has no children (e.g. because they
+        were detached by another thread). The node is not changed in this
+        case. */
+    bool ShareChildren(const SgUctNode& node, const SgUctNode& source);
+
     /** @name Functions for debugging */
     // @{
 
@@ -883,8 +1279,22 @@ public:
     // @} // @name
 
 private:
+    struct CopyTask;
+
+    /** Header of a file written by Save(). */
+    struct FileHeader;
+
+    /** Record of a node in a file written by Save(). */
+    struct FileNode;
+
     std::size_t m_maxNodes;
 
+    /** See SetNumaPlacement() */
+    bool m_numaPlacement;
+
+    /** See SetNumaPlacement() */
+    std::size_t m_numaInterleaveNodes;
+
     SgUctNode m_root;
 
     /** Allocators.
@@ -905,7 +1315,31 @@ private:
                                 const SgUctNode& node, SgUctValue minCount,
                                 std::size_t& currentAllocatorId, bool warnTruncate,
                                 bool& abort, SgTimer& timer, double maxTime,
-                                bool alwaysKeepProven) const;
+                                bool alwaysKeepProven,
+                                bool cycleAllocators = true) const;
+
+    void CopySubtreeParallel(SgUctTree& target, const SgUctNode& node,
+                             SgUctValue minCount, bool warnTruncate,
+                             double maxTime, bool alwaysKeepProven) const;
+
+    void CopySubtreeWorker(SgUctTree& target, std::vector<CopyTask>& tasks,
+                           boost::atomic<std::size_t>& nextTask,
+                           std::size_t allocatorId, SgUctValue minCount,
+                           bool warnTruncate, double maxTime,
+                           bool alwaysKeepProven) const;
+
+    void DetachLowCount(const SgUctNode& node, SgUctValue minCount,
+                        bool lockExpansion,
+                        std::vector<SgUctNodeBlock>& detached,
+                        std::size_t& nuDetached);
+
+    std::size_t NuSubtreeNodes(const SgUctNode& node) const;
+
+    void LoadSubtree(SgUctNode& node, const FileNode*& next,
+                     const FileNode* end, std::size_t& currentAllocatorId,
+                     int depth);
+
+    void SaveSubtree(std::ostream& out, const SgUctNode& node) const;
 
     void ThrowConsistencyError(const std::string& message) const;
 };
@@ -934,6 +1368,21 @@ inline void SgUctTree::AddGameResults(const SgUctNode& node,
     const_cast<SgUctNode&>(node).AddGameResults(eval, count);
 }
 
+inline void SgUctTree::AddGameResultsLocked(const SgUctNode& node,
+                                            const SgUctNode* father,
+                                            SgUctValue eval, SgUctValue count)
+{
+    SG_ASSERT(Contains(node));
+    // Parameters are const-references, because only the tree is allowed
+    // to modify nodes
+    if (father != 0)
+        const_cast<SgUctNode*>(father)->AtomicIncPosCount(count);
+    SgUctNode& nonConstNode = const_cast<SgUctNode&>(node);
+    nonConstNode.LockUpdate();
+    nonConstNode.AddGameResults(eval, count);
+    nonConstNode.UnlockUpdate();
+}
+
 inline void SgUctTree::CreateChildren(std::size_t allocatorId,
                                       const SgUctNode& node,
                                       const std::vector<SgUctMoveInfo>& moves)
@@ -953,16 +1402,13 @@ inline void SgUctTree::CreateChildren(std::size_t allocatorId,
     // thread)
     SG_ASSERT(NuAllocators() > 1 || ! node.HasChildren());
 
-    const SgUctNode* firstChild = allocator.Finish();
-    
-    SgUctValue parentCount = allocator.Create(moves);
+    SgUctValue parentCount;
+    const SgUctNode* firstChild = allocator.Create(moves, parentCount);
 
     // Write order dependency: SgUctSearch in lock-free mode assumes that
     // m_firstChild is valid if m_nuChildren is greater zero
     nonConstNode.SetPosCount(parentCount);
-    SgSynchronizeThreadMemory();
     nonConstNode.SetFirstChild(firstChild);
-    SgSynchronizeThreadMemory();
     nonConstNode.SetNuChildren(nuChildren);
 }
 
@@ -1018,6 +1464,18 @@ inline void SgUctTree::RemoveRaveValue(const SgUctNode& node, SgUctValue value,
     const_cast<SgUctNode&>(node).RemoveRaveValue(value, weight);
 }
 
+inline void SgUctTree::AddRaveValueLocked(const SgUctNode& node,
+                                          SgUctValue value, SgUctValue weight)
+{
+    SG_ASSERT(Contains(node));
+    // Parameters are const-references, because only the tree is allowed
+    // to modify nodes
+    SgUctNode& nonConstNode = const_cast<SgUctNode&>(node);
+    nonConstNode.LockUpdate();
+    nonConstNode.AddRaveValue(value, weight);
+    nonConstNode.UnlockUpdate();
+}
+
 inline SgUctAllocator& SgUctTree::Allocator(std::size_t i)
 {
     SG_ASSERT(i < m_allocators.size());
@@ -1059,6 +1517,16 @@ inline std::size_t SgUctTree::MaxNodes() const
     return m_maxNodes;
 }
 
+inline std::size_t SgUctTree::NumaInterleaveNodes() const
+{
+    return m_numaInterleaveNodes;
+}
+
+inline bool SgUctTree::NumaPlacement() const
+{
+    return m_numaPlacement;
+}
+
 inline std::size_t SgUctTree::NuAllocators() const
 {
     return m_allocators.size();
@@ -1083,6 +1551,35 @@ inline void SgUctTree::SetKnowledgeCount(const SgUctNode& node,
     const_cast<SgUctNode&>(node).SetKnowledgeCount(count);
 }
 
+inline bool SgUctTree::CompareAndSetKnowledgeCount(const SgUctNode& node,
+                                                   SgUctValue expected,
+                                                   SgUctValue count)
+{
+    SG_ASSERT(Contains(node));
+    // Parameters are const-references, because only the tree is allowed
+    // to modify nodes
+    return const_cast<SgUctNode&>(node).CompareAndSetKnowledgeCount(expected,
+                                                                     count);
+}
+
+inline bool SgUctTree::TryLockExpansion(const SgUctNode& node)
+{
+    SG_ASSERT(Contains(node));
+    return const_cast<SgUctNode&>(node).TryLockExpansion();
+}
+
+inline void SgUctTree::LockExpansion(const SgUctNode& node)
+{
+    SG_ASSERT(Contains(node));
+    const_cast<SgUctNode&>(node).LockExpansion();
+}
+
+inline void SgUctTree::UnlockExpansion(const SgUctNode& node)
+{
+    SG_ASSERT(Contains(node));
+    const_cast<SgUctNode&>(node).UnlockExpansion();
+}
+
 inline void SgUctTree::SetPosCount(const SgUctNode& node,
                                    SgUctValue posCount)
 {
@@ -1092,6 +1589,33 @@ inline void SgUctTree::SetPosCount(const SgUctNode& node,
     const_cast<SgUctNode&>(node).SetPosCount(posCount);
 }
 
+inline bool SgUctTree::ShareChildren(const SgUctNode& node,
+                                     const SgUctNode& source)
+{
+    SG_ASSERT(Contains(node));
+    SG_ASSERT(Contains(source));
+    SG_ASSERT(&node != &source);
+    // The source can be changed by MergeChildren() or DetachLowCount() in
+    // another thread, read the number of children and the first child as a
+    // consistent pair
+    const SgUctNode* firstChild;
+    const int nuChildren = source.GetChildren(firstChild);
+    if (nuChildren == 0)
+        return false;
+    SgUctValue parentCount = 0;
+    for (int i = 0; i < nuChildren; ++i)
+        parentCount += firstChild[i].MoveCount();
+    // Parameters are const-references, because only the tree is allowed
+    // to modify nodes
+    SgUctNode& nonConstNode = const_cast<SgUctNode&>(node);
+    nonConstNode.SetKnowledgeCount(source.KnowledgeCount());
+    // Write order dependency, see CreateChildren()
+    nonConstNode.SetPosCount(parentCount);
+    nonConstNode.SetFirstChild(firstChild);
+    nonConstNode.SetNuChildren(nuChildren);
+    return true;
+}
+
 inline void SgUctTree::SetProvenType(const SgUctNode &node,
                                      SgUctProvenType type)
 {
@@ -1105,15 +1629,18 @@ inline void SgUctTree::SetProvenType(const SgUctNode &node,
 
 /** Iterator over all children of a node.
     It was intentionally implemented to be used only, if at least one child
-    exists (checked with an assertion), since in many use cases, the case
-    of no children needs to be handled specially and should be checked
-    before doing a loop over all children.
+    exists, since in many use cases, the case of no children needs to be
+    handled specially and should be checked before doing a loop over all
+    children. During a multi-threaded search, the children can be detached
+    by another thread after that check (see SgUctTree::DetachLowCount()),
+    in this case the iterator is empty.
     @ingroup sguctgroup */
 class SgUctChildIterator
 {
 public:
     /** Constructor.
-        Requires: node.HasChildren() */
+        Requires: node.HasChildren() was true (the children can be detached
+        concurrently, see class description) */
     SgUctChildIterator(const SgUctTree& tree, const SgUctNode& node);
 
     const SgUctNode& operator*() const;
@@ -1140,9 +1667,10 @@ inline SgUctChildIterator::SgUctChildIterator(const SgUctTree& tree,
 {
     SG_DEBUG_ONLY(tree);
     SG_ASSERT(tree.Contains(node));
-    SG_ASSERT(node.HasChildren());
-    m_current = node.FirstChild();
-    m_last = m_current + node.NuChildren();
+    int nuChildren = node.GetChildren(m_current);
+    if (nuChildren == 0)
+        m_current = 0;
+    m_last = m_current + nuChildren;
 }
 
 inline const SgUctNode& SgUctChildIterator::operator*() const
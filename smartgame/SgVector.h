@@ -19,6 +19,13 @@ public:
     SgVector()
         : m_vec()
     { }
+
+    /** Copy constructor.
+        Declared explicitly, because the implicit copy constructor is
+        deprecated in a class with a user-declared assignment operator. */
+    SgVector(const SgVector<T>& v)
+        : m_vec(v.m_vec)
+    { }
     
     /** Return reference to element.
         @param index Position of element in range <code>0..length-1</code>. */
@@ -0,0 +1,178 @@
+//----------------------------------------------------------------------------
+/** @file SgDfpnSearchTest.cpp
+    Unit tests for DfpnSolver. */
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+
+#include <vector>
+#include <boost/test/auto_unit_test.hpp>
+#include "SgDebug.h"
+#include "SgDfpnSearch.h"
+
+using namespace std;
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+/** Solver for Nim.
+    A move takes one or more stones from one pile, the player who takes
+    the last stone wins. The first player wins if and only if the
+    exclusive or of the pile sizes is not zero. Moves are encoded as
+    16 * pile + number of stones. */
+class NimSolver
+    : public DfpnSolver
+{
+public:
+    NimSolver(const vector<int>& piles);
+
+    DfpnSolver* CreateHelper() const;
+
+    void GenerateChildren(vector<SgMove>& children) const;
+
+    void PlayMove(SgMove move);
+
+    void UndoMove();
+
+    bool TerminalState(SgBoardColor colorToPlay, SgEmptyBlackWhite& winner);
+
+    SgBoardColor GetColorToMove() const;
+
+    SgHashCode Hash() const;
+
+    void WriteMoveSequence(ostream& stream,
+                           const PointSequence& sequence) const;
+
+private:
+    vector<int> m_piles;
+
+    SgBlackWhite m_toPlay;
+
+    vector<SgMove> m_moves;
+};
+
+NimSolver::NimSolver(const vector<int>& piles)
+    : m_piles(piles),
+      m_toPlay(SG_BLACK)
+{ }
+
+DfpnSolver* NimSolver::CreateHelper() const
+{
+    NimSolver* solver = new NimSolver(m_piles);
+    solver->m_toPlay = m_toPlay;
+    return solver;
+}
+
+void NimSolver::GenerateChildren(vector<SgMove>& children) const
+{
+    for (size_t i = 0; i < m_piles.size(); ++i)
+        for (int n = m_piles[i]; n >= 1; --n)
+            children.push_back(16 * static_cast<int>(i) + n);
+}
+
+SgBoardColor NimSolver::GetColorToMove() const
+{
+    return m_toPlay;
+}
+
+SgHashCode NimSolver::Hash() const
+{
+    unsigned int key = m_toPlay;
+    for (size_t i = 0; i < m_piles.size(); ++i)
+        key = 16 * key + m_piles[i];
+    return SgHashCode(key);
+}
+
+void NimSolver::PlayMove(SgMove move)
+{
+    m_piles[move / 16] -= move % 16;
+    SG_ASSERT(m_piles[move / 16] >= 0);
+    m_moves.push_back(move);
+    m_toPlay = SgOppBW(m_toPlay);
+}
+
+bool NimSolver::TerminalState(SgBoardColor colorToPlay,
+                              SgEmptyBlackWhite& winner)
+{
+    for (size_t i = 0; i < m_piles.size(); ++i)
+        if (m_piles[i] > 0)
+            return false;
+    winner = SgOppBW(colorToPlay);
+    return true;
+}
+
+void NimSolver::UndoMove()
+{
+    const SgMove move = m_moves.back();
+    m_moves.pop_back();
+    m_piles[move / 16] += move % 16;
+    m_toPlay = SgOppBW(m_toPlay);
+}
+
+void NimSolver::WriteMoveSequence(ostream& stream,
+                                  const PointSequence& sequence) const
+{
+    for (size_t i = 0; i < sequence.size(); ++i)
+        stream << sequence[i] / 16 << ':' << sequence[i] % 16 << ' ';
+}
+
+SgEmptyBlackWhite Solve(const vector<int>& piles, int numberThreads)
+{
+    NimSolver solver(piles);
+    solver.SetNumberThreads(numberThreads);
+    DfpnHashTable hashTable(1 << 16);
+    PointSequence pv;
+    SgEmptyBlackWhite winner;
+    {
+        SgDebugToString debugToString(false);
+        winner = solver.StartSearch(hashTable, pv);
+    }
+    if (winner != SG_EMPTY)
+    {
+        SgSearchTracer tracer(0);
+        BOOST_CHECK(solver.Validate(hashTable, winner, tracer));
+    }
+    BOOST_CHECK_EQUAL(solver.NumMIDcallsPerThread().size(),
+                      numberThreads > 1 ? size_t(numberThreads) : 0u);
+    return winner;
+}
+
+BOOST_AUTO_TEST_CASE(SgDfpnSearchTest_Nim)
+{
+    const int piles[][4] = {
+        { 1, 2, 3, 0 }, // Losing for first player
+        { 3, 4, 5, 0 },
+        { 2, 5, 6, 7 }, // Losing for first player
+        { 3, 5, 7, 9 }
+    };
+    for (size_t i = 0; i < sizeof(piles) / sizeof(piles[0]); ++i)
+    {
+        const vector<int> p(piles[i], piles[i] + 4);
+        const SgBlackWhite expected =
+            (p[0] ^ p[1] ^ p[2] ^ p[3]) != 0 ? SG_BLACK : SG_WHITE;
+        BOOST_CHECK_EQUAL(Solve(p, 1), expected);
+    }
+}
+
+/** The parallel search finds the same winners as the sequential search. */
+BOOST_AUTO_TEST_CASE(SgDfpnSearchTest_Parallel)
+{
+    const int piles[][4] = {
+        { 1, 2, 3, 0 },
+        { 3, 4, 5, 0 },
+        { 2, 5, 6, 7 },
+        { 3, 5, 7, 9 }
+    };
+    for (size_t i = 0; i < sizeof(piles) / sizeof(piles[0]); ++i)
+    {
+        const vector<int> p(piles[i], piles[i] + 4);
+        const SgBlackWhite expected =
+            (p[0] ^ p[1] ^ p[2] ^ p[3]) != 0 ? SG_BLACK : SG_WHITE;
+        BOOST_CHECK_EQUAL(Solve(p, 4), expected);
+    }
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
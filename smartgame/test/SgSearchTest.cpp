@@ -10,6 +10,7 @@
 #include <boost/test/auto_unit_test.hpp>
 #include "SgDebug.h"
 #include "SgHashTable.h"
+#include "SgRandom.h"
 #include "SgSearch.h"
 #include "SgSearchControl.h"
 #include "SgVector.h"
@@ -45,6 +46,8 @@ public:
 
     bool CheckDepthLimitReached() const;
 
+    SgSearch* CreateHelper() const;
+
     void Generate(SgVector<SgMove>* moves, int depth);
 
     int Evaluate(bool* isExact, int depth);
@@ -143,6 +146,15 @@ bool TestSearch::CheckDepthLimitReached() const
     return true;
 }
 
+SgSearch* TestSearch::CreateHelper() const
+{
+    TestSearch* search = new TestSearch();
+    search->m_currentNode = m_currentNode;
+    search->m_toPlay = m_toPlay;
+    search->m_nodes = m_nodes;
+    return search;
+}
+
 inline TestSearch::TestNode& TestSearch::CurrentNode()
 {
     return Node(m_currentNode);
@@ -367,6 +379,51 @@ BOOST_AUTO_TEST_CASE(SgSearchTest_NewBestInIncompleteIteration)
     delete control;
 }
 
+/** Add a random subtree with uniform depth and number of children. */
+void AddRandomTree(TestSearch& search, size_t father, int depth,
+                   int nuChildren, SgRandom& random, size_t& nuNodes)
+{
+    for (int i = 0; i < nuChildren; ++i)
+    {
+        const size_t index = nuNodes++;
+        search.AddNode(father, static_cast<SgMove>(index),
+                       random.Int(201) - 100);
+        if (depth > 1)
+            AddRandomTree(search, index, depth - 1, nuChildren, random,
+                          nuNodes);
+    }
+}
+
+/** Parallel search returns the same value as the sequential search.
+    The tree has a uniform depth, so the value is the negamax value of the
+    complete tree independent of the order in which the threads search. */
+BOOST_AUTO_TEST_CASE(SgSearchTest_Parallel)
+{
+    SgRandom random;
+    for (int n = 0; n < 10; ++n)
+    {
+        TestSearch search;
+        search.AddNode(TestSearch::NO_NODE, SG_NULLMOVE, 0);
+        size_t nuNodes = 1;
+        AddRandomTree(search, 0, 5, 5, random, nuNodes);
+        SgSearchHashTable hashTable(1 << 12);
+        search.SetHashTable(&hashTable);
+        SgVector<SgMove> sequence;
+        const int value =
+            search.IteratedSearch(1, 10, -1000, 1000, &sequence, true, 0);
+        BOOST_CHECK_EQUAL(search.Statistics().DepthReached(), 6);
+        BOOST_CHECK(search.Statistics().DepthTime(5) >= 0);
+        BOOST_CHECK_EQUAL(search.Statistics().DepthTime(7), -1);
+        search.SetNumberThreads(4);
+        SgVector<SgMove> parallelSequence;
+        BOOST_CHECK_EQUAL(search.IteratedSearch(1, 10, -1000, 1000,
+                                                &parallelSequence, true, 0),
+                          value);
+        BOOST_CHECK_EQUAL(parallelSequence.Length(), 5);
+        BOOST_CHECK(search.Statistics().DepthTime(5) >= 0);
+    }
+}
+
 } // namespace
 
 //----------------------------------------------------------------------------
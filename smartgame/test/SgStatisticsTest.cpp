@@ -93,6 +93,46 @@ BOOST_AUTO_TEST_CASE(SgStatisticsTest_Basics)
     BOOST_CHECK_CLOSE(statistics2.Deviation(), 1.547, 0.1);
 }
 
+BOOST_AUTO_TEST_CASE(SgStatisticsTest_AddStatistics)
+{
+    typedef SgStatistics<double,std::size_t> Statistics;
+    const double values[] = { 1.0, 2.0, 3.0, -1.0, 2.5, 2.5, 2.7 };
+    Statistics all;
+    Statistics statistics1;
+    Statistics statistics2;
+    for (int i = 0; i < 7; ++i)
+    {
+        all.Add(values[i]);
+        (i < 3 ? statistics1 : statistics2).Add(values[i]);
+    }
+    Statistics empty;
+    statistics1.Add(empty);
+    BOOST_CHECK_EQUAL(statistics1.Count(), 3u);
+    statistics1.Add(statistics2);
+    BOOST_CHECK_EQUAL(statistics1.Count(), all.Count());
+    BOOST_CHECK_CLOSE(statistics1.Mean(), all.Mean(), 1e-6);
+    BOOST_CHECK_CLOSE(statistics1.Deviation(), all.Deviation(), 1e-6);
+    empty.Add(statistics2);
+    BOOST_CHECK_EQUAL(empty.Count(), 4u);
+    BOOST_CHECK_CLOSE(empty.Mean(), statistics2.Mean(), 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(SgStatisticsExtTest_AddStatistics)
+{
+    typedef SgStatisticsExt<double,std::size_t> Statistics;
+    Statistics statistics1;
+    statistics1.Add(1.0);
+    statistics1.Add(3.0);
+    Statistics statistics2;
+    statistics2.Add(-1.0);
+    statistics2.Add(2.0);
+    statistics1.Add(statistics2);
+    BOOST_CHECK_EQUAL(statistics1.Count(), 4u);
+    BOOST_CHECK_CLOSE(statistics1.Mean(), 1.25, 1e-6);
+    BOOST_CHECK_EQUAL(statistics1.Min(), -1.0);
+    BOOST_CHECK_EQUAL(statistics1.Max(), 3.0);
+}
+
 //----------------------------------------------------------------------------
 
 BOOST_AUTO_TEST_CASE(SgHistogramTest_Basics)
@@ -0,0 +1,94 @@
+//----------------------------------------------------------------------------
+/** @file SgUctProfileTest.cpp
+    Unit tests for SgUctPhaseProfile. */
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+
+#include <sstream>
+#include <boost/test/auto_unit_test.hpp>
+#include "SgUctProfile.h"
+
+using namespace std;
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+BOOST_AUTO_TEST_CASE(SgUctPhaseProfileTest_Add)
+{
+    SgUctPhaseProfile profile;
+    profile.Add(SG_UCTPHASE_PLAYOUT, 0);
+    profile.Add(SG_UCTPHASE_PLAYOUT, 1);
+    profile.Add(SG_UCTPHASE_PLAYOUT, 1000);
+    profile.Add(SG_UCTPHASE_PLAYOUT, 1023);
+    profile.Add(SG_UCTPHASE_EXPAND, 1024);
+    BOOST_CHECK_EQUAL(profile.Count(SG_UCTPHASE_PLAYOUT), 4u);
+    BOOST_CHECK_EQUAL(profile.Time(SG_UCTPHASE_PLAYOUT), 2024u);
+    BOOST_CHECK_EQUAL(profile.Count(SG_UCTPHASE_PLAYOUT, 0), 2u);
+    BOOST_CHECK_EQUAL(profile.Count(SG_UCTPHASE_PLAYOUT, 9), 2u);
+    BOOST_CHECK_EQUAL(profile.Count(SG_UCTPHASE_EXPAND), 1u);
+    BOOST_CHECK_EQUAL(profile.Count(SG_UCTPHASE_EXPAND, 10), 1u);
+    BOOST_CHECK_EQUAL(profile.Count(SG_UCTPHASE_SELECT), 0u);
+}
+
+/** Test that very long intervals are counted in the last bin. */
+BOOST_AUTO_TEST_CASE(SgUctPhaseProfileTest_AddLastBin)
+{
+    SgUctPhaseProfile profile;
+    profile.Add(SG_UCTPHASE_LOCK, ~uint64_t(0));
+    BOOST_CHECK_EQUAL(profile.Count(SG_UCTPHASE_LOCK,
+                                    SgUctPhaseProfile::NU_BINS - 1), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(SgUctPhaseProfileTest_AddProfile)
+{
+    SgUctPhaseProfile profile1;
+    profile1.Add(SG_UCTPHASE_SELECT, 10);
+    profile1.Add(SG_UCTPHASE_UPDATE_TREE, 20);
+    SgUctPhaseProfile profile2;
+    profile2.Add(SG_UCTPHASE_SELECT, 12);
+    profile2.Add(SG_UCTPHASE_UPDATE_RAVE, 100);
+    profile1.Add(profile2);
+    BOOST_CHECK_EQUAL(profile1.Count(SG_UCTPHASE_SELECT), 2u);
+    BOOST_CHECK_EQUAL(profile1.Time(SG_UCTPHASE_SELECT), 22u);
+    BOOST_CHECK_EQUAL(profile1.Count(SG_UCTPHASE_SELECT, 3), 2u);
+    BOOST_CHECK_EQUAL(profile1.Count(SG_UCTPHASE_UPDATE_TREE), 1u);
+    BOOST_CHECK_EQUAL(profile1.Count(SG_UCTPHASE_UPDATE_RAVE), 1u);
+    profile1.Clear();
+    BOOST_CHECK_EQUAL(profile1.Count(SG_UCTPHASE_SELECT), 0u);
+    BOOST_CHECK_EQUAL(profile1.Time(SG_UCTPHASE_SELECT), 0u);
+    BOOST_CHECK_EQUAL(profile1.Count(SG_UCTPHASE_SELECT, 3), 0u);
+}
+
+/** Test that Lap() measures time only if SG_UCT_PROFILE is enabled. */
+BOOST_AUTO_TEST_CASE(SgUctPhaseProfileTest_Lap)
+{
+    SgUctPhaseProfile profile;
+    profile.Start();
+    {
+        SgUctPhaseScope scope(profile, SG_UCTPHASE_SELECT,
+                              SG_UCTPHASE_EXPAND);
+    }
+    profile.Lap(SG_UCTPHASE_PLAYOUT);
+    const uint64_t count = (SG_UCT_PROFILE ? 1 : 0);
+    BOOST_CHECK_EQUAL(profile.Count(SG_UCTPHASE_SELECT), count);
+    BOOST_CHECK_EQUAL(profile.Count(SG_UCTPHASE_EXPAND), count);
+    BOOST_CHECK_EQUAL(profile.Count(SG_UCTPHASE_PLAYOUT), count);
+    BOOST_CHECK_EQUAL(profile.Count(SG_UCTPHASE_EVALUATE), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(SgUctPhaseProfileTest_Write)
+{
+    SgUctPhaseProfile profile;
+    profile.Add(SG_UCTPHASE_PLAYOUT, 3000);
+    ostringstream out;
+    profile.Write(out);
+    BOOST_CHECK(out.str().find("Playout") != string::npos);
+    BOOST_CHECK(out.str().find("Playout[2048ns]") != string::npos);
+    BOOST_CHECK(out.str().find("Select[") == string::npos);
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
@@ -5,11 +5,16 @@
 
 #include "SgSystem.h"
 
+#include <limits>
+#include <map>
 #include <sstream>
 #include <vector>
 #include <boost/test/auto_unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
 #include "SgDebug.h"
+#include "SgSharedMemorySynchronizer.h"
 #include "SgUctSearch.h"
 #include "SgUctTreeUtil.h"
 
@@ -63,6 +68,11 @@ struct TestNode
     float m_eval;
 
     bool m_isLeaf;
+
+    /** Identifier of the position for SgUctThreadState::PositionHash().
+        Initialized with the node index, nodes with the same identifier
+        represent transpositions. */
+    size_t m_position;
 };
 
 //----------------------------------------------------------------------------
@@ -74,7 +84,8 @@ class TestThreadState
     : public SgUctThreadState
 {
 public:
-    TestThreadState(unsigned int threadId, const vector<TestNode>& nodes);
+    TestThreadState(unsigned int threadId, const vector<TestNode>& nodes,
+                    int moveRange);
 
 
     /** @name Virtual functions of SgUctThreadState */
@@ -91,6 +102,8 @@ public:
 
     SgMove GeneratePlayoutMove(bool& skipRaveUpdate);
 
+    SgHashCode PositionHash() const;
+
     void StartSearch();
 
     void TakeBackInTree(size_t nuMoves);
@@ -116,8 +129,9 @@ private:
 };
 
 TestThreadState::TestThreadState(unsigned int threadId,
-                                 const vector<TestNode>& nodes)
-    : SgUctThreadState(threadId),
+                                 const vector<TestNode>& nodes,
+                                 int moveRange)
+    : SgUctThreadState(threadId, moveRange),
       m_currentNode(0),
       m_toPlay(SG_BLACK),
       m_nodes(nodes)
@@ -209,6 +223,11 @@ SgMove TestThreadState::GeneratePlayoutMove(bool& skipRaveUpdate)
         return moves.begin()->m_move;
 }
 
+SgHashCode TestThreadState::PositionHash() const
+{
+    return SgHashCode(static_cast<unsigned int>(CurrentNode().m_position + 1));
+}
+
 inline const TestNode& TestThreadState::Node(size_t index) const
 {
     SG_ASSERT(index < m_nodes.size());
@@ -251,23 +270,27 @@ class TestThreadStateFactory
     : public SgUctThreadStateFactory
 {
 public:
-    TestThreadStateFactory(const vector<TestNode>& nodes);
+    TestThreadStateFactory(const vector<TestNode>& nodes, int moveRange);
 
     SgUctThreadState* Create(unsigned int threadId, const SgUctSearch& search);
 
 private:
     const vector<TestNode>& m_nodes;
+
+    int m_moveRange;
 };
 
-TestThreadStateFactory::TestThreadStateFactory(const vector<TestNode>& nodes)
-    : m_nodes(nodes)
+TestThreadStateFactory::TestThreadStateFactory(const vector<TestNode>& nodes,
+                                               int moveRange)
+    : m_nodes(nodes),
+      m_moveRange(moveRange)
 { }
 
 SgUctThreadState* TestThreadStateFactory::Create(unsigned int threadId,
                                                  const SgUctSearch& search)
 {
     SG_UNUSED(search);
-    return new TestThreadState(threadId, m_nodes);
+    return new TestThreadState(threadId, m_nodes, m_moveRange);
 }
 
 //----------------------------------------------------------------------------
@@ -278,7 +301,9 @@ class TestUctSearch
     : public SgUctSearch
 {
 public:
-    TestUctSearch();
+    /** Constructor.
+        @param moveRange See SgUctSearch::SgUctSearch(), needed for RAVE */
+    TestUctSearch(int moveRange = 0);
 
     ~TestUctSearch();
 
@@ -294,6 +319,9 @@ public:
         @param father Index of father node, NO_NODE if root node. */
     void AddNode(size_t father, SgMove move);
 
+    /** Let a node represent the same position as another node. */
+    void SetSamePosition(size_t node, size_t otherNode);
+
     // @} // @name
 
     /** @name Virtual functions of SgUctSearch */
@@ -311,8 +339,8 @@ private:
     void AddNode(size_t father, SgMove move, bool isLeaf, float eval);
 };
 
-TestUctSearch::TestUctSearch()
-    : SgUctSearch(new TestThreadStateFactory(m_nodes))
+TestUctSearch::TestUctSearch(int moveRange)
+    : SgUctSearch(new TestThreadStateFactory(m_nodes, moveRange), moveRange)
 { }
 
 TestUctSearch::~TestUctSearch()
@@ -356,9 +384,17 @@ void TestUctSearch::AddNode(size_t father, SgMove move, bool isLeaf,
     node.m_move = move;
     node.m_eval = eval;
     node.m_isLeaf = isLeaf;
+    node.m_position = index;
     m_nodes.push_back(node);
 }
 
+void TestUctSearch::SetSamePosition(size_t node, size_t otherNode)
+{
+    SG_ASSERT(node < m_nodes.size());
+    SG_ASSERT(otherNode < m_nodes.size());
+    m_nodes[node].m_position = m_nodes[otherNode].m_position;
+}
+
 string TestUctSearch::MoveString(SgMove move) const
 {
     ostringstream buffer;
@@ -368,9 +404,10 @@ string TestUctSearch::MoveString(SgMove move) const
 
 SgUctValue TestUctSearch::UnknownEval() const
 {
-    // UnknownEval() is only called by SgUctSearch if maximum game length was
-    // exceeded, which should not happen with Search
-    SG_ASSERT(false);
+    // UnknownEval() is called by SgUctSearch if maximum game length was
+    // exceeded, which should not happen with the test trees, or if a game
+    // was aborted, because the tree was full and could not be pruned
+    // incrementally (possible in SgUctSearchTest_IncrementalPruneConcurrent)
     return 0;
 }
 
@@ -423,8 +460,8 @@ BOOST_AUTO_TEST_CASE(SgUctSearchTest_Simple)
     {
         const SgUctGameInfo& info = search.LastGameInfo();
         BOOST_CHECK_CLOSE(SgUctValue(0.0), info.m_eval[0], 1e-3f);
-        const vector<SgMove>& sequence = info.m_sequence[0];
-        BOOST_CHECK_EQUAL(2u, sequence.size());
+        const SgUctGameSequence& sequence = info.m_sequence[0];
+        BOOST_CHECK_EQUAL(2u, sequence.Size());
         BOOST_CHECK_EQUAL(1, sequence[0]);
         BOOST_CHECK_EQUAL(5, sequence[1]);
         const SgUctTree& tree = search.Tree();
@@ -444,8 +481,8 @@ BOOST_AUTO_TEST_CASE(SgUctSearchTest_Simple)
     {
         const SgUctGameInfo& info = search.LastGameInfo();
         BOOST_CHECK_CLOSE(SgUctValue(0.0), info.m_eval[0], 1e-3f);
-        const vector<SgMove>& sequence = info.m_sequence[0];
-        BOOST_CHECK_EQUAL(2u, sequence.size());
+        const SgUctGameSequence& sequence = info.m_sequence[0];
+        BOOST_CHECK_EQUAL(2u, sequence.Size());
         BOOST_CHECK_EQUAL(1, sequence[0]);
         BOOST_CHECK_EQUAL(5, sequence[1]);
         const SgUctTree& tree = search.Tree();
@@ -467,8 +504,8 @@ BOOST_AUTO_TEST_CASE(SgUctSearchTest_Simple)
     {
         const SgUctGameInfo& info = search.LastGameInfo();
         BOOST_CHECK_CLOSE(SgUctValue(1.0), info.m_eval[0], 1e-3f);
-        const vector<SgMove>& sequence = info.m_sequence[0];
-        BOOST_CHECK_EQUAL(2u, sequence.size());
+        const SgUctGameSequence& sequence = info.m_sequence[0];
+        BOOST_CHECK_EQUAL(2u, sequence.Size());
         BOOST_CHECK_EQUAL(2, sequence[0]);
         BOOST_CHECK_EQUAL(7, sequence[1]);
         const SgUctTree& tree = search.Tree();
@@ -490,8 +527,8 @@ BOOST_AUTO_TEST_CASE(SgUctSearchTest_Simple)
     {
         const SgUctGameInfo& info = search.LastGameInfo();
         BOOST_CHECK_CLOSE(SgUctValue(1.0), info.m_eval[0], 1e-3f);
-        const vector<SgMove>& sequence = info.m_sequence[0];
-        BOOST_CHECK_EQUAL(2u, sequence.size());
+        const SgUctGameSequence& sequence = info.m_sequence[0];
+        BOOST_CHECK_EQUAL(2u, sequence.Size());
         BOOST_CHECK_EQUAL(3, sequence[0]);
         BOOST_CHECK_EQUAL(9, sequence[1]);
         const SgUctTree& tree = search.Tree();
@@ -513,8 +550,8 @@ BOOST_AUTO_TEST_CASE(SgUctSearchTest_Simple)
     {
         const SgUctGameInfo& info = search.LastGameInfo();
         BOOST_CHECK_CLOSE(SgUctValue(0.0), info.m_eval[0], 1e-3f);
-        const vector<SgMove>& sequence = info.m_sequence[0];
-        BOOST_CHECK_EQUAL(2u, sequence.size());
+        const SgUctGameSequence& sequence = info.m_sequence[0];
+        BOOST_CHECK_EQUAL(2u, sequence.Size());
         BOOST_CHECK_EQUAL(4, sequence[0]);
         BOOST_CHECK_EQUAL(11, sequence[1]);
         const SgUctTree& tree = search.Tree();
@@ -559,8 +596,8 @@ BOOST_AUTO_TEST_CASE(SgUctSearchTest_Knowledge)
     {
         const SgUctGameInfo& info = search.LastGameInfo();
         BOOST_CHECK_CLOSE(SgUctValue(0.0), info.m_eval[0], 1e-3f);
-        const vector<SgMove>& sequence = info.m_sequence[0];
-        BOOST_CHECK_EQUAL(1u, sequence.size());
+        const SgUctGameSequence& sequence = info.m_sequence[0];
+        BOOST_CHECK_EQUAL(1u, sequence.Size());
         BOOST_CHECK_EQUAL(1, sequence[0]);
         const SgUctTree& tree = search.Tree();
         BOOST_CHECK_EQUAL(1u, tree.NuNodes());
@@ -579,8 +616,8 @@ BOOST_AUTO_TEST_CASE(SgUctSearchTest_Knowledge)
     {
         const SgUctGameInfo& info = search.LastGameInfo();
         BOOST_CHECK_CLOSE(SgUctValue(0.0), info.m_eval[0], 1e-3f);
-        const vector<SgMove>& sequence = info.m_sequence[0];
-        BOOST_CHECK_EQUAL(1u, sequence.size());
+        const SgUctGameSequence& sequence = info.m_sequence[0];
+        BOOST_CHECK_EQUAL(1u, sequence.Size());
         BOOST_CHECK_EQUAL(1, sequence[0]);
         const SgUctTree& tree = search.Tree();
         BOOST_CHECK_EQUAL(4u, tree.NuNodes());
@@ -602,8 +639,8 @@ BOOST_AUTO_TEST_CASE(SgUctSearchTest_Knowledge)
     {
         const SgUctGameInfo& info = search.LastGameInfo();
         BOOST_CHECK_CLOSE(SgUctValue(1.0), info.m_eval[0], 1e-3f);
-        const vector<SgMove>& sequence = info.m_sequence[0];
-        BOOST_CHECK_EQUAL(1u, sequence.size());
+        const SgUctGameSequence& sequence = info.m_sequence[0];
+        BOOST_CHECK_EQUAL(1u, sequence.Size());
         BOOST_CHECK_EQUAL(2, sequence[0]);
         const SgUctTree& tree = search.Tree();
         BOOST_CHECK_EQUAL(4u, tree.NuNodes());
@@ -625,8 +662,8 @@ BOOST_AUTO_TEST_CASE(SgUctSearchTest_Knowledge)
     {
         const SgUctGameInfo& info = search.LastGameInfo();
         BOOST_CHECK_CLOSE(SgUctValue(1.0), info.m_eval[0], 1e-3f);
-        const vector<SgMove>& sequence = info.m_sequence[0];
-        BOOST_CHECK_EQUAL(0u, sequence.size());
+        const SgUctGameSequence& sequence = info.m_sequence[0];
+        BOOST_CHECK_EQUAL(0u, sequence.Size());
         const SgUctTree& tree = search.Tree();
         BOOST_CHECK_EQUAL(4u, tree.NuNodes());
         BOOST_CHECK_EQUAL(4u, tree.Root().MoveCount());
@@ -638,6 +675,557 @@ BOOST_AUTO_TEST_CASE(SgUctSearchTest_Knowledge)
 
 //----------------------------------------------------------------------------
 
+/** Check that the knowledge computed by SgUctSearch::KnowledgeWorkers() is
+    merged into the tree.
+    The knowledge of the test search replaces the last child by move 100
+    with a prior count of 10, so the last child of each node has move 100.
+    Leaves have value 0.5 so no node gets proven.
+    @verbatim
+    0--1---3    0.5
+    |  \--100   0.5
+    \--100--4   0.5
+        \--100  0.5
+    @endverbatim */
+BOOST_AUTO_TEST_CASE(SgUctSearchTest_KnowledgeWorkers)
+{
+    TestUctSearch search;
+    search.SetExpandThreshold(1);
+    std::vector<SgUctValue> thresholds(1, 2);
+    search.SetKnowledgeThreshold(thresholds);
+    search.SetKnowledgeWorkers(1);
+    search.AddNode(NO_NODE, SG_NULLMOVE);
+    search.AddNode(0, 1);
+    search.AddNode(0, 100);
+    search.AddLeafNode(1, 3, 0.5f);
+    search.AddLeafNode(1, 100, 0.5f);
+    search.AddLeafNode(2, 4, 0.5f);
+    search.AddLeafNode(2, 100, 0.5f);
+    search.StartSearch();
+    // A game adds at most one to the count of a node, the merged knowledge
+    // adds the prior count of 10
+    bool isMerged = false;
+    SgUctValue lastCount = 0;
+    for (int i = 0; i < 1000 && ! isMerged; ++i)
+    {
+        search.PlayGame();
+        const SgUctTree& tree = search.Tree();
+        const SgUctNode* node = GetNode(tree, 1);
+        if (node == 0 || ! node->HasChildren())
+            continue;
+        const SgUctNode* child =
+            SgUctTreeUtil::FindChildWithMove(tree, *node, 100);
+        if (child == 0)
+            continue;
+        isMerged = (child->MoveCount() >= lastCount + 10);
+        lastCount = child->MoveCount();
+        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+    BOOST_CHECK(isMerged);
+    search.EndSearch();
+}
+
+//----------------------------------------------------------------------------
+
+/** Check that no updates get lost in a multi-threaded search in atomic mode.
+    The position count of a node is incremented together with the move count
+    of the child that was played, so they must be equal after the search, if
+    all updates were done atomically.
+    Uses the same test tree as SgUctSearchTest_Simple. */
+BOOST_AUTO_TEST_CASE(SgUctSearchTest_AtomicTree)
+{
+    TestUctSearch search;
+    search.SetExpandThreshold(1);
+    search.SetNumberThreads(4);
+    search.SetAtomicTree(true);
+    search.SetLockFree(false);
+    search.AddNode(NO_NODE, SG_NULLMOVE);
+    search.AddNode(0, 1);
+    search.AddNode(0, 2);
+    search.AddNode(0, 3);
+    search.AddNode(0, 4);
+    search.AddLeafNode(1, 5, 0.f);
+    search.AddLeafNode(1, 6, 1.f);
+    search.AddLeafNode(2, 7, 1.f);
+    search.AddLeafNode(2, 8, 1.f);
+    search.AddLeafNode(3, 9, 1.f);
+    search.AddLeafNode(3, 10, 0.f);
+    search.AddLeafNode(4, 11, 0.f);
+    search.AddLeafNode(4, 12, 0.f);
+    vector<SgMove> sequence;
+    search.Search(10000, numeric_limits<double>::max(), sequence);
+    const SgUctTree& tree = search.Tree();
+    for (SgUctTreeIterator it(tree); it; ++it)
+    {
+        const SgUctNode& node = *it;
+        if (! node.HasChildren())
+            continue;
+        SgUctValue childCount = 0;
+        for (SgUctChildIterator it2(tree, node); it2; ++it2)
+            childCount += (*it2).MoveCount();
+        BOOST_CHECK_EQUAL(node.PosCount(), childCount);
+    }
+}
+
+//----------------------------------------------------------------------------
+
+/** Check that SgUctSearch::IncrementalPrune() keeps the search running in a
+    tree that is too small.
+    Uses a test tree with 4 nodes in the first level, 3 children per node in
+    the second level and 2 leaves per node in the third level. The maximum
+    tree size per thread allows only one expanded node in the first level,
+    so that no node gets proven. Tested with a single thread and with multiple threads
+    in atomic mode. */
+BOOST_AUTO_TEST_CASE(SgUctSearchTest_IncrementalPrune)
+{
+    for (int i = 0; i < 2; ++i)
+    {
+        TestUctSearch search;
+        search.SetExpandThreshold(1);
+        search.SetPruneMinCount(4);
+        // Avoid that the search stops, because the best move cannot change
+        search.SetMoveSelect(SG_UCTMOVESELECT_VALUE);
+        if (i == 1)
+        {
+            search.SetNumberThreads(4);
+            search.SetAtomicTree(true);
+            search.SetLockFree(false);
+        }
+        // Maximum number of nodes is divided between the threads
+        const size_t maxNodes = 8 * search.NumberThreads();
+        search.SetMaxNodes(maxNodes);
+        search.AddNode(NO_NODE, SG_NULLMOVE);
+        int nodeIndex = 1;
+        for (int level1 = 0; level1 < 4; ++level1)
+        {
+            int node1 = nodeIndex++;
+            search.AddNode(0, node1);
+            for (int level2 = 0; level2 < 3; ++level2)
+            {
+                int node2 = nodeIndex++;
+                search.AddNode(node1, node2);
+                for (int level3 = 0; level3 < 2; ++level3)
+                {
+                    int node3 = nodeIndex++;
+                    float eval = (node3 % 3 == 0 ? 1.f : 0.f);
+                    search.AddLeafNode(node2, node3, eval);
+                }
+            }
+        }
+        vector<SgMove> sequence;
+        search.Search(1000, numeric_limits<double>::max(), sequence);
+        const SgUctSearchStat& stat = search.Statistics();
+        BOOST_CHECK(stat.m_prunedNodes > 0);
+        BOOST_CHECK(stat.m_pruneTime.Count() > 0);
+        BOOST_CHECK(search.Tree().NuNodes() <= maxNodes + 1);
+        BOOST_CHECK(search.Tree().Root().MoveCount() >= 1000);
+    }
+}
+
+/** Check SgUctSearch::IncrementalPrune() while other threads search.
+    The threads search a tree with 4 levels and 4 children per node without
+    a global lock (lock-free mode with atomic tree updates). The maximum
+    tree size is small, such that the pruning thread detaches children of
+    nodes that other threads are selecting a child of or iterating over.
+    The search must play all games and keep the tree consistent. */
+BOOST_AUTO_TEST_CASE(SgUctSearchTest_IncrementalPruneConcurrent)
+{
+    TestUctSearch search;
+    search.SetExpandThreshold(1);
+    search.SetPruneMinCount(4);
+    search.SetNumberThreads(4);
+    search.SetAtomicTree(true);
+    search.SetLockFree(true);
+    search.SetVirtualLoss(true);
+    // Avoid that the search stops, because the best move cannot change
+    search.SetMoveSelect(SG_UCTMOVESELECT_VALUE);
+    const size_t maxNodes = 16 * search.NumberThreads();
+    search.SetMaxNodes(maxNodes);
+    search.AddNode(NO_NODE, SG_NULLMOVE);
+    const int nuLevels = 4;
+    const int nuChildren = 4;
+    vector<size_t> level(1, 0);
+    size_t nodeIndex = 1;
+    for (int i = 1; i <= nuLevels; ++i)
+    {
+        vector<size_t> nextLevel;
+        for (size_t j = 0; j < level.size(); ++j)
+            for (int k = 0; k < nuChildren; ++k)
+            {
+                const SgMove move = SgMove(nodeIndex);
+                if (i == nuLevels)
+                    search.AddLeafNode(level[j], move,
+                                       nodeIndex % 3 == 0 ? 1.f : 0.f);
+                else
+                    search.AddNode(level[j], move);
+                nextLevel.push_back(nodeIndex++);
+            }
+        level.swap(nextLevel);
+    }
+    vector<SgMove> sequence;
+    search.Search(20000, numeric_limits<double>::max(), sequence);
+    const SgUctSearchStat& stat = search.Statistics();
+    BOOST_CHECK(stat.m_prunedNodes > 0);
+    BOOST_CHECK(search.Tree().NuNodes() <= maxNodes + 1);
+    BOOST_CHECK(search.Tree().Root().MoveCount() >= 20000);
+    search.Tree().CheckConsistency();
+}
+
+/** Check SgUctSearch::IncrementalPrune() while knowledge results are
+    pending.
+    Like SgUctSearchTest_IncrementalPruneConcurrent, but the knowledge is
+    computed by SgUctSearch::KnowledgeWorkers(). The tree is so small that
+    nodes are detached while results for them are queued or merged. The
+    last child of each node has move 100, which the knowledge of the test
+    search adds. The search must play all games and keep the tree
+    consistent. */
+BOOST_AUTO_TEST_CASE(SgUctSearchTest_IncrementalPruneKnowledgeWorkers)
+{
+    TestUctSearch search;
+    search.SetExpandThreshold(1);
+    search.SetPruneMinCount(4);
+    search.SetNumberThreads(4);
+    search.SetAtomicTree(true);
+    search.SetLockFree(true);
+    search.SetKnowledgeWorkers(2);
+    std::vector<SgUctValue> thresholds(1, 2);
+    search.SetKnowledgeThreshold(thresholds);
+    // Avoid that the search stops, because the best move cannot change
+    search.SetMoveSelect(SG_UCTMOVESELECT_VALUE);
+    const size_t maxNodes = 16 * search.NumberThreads();
+    search.SetMaxNodes(maxNodes);
+    search.AddNode(NO_NODE, SG_NULLMOVE);
+    const int nuLevels = 4;
+    const int nuChildren = 4;
+    vector<size_t> level(1, 0);
+    size_t nodeIndex = 1;
+    for (int i = 1; i <= nuLevels; ++i)
+    {
+        vector<size_t> nextLevel;
+        for (size_t j = 0; j < level.size(); ++j)
+            for (int k = 0; k < nuChildren; ++k)
+            {
+                const SgMove move =
+                    (k == nuChildren - 1 ? 100 : SgMove(nodeIndex + 100));
+                if (i == nuLevels)
+                    search.AddLeafNode(level[j], move,
+                                       nodeIndex % 3 == 0 ? 1.f : 0.f);
+                else
+                    search.AddNode(level[j], move);
+                nextLevel.push_back(nodeIndex++);
+            }
+        level.swap(nextLevel);
+    }
+    vector<SgMove> sequence;
+    search.Search(20000, numeric_limits<double>::max(), sequence);
+    const SgUctSearchStat& stat = search.Statistics();
+    BOOST_CHECK(stat.m_knowledge > 0);
+    BOOST_CHECK(stat.m_prunedNodes > 0);
+    BOOST_CHECK(search.Tree().NuNodes() <= maxNodes + 1);
+    BOOST_CHECK(search.Tree().Root().MoveCount() >= 20000);
+    search.Tree().CheckConsistency();
+}
+
+/** Test SgUctSearch::Transpositions().
+    @verbatim
+    Numbers are node indices; L = Loss, W = Win for player at root
+    0--1--3--5  W
+    |     \--6  L
+    \--2--4--7  W
+             \--8  L
+    @endverbatim
+    Nodes 3 and 4 are the same position reached by the move orders 1, 2 and
+    2, 1. With transpositions, the nodes in the search tree share their
+    children, without transpositions, they have separate children. */
+BOOST_AUTO_TEST_CASE(SgUctSearchTest_Transpositions)
+{
+    for (int i = 0; i < 2; ++i)
+    {
+        const bool transpositions = (i == 1);
+        TestUctSearch search;
+        search.SetTranspositions(transpositions);
+        search.SetExpandThreshold(1);
+        search.AddNode(NO_NODE, SG_NULLMOVE);
+        search.AddNode(0, 1);
+        search.AddNode(0, 2);
+        search.AddNode(1, 2);
+        search.AddNode(2, 1);
+        search.AddLeafNode(3, 5, 1);
+        search.AddLeafNode(3, 6, 0);
+        search.AddLeafNode(4, 5, 1);
+        search.AddLeafNode(4, 6, 0);
+        search.SetSamePosition(4, 3);
+        vector<SgMove> sequence;
+        search.Search(100, numeric_limits<double>::max(), sequence);
+        const SgUctTree& tree = search.Tree();
+        const SgUctNode* node1 =
+            SgUctTreeUtil::FindChildWithMove(tree, *GetNode(tree, 1), 2);
+        const SgUctNode* node2 =
+            SgUctTreeUtil::FindChildWithMove(tree, *GetNode(tree, 2), 1);
+        BOOST_REQUIRE(node1 != 0);
+        BOOST_REQUIRE(node2 != 0);
+        BOOST_REQUIRE(node1->HasChildren());
+        BOOST_REQUIRE(node2->HasChildren());
+        const SgUctSearchStat& stat = search.Statistics();
+        if (transpositions)
+        {
+            BOOST_CHECK_EQUAL(node1->FirstChild(), node2->FirstChild());
+            BOOST_CHECK_EQUAL(stat.m_transpositions, 1u);
+            BOOST_CHECK_EQUAL(stat.m_sharedNodes, 2u);
+            // 7 nodes instead of 9
+            BOOST_CHECK_EQUAL(tree.NuNodes(), 7u);
+            // Statistics of the shared children include the games of both
+            // move orders
+            const SgUctNode* child = node1->FirstChild();
+            BOOST_CHECK(child[0].MoveCount() + child[1].MoveCount()
+                        > node1->MoveCount());
+        }
+        else
+        {
+            BOOST_CHECK(node1->FirstChild() != node2->FirstChild());
+            BOOST_CHECK_EQUAL(stat.m_transpositions, 0u);
+            BOOST_CHECK_EQUAL(tree.NuNodes(), 9u);
+        }
+    }
+}
+
+/** Test that SgUctSearch::Transpositions() does not create cycles.
+    @verbatim
+    Numbers are node indices; all leaves are draws, so that no node is
+    proven and all nodes are explored
+    0--1--2--3--6
+       |  |  \--7
+       |  \--5
+       \--4
+    @endverbatim
+    Node 3 repeats the position of node 1 (e.g. after a ko capture and
+    recapture) and has the same moves. Node 1 is on the path to node 3, so
+    node 3 must not share its children. */
+BOOST_AUTO_TEST_CASE(SgUctSearchTest_TranspositionsRepeatedPosition)
+{
+    TestUctSearch search;
+    search.SetTranspositions(true);
+    search.SetExpandThreshold(1);
+    // Avoid that the search stops, because the best move cannot change
+    search.SetMoveSelect(SG_UCTMOVESELECT_VALUE);
+    search.AddNode(NO_NODE, SG_NULLMOVE);
+    search.AddNode(0, 1);
+    search.AddNode(1, 2);
+    search.AddNode(2, 3);
+    search.AddLeafNode(1, 4, 0.5f);
+    search.AddLeafNode(2, 5, 0.5f);
+    search.AddLeafNode(3, 2, 0.5f);
+    search.AddLeafNode(3, 4, 0.5f);
+    search.SetSamePosition(3, 1);
+    vector<SgMove> sequence;
+    search.Search(100, numeric_limits<double>::max(), sequence);
+    const SgUctTree& tree = search.Tree();
+    const SgUctNode* node1 = GetNode(tree, 1);
+    BOOST_REQUIRE(node1 != 0);
+    const SgUctNode* node2 = SgUctTreeUtil::FindChildWithMove(tree, *node1, 2);
+    BOOST_REQUIRE(node2 != 0);
+    const SgUctNode* node3 = SgUctTreeUtil::FindChildWithMove(tree, *node2, 3);
+    BOOST_REQUIRE(node3 != 0);
+    BOOST_REQUIRE(node1->HasChildren());
+    BOOST_REQUIRE(node3->HasChildren());
+    BOOST_CHECK(node1->FirstChild() != node3->FirstChild());
+    BOOST_CHECK_EQUAL(search.Statistics().m_transpositions, 0u);
+    BOOST_CHECK_EQUAL(tree.NuNodes(), 8u);
+    tree.CheckConsistency();
+}
+
+//----------------------------------------------------------------------------
+
+void SearchWithMaxGames(TestUctSearch* search, SgUctValue maxGames)
+{
+    vector<SgMove> sequence;
+    search->Search(maxGames, numeric_limits<double>::max(), sequence);
+}
+
+/** Run a root-parallel search with SgSharedMemorySynchronizer.
+    Two searches in different threads simulate two processes. The second
+    search has no game limit and must be stopped by the first one. After the
+    search, both must have the combined counts of the root children. */
+void CheckSharedMemorySynchronizer(const char* name)
+{
+    TestUctSearch search[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        // Expand the root in the first game, such that all games are
+        // counted in the root children
+        search[i].SetExpandThreshold(0);
+        search[i].SetMpiSynchronizer(
+                                 SgSharedMemorySynchronizer::Create(name, i, 2));
+        search[i].AddNode(NO_NODE, SG_NULLMOVE);
+        search[i].AddNode(0, 1);
+        search[i].AddNode(0, 2);
+        search[i].AddNode(0, 3);
+        search[i].AddLeafNode(1, 4, 0.f);
+        search[i].AddLeafNode(1, 5, 1.f);
+        search[i].AddLeafNode(2, 6, 1.f);
+        search[i].AddLeafNode(2, 7, 0.f);
+        search[i].AddLeafNode(3, 8, 0.f);
+        search[i].AddLeafNode(3, 9, 0.f);
+    }
+    boost::thread thread1(boost::bind(SearchWithMaxGames, &search[1],
+                                      numeric_limits<SgUctValue>::max()));
+    // Start the first search after the second one has expanded its root,
+    // otherwise it could be stopped before playing a game
+    while (! search[1].Tree().Root().HasChildren())
+        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    boost::thread thread0(boost::bind(SearchWithMaxGames, &search[0], 100));
+    thread0.join();
+    thread1.join();
+    SgUctValue childCount = 0;
+    for (SgMove move = 1; move <= 3; ++move)
+    {
+        const SgUctNode* node0 = GetNode(search[0].Tree(), move);
+        const SgUctNode* node1 = GetNode(search[1].Tree(), move);
+        BOOST_REQUIRE(node0 != 0);
+        BOOST_REQUIRE(node1 != 0);
+        BOOST_CHECK_EQUAL(node0->MoveCount(), node1->MoveCount());
+        childCount += node0->MoveCount();
+    }
+    BOOST_CHECK_EQUAL(childCount, search[0].Tree().Root().MoveCount());
+    BOOST_CHECK_EQUAL(childCount, search[1].Tree().Root().MoveCount());
+}
+
+BOOST_AUTO_TEST_CASE(SgUctSearchTest_SharedMemorySynchronizer)
+{
+    const char* name = "SgUctSearchTest_SharedMemorySynchronizer";
+    boost::interprocess::shared_memory_object::remove(name);
+    CheckSharedMemorySynchronizer(name);
+}
+
+/** Test that SgSharedMemorySynchronizer replaces a stale segment.
+    A segment with the same name and a different layout is left over, like
+    after a process terminated abnormally. The root process must create a
+    new segment instead of using the old one. */
+BOOST_AUTO_TEST_CASE(SgUctSearchTest_SharedMemorySynchronizerStaleSegment)
+{
+    using boost::interprocess::managed_shared_memory;
+    const char* name = "SgUctSearchTest_SharedMemorySynchronizerStale";
+    boost::interprocess::shared_memory_object::remove(name);
+    {
+        managed_shared_memory stale(boost::interprocess::create_only, name,
+                                    4096);
+        stale.construct<int>("Stale")(1);
+    }
+    CheckSharedMemorySynchronizer(name);
+    BOOST_CHECK_THROW(managed_shared_memory(boost::interprocess::open_only,
+                                            name),
+                      boost::interprocess::interprocess_exception);
+}
+
+/** Add a complete subtree to the test tree of SgUctSearchTest_RaveValues.
+    Each internal node has children with the moves 1, 2 and 3, so that
+    moves are repeated by both colors.
+    @param search The search
+    @param father Index of the root of the subtree
+    @param depth Depth of the subtree
+    @param[in,out] nuNodes Number of nodes in the test tree */
+void AddRaveTestTree(TestUctSearch& search, size_t father, int depth,
+                     size_t& nuNodes)
+{
+    for (SgMove move = 1; move <= 3; ++move)
+    {
+        size_t index = nuNodes++;
+        if (depth == 1)
+            search.AddLeafNode(father, move, index % 5 < 2 ? 1.f : 0.f);
+        else
+        {
+            search.AddNode(father, move);
+            AddRaveTestTree(search, index, depth - 1, nuNodes);
+        }
+    }
+}
+
+/** Sum of weights and weighted values of the RAVE updates of a node. */
+typedef map<const SgUctNode*, pair<double,double> > RaveSums;
+
+/** Add the RAVE updates of the last game computed directly from the
+    definition of the update in SgUctSearch::UpdateRaveValues(). */
+void AddRaveUpdates(const SgUctSearch& search, RaveSums& sums)
+{
+    const size_t notPlayed = numeric_limits<size_t>::max();
+    const SgUctGameInfo& info = search.LastGameInfo();
+    const SgUctGameSequence& sequence = info.m_sequence[0];
+    const size_t len = sequence.Size();
+    for (size_t i = 0; i < info.m_nodes.size() && i < len; ++i)
+    {
+        const SgUctNode& node = *info.m_nodes[i];
+        if (! node.HasChildren())
+            continue;
+        double eval = info.m_eval[0];
+        if (i % 2 != 0)
+            eval = 1 - eval;
+        for (SgUctChildIterator it(search.Tree(), node); it; ++it)
+        {
+            size_t first = notPlayed;
+            size_t firstOpp = notPlayed;
+            for (size_t j = len; j-- > i; )
+                if (sequence[j] == (*it).Move())
+                {
+                    if ((j - i) % 2 == 0)
+                        first = j;
+                    else
+                        firstOpp = j;
+                }
+            if (first == notPlayed)
+                continue;
+            if (search.RaveCheckSame() && firstOpp < first)
+                continue;
+            double weight = 1;
+            if (search.WeightRaveUpdates())
+                weight = 2 - double(first - i) / double(len - i);
+            sums[&(*it)].first += weight;
+            sums[&(*it)].second += weight * eval;
+        }
+    }
+}
+
+/** Check that the RAVE values match a direct computation of the updates
+    for all combinations of RAVE update parameters. */
+BOOST_AUTO_TEST_CASE(SgUctSearchTest_RaveValues)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        TestUctSearch search(4);
+        search.SetExpandThreshold(1);
+        search.SetRave(true);
+        search.SetRaveCheckSame(i % 2 != 0);
+        search.SetWeightRaveUpdates(i / 2 != 0);
+        search.AddNode(NO_NODE, SG_NULLMOVE);
+        size_t nuNodes = 1;
+        AddRaveTestTree(search, 0, 4, nuNodes);
+        search.StartSearch();
+        RaveSums sums;
+        for (int j = 0; j < 100; ++j)
+        {
+            search.PlayGame();
+            AddRaveUpdates(search, sums);
+        }
+        BOOST_CHECK(! sums.empty());
+        for (SgUctTreeIterator it(search.Tree()); it; ++it)
+        {
+            const SgUctNode& node = *it;
+            RaveSums::const_iterator sum = sums.find(&node);
+            if (sum == sums.end())
+            {
+                BOOST_CHECK(! node.HasRaveValue());
+                continue;
+            }
+            BOOST_REQUIRE(node.HasRaveValue());
+            BOOST_CHECK_CLOSE(SgUctValue(sum->second.first),
+                              node.RaveCount(), 1e-3f);
+            BOOST_CHECK_CLOSE(SgUctValue(sum->second.second
+                                         / sum->second.first),
+                              node.RaveValue(), 1e-3f);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+
 } // namespace
 
 //----------------------------------------------------------------------------
@@ -5,18 +5,68 @@
 
 #include "SgSystem.h"
 
+#include <cstdio>
+#include <fstream>
+#include <limits>
 #include <boost/test/auto_unit_test.hpp>
+#include <boost/bind.hpp>
 #include <boost/test/floating_point_comparison.hpp>
+#include "SgException.h"
+#include "SgPoint.h"
 #include "SgUctTree.h"
 #include "SgUctTreeUtil.h"
 
 using namespace std;
+using SgPointUtil::Pt;
 using SgUctTreeUtil::FindChildWithMove;
 
 //----------------------------------------------------------------------------
 
 namespace {
 
+/** Size of the header of a file written by SgUctTree::Save(). */
+const std::streamoff FILE_HEADER_SIZE = 40;
+
+/** Size of a node record in a file written by SgUctTree::Save(). */
+const std::streamoff FILE_NODE_SIZE = 64;
+
+/** Offset of the mean in a node record. */
+const std::streamoff FILE_NODE_MEAN_OFFSET = 8;
+
+/** Offset of the move in a node record. */
+const std::streamoff FILE_NODE_MOVE_OFFSET = 52;
+
+/** Overwrite a field of a node record in a file written by
+    SgUctTree::Save().
+    @param fileName
+    @param record The index of the record in depth-first order
+    @param offset The offset of the field in the record
+    @param value The new value of the field */
+template<typename T>
+void PatchTreeFileRecord(const char* fileName, int record,
+                         std::streamoff offset, T value)
+{
+    std::fstream file(fileName,
+                      std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(FILE_HEADER_SIZE + record * FILE_NODE_SIZE + offset);
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    BOOST_REQUIRE(file);
+}
+
+/** Merge the children of a node with alternating move lists until the
+    allocator is full.
+    Used in SgUctTreeTest_ShareChildrenWhileMerging. */
+void MergeChildrenUntilFull(SgUctTree* tree, const SgUctNode* node,
+                            const vector<SgUctMoveInfo>* moves1,
+                            const vector<SgUctMoveInfo>* moves2,
+                            boost::atomic<bool>* finished)
+{
+    for (int i = 0; tree->HasCapacity(0, moves2->size()); ++i)
+        tree->MergeChildren(0, *node, i % 2 == 0 ? *moves2 : *moves1,
+                            true);
+    finished->store(true);
+}
+
 /** Test SgUctTreeIterator on a small tree. */
 BOOST_AUTO_TEST_CASE(SgUctTreeIteratorTest_Simple)
 {
@@ -108,6 +158,325 @@ BOOST_AUTO_TEST_CASE(SgUctTreeIteratorTest_ApplyFilter)
     BOOST_CHECK_CLOSE((*it).Mean(), SgUctValue(0.5), 1e-4);
 }
 
+/** Test SgUctTree::DetachLowCount() and SgUctTree::ReclaimSubtrees() */
+BOOST_AUTO_TEST_CASE(SgUctTreeTest_DetachLowCount)
+{
+    SgUctTree tree;
+    tree.CreateAllocators(1);
+    tree.SetMaxNodes(6);
+    vector<SgUctMoveInfo> moves;
+    moves.push_back(SgUctMoveInfo(10));
+    moves.push_back(SgUctMoveInfo(20));
+    moves.push_back(SgUctMoveInfo(30));
+    const SgUctNode& root = tree.Root();
+    tree.CreateChildren(0, root, moves);
+    const SgUctNode& node1 = *FindChildWithMove(tree, root, 10);
+    const SgUctNode& node2 = *FindChildWithMove(tree, root, 20);
+    const SgUctNode& node3 = *FindChildWithMove(tree, root, 30);
+    tree.AddGameResult(node2, &root, 1.f);
+    for (int i = 0; i < 5; ++i)
+        tree.AddGameResult(node3, &root, 1.f);
+    moves.clear();
+    moves.push_back(SgUctMoveInfo(40));
+    moves.push_back(SgUctMoveInfo(50));
+    tree.CreateChildren(0, node2, moves);
+    const SgUctNode* firstChild2 = node2.FirstChild();
+    moves.clear();
+    moves.push_back(SgUctMoveInfo(60));
+    tree.CreateChildren(0, node3, moves);
+    BOOST_CHECK_EQUAL(tree.NuNodes(), 7u);
+    BOOST_CHECK(! tree.HasCapacity(0, 2));
+
+    vector<SgUctNodeBlock> detached;
+    BOOST_CHECK_EQUAL(tree.DetachLowCount(2, false, detached), 2u);
+    BOOST_CHECK(! node2.HasChildren());
+    BOOST_CHECK(node3.HasChildren());
+    BOOST_CHECK_EQUAL(detached.size(), 1u);
+    BOOST_CHECK(! tree.HasCapacity(0, 2));
+
+    BOOST_CHECK_EQUAL(tree.ReclaimSubtrees(detached), 2u);
+    BOOST_CHECK_EQUAL(tree.NuNodes(), 5u);
+    BOOST_CHECK(tree.HasCapacity(0, 2));
+    BOOST_CHECK(! tree.HasCapacity(0, 3));
+    moves.clear();
+    moves.push_back(SgUctMoveInfo(70));
+    tree.CreateChildren(0, node1, moves);
+    BOOST_CHECK_EQUAL(node1.FirstChild(), firstChild2);
+    BOOST_CHECK_EQUAL(tree.NuNodes(), 6u);
+    BOOST_CHECK(tree.HasCapacity(0, 1));
+    BOOST_CHECK(! tree.HasCapacity(0, 2));
+}
+
+/** Test SgUctTree::ShareChildren() while the children of the source are
+    merged in another thread.
+    The children of the source alternate between an array with two children
+    in row 1 and an array with five children in row 2. The shared children
+    must be a prefix of one of these arrays, a number of children that
+    belongs to a different array would make the node use children outside
+    of the array. */
+BOOST_AUTO_TEST_CASE(SgUctTreeTest_ShareChildrenWhileMerging)
+{
+    SgUctTree tree;
+    tree.CreateAllocators(1);
+    tree.SetMaxNodes(3000000);
+    vector<SgUctMoveInfo> moves;
+    moves.push_back(SgUctMoveInfo(Pt(1, 1)));
+    moves.push_back(SgUctMoveInfo(Pt(2, 1)));
+    const SgUctNode& root = tree.Root();
+    tree.CreateChildren(0, root, moves);
+    const SgUctNode& source = *FindChildWithMove(tree, root, Pt(1, 1));
+    const SgUctNode& node = *FindChildWithMove(tree, root, Pt(2, 1));
+    vector<SgUctMoveInfo> moves1;
+    for (int i = 1; i <= 2; ++i)
+        moves1.push_back(SgUctMoveInfo(Pt(i, 1)));
+    vector<SgUctMoveInfo> moves2;
+    for (int i = 1; i <= 5; ++i)
+        moves2.push_back(SgUctMoveInfo(Pt(i, 2)));
+    tree.CreateChildren(0, source, moves1);
+    boost::atomic<bool> finished(false);
+    boost::thread thread(boost::bind(MergeChildrenUntilFull, &tree, &source,
+                                     &moves1, &moves2, &finished));
+    int nuFailures = 0;
+    int nuShared = 0;
+    while (! finished.load())
+    {
+        if (! tree.ShareChildren(node, source))
+            continue;
+        ++nuShared;
+        const SgUctNode* firstChild;
+        const int nuChildren = node.GetChildren(firstChild);
+        // Not SgPointUtil::Row(), which asserts a point on the board
+        const int row = firstChild[0].Move() / SG_NS;
+        bool isValid = (row == 1 && nuChildren <= 2)
+                       || (row == 2 && nuChildren <= 5);
+        for (int i = 0; i < nuChildren; ++i)
+            if (firstChild[i].Move() / SG_NS != row)
+                isValid = false;
+        if (! isValid)
+            ++nuFailures;
+    }
+    thread.join();
+    BOOST_CHECK(nuShared > 0);
+    BOOST_CHECK_EQUAL(nuFailures, 0);
+}
+
+/** Test that SgUctTree::ExtractSubtree() with multiple allocators in the
+    target tree (parallel copy) gives the same tree as with one allocator. */
+BOOST_AUTO_TEST_CASE(SgUctTreeTest_ExtractSubtreeParallel)
+{
+    SgUctTree tree;
+    tree.CreateAllocators(1);
+    tree.SetMaxNodes(1000);
+    // Tree with 5 children at the root, 4 children per node in the second
+    // level, 3 in the third level and different counts
+    const SgUctNode& root = tree.Root();
+    vector<const SgUctNode*> nodes;
+    vector<int> depth;
+    nodes.push_back(&root);
+    depth.push_back(0);
+    SgMove nextMove = 1;
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (depth[i] == 3)
+            continue;
+        vector<SgUctMoveInfo> moves;
+        for (int j = 0; j < 5 - depth[i]; ++j)
+            moves.push_back(SgUctMoveInfo(nextMove++));
+        tree.CreateChildren(0, *nodes[i], moves);
+        for (SgUctChildIterator it(tree, *nodes[i]); it; ++it)
+        {
+            for (int k = 0; k <= (*it).Move() % 7; ++k)
+                tree.AddGameResult(*it, nodes[i], 1.f);
+            nodes.push_back(&(*it));
+            depth.push_back(depth[i] + 1);
+        }
+    }
+    for (int i = 0; i < 100; ++i)
+        tree.AddGameResult(root, 0, 0.f);
+    vector<SgUctValue> moveCounts[2];
+    vector<SgMove> moves[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        SgUctTree target;
+        target.CreateAllocators(i == 0 ? 1 : 4);
+        target.SetMaxNodes(1000);
+        tree.ExtractSubtree(target, root, true);
+        BOOST_CHECK_EQUAL(target.NuNodes(), tree.NuNodes());
+        target.CheckConsistency();
+        for (SgUctTreeIterator it(target); it; ++it)
+        {
+            moveCounts[i].push_back((*it).MoveCount());
+            // The root has no move
+            if ((*it).HasMove())
+                moves[i].push_back((*it).Move());
+        }
+    }
+    BOOST_CHECK(moveCounts[0] == moveCounts[1]);
+    BOOST_CHECK(moves[0] == moves[1]);
+}
+
+/** Test that SgUctTree::Load() restores a tree written by SgUctTree::Save().
+    Also checks that files for a different key, corrupt files and trees
+    that do not fit into the maximum number of nodes are rejected. */
+BOOST_AUTO_TEST_CASE(SgUctTreeTest_SaveLoad)
+{
+    const char* fileName = "SgUctTreeTest_SaveLoad.uct";
+    SgUctTree tree;
+    tree.CreateAllocators(1);
+    tree.SetMaxNodes(100);
+    const SgUctNode& root = tree.Root();
+    vector<SgUctMoveInfo> moves;
+    moves.push_back(SgUctMoveInfo(Pt(1, 1), 0.6f, 5, 0.4f, 12));
+    moves.push_back(SgUctMoveInfo(SG_PASS));
+    moves.back().m_predictorValue = 0.25f;
+    tree.CreateChildren(0, root, moves);
+    const SgUctNode& node2 = *FindChildWithMove(tree, root, SG_PASS);
+    moves.clear();
+    moves.push_back(SgUctMoveInfo(Pt(3, 3), 1.f, 2, 0.f, 0));
+    tree.CreateChildren(0, node2, moves);
+    tree.AddGameResult(root, 0, 0.5f);
+    tree.SetKnowledgeCount(node2, 7);
+    const SgUctNode& node3 = *FindChildWithMove(tree, node2, Pt(3, 3));
+    tree.SetProvenType(node3, SG_PROVEN_WIN);
+    tree.Save(fileName, 42);
+
+    SgUctTree loaded;
+    loaded.CreateAllocators(2);
+    loaded.SetMaxNodes(100);
+    BOOST_CHECK(! loaded.Load(fileName, 43));
+    BOOST_CHECK_EQUAL(loaded.NuNodes(), 1u);
+    BOOST_CHECK(loaded.Load(fileName, 42));
+    loaded.CheckConsistency();
+    BOOST_CHECK_EQUAL(loaded.NuNodes(), tree.NuNodes());
+    SgUctTreeIterator it1(tree);
+    SgUctTreeIterator it2(loaded);
+    for ( ; it1 && it2; ++it1, ++it2)
+    {
+        const SgUctNode& node = *it1;
+        const SgUctNode& loadedNode = *it2;
+        BOOST_CHECK_EQUAL(node.HasMove(), loadedNode.HasMove());
+        if (node.HasMove())
+            BOOST_CHECK_EQUAL(node.Move(), loadedNode.Move());
+        BOOST_CHECK_EQUAL(node.MoveCount(), loadedNode.MoveCount());
+        BOOST_CHECK_EQUAL(node.HasMean(), loadedNode.HasMean());
+        if (node.HasMean())
+            BOOST_CHECK_CLOSE(node.Mean(), loadedNode.Mean(), 1e-4);
+        BOOST_CHECK_EQUAL(node.RaveCount(), loadedNode.RaveCount());
+        if (node.HasRaveValue())
+            BOOST_CHECK_CLOSE(node.RaveValue(), loadedNode.RaveValue(),
+                              1e-4);
+        BOOST_CHECK_EQUAL(node.PosCount(), loadedNode.PosCount());
+        BOOST_CHECK_EQUAL(node.KnowledgeCount(),
+                          loadedNode.KnowledgeCount());
+        BOOST_CHECK_EQUAL(node.PredictorValue(),
+                          loadedNode.PredictorValue());
+        BOOST_CHECK_EQUAL(node.ProvenType(), loadedNode.ProvenType());
+        BOOST_CHECK_EQUAL(node.NuChildren(), loadedNode.NuChildren());
+    }
+    BOOST_CHECK(! it1);
+    BOOST_CHECK(! it2);
+
+    SgUctTree small;
+    small.CreateAllocators(1);
+    small.SetMaxNodes(2);
+    BOOST_CHECK_THROW(small.Load(fileName, 42), SgException);
+    BOOST_CHECK_EQUAL(small.NuNodes(), 1u);
+
+    // Records with a move that is not on the board or a value that is not
+    // in [0..1]. Record 1 is the first child of the root.
+    PatchTreeFileRecord(fileName, 1, FILE_NODE_MOVE_OFFSET, int32_t(10));
+    BOOST_CHECK_THROW(loaded.Load(fileName, 42), SgException);
+    BOOST_CHECK_EQUAL(loaded.NuNodes(), 1u);
+    tree.Save(fileName, 42);
+    PatchTreeFileRecord(fileName, 1, FILE_NODE_MEAN_OFFSET, 2.);
+    BOOST_CHECK_THROW(loaded.Load(fileName, 42), SgException);
+    tree.Save(fileName, 42);
+    PatchTreeFileRecord(fileName, 1, FILE_NODE_MEAN_OFFSET,
+                        std::numeric_limits<double>::quiet_NaN());
+    BOOST_CHECK_THROW(loaded.Load(fileName, 42), SgException);
+    tree.Save(fileName, 42);
+
+    {
+        std::ofstream out(fileName, std::ios::binary | std::ios::app);
+        out << "garbage";
+    }
+    BOOST_CHECK_THROW(loaded.Load(fileName, 42), SgException);
+    std::remove(fileName);
+    BOOST_CHECK_THROW(loaded.Load(fileName, 42), SgException);
+}
+
+/** Test that SgUctTree::Load() rejects trees that are too deep.
+    Limits the recursion depth for corrupt files. */
+BOOST_AUTO_TEST_CASE(SgUctTreeTest_LoadTooDeep)
+{
+    const char* fileName = "SgUctTreeTest_LoadTooDeep.uct";
+    const int depth = 10001;
+    SgUctTree tree;
+    tree.CreateAllocators(1);
+    tree.SetMaxNodes(depth + 1);
+    vector<SgUctMoveInfo> moves;
+    moves.push_back(SgUctMoveInfo(Pt(1, 1)));
+    const SgUctNode* node = &tree.Root();
+    for (int i = 0; i < depth; ++i)
+    {
+        tree.CreateChildren(0, *node, moves);
+        node = node->FirstChild();
+    }
+    tree.Save(fileName, 42);
+    SgUctTree loaded;
+    loaded.CreateAllocators(1);
+    loaded.SetMaxNodes(depth + 1);
+    BOOST_CHECK_THROW(loaded.Load(fileName, 42), SgException);
+    BOOST_CHECK_EQUAL(loaded.NuNodes(), 1u);
+    std::remove(fileName);
+}
+
+/** Test that the allocators can be used with NUMA placement.
+    The placement only has an effect on NUMA systems, if Fuego was compiled
+    with libnuma (see SgNuma.h). */
+BOOST_AUTO_TEST_CASE(SgUctTreeTest_NumaPlacement)
+{
+    SgUctTree tree;
+    tree.CreateAllocators(2);
+    tree.SetNumaPlacement(true, 3);
+    tree.SetMaxNodes(20000);
+    BOOST_CHECK(tree.NumaPlacement());
+    BOOST_CHECK_EQUAL(tree.NumaInterleaveNodes(), 3u);
+    vector<SgUctMoveInfo> moves;
+    for (SgMove move = 1; move <= 10; ++move)
+        moves.push_back(SgUctMoveInfo(move));
+    tree.CreateChildren(1, tree.Root(), moves);
+    BOOST_CHECK_EQUAL(tree.NuNodes(), 11u);
+    tree.CheckConsistency();
+}
+
+/** Test that the data of SgUctNode survives a copy.
+    Checks the members that use narrow storage types in the compact node
+    layout (see SG_UCT_COMPACT_NODE). */
+BOOST_AUTO_TEST_CASE(SgUctNodeTest_CopyDataFrom)
+{
+    const SgUctMoveInfo nullMoveInfo(SG_NULLMOVE);
+    SgUctNode node(nullMoveInfo);
+    BOOST_CHECK(! node.HasMove());
+    SgUctNode node1(SgUctMoveInfo(362, 0.5, 3, 0.25, 2));
+    node1.SetProvenType(SG_PROVEN_LOSS);
+    node1.AddVirtualLoss();
+    node1.AddVirtualLoss();
+    node1.SetPosCount(7);
+    node1.SetNuChildren(300);
+    node.CopyDataFrom(node1);
+    BOOST_CHECK_EQUAL(node.Move(), 362);
+    BOOST_CHECK_EQUAL(node.ProvenType(), SG_PROVEN_LOSS);
+    BOOST_CHECK_EQUAL(node.VirtualLossCount(), 2);
+    BOOST_CHECK_EQUAL(node.PosCount(), SgUctValue(7));
+    BOOST_CHECK_EQUAL(node.MoveCount(), SgUctValue(3));
+    BOOST_CHECK_CLOSE(node.Mean(), SgUctValue(0.5), 1e-4);
+    BOOST_CHECK_EQUAL(node.RaveCount(), SgUctValue(2));
+    BOOST_CHECK_CLOSE(node.RaveValue(), SgUctValue(0.25), 1e-4);
+    // Children information is not copied
+    BOOST_CHECK_EQUAL(node.NuChildren(), 0);
+}
+
 } // namespace
 
 //----------------------------------------------------------------------------
@@ -0,0 +1,104 @@
+#!/usr/bin/perl -w
+
+# Compare the memory efficiency and speed of different builds of Fuego,
+# e.g. a default build and one configured with --enable-uct-compact-node.
+# For each program, prints the size of the UCT tree in nodes per GB of
+# memory (derived from the max_nodes parameter after uct_max_memory) and
+# the average number of simulations per second.
+
+use Getopt::Long;
+use File::Temp qw/ tempfile /;
+
+$verbose = 0;
+
+@programs = ();
+$size = 9;
+$games = 50000;
+$threads = 1;
+$count = 5;
+
+
+sub printUsage {
+    print STDERR "Usage: fuego-node-layout-test [options] --program <path> [--program <path> ...]\n";
+    print STDERR "  Options\n";
+    print STDERR "    --size <n>         Board size. (default $size)\n";
+    print STDERR "    --games <n>        Number of games in search. (default $games)\n";
+    print STDERR "    --threads <n>      Number of threads. (default $threads)\n";
+    print STDERR "    --count <n>        Number of tests to average. (default $count)\n";
+    print STDERR "    --program <path>   Path to a Fuego executable. Can be repeated.\n";
+    print STDERR "    --verbose          Display Fuego's output.\n";
+    print STDERR "    --help             Displays this help message.\n";
+    exit 0;
+}
+
+
+GetOptions('verbose' => \$verbose,
+	   'program=s' => \@programs,
+           'size=i' => \$size,
+           'games=i' => \$games,
+           'threads=i' => \$threads,
+           'count=i' => \$count,
+           'help' => \$help);
+
+if ($help || ! @programs) {
+    printUsage();
+}
+
+$gigabyte = 1024 * 1024 * 1024;
+
+($CONFIG, $configFilename) = tempfile( UNLINK=> 1 );
+
+print $CONFIG "boardsize $size\n";
+print $CONFIG "go_rules cgos\n";
+print $CONFIG "komi 7.5\n";
+
+print $CONFIG "book_clear\n";
+
+print $CONFIG "uct_max_memory $gigabyte\n";
+print $CONFIG "uct_param_search\n";
+
+print $CONFIG "uct_param_player ignore_clock 1\n";
+print $CONFIG "uct_param_player max_games $games\n";
+print $CONFIG "uct_param_player reuse_subtree 0\n";
+print $CONFIG "uct_param_player forced_opening_moves 0\n";
+
+print $CONFIG "uct_param_search lock_free 1\n";
+print $CONFIG "uct_param_search number_threads $threads\n";
+print $CONFIG "uct_param_search move_select estimate\n";
+
+print $CONFIG "reg_genmove b\n";
+close($CONFIG);
+
+printf STDOUT "%-40s %14s %10s\n", "Program", "Nodes/GB", "Games/s";
+foreach $program (@programs) {
+    $speedTally = 0;
+    $nodesPerGb = 0;
+    for($i = 1; $i <= $count; $i++) {
+	print STDERR "$program: test $i of $count...\n";
+	$speed = 0;
+	open(FUEGO, "$program <$configFilename 2>&1 |");
+	while (<FUEGO>) {
+	    if ($verbose) {
+		print $_;
+	    }
+	    chomp($_);
+	    # uct_max_memory reserves memory for two trees (see
+	    # GoUctCommands::CmdMaxMemory)
+	    if ($_ =~ /max_nodes +([0-9]+)/ ) {
+		$nodesPerGb = 2 * $1;
+	    }
+	    if ($_ =~ /^Games\/s/ ) {
+		@fields=split(/ +/,$_);
+		$speed = $fields[1];
+		$speedTally += $speed;
+	    }
+	}
+	close(FUEGO);
+	if ($speed <= 0) {
+	    print STDERR "error: could not find speed in output\n";
+	    exit 0;
+	}
+    }
+    printf STDOUT "%-40s %14d %10.1f\n", $program, $nodesPerGb,
+        $speedTally / $count;
+}
@@ -0,0 +1,103 @@
+#!/usr/bin/perl -w
+
+# Compare the speed of Fuego with and without NUMA thread binding and
+# memory placement (uct_param_search numa and numa_interleave_nodes).
+# For each setting, prints the average number of simulations per second.
+# NUMA support requires that Fuego was compiled with libnuma.
+
+use Getopt::Long;
+use File::Temp qw/ tempfile /;
+
+$verbose = 0;
+
+$program = "fuego";
+$size = 19;
+$games = 100000;
+$threads = 8;
+$memory = -1;
+$interleave = 10000;
+$count = 5;
+
+
+sub printUsage {
+    print STDERR "Usage: fuego-numa-test [options]\n";
+    print STDERR "  Options\n";
+    print STDERR "    --size <n>         Board size. (default $size)\n";
+    print STDERR "    --games <n>        Number of games in search. (default $games)\n";
+    print STDERR "    --threads <n>      Number of threads. (default $threads)\n";
+    print STDERR "    --memory <n>       Set Fuego's maximum memory parameter.\n";
+    print STDERR "    --interleave <n>   Interleaved nodes per thread for the last setting. (default $interleave)\n";
+    print STDERR "    --count <n>        Number of tests to average. (default $count)\n";
+    print STDERR "    --program <path>   Path to the Fuego executable.\n";
+    print STDERR "    --verbose          Display Fuego's output.\n";
+    print STDERR "    --help             Displays this help message.\n";
+    exit 0;
+}
+
+
+GetOptions('verbose' => \$verbose,
+	   'program=s' => \$program,
+           'size=i' => \$size,
+           'games=i' => \$games,
+           'threads=i' => \$threads,
+	   'memory=i' => \$memory,
+           'interleave=i' => \$interleave,
+           'count=i' => \$count,
+           'help' => \$help);
+
+if ($help) {
+    printUsage();
+}
+
+@settings = ( [ "no binding", 0, 0 ],
+              [ "numa", 1, 0 ],
+              [ "numa, interleaved top", 1, $interleave ] );
+
+printf STDOUT "%-30s %10s\n", "Setting", "Games/s";
+foreach $setting (@settings) {
+    ($name, $numa, $interleaveNodes) = @$setting;
+
+    ($CONFIG, $configFilename) = tempfile( UNLINK=> 1 );
+    print $CONFIG "boardsize $size\n";
+    print $CONFIG "go_rules cgos\n";
+    print $CONFIG "komi 7.5\n";
+    print $CONFIG "book_clear\n";
+    if ($memory > 0) {
+	print $CONFIG "uct_max_memory $memory\n";
+    }
+    print $CONFIG "uct_param_player ignore_clock 1\n";
+    print $CONFIG "uct_param_player max_games $games\n";
+    print $CONFIG "uct_param_player reuse_subtree 0\n";
+    print $CONFIG "uct_param_player forced_opening_moves 0\n";
+    print $CONFIG "uct_param_search lock_free 1\n";
+    print $CONFIG "uct_param_search number_threads $threads\n";
+    print $CONFIG "uct_param_search numa $numa\n";
+    print $CONFIG "uct_param_search numa_interleave_nodes $interleaveNodes\n";
+    print $CONFIG "uct_param_search move_select estimate\n";
+    print $CONFIG "reg_genmove b\n";
+    close($CONFIG);
+
+    $speedTally = 0;
+    for($i = 1; $i <= $count; $i++) {
+	print STDERR "$name: test $i of $count...\n";
+	$speed = 0;
+	open(FUEGO, "$program <$configFilename 2>&1 |");
+	while (<FUEGO>) {
+	    if ($verbose) {
+		print $_;
+	    }
+	    chomp($_);
+	    if ($_ =~ /^Games\/s/ ) {
+		@fields=split(/ +/,$_);
+		$speed = $fields[1];
+		$speedTally += $speed;
+	    }
+	}
+	close(FUEGO);
+	if ($speed <= 0) {
+	    print STDERR "error: could not find speed in output\n";
+	    exit 0;
+	}
+    }
+    printf STDOUT "%-30s %10.1f\n", $name, $speedTally / $count;
+}